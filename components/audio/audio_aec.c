@@ -0,0 +1,141 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "audio_aec.h"
+
+#define AEC_HIST_MASK   (AUDIO_AEC_HIST - 1)
+#define AEC_ACTIVE_RMS  (64)      // far end below this level per sample is not worth adapting to
+#define AEC_DELTA_RMS   (32)      // NLMS regularisation, per sample
+#define AEC_G_MAX       (65535)   // keeps the per tap update in 32 bits
+#define AEC_ERLE_ALPHA  (0.05f)   // per frame smoothing of the ERLE powers
+
+static inline int16_t sat16(int32_t v) {
+    return (v > INT16_MAX) ? INT16_MAX : (v < INT16_MIN) ? INT16_MIN : (int16_t)v;
+}
+
+// a tap is +-2.0 in Q30, a diverging path estimate must clip there rather than wrap
+static inline int32_t sat32(int64_t v) {
+    return (v > INT32_MAX) ? INT32_MAX : (v < -INT32_MAX) ? -INT32_MAX : (int32_t)v;
+}
+
+void audio_aec_init(audio_aec_t *aec, uint32_t sample_rate) {
+    memset(aec, 0, sizeof(audio_aec_t));
+    aec->taps = AUDIO_AEC_TAIL_MS * sample_rate / 1000;
+    if (aec->taps > AUDIO_AEC_TAPS_MAX) {
+        aec->taps = AUDIO_AEC_TAPS_MAX;
+    }
+    aec->hang_len = AUDIO_AEC_HANG_MS * sample_rate / 1000;
+}
+
+void audio_aec_far(audio_aec_t *aec, const int16_t *far, uint32_t n) {
+    for (uint32_t i = 0; i < n; i++) {
+        aec->far[(aec->far_end + i) & AEC_HIST_MASK] = far[i];
+    }
+    aec->far_end += n;
+}
+
+bool audio_aec_process(audio_aec_t *aec, int16_t *near, uint32_t n, uint32_t far_pos) {
+    const uint32_t taps = aec->taps;
+    const uint32_t first = far_pos - (taps - 1);
+    const int64_t active = (int64_t)taps * AEC_ACTIVE_RMS * AEC_ACTIVE_RMS;
+    const int64_t delta = (int64_t)taps * AEC_DELTA_RMS * AEC_DELTA_RMS;
+    int32_t *w = aec->w;
+    int16_t *x = aec->x;
+
+    // the whole reference window of the frame must still be, and already be, in the history
+    if (n > WBS_PCM_FRAME_SAMPLES || (int32_t)(aec->far_end - (far_pos + n)) < 0 || aec->far_end - first > AUDIO_AEC_HIST) {
+        aec->stats.skipped++;
+        return false;
+    }
+
+    int32_t peak = 0;
+    for (uint32_t k = 0; k < taps - 1 + n; k++) {
+        x[k] = aec->far[(first + k) & AEC_HIST_MASK];
+        int32_t a = (x[k] < 0) ? -x[k] : x[k];
+        if (a > peak) {
+            peak = a;
+        }
+    }
+    int64_t energy = 0;
+    for (uint32_t k = 0; k < taps; k++) {
+        energy += (int32_t)x[k] * x[k];
+    }
+
+    float pn = 0.0f;
+    float pe = 0.0f;
+    bool dt = false;
+    for (uint32_t i = 0; i < n; i++) {
+        // window of sample i is xi[0..taps-1], newest last, w[k] pairs with xi[k]
+        const int16_t *xi = x + i;
+        int64_t acc = 0;
+        for (uint32_t k = 0; k < taps; k++) {
+            acc += (int64_t)w[k] * xi[k];
+        }
+        int32_t d = near[i];
+        int16_t e = sat16(d - (int32_t)(acc >> 30));
+
+        // Geigel: near end louder than half the far-end peak cannot be echo alone
+        if (((d < 0) ? -d : d) > peak / 2) {
+            aec->hang = aec->hang_len;
+        }
+        if (aec->hang) {
+            aec->hang--;
+            dt = true;
+        } else if (energy > active) {
+            int64_t g = ((int64_t)AUDIO_AEC_MU_Q15 * e * 32768) / (energy + delta);
+            g = (g > AEC_G_MAX) ? AEC_G_MAX : (g < -AEC_G_MAX) ? -AEC_G_MAX : g;
+            for (uint32_t k = 0; k < taps; k++) {
+                w[k] = sat32((int64_t)w[k] + (int32_t)g * xi[k]);
+            }
+            pn += (float)d * d;
+            pe += (float)e * e;
+        }
+
+        if (i + 1 < n) {
+            energy += (int32_t)xi[taps] * xi[taps] - (int32_t)xi[0] * xi[0];
+        }
+        near[i] = e;
+    }
+
+    aec->stats.frames++;
+    if (dt) {
+        aec->stats.double_talk++;
+    }
+    if (pn > 0.0f) {
+        aec->pow_near += AEC_ERLE_ALPHA * (pn - aec->pow_near);
+        aec->pow_err += AEC_ERLE_ALPHA * (pe - aec->pow_err);
+        aec->stats.erle_db = 10.0f * log10f((aec->pow_near + 1.0f) / (aec->pow_err + 1.0f));
+    }
+    return true;
+}
@@ -0,0 +1,89 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef __AUDIO_AEC_H__
+#define __AUDIO_AEC_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "audio_frame.h"
+
+#define AUDIO_AEC_TAIL_MS  (16)   // echo tail covered after the bulk delay
+#define AUDIO_AEC_TAPS_MAX (AUDIO_AEC_TAIL_MS * WBS_PCM_SAMPLING_RATE_KHZ)
+#define AUDIO_AEC_HIST     (4096) // far-end samples kept, must be a power of two
+#define AUDIO_AEC_MU_Q15   (16384) // NLMS step size, 0.5
+#define AUDIO_AEC_HANG_MS  (30)   // adaptation stays frozen this long after double talk
+
+typedef struct {
+    uint32_t frames;      /*!< near-end frames cancelled */
+    uint32_t skipped;     /*!< near-end frames whose reference was not in the history */
+    uint32_t double_talk; /*!< frames with adaptation frozen by the double-talk detector */
+    float erle_db;        /*!< echo return loss enhancement while only the far end talks */
+} audio_aec_stats_t;
+
+/**
+ * @brief     fixed-point NLMS echo canceller with a Geigel double-talk detector
+ *
+ *            The cost per sample is bounded by taps (16 ms of tail) whatever the signal. The far-end history is
+ *            indexed by absolute sample number, so the caller aligns each near-end frame to the far end it echoes.
+ */
+typedef struct {
+    int16_t far[AUDIO_AEC_HIST];                               /*!< far-end history, circular */
+    uint32_t far_end;                                          /*!< absolute index one past the newest far-end sample */
+    int32_t w[AUDIO_AEC_TAPS_MAX];                             /*!< echo path estimate, Q30 */
+    int16_t x[AUDIO_AEC_TAPS_MAX - 1 + WBS_PCM_FRAME_SAMPLES]; /*!< linear copy of the reference for one frame */
+    uint32_t taps;                                             /*!< filter length for the sample rate */
+    uint32_t hang;                                             /*!< samples of frozen adaptation left */
+    uint32_t hang_len;                                         /*!< hang time in samples */
+    float pow_near;                                            /*!< smoothed near-end power, far end only */
+    float pow_err;                                             /*!< smoothed residual power, far end only */
+    audio_aec_stats_t stats;
+} audio_aec_t;
+
+/**
+ * @brief     reset the canceller for sample_rate (8000 or 16000)
+ */
+void audio_aec_init(audio_aec_t *aec, uint32_t sample_rate);
+
+/**
+ * @brief     append n far-end samples, their absolute index continues from the previous call
+ */
+void audio_aec_far(audio_aec_t *aec, const int16_t *far, uint32_t n);
+
+/**
+ * @brief     cancel the echo from n near-end samples in place
+ *
+ *            far_pos: absolute far-end index whose echo arrives with near[0] without extra delay, i.e. the frame
+ *            alignment minus the bulk delay. Returns false, leaving the frame untouched, if that part of the far end
+ *            is no longer or not yet in the history.
+ */
+bool audio_aec_process(audio_aec_t *aec, int16_t *near, uint32_t n, uint32_t far_pos);
+
+#endif /* __AUDIO_AEC_H__ */
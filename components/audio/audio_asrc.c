@@ -0,0 +1,72 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "audio_asrc.h"
+
+bool audio_asrc_init(audio_asrc_t *asrc, uint32_t sample_rate, uint32_t frame_samples, int32_t target) {
+    if (frame_samples == 0 || frame_samples > WBS_PCM_FRAME_SAMPLES || !audio_resampler_init(&asrc->rs, sample_rate, sample_rate)) {
+        return false;
+    }
+    audio_drift_init(&asrc->drift, sample_rate, frame_samples, target);
+    asrc->frame = frame_samples;
+    asrc->count = 0;
+    asrc->lost = 0;
+    return true;
+}
+
+const int16_t *audio_asrc_peek(const audio_asrc_t *asrc) {
+    return (asrc->count >= asrc->frame) ? asrc->buf : NULL;
+}
+
+void audio_asrc_release(audio_asrc_t *asrc) {
+    if (asrc->count < asrc->frame) {
+        return;
+    }
+    asrc->count -= asrc->frame;
+    memmove(asrc->buf, asrc->buf + asrc->frame, asrc->count * sizeof(int16_t));
+}
+
+void audio_asrc_put(audio_asrc_t *asrc, const int16_t *frame) {
+    // a trimmed frame is one sample longer at most, room is made by dropping the oldest frame
+    if (asrc->count + asrc->frame + 1 > AUDIO_ASRC_BUF) {
+        audio_asrc_release(asrc);
+        asrc->lost++;
+    }
+    asrc->count += audio_resampler_process(&asrc->rs, frame, asrc->frame, asrc->buf + asrc->count, AUDIO_ASRC_BUF - asrc->count);
+}
+
+int32_t audio_asrc_track(audio_asrc_t *asrc, int32_t queued) {
+    int32_t ppb = audio_drift_update(&asrc->drift, queued + (int32_t)asrc->count);
+    audio_resampler_set_ppb(&asrc->rs, ppb);
+    return ppb;
+}
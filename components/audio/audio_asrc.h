@@ -0,0 +1,89 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef __AUDIO_ASRC_H__
+#define __AUDIO_ASRC_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "audio_drift.h"
+#include "audio_frame.h"
+#include "audio_resample.h"
+
+#define AUDIO_ASRC_BUF (2 * WBS_PCM_FRAME_SAMPLES + 2) // less than a frame left over plus one trimmed frame
+
+/**
+ * @brief     1:1 rate converter between a local clock and the air clock of the SCO link, at the same nominal rate
+ *
+ *            Whole frames go in through a FRAC resampler trimmed by audio_drift, and whole frames come out. It sits on
+ *            the local clock side of the frame queue between the two domains. Once per frame the caller reports how
+ *            many samples the queue holds, and the loop trims the ratio until that fill stays at the target. A clock
+ *            offset of a few hundred ppm then neither drains nor fills the queue, and the latency stays bounded.
+ */
+typedef struct {
+    audio_resampler_t rs;
+    audio_drift_t drift;
+    uint32_t frame;              /*!< samples per frame */
+    uint32_t count;              /*!< converted samples held in buf */
+    uint32_t lost;               /*!< frames dropped from buf, the caller did not take them in time */
+    int16_t buf[AUDIO_ASRC_BUF]; /*!< converted samples, oldest first */
+} audio_asrc_t;
+
+/**
+ * @brief     reset the converter for frames of frame_samples at sample_rate, the loop holds target samples queued
+ */
+bool audio_asrc_init(audio_asrc_t *asrc, uint32_t sample_rate, uint32_t frame_samples, int32_t target);
+
+/**
+ * @brief     convert one frame
+ */
+void audio_asrc_put(audio_asrc_t *asrc, const int16_t *frame);
+
+/**
+ * @brief     oldest converted frame, NULL until one is complete; valid until audio_asrc_release
+ */
+const int16_t *audio_asrc_peek(const audio_asrc_t *asrc);
+
+/**
+ * @brief     drop the frame returned by audio_asrc_peek
+ */
+void audio_asrc_release(audio_asrc_t *asrc);
+
+/**
+ * @brief     feed the samples waiting in the queue outside the converter, once per frame; returns the trim in ppb
+ *
+ *            The other side of the queue moves in whole frames, so queued has to be interpolated by how far it is into
+ *            its next frame: plus that part when it writes, minus when it reads. Otherwise the phase of the two frame
+ *            clocks beats slowly through the fill and the trim follows the beat rather than the offset. The converted
+ *            samples held inside count as queued as well. A positive trim means the input side is fast.
+ */
+int32_t audio_asrc_track(audio_asrc_t *asrc, int32_t queued);
+
+#endif /* __AUDIO_ASRC_H__ */
@@ -0,0 +1,130 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "audio_bridge.h"
+
+void audio_bridge_init(audio_bridge_t *bridge, const audio_bridge_ops_t *ops, void *drv) {
+    memset(bridge, 0, sizeof(audio_bridge_t));
+    bridge->ops = ops;
+    bridge->drv = drv;
+}
+
+bool audio_bridge_start(audio_bridge_t *bridge, uint32_t sample_rate, uint32_t samples, audio_bridge_frame_cb_t cb, void *ctx) {
+    if (bridge->running || sample_rate == 0 || samples == 0 || cb == NULL) {
+        return false;
+    }
+
+    bridge->cb = cb;
+    bridge->ctx = ctx;
+    bridge->sample_rate = sample_rate;
+    bridge->samples = samples;
+    bridge->frame_us = (uint32_t)((uint64_t)samples * 1000000 / sample_rate);
+    memset(&bridge->rx, 0, sizeof(audio_bridge_lane_t));
+    memset(&bridge->tx, 0, sizeof(audio_bridge_lane_t));
+    memset(&bridge->stats, 0, sizeof(audio_bridge_stats_t));
+
+    bridge->running = bridge->ops->start(bridge->drv, bridge);
+    return bridge->running;
+}
+
+void audio_bridge_stop(audio_bridge_t *bridge) {
+    if (!bridge->running) {
+        return;
+    }
+    bridge->ops->stop(bridge->drv);
+    bridge->running = false;
+}
+
+// the slot is published by the release store of posted, the task only reads slots below it
+static bool bridge_post(audio_bridge_t *bridge, audio_bridge_lane_t *lane, audio_bridge_lane_t *other, int16_t *buf) {
+    uint32_t posted = lane->posted;
+    lane->buf[posted % AUDIO_BRIDGE_SLOTS] = buf;
+    lane->at_us[posted % AUDIO_BRIDGE_SLOTS] = bridge->ops->now_us(bridge->drv);
+    __atomic_store_n(&lane->posted, posted + 1, __ATOMIC_RELEASE);
+    return __atomic_load_n(&other->posted, __ATOMIC_ACQUIRE) != __atomic_load_n(&other->done, __ATOMIC_RELAXED);
+}
+
+bool audio_bridge_rx_done(audio_bridge_t *bridge, int16_t *buf) {
+    return bridge_post(bridge, &bridge->rx, &bridge->tx, buf);
+}
+
+bool audio_bridge_tx_done(audio_bridge_t *bridge, int16_t *buf) {
+    return bridge_post(bridge, &bridge->tx, &bridge->rx, buf);
+}
+
+// with every slot posted again the DMA is back on the oldest one: an rx buffer being overwritten, a tx buffer already playing
+static uint32_t bridge_skip(audio_bridge_lane_t *lane, uint32_t posted) {
+    uint32_t lost = 0;
+    if (posted - lane->done > AUDIO_BRIDGE_SLOTS - 1) {
+        lost = posted - lane->done - (AUDIO_BRIDGE_SLOTS - 1);
+        lane->done += lost;
+    }
+    return lost;
+}
+
+uint32_t audio_bridge_service(audio_bridge_t *bridge) {
+    uint32_t handed = 0;
+    for (;;) {
+        uint32_t rx_posted = __atomic_load_n(&bridge->rx.posted, __ATOMIC_ACQUIRE);
+        uint32_t tx_posted = __atomic_load_n(&bridge->tx.posted, __ATOMIC_ACQUIRE);
+        if (rx_posted == bridge->rx.done || tx_posted == bridge->tx.done) {
+            break;
+        }
+        bridge->stats.overruns += bridge_skip(&bridge->rx, rx_posted);
+        bridge->stats.underruns += bridge_skip(&bridge->tx, tx_posted);
+
+        uint32_t rx_slot = bridge->rx.done % AUDIO_BRIDGE_SLOTS;
+        uint32_t tx_slot = bridge->tx.done % AUDIO_BRIDGE_SLOTS;
+        // the deadline runs from the later of the two completions
+        int64_t at_us = bridge->rx.at_us[rx_slot];
+        if (bridge->tx.at_us[tx_slot] > at_us) {
+            at_us = bridge->tx.at_us[tx_slot];
+        }
+
+        bridge->cb(bridge->ctx, bridge->rx.buf[rx_slot], bridge->tx.buf[tx_slot], bridge->samples);
+
+        __atomic_store_n(&bridge->rx.done, bridge->rx.done + 1, __ATOMIC_RELAXED);
+        __atomic_store_n(&bridge->tx.done, bridge->tx.done + 1, __ATOMIC_RELAXED);
+        uint32_t lat_us = (uint32_t)(bridge->ops->now_us(bridge->drv) - at_us);
+        if (lat_us > bridge->stats.lat_max_us) {
+            bridge->stats.lat_max_us = lat_us;
+        }
+        if (lat_us > bridge->frame_us) {
+            bridge->stats.late++;
+        }
+        bridge->stats.lat_sum_us += lat_us;
+        bridge->stats.frames++;
+        handed++;
+    }
+    return handed;
+}
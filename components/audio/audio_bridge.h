@@ -0,0 +1,125 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef __AUDIO_BRIDGE_H__
+#define __AUDIO_BRIDGE_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define AUDIO_BRIDGE_SLOTS (2) // DMA buffers per direction, the stages work on one while the DMA runs the other
+
+typedef struct audio_bridge_s audio_bridge_t;
+
+/**
+ * @brief     one frame of the codec: rx was just captured, tx is played after the frame now playing.
+ *            Both are the DMA buffers themselves, tx must be written before the callback returns
+ */
+typedef void (*audio_bridge_frame_cb_t)(void *ctx, const int16_t *rx, int16_t *tx, uint32_t samples);
+
+/**
+ * @brief     driver below the bridge
+ *
+ *            The driver owns AUDIO_BRIDGE_SLOTS frame sized DMA buffers per direction and reports each one as its
+ *            transfer completes through audio_bridge_rx_done/audio_bridge_tx_done, from its interrupt. When they
+ *            return true it wakes the task that calls audio_bridge_service.
+ */
+typedef struct {
+    bool (*start)(void *drv, audio_bridge_t *bridge); /*!< set up for bridge->sample_rate and bridge->samples and run */
+    void (*stop)(void *drv);                          /*!< no completion is reported after it returns */
+    int64_t (*now_us)(void *drv);                     /*!< monotonic clock, safe from the completion context */
+} audio_bridge_ops_t;
+
+typedef struct {
+    uint32_t frames;     /*!< frames handed to the callback */
+    uint32_t overruns;   /*!< captured frames overwritten before they were serviced */
+    uint32_t underruns;  /*!< frames played without being written */
+    uint32_t late;       /*!< frames serviced after their deadline, one frame after completion */
+    uint32_t lat_max_us; /*!< longest completion to callback return */
+    uint64_t lat_sum_us; /*!< sum of completion to callback return */
+} audio_bridge_stats_t;
+
+/**
+ * @brief     completions of one direction, posted by the interrupt and consumed by the service task
+ */
+typedef struct {
+    int16_t *buf[AUDIO_BRIDGE_SLOTS];  /*!< buffers in completion order */
+    int64_t at_us[AUDIO_BRIDGE_SLOTS]; /*!< completion time */
+    uint32_t posted;                   /*!< completions reported, written by the interrupt only */
+    uint32_t done;                     /*!< completions serviced, written by the service task only */
+} audio_bridge_lane_t;
+
+/**
+ * @brief     double buffered DMA codec link handing frame aligned buffers to a callback without copying
+ */
+struct audio_bridge_s {
+    const audio_bridge_ops_t *ops;
+    void *drv;
+    audio_bridge_frame_cb_t cb;
+    void *ctx;
+    uint32_t sample_rate;
+    uint32_t samples;  /*!< frame length, also the DMA buffer length */
+    uint32_t frame_us; /*!< frame duration, the service deadline */
+    audio_bridge_lane_t rx;
+    audio_bridge_lane_t tx;
+    bool running;
+    audio_bridge_stats_t stats;
+};
+
+/**
+ * @brief     bind the bridge to a driver
+ */
+void audio_bridge_init(audio_bridge_t *bridge, const audio_bridge_ops_t *ops, void *drv);
+
+/**
+ * @brief     start the driver with frames of samples at sample_rate, cb receives every frame
+ */
+bool audio_bridge_start(audio_bridge_t *bridge, uint32_t sample_rate, uint32_t samples, audio_bridge_frame_cb_t cb, void *ctx);
+
+/**
+ * @brief     stop the driver, the statistics stay until the next start
+ */
+void audio_bridge_stop(audio_bridge_t *bridge);
+
+/**
+ * @brief     driver side: buf has been captured. Returns true when a frame is ready for audio_bridge_service
+ */
+bool audio_bridge_rx_done(audio_bridge_t *bridge, int16_t *buf);
+
+/**
+ * @brief     driver side: buf has been played and is free. Returns true when a frame is ready for audio_bridge_service
+ */
+bool audio_bridge_tx_done(audio_bridge_t *bridge, int16_t *buf);
+
+/**
+ * @brief     task side: hand every ready frame to the callback, returns the number handed over
+ */
+uint32_t audio_bridge_service(audio_bridge_t *bridge);
+
+#endif /* __AUDIO_BRIDGE_H__ */
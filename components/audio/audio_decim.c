@@ -0,0 +1,115 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "audio_decim.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define DECIM_CUTOFF (0.45) // passband edge, fraction of the output rate
+#define DECIM_MASK   ((1u << AUDIO_DECIM_IN_BITS) - 1)
+#define DECIM_SCALE  (16 - AUDIO_DECIM_IN_BITS)
+
+bool audio_decim_init(audio_decim_t *d, uint32_t out_rate) {
+    memset(d, 0, sizeof(audio_decim_t));
+    if (out_rate == 0 || AUDIO_DECIM_IN_RATE % out_rate != 0 || AUDIO_DECIM_IN_RATE / out_rate > AUDIO_DECIM_FACTOR_MAX) {
+        return false;
+    }
+    d->factor = AUDIO_DECIM_IN_RATE / out_rate;
+    d->len = d->factor * AUDIO_DECIM_TAPS;
+
+    // Blackman windowed sinc at the input rate, stored reversed so it runs over the window oldest first
+    const double fc = DECIM_CUTOFF / d->factor;
+    const double mid = (d->len - 1) / 2.0;
+    double h[AUDIO_DECIM_FACTOR_MAX * AUDIO_DECIM_TAPS], sum = 0;
+    for (uint32_t i = 0; i < d->len; i++) {
+        double t = i - mid;
+        double sinc = (t == 0) ? 2 * fc : sin(2 * M_PI * fc * t) / (M_PI * t);
+        double win = 0.42 + 0.5 * cos(2 * M_PI * t / d->len) + 0.08 * cos(4 * M_PI * t / d->len);
+        h[i] = sinc * win;
+        sum += h[i];
+    }
+    for (uint32_t i = 0; i < d->len; i++) {
+        d->coef[d->len - 1 - i] = (int16_t)lrint(h[i] / sum * 32767);
+    }
+    return true;
+}
+
+uint32_t audio_decim_process(audio_decim_t *d, const uint16_t *raw, uint32_t n, int16_t *out, uint32_t out_max) {
+    uint32_t produced = 0;
+    uint32_t clipped = 0;
+    int32_t dc_acc = d->dc_acc;
+
+    if (!d->seeded && n > 0) {
+        dc_acc = (int32_t)((raw[0] & DECIM_MASK) << DECIM_SCALE) << AUDIO_DECIM_DC_SHIFT;
+        d->seeded = true;
+    }
+
+    for (uint32_t i = 0; i < n; i++) {
+        int32_t x = (int32_t)((raw[i] & DECIM_MASK) << DECIM_SCALE);
+        dc_acc += x - (dc_acc >> AUDIO_DECIM_DC_SHIFT);
+        x -= dc_acc >> AUDIO_DECIM_DC_SHIFT;
+        x = (x > INT16_MAX) ? INT16_MAX : (x < INT16_MIN) ? INT16_MIN : x;
+        d->hist[d->pos] = (int16_t)x;
+        d->hist[d->pos + d->len] = (int16_t)x;
+        d->pos = (d->pos + 1 == d->len) ? 0 : d->pos + 1;
+
+        if (++d->phase < d->factor) {
+            continue;
+        }
+        d->phase = 0;
+        if (produced == out_max) {
+            continue;
+        }
+        // oldest to newest
+        const int16_t *w = &d->hist[d->pos];
+        int32_t acc = 0;
+        for (uint32_t k = 0; k < d->len; k++) {
+            acc += d->coef[k] * w[k];
+        }
+        acc >>= 15;
+        if (acc > INT16_MAX || acc < INT16_MIN) {
+            acc = (acc > INT16_MAX) ? INT16_MAX : INT16_MIN;
+            clipped++;
+        }
+        out[produced++] = (int16_t)acc;
+    }
+
+    d->dc_acc = dc_acc;
+    d->stats.in += n;
+    d->stats.out += produced;
+    d->stats.clipped += clipped;
+    return produced;
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef __AUDIO_DECIM_H__
+#define __AUDIO_DECIM_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define AUDIO_DECIM_IN_RATE    (64000) // ADC conversions per second, whatever the output rate
+#define AUDIO_DECIM_FACTOR_MAX (8)     // 64 kHz to 8 kHz
+#define AUDIO_DECIM_TAPS       (24)    // filter taps per output phase, the filter is factor * taps long
+#define AUDIO_DECIM_IN_BITS    (12)    // converter resolution, higher bits of the input words are ignored
+#define AUDIO_DECIM_DC_SHIFT   (10)    // DC tracking time constant, 2^shift conversions: 10 Hz corner at 64 kHz
+
+typedef struct {
+    uint32_t in;      /*!< conversions taken */
+    uint32_t out;     /*!< samples produced */
+    uint32_t clipped; /*!< samples saturated to 16 bits */
+} audio_decim_stats_t;
+
+/**
+ * @brief     DC blocker and decimating low pass for a converter running at AUDIO_DECIM_IN_RATE
+ *
+ *            Raw conversion words go in as the DMA delivers them. Each one is masked to the converter bits, scaled to
+ *            16 bits and has the tracked DC removed in the same pass that stores it for the filter; the windowed sinc
+ *            low pass is only evaluated for the samples kept.
+ */
+typedef struct {
+    int16_t coef[AUDIO_DECIM_FACTOR_MAX * AUDIO_DECIM_TAPS];     /*!< low pass, Q15, unity gain */
+    int16_t hist[2 * AUDIO_DECIM_FACTOR_MAX * AUDIO_DECIM_TAPS]; /*!< last inputs, mirrored so a window is contiguous */
+    uint32_t len;                                                /*!< filter length, factor * taps */
+    uint32_t pos;                                                /*!< next slot of hist */
+    uint32_t factor;                                             /*!< conversions per output sample */
+    uint32_t phase;                                              /*!< conversions since the last output */
+    int32_t dc_acc;                                              /*!< DC estimate, Q(AUDIO_DECIM_DC_SHIFT) */
+    bool seeded;                                                 /*!< DC estimate taken from the first conversion */
+    audio_decim_stats_t stats;
+} audio_decim_t;
+
+/**
+ * @brief     build the filter for out_rate, false unless it divides AUDIO_DECIM_IN_RATE into at most AUDIO_DECIM_FACTOR_MAX
+ */
+bool audio_decim_init(audio_decim_t *d, uint32_t out_rate);
+
+/**
+ * @brief     take n raw conversions, write at most out_max samples to out, returns the number written
+ */
+uint32_t audio_decim_process(audio_decim_t *d, const uint16_t *raw, uint32_t n, int16_t *out, uint32_t out_max);
+
+#endif /* __AUDIO_DECIM_H__ */
@@ -0,0 +1,84 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "audio_drift.h"
+
+#define DRIFT_DAMPING   (0.7f)
+#define DRIFT_LP_SHIFT  (4) // fill error smoothing over 16 updates, much shorter than the loop time constant
+#define DRIFT_MAX_PPB   ((float)AUDIO_DRIFT_MAX_PPM * 1000.0f)
+
+void audio_drift_init(audio_drift_t *d, uint32_t sample_rate, uint32_t frame_samples, int32_t target) {
+    memset(d, 0, sizeof(audio_drift_t));
+    d->target = target;
+    if (sample_rate == 0 || frame_samples == 0) {
+        return;
+    }
+
+    // natural frequency in rad per update; a fill error of e samples moves the fill by frame_samples * ppb / 1e9 per update
+    float wn = (float)frame_samples * 1000.0f / ((float)sample_rate * AUDIO_DRIFT_TAU_MS);
+    d->kp = 2.0f * DRIFT_DAMPING * wn / frame_samples * 1e9f;
+    d->ki = wn * wn / frame_samples * 1e9f;
+}
+
+int32_t audio_drift_update(audio_drift_t *d, int32_t fill) {
+    int32_t err = fill - d->target;
+
+    if (d->updates++ == 0) {
+        d->err_lp = (float)err;
+        d->err_min = err;
+        d->err_max = err;
+    }
+    if (err < d->err_min) {
+        d->err_min = err;
+    }
+    if (err > d->err_max) {
+        d->err_max = err;
+    }
+    d->err_lp += ((float)err - d->err_lp) / (1 << DRIFT_LP_SHIFT);
+
+    // clamped integrator, no wind-up while the proportional branch saturates
+    d->integ += d->ki * d->err_lp;
+    if (d->integ > DRIFT_MAX_PPB) {
+        d->integ = DRIFT_MAX_PPB;
+    } else if (d->integ < -DRIFT_MAX_PPB) {
+        d->integ = -DRIFT_MAX_PPB;
+    }
+
+    float ppb = d->integ + d->kp * d->err_lp;
+    if (ppb > DRIFT_MAX_PPB) {
+        ppb = DRIFT_MAX_PPB;
+    } else if (ppb < -DRIFT_MAX_PPB) {
+        ppb = -DRIFT_MAX_PPB;
+    }
+    d->ppb = (int32_t)ppb;
+    return d->ppb;
+}
@@ -0,0 +1,67 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef __AUDIO_DRIFT_H__
+#define __AUDIO_DRIFT_H__
+
+#include <stdint.h>
+
+#define AUDIO_DRIFT_MAX_PPM (500)  // correction range, far beyond crystal tolerances
+#define AUDIO_DRIFT_TAU_MS  (10000) // loop time constant, long enough to average out the frame sized steps of the fill level
+
+/**
+ * @brief     second order loop that locks a rate correction to the fill level of a buffer between two clock domains
+ *
+ *            The writer runs at its own clock and is trimmed by ppb, typically through audio_resampler_set_ppb on a 1:1
+ *            FRAC resampler in front of the buffer, as audio_asrc does. The reader runs at the other clock. At lock ppb is the relative
+ *            offset of the two clocks and the fill level sits at the target, so the latency stays constant.
+ */
+typedef struct {
+    int32_t target;   /*!< fill level to hold, samples */
+    float kp;         /*!< ppb per sample of fill error */
+    float ki;         /*!< ppb per sample of fill error and update */
+    float err_lp;     /*!< fill error with the frame sawtooth filtered out, samples */
+    float integ;      /*!< integral branch, ppb */
+    int32_t ppb;      /*!< current correction, positive when the writer is fast */
+    int32_t err_min;  /*!< lowest fill error seen, samples */
+    int32_t err_max;  /*!< highest fill error seen, samples */
+    uint32_t updates; /*!< calls to audio_drift_update */
+} audio_drift_t;
+
+/**
+ * @brief     reset the loop for a buffer of sample_rate updated once every frame_samples, holding target samples
+ */
+void audio_drift_init(audio_drift_t *d, uint32_t sample_rate, uint32_t frame_samples, int32_t target);
+
+/**
+ * @brief     feed the fill level measured once per frame, returns the new correction in ppb
+ */
+int32_t audio_drift_update(audio_drift_t *d, int32_t fill);
+
+#endif /* __AUDIO_DRIFT_H__ */
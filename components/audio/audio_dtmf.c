@@ -0,0 +1,235 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "audio_dtmf.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define DTMF_QUEUE_MASK  (AUDIO_DTMF_QUEUE - 1)
+#define DTMF_LEVEL_LOW   (7336) // -13 dBFS
+#define DTMF_LEVEL_HIGH  (9235) // -11 dBFS, the high group 2 dB over the low one as telephone sets send it
+
+#define DET_MIN_DBFS     (-36.0f) // quietest tone accepted, each
+#define DET_TWIST_NORMAL (0.158f) // column tone may be 8 dB under the row tone
+#define DET_TWIST_REV    (2.51f)  // and 4 dB over it
+#define DET_REL_PEAK     (0.158f) // other tones of the group at least 8 dB under the strongest
+#define DET_HARMONIC     (0.1f)   // second harmonics at least 10 dB under their tone
+#define DET_PURITY       (0.5f)   // share of the block energy in the two tones
+#define DET_EVEN         (0.5f)   // energy of the weaker half block against the stronger one
+
+static const uint16_t s_dtmf_freq[8] = { 697, 770, 852, 941, 1209, 1336, 1477, 1633 };
+static const char s_dtmf_map[4][4] = {
+    { '1', '2', '3', 'A' },
+    { '4', '5', '6', 'B' },
+    { '7', '8', '9', 'C' },
+    { '*', '0', '#', 'D' },
+};
+
+static bool dtmf_pos(char digit, int *row, int *col) {
+    for (int r = 0; r < 4; r++) {
+        for (int c = 0; c < 4; c++) {
+            if (s_dtmf_map[r][c] == digit) {
+                *row = r;
+                *col = c;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool audio_dtmf_valid(char digit) {
+    int row, col;
+    return dtmf_pos(digit, &row, &col);
+}
+
+void audio_dtmf_gen_init(audio_dtmf_gen_t *gen, uint32_t sample_rate) {
+    memset(gen, 0, sizeof(audio_dtmf_gen_t));
+    gen->sample_rate = sample_rate;
+}
+
+bool audio_dtmf_gen_push(audio_dtmf_gen_t *gen, char digit) {
+    uint32_t head = gen->head;
+    uint32_t tail = __atomic_load_n(&gen->tail, __ATOMIC_ACQUIRE);
+
+    if (!audio_dtmf_valid(digit) || head - tail >= AUDIO_DTMF_QUEUE) {
+        __atomic_fetch_add(&gen->dropped, 1, __ATOMIC_RELAXED);
+        return false;
+    }
+    gen->queue[head & DTMF_QUEUE_MASK] = digit;
+    __atomic_store_n(&gen->head, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+bool audio_dtmf_gen_fill(audio_dtmf_gen_t *gen, int16_t *pcm, uint32_t n) {
+    bool replaced = false;
+
+    while (n) {
+        if (gen->on_left == 0 && gen->gap_left == 0) {
+            uint32_t tail = gen->tail;
+            if (tail == __atomic_load_n(&gen->head, __ATOMIC_ACQUIRE)) {
+                break;
+            }
+            int row, col;
+            bool known = dtmf_pos(gen->queue[tail & DTMF_QUEUE_MASK], &row, &col);
+            __atomic_store_n(&gen->tail, tail + 1, __ATOMIC_RELEASE);
+            // push only queues known digits, anything else is dropped, not guessed
+            if (!known) {
+                __atomic_fetch_add(&gen->dropped, 1, __ATOMIC_RELAXED);
+                continue;
+            }
+
+            const audio_tone_spec_t spec = {
+                .freq = { s_dtmf_freq[row], s_dtmf_freq[4 + col] },
+                .level = { DTMF_LEVEL_LOW, DTMF_LEVEL_HIGH },
+                .cadence_ms = { 0 },
+            };
+            audio_tone_init(&gen->tone, &spec, gen->sample_rate);
+            gen->on_left = AUDIO_DTMF_ON_MS * gen->sample_rate / 1000;
+            gen->gap_left = AUDIO_DTMF_GAP_MS * gen->sample_rate / 1000;
+        }
+
+        uint32_t k;
+        if (gen->on_left) {
+            k = (gen->on_left < n) ? gen->on_left : n;
+            audio_tone_fill(&gen->tone, pcm, k);
+            replaced = true;
+            gen->on_left -= k;
+            if (gen->on_left == 0) {
+                gen->played++;
+            }
+        } else {
+            k = (gen->gap_left < n) ? gen->gap_left : n;
+            gen->gap_left -= k;
+        }
+        pcm += k;
+        n -= k;
+    }
+    return replaced;
+}
+
+void audio_dtmf_det_init(audio_dtmf_det_t *det, uint32_t sample_rate) {
+    memset(det, 0, sizeof(audio_dtmf_det_t));
+    det->block = AUDIO_DTMF_BLOCK_8K * sample_rate / 8000;
+    det->bank[1].pos = det->block / 2;
+    for (int k = 0; k < AUDIO_DTMF_FILTERS; k++) {
+        // filters 8..15 sit on the second harmonics of 0..7
+        double f = s_dtmf_freq[k & 7] * ((k < 8) ? 1.0 : 2.0);
+        det->coef_q14[k] = (int32_t)lrint(2.0 * cos(2.0 * M_PI * f / sample_rate) * 16384.0);
+    }
+}
+
+static char dtmf_det_block(audio_dtmf_det_t *det, const audio_dtmf_bank_t *bank) {
+    const float n = (float)det->block;
+    float p[AUDIO_DTMF_FILTERS];
+
+    // tone power normalised to its squared amplitude
+    for (int k = 0; k < AUDIO_DTMF_FILTERS; k++) {
+        float s1 = (float)bank->s1[k];
+        float s2 = (float)bank->s2[k];
+        p[k] = (s1 * s1 + s2 * s2 - s1 * s2 * det->coef_q14[k] / 16384.0f) * 4.0f / (n * n);
+    }
+    float energy = (float)bank->energy;
+
+    int row = 0;
+    int col = 4;
+    for (int k = 1; k < 4; k++) {
+        row = (p[k] > p[row]) ? k : row;
+        col = (p[4 + k] > p[col]) ? 4 + k : col;
+    }
+
+    const float min = 32768.0f * 32768.0f * powf(10.0f, DET_MIN_DBFS / 10.0f);
+    if (p[row] < min || p[col] < min) {
+        return 0;
+    }
+
+    bool ok = (p[col] >= p[row] * DET_TWIST_NORMAL) && (p[col] <= p[row] * DET_TWIST_REV);
+    for (int k = 0; k < 4 && ok; k++) {
+        if ((k != row && p[k] > p[row] * DET_REL_PEAK) || (4 + k != col && p[4 + k] > p[col] * DET_REL_PEAK)) {
+            ok = false;
+        }
+    }
+    ok = ok && (p[8 + row] < p[row] * DET_HARMONIC) && (p[8 + col] < p[col] * DET_HARMONIC);
+    // a sine of squared amplitude a carries a * n / 2 of block energy
+    ok = ok && ((p[row] + p[col]) * n / 2.0f >= energy * DET_PURITY);
+    // a burst shorter than the block leaves one half weak
+    float e1 = (float)bank->energy_half;
+    float e2 = energy - e1;
+    ok = ok && (e1 >= e2 * DET_EVEN) && (e2 >= e1 * DET_EVEN);
+    if (!ok) {
+        det->stats.rejected++;
+        return 0;
+    }
+    return s_dtmf_map[row][col - 4];
+}
+
+char audio_dtmf_det_process(audio_dtmf_det_t *det, const int16_t *pcm, uint32_t n) {
+    char found = 0;
+
+    for (uint32_t i = 0; i < n; i++) {
+        const int32_t x = pcm[i];
+        for (int b = 0; b < 2; b++) {
+            audio_dtmf_bank_t *bank = &det->bank[b];
+            for (int k = 0; k < AUDIO_DTMF_FILTERS; k++) {
+                int32_t s = x + (int32_t)(((int64_t)det->coef_q14[k] * bank->s1[k]) >> 14) - bank->s2[k];
+                bank->s2[k] = bank->s1[k];
+                bank->s1[k] = s;
+            }
+            bank->energy += x * x;
+
+            if (++bank->pos == det->block / 2) {
+                bank->energy_half = bank->energy;
+            }
+            if (bank->pos < det->block) {
+                continue;
+            }
+
+            char hit = dtmf_det_block(det, bank);
+            det->stats.blocks++;
+            // two agreeing decisions start a digit, two empty ones end it
+            if (hit && hit == det->last && hit != det->reported) {
+                det->reported = hit;
+                det->stats.digits++;
+                found = hit;
+            } else if (!hit && !det->last) {
+                det->reported = 0;
+            }
+            det->last = hit;
+            memset(bank, 0, sizeof(audio_dtmf_bank_t));
+        }
+    }
+    return found;
+}
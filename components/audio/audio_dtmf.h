@@ -0,0 +1,127 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef __AUDIO_DTMF_H__
+#define __AUDIO_DTMF_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "audio_tone.h"
+
+#define AUDIO_DTMF_ON_MS     (100) // tone length of a generated digit
+#define AUDIO_DTMF_GAP_MS    (60)  // pause after a generated digit
+#define AUDIO_DTMF_QUEUE     (32)  // digits waiting to be generated, must be a power of two
+#define AUDIO_DTMF_BLOCK_8K  (205) // detector block at 8 kHz, 25.6 ms, scaled with the sample rate
+#define AUDIO_DTMF_FILTERS   (16)  // 4 rows, 4 columns and their second harmonics
+
+/**
+ * @brief     DTMF generator, plays queued digits over the frames it is given
+ *
+ *            Digits are queued from one task and played from another, single producer and single consumer. Each
+ *            digit replaces the frame content for AUDIO_DTMF_ON_MS and lets it through for AUDIO_DTMF_GAP_MS, at
+ *            sample resolution across frame boundaries.
+ */
+typedef struct {
+    char queue[AUDIO_DTMF_QUEUE]; /*!< digits to play */
+    uint32_t head;                /*!< digits queued, written by the producer */
+    uint32_t tail;                /*!< digits taken, written by the consumer */
+    audio_tone_t tone;            /*!< dual tone of the current digit */
+    uint32_t sample_rate;
+    uint32_t on_left;             /*!< tone samples left of the current digit */
+    uint32_t gap_left;            /*!< pause samples left after it */
+    uint32_t played;              /*!< digits played */
+    uint32_t dropped;             /*!< digits refused on a full queue or unknown */
+} audio_dtmf_gen_t;
+
+typedef struct {
+    uint32_t blocks;    /*!< blocks analysed, two per block length */
+    uint32_t digits;    /*!< digits reported */
+    uint32_t rejected;  /*!< blocks with both tones present but failing twist, purity, harmonic or coverage checks */
+} audio_dtmf_stats_t;
+
+typedef struct {
+    int32_t s1[AUDIO_DTMF_FILTERS]; /*!< Goertzel state */
+    int32_t s2[AUDIO_DTMF_FILTERS];
+    int64_t energy;                 /*!< block energy */
+    int64_t energy_half;            /*!< energy of the first half of the block */
+    uint32_t pos;                   /*!< samples of the current block */
+} audio_dtmf_bank_t;
+
+/**
+ * @brief     Goertzel bank DTMF detector
+ *
+ *            Each block is checked for one row and one column tone above the level floor, within the twist limits,
+ *            standing clear of the other tones of its group, carrying most of the block energy and with weak second
+ *            harmonics, which speech has and DTMF does not. Two banks run half a block apart, so a decision comes every
+ *            half block while each keeps the frequency resolution of a whole one. A digit is reported after two
+ *            consecutive decisions agree, and reported again only after it has gone. A block only counts when both of
+ *            its halves carry energy within 3 dB of each other, so a burst must cover two overlapping blocks, about
+ *            40 ms, to be reported, and bursts under 25 ms never are.
+ */
+typedef struct {
+    int32_t coef_q14[AUDIO_DTMF_FILTERS]; /*!< 2 cos(2 pi f / fs) */
+    audio_dtmf_bank_t bank[2];            /*!< filters of the two overlapping blocks */
+    uint32_t block;                       /*!< samples per block */
+    char last;                            /*!< digit of the previous decision, 0 for none */
+    char reported;                        /*!< digit reported and still present */
+    audio_dtmf_stats_t stats;
+} audio_dtmf_det_t;
+
+/**
+ * @brief     true for 0-9, *, # and A-D
+ */
+bool audio_dtmf_valid(char digit);
+
+/**
+ * @brief     reset the generator for sample_rate (8000 or 16000), the queue is emptied
+ */
+void audio_dtmf_gen_init(audio_dtmf_gen_t *gen, uint32_t sample_rate);
+
+/**
+ * @brief     queue a digit, false if it is unknown or the queue is full
+ */
+bool audio_dtmf_gen_push(audio_dtmf_gen_t *gen, char digit);
+
+/**
+ * @brief     overwrite n samples with the queued digits while they play, true if any sample was replaced
+ */
+bool audio_dtmf_gen_fill(audio_dtmf_gen_t *gen, int16_t *pcm, uint32_t n);
+
+/**
+ * @brief     reset the detector for sample_rate (8000 or 16000)
+ */
+void audio_dtmf_det_init(audio_dtmf_det_t *det, uint32_t sample_rate);
+
+/**
+ * @brief     analyse n samples, returns a newly detected digit or 0
+ */
+char audio_dtmf_det_process(audio_dtmf_det_t *det, const int16_t *pcm, uint32_t n);
+
+#endif /* __AUDIO_DTMF_H__ */
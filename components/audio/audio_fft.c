@@ -0,0 +1,115 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "audio_fft.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+bool audio_fft_init(audio_fft_t *fft, uint32_t n) {
+    if (n < 2 || n > AUDIO_FFT_MAX || (n & (n - 1)) != 0) {
+        return false;
+    }
+
+    memset(fft, 0, sizeof(audio_fft_t));
+    fft->n = n;
+    while ((1u << fft->log2n) < n) {
+        fft->log2n++;
+    }
+    for (uint32_t k = 0; k < n / 2; k++) {
+        double a = 2.0 * M_PI * k / n;
+        fft->cos_q15[k] = (int16_t)lrint(fmin(cos(a) * 32768.0, 32767.0));
+        fft->sin_q15[k] = (int16_t)lrint(fmin(sin(a) * 32768.0, 32767.0));
+    }
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t r = 0;
+        for (uint32_t b = 0; b < fft->log2n; b++) {
+            r |= ((i >> b) & 1) << (fft->log2n - 1 - b);
+        }
+        fft->rev[i] = (uint16_t)r;
+    }
+    return true;
+}
+
+// decimation in time: bit reversed input, natural order output
+static void fft_run(const audio_fft_t *fft, int32_t *re, int32_t *im, bool inverse) {
+    const uint32_t n = fft->n;
+    const int32_t sign = inverse ? 1 : -1;
+
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t j = fft->rev[i];
+        if (j > i) {
+            int32_t t = re[i];
+            re[i] = re[j];
+            re[j] = t;
+            t = im[i];
+            im[i] = im[j];
+            im[j] = t;
+        }
+    }
+
+    for (uint32_t half = 1, step = n / 2; half < n; half <<= 1, step >>= 1) {
+        for (uint32_t k = 0; k < half; k++) {
+            // w = exp(sign * j 2 pi k / (2 half))
+            const int32_t wr = fft->cos_q15[k * step];
+            const int32_t wi = sign * fft->sin_q15[k * step];
+            for (uint32_t i = k; i < n; i += 2 * half) {
+                const uint32_t j = i + half;
+                int32_t tr = (int32_t)(((int64_t)re[j] * wr - (int64_t)im[j] * wi + (1 << 14)) >> 15);
+                int32_t ti = (int32_t)(((int64_t)re[j] * wi + (int64_t)im[j] * wr + (1 << 14)) >> 15);
+                if (inverse) {
+                    // halving every stage keeps the inverse at the input scale and inside 32 bits
+                    re[j] = (re[i] - tr) >> 1;
+                    im[j] = (im[i] - ti) >> 1;
+                    re[i] = (re[i] + tr) >> 1;
+                    im[i] = (im[i] + ti) >> 1;
+                } else {
+                    re[j] = re[i] - tr;
+                    im[j] = im[i] - ti;
+                    re[i] += tr;
+                    im[i] += ti;
+                }
+            }
+        }
+    }
+}
+
+void audio_fft_forward(const audio_fft_t *fft, int32_t *re, int32_t *im) {
+    fft_run(fft, re, im, false);
+}
+
+void audio_fft_inverse(const audio_fft_t *fft, int32_t *re, int32_t *im) {
+    fft_run(fft, re, im, true);
+}
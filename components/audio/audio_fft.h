@@ -0,0 +1,67 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef __AUDIO_FFT_H__
+#define __AUDIO_FFT_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define AUDIO_FFT_MAX (256) // largest transform, must be a power of two
+
+/**
+ * @brief     radix-2 complex FFT on int32 data with Q15 twiddles
+ *
+ *            The forward transform is unscaled: int16 input grows to at most n * 32768, which fits easily for n up to
+ *            AUDIO_FFT_MAX. The inverse halves every stage, so it returns the original scale.
+ */
+typedef struct {
+    int16_t cos_q15[AUDIO_FFT_MAX / 2]; /*!< cos(2 pi k / n) */
+    int16_t sin_q15[AUDIO_FFT_MAX / 2]; /*!< sin(2 pi k / n) */
+    uint16_t rev[AUDIO_FFT_MAX];        /*!< bit reversed index */
+    uint32_t n;                         /*!< transform length */
+    uint32_t log2n;                     /*!< number of stages */
+} audio_fft_t;
+
+/**
+ * @brief     build the tables for length n, a power of two up to AUDIO_FFT_MAX. Returns false for other lengths
+ */
+bool audio_fft_init(audio_fft_t *fft, uint32_t n);
+
+/**
+ * @brief     transform re/im in place, n values each
+ */
+void audio_fft_forward(const audio_fft_t *fft, int32_t *re, int32_t *im);
+
+/**
+ * @brief     inverse transform re/im in place, n values each, including the 1/n scaling
+ */
+void audio_fft_inverse(const audio_fft_t *fft, int32_t *re, int32_t *im);
+
+#endif /* __AUDIO_FFT_H__ */
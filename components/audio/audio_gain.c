@@ -0,0 +1,147 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "audio_gain.h"
+
+#define AGC_ATTACK_MS  (10)
+#define AGC_RELEASE_MS (400)
+#define AGC_UP_DB_S    (6.0f)  // slow boost, pumping is audible
+#define AGC_DOWN_DB_S  (40.0f) // fast cut, the limiter covers the frames in between
+
+static inline int16_t sat16(int32_t v) {
+    return (v > INT16_MAX) ? INT16_MAX : (v < INT16_MIN) ? INT16_MIN : (int16_t)v;
+}
+
+// AUDIO_GAIN_STEP_DB per step down from unity at step 15, step 0 mutes
+static const int16_t gain_step_q12[AUDIO_GAIN_STEPS] = {
+    0, 33, 46, 65, 92, 130, 183, 258, 365, 516, 728, 1029, 1453, 2053, 2900, 4096,
+};
+
+int32_t audio_gain_from_step(uint32_t step) {
+    return gain_step_q12[(step < AUDIO_GAIN_STEPS) ? step : AUDIO_GAIN_STEPS - 1];
+}
+
+int32_t audio_gain_from_db(float db) {
+    float g = powf(10.0f, db / 20.0f) * AUDIO_GAIN_ONE + 0.5f;
+    return (g > AUDIO_GAIN_MAX) ? AUDIO_GAIN_MAX : (int32_t)g;
+}
+
+void audio_gain_init(audio_gain_t *g, uint32_t sample_rate, int32_t gain) {
+    memset(g, 0, sizeof(audio_gain_t));
+    g->cur = gain;
+    g->target = gain;
+    g->slope_q8 = (int32_t)(((int64_t)AUDIO_GAIN_MAX << 8) * 1000 / (AUDIO_GAIN_RAMP_MS * sample_rate));
+}
+
+void audio_gain_set(audio_gain_t *g, int32_t gain) {
+    g->target = (gain < 0) ? 0 : (gain > AUDIO_GAIN_MAX) ? AUDIO_GAIN_MAX : gain;
+}
+
+void audio_gain_set_ceiling(audio_gain_t *g, int16_t ceiling) {
+    g->ceiling = (ceiling < 0) ? 0 : ceiling;
+}
+
+void audio_gain_process(audio_gain_t *g, int16_t *pcm, uint32_t n) {
+    int32_t target = g->target;
+
+    if (g->ceiling) {
+        int32_t peak = 0;
+        for (uint32_t i = 0; i < n; i++) {
+            int32_t a = (pcm[i] < 0) ? -pcm[i] : pcm[i];
+            peak = (a > peak) ? a : peak;
+        }
+        if (peak) {
+            int32_t allowed = (g->ceiling << 12) / peak;
+            // attack at the frame boundary, the release is the normal ramp back to the target
+            if (g->cur > allowed || target > allowed) {
+                g->limited++;
+                g->cur = (g->cur > allowed) ? allowed : g->cur;
+                target = (target > allowed) ? allowed : target;
+            }
+        }
+    }
+
+    if (g->cur == target) {
+        if (target != AUDIO_GAIN_ONE) {
+            const int32_t gain = target;
+            for (uint32_t i = 0; i < n; i++) {
+                pcm[i] = sat16((pcm[i] * gain + (1 << 11)) >> 12);
+            }
+        }
+        return;
+    }
+
+    // linear ramp with the frame, ends on target when the slope allows it
+    int32_t span = (int32_t)(((int64_t)g->slope_q8 * n) >> 8);
+    int32_t end = (target > g->cur) ? ((target - g->cur > span) ? g->cur + span : target) : ((g->cur - target > span) ? g->cur - span : target);
+    int32_t acc = g->cur << 8;
+    const int32_t step = ((end - g->cur) << 8) / (int32_t)n;
+    for (uint32_t i = 0; i < n; i++) {
+        acc += step;
+        pcm[i] = sat16((pcm[i] * (acc >> 8) + (1 << 11)) >> 12);
+    }
+    g->cur = end;
+}
+
+void audio_agc_init(audio_agc_t *agc, uint32_t sample_rate, uint32_t frame_samples) {
+    const float frame_s = (float)frame_samples / sample_rate;
+
+    memset(agc, 0, sizeof(audio_agc_t));
+    agc->level_db = AUDIO_AGC_TARGET_DBFS;
+    agc->attack = 1.0f - expf(-frame_s * 1000.0f / AGC_ATTACK_MS);
+    agc->release = 1.0f - expf(-frame_s * 1000.0f / AGC_RELEASE_MS);
+    agc->up_db = AGC_UP_DB_S * frame_s;
+    agc->down_db = AGC_DOWN_DB_S * frame_s;
+}
+
+int32_t audio_agc_process(audio_agc_t *agc, const int16_t *pcm, uint32_t n) {
+    int64_t energy = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        energy += (int32_t)pcm[i] * pcm[i];
+    }
+    float level = 10.0f * log10f((float)energy / n / (32768.0f * 32768.0f) + 1e-10f);
+
+    // silence and line noise must not be pulled up to speech level
+    if (level > AUDIO_AGC_GATE_DBFS) {
+        agc->level_db += ((level > agc->level_db) ? agc->attack : agc->release) * (level - agc->level_db);
+        float want = AUDIO_AGC_TARGET_DBFS - agc->level_db;
+        want = (want > AUDIO_AGC_MAX_DB) ? AUDIO_AGC_MAX_DB : (want < AUDIO_AGC_MIN_DB) ? AUDIO_AGC_MIN_DB : want;
+        if (want > agc->gain_db) {
+            agc->gain_db = (want - agc->gain_db > agc->up_db) ? agc->gain_db + agc->up_db : want;
+        } else {
+            agc->gain_db = (agc->gain_db - want > agc->down_db) ? agc->gain_db - agc->down_db : want;
+        }
+    }
+    return audio_gain_from_db(agc->gain_db);
+}
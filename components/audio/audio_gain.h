@@ -0,0 +1,113 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef __AUDIO_GAIN_H__
+#define __AUDIO_GAIN_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define AUDIO_GAIN_STEPS   (16)    // HFP volume steps 0..15, 0 mutes
+#define AUDIO_GAIN_STEP_DB (3)     // attenuation per step below the top one
+#define AUDIO_GAIN_ONE     (4096)  // unity, gains are Q12
+#define AUDIO_GAIN_MAX     (32767) // +18 dB, keeps sample * gain inside 32 bits
+#define AUDIO_GAIN_RAMP_MS (20)    // longest ramp, from mute to the largest gain
+
+#define AUDIO_AGC_TARGET_DBFS (-20) // speech level the AGC steers to
+#define AUDIO_AGC_MAX_DB      (18)  // largest boost
+#define AUDIO_AGC_MIN_DB      (-12) // largest cut
+#define AUDIO_AGC_GATE_DBFS   (-55) // frames quieter than this hold the gain
+
+/**
+ * @brief     saturating Q12 gain on whole frames, ramped linearly per sample between settings
+ *
+ *            With a ceiling set, the frame peak is checked before the gain is applied and the gain of that frame is
+ *            pulled down so the output stays under it: a limiter without look-ahead beyond the frame.
+ */
+typedef struct {
+    int32_t cur;       /*!< gain at the start of the next frame */
+    int32_t target;    /*!< gain the ramp heads to */
+    int32_t slope_q8;  /*!< largest change of the Q12 gain per sample, with 8 more fraction bits */
+    int32_t ceiling;   /*!< largest output peak, 0 without limiter */
+    uint32_t limited;  /*!< frames pulled down by the limiter */
+} audio_gain_t;
+
+/**
+ * @brief     level following AGC, one gain per frame in dB steered to AUDIO_AGC_TARGET_DBFS
+ */
+typedef struct {
+    float level_db;    /*!< smoothed frame level, dBFS */
+    float gain_db;     /*!< current gain */
+    float attack;      /*!< level smoothing when it rises */
+    float release;     /*!< level smoothing when it falls */
+    float up_db;       /*!< largest gain increase per frame */
+    float down_db;     /*!< largest gain decrease per frame */
+} audio_agc_t;
+
+/**
+ * @brief     Q12 gain of HFP volume step (0..15)
+ */
+int32_t audio_gain_from_step(uint32_t step);
+
+/**
+ * @brief     Q12 gain of db, clamped to 0..AUDIO_GAIN_MAX
+ */
+int32_t audio_gain_from_db(float db);
+
+/**
+ * @brief     start at gain (Q12) without ramp
+ */
+void audio_gain_init(audio_gain_t *g, uint32_t sample_rate, int32_t gain);
+
+/**
+ * @brief     ramp to gain (Q12) from the next frame on
+ */
+void audio_gain_set(audio_gain_t *g, int32_t gain);
+
+/**
+ * @brief     limit output peaks to ceiling, 0 to turn the limiter off
+ */
+void audio_gain_set_ceiling(audio_gain_t *g, int16_t ceiling);
+
+/**
+ * @brief     apply the gain to n samples in place
+ */
+void audio_gain_process(audio_gain_t *g, int16_t *pcm, uint32_t n);
+
+/**
+ * @brief     reset the AGC to 0 dB for frames of frame_samples at sample_rate
+ */
+void audio_agc_init(audio_agc_t *agc, uint32_t sample_rate, uint32_t frame_samples);
+
+/**
+ * @brief     measure one frame and return the AGC gain for it, Q12
+ */
+int32_t audio_agc_process(audio_agc_t *agc, const int16_t *pcm, uint32_t n);
+
+#endif /* __AUDIO_GAIN_H__ */
@@ -0,0 +1,149 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "audio_frame.h"
+#include "audio_jbuf.h"
+
+static void jbuf_frame_arrived(audio_jbuf_t *jb, int64_t now_us) {
+    jb->frames_in++;
+    if (jb->last_arrival_us != 0) {
+        int64_t delta = now_us - jb->last_arrival_us;
+        uint32_t dev = (uint32_t)((delta > PCM_BLOCK_DURATION_US) ? delta - PCM_BLOCK_DURATION_US : PCM_BLOCK_DURATION_US - delta);
+        uint32_t dev_q4 = dev << 4;
+
+        // RFC 3550 style smoothing for the steady state, decaying peak so a burst raises the target at once
+        jb->jitter_q4 += ((int32_t)dev_q4 - (int32_t)jb->jitter_q4) / 16;
+        jb->peak_q4 -= jb->peak_q4 / 64;
+        if (dev_q4 > jb->peak_q4) {
+            jb->peak_q4 = dev_q4;
+        }
+
+        uint32_t cover_us = ((jb->jitter_q4 * 2 > jb->peak_q4) ? jb->jitter_q4 * 2 : jb->peak_q4) >> 4;
+        uint32_t target = AUDIO_JBUF_MIN_DEPTH + (cover_us + PCM_BLOCK_DURATION_US - 1) / PCM_BLOCK_DURATION_US;
+        jb->target = (target > AUDIO_JBUF_MAX_DEPTH) ? AUDIO_JBUF_MAX_DEPTH : target;
+    }
+    jb->last_arrival_us = now_us;
+}
+
+void audio_jbuf_init(audio_jbuf_t *jb, uint32_t frame_size) {
+    memset(jb, 0, sizeof(audio_jbuf_t));
+    audio_ring_init(&jb->ring, frame_size);
+    jb->target = AUDIO_JBUF_MIN_DEPTH + 1;
+}
+
+void audio_jbuf_put(audio_jbuf_t *jb, const uint8_t *data, uint32_t len, int64_t now_us) {
+    const uint32_t frame_size = jb->ring.frame_size;
+    if (frame_size == 0) {
+        return;
+    }
+
+    while (len) {
+        if (jb->wr_off == 0) {
+            // a full ring keeps the frame alignment by discarding the whole frame
+            jb->wr = audio_ring_write_begin(&jb->ring);
+            if (jb->wr) {
+                audio_ring_write_tag(&jb->ring)->capture_us = (uint32_t)now_us;
+            }
+        }
+        uint32_t chunk = frame_size - jb->wr_off;
+        if (chunk > len) {
+            chunk = len;
+        }
+        if (jb->wr) {
+            memcpy(jb->wr + jb->wr_off, data, chunk);
+        }
+        data += chunk;
+        len -= chunk;
+        jb->wr_off += chunk;
+        if (jb->wr_off == frame_size) {
+            if (jb->wr) {
+                // numbered by arrival, frames discarded on a full ring keep their number
+                audio_ring_write_tag(&jb->ring)->seq = jb->frames_in;
+                audio_ring_write_tag(&jb->ring)->enqueue_us = (uint32_t)now_us;
+                audio_ring_write_commit(&jb->ring);
+            }
+            jb->wr = NULL;
+            jb->wr_off = 0;
+            jbuf_frame_arrived(jb, now_us);
+        }
+    }
+}
+
+uint8_t *audio_jbuf_get(audio_jbuf_t *jb) {
+    uint32_t depth = audio_ring_count(&jb->ring);
+    uint32_t target = jb->target;
+
+    if (!jb->playing) {
+        if (depth < target) {
+            return NULL;
+        }
+        jb->playing = true;
+        jb->hold = 0;
+    } else if (depth == 0) {
+        // play out again only once the buffer is back at target depth
+        jb->underruns++;
+        jb->playing = false;
+        return NULL;
+    }
+
+    if (depth > target + 1) {
+        if (++jb->hold >= AUDIO_JBUF_SHRINK_HOLD) {
+            audio_ring_read_commit(&jb->ring);
+            jb->drops++;
+            jb->hold = 0;
+        }
+    } else {
+        jb->hold = 0;
+    }
+
+    jb->frames_out++;
+    return (uint8_t *)audio_ring_read_begin(&jb->ring);
+}
+
+const audio_ring_tag_t *audio_jbuf_tag(const audio_jbuf_t *jb) {
+    return audio_ring_read_tag(&jb->ring);
+}
+
+void audio_jbuf_release(audio_jbuf_t *jb) {
+    audio_ring_read_commit(&jb->ring);
+}
+
+void audio_jbuf_get_stats(const audio_jbuf_t *jb, audio_jbuf_stats_t *stats) {
+    stats->frames_in = jb->frames_in;
+    stats->frames_out = jb->frames_out;
+    stats->underruns = jb->underruns;
+    stats->overruns = jb->ring.stats.overruns;
+    stats->drops = jb->drops;
+    stats->depth = audio_ring_count(&jb->ring);
+    stats->target = jb->target;
+    stats->jitter_us = jb->jitter_q4 >> 4;
+}
@@ -0,0 +1,108 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef __AUDIO_JBUF_H__
+#define __AUDIO_JBUF_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "audio_ring.h"
+
+#define AUDIO_JBUF_MIN_DEPTH   (1)                     // frames
+#define AUDIO_JBUF_MAX_DEPTH   (AUDIO_RING_FRAMES - 2) // frames
+#define AUDIO_JBUF_SHRINK_HOLD (32)                    // frames above target before one is dropped
+
+typedef struct {
+    uint32_t frames_in;  /*!< complete frames received */
+    uint32_t frames_out; /*!< frames handed to the consumer */
+    uint32_t underruns;  /*!< consumer found the buffer empty while playing */
+    uint32_t overruns;   /*!< frames dropped because the buffer was full */
+    uint32_t drops;      /*!< frames dropped to bring the depth back to target */
+    uint32_t depth;      /*!< frames currently buffered */
+    uint32_t target;     /*!< current target depth in frames */
+    uint32_t jitter_us;  /*!< smoothed arrival jitter */
+} audio_jbuf_stats_t;
+
+/**
+ * @brief     adaptive jitter buffer, the producer pushes arbitrary sized chunks and the consumer pulls whole frames
+ *
+ *            Only the producer calls audio_jbuf_put and only the consumer calls audio_jbuf_get/audio_jbuf_release.
+ */
+typedef struct {
+    audio_ring_t ring;
+    // producer side
+    uint8_t *wr;              /*!< slot being assembled, NULL while discarding */
+    uint32_t wr_off;          /*!< bytes of the current frame received so far */
+    int64_t last_arrival_us;  /*!< completion time of the previous frame, 0 before the first one */
+    uint32_t jitter_q4;       /*!< smoothed absolute arrival deviation, us Q4 */
+    uint32_t peak_q4;         /*!< decaying peak arrival deviation, us Q4 */
+    uint32_t frames_in;
+    volatile uint32_t target; /*!< target depth in frames */
+    // consumer side
+    bool playing;  /*!< prefill done, frames are being played out */
+    uint32_t hold; /*!< consecutive pulls with depth above target */
+    uint32_t frames_out;
+    uint32_t underruns;
+    uint32_t drops;
+} audio_jbuf_t;
+
+/**
+ * @brief     reset the buffer for frames of frame_size bytes, neither side may be running
+ */
+void audio_jbuf_init(audio_jbuf_t *jb, uint32_t frame_size);
+
+/**
+ * @brief     producer side: append len bytes that arrived at now_us
+ */
+void audio_jbuf_put(audio_jbuf_t *jb, const uint8_t *data, uint32_t len, int64_t now_us);
+
+/**
+ * @brief     consumer side: get the next frame, or NULL while prefilling or on underrun
+ *
+ *            The frame may be modified in place until audio_jbuf_release is called.
+ */
+uint8_t *audio_jbuf_get(audio_jbuf_t *jb);
+
+/**
+ * @brief     consumer side: timestamps of the frame returned by audio_jbuf_get, capture is its first byte received
+ */
+const audio_ring_tag_t *audio_jbuf_tag(const audio_jbuf_t *jb);
+
+/**
+ * @brief     consumer side: give back the frame returned by audio_jbuf_get
+ */
+void audio_jbuf_release(audio_jbuf_t *jb);
+
+/**
+ * @brief     snapshot of the buffer counters
+ */
+void audio_jbuf_get_stats(const audio_jbuf_t *jb, audio_jbuf_stats_t *stats);
+
+#endif /* __AUDIO_JBUF_H__ */
@@ -0,0 +1,157 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "audio_mixer.h"
+
+static inline int16_t sat16(int32_t v) {
+    return (v > INT16_MAX) ? INT16_MAX : (v < INT16_MIN) ? INT16_MIN : (int16_t)v;
+}
+
+static inline int32_t mixer_gain(int32_t gain) {
+    return (gain < 0) ? 0 : (gain > AUDIO_MIXER_GAIN_MAX) ? AUDIO_MIXER_GAIN_MAX : gain;
+}
+
+void audio_mixer_init(audio_mixer_t *mixer) {
+    memset(mixer, 0, sizeof(audio_mixer_t));
+}
+
+int audio_mixer_add(audio_mixer_t *mixer, audio_mixer_pull_t pull, audio_mixer_release_t release, void *ctx, uint8_t priority, int32_t gain,
+                    int32_t duck) {
+    if (mixer->count == AUDIO_MIXER_SOURCES || pull == NULL) {
+        return -1;
+    }
+
+    audio_mixer_source_t *src = &mixer->src[mixer->count];
+    memset(src, 0, sizeof(audio_mixer_source_t));
+    src->pull = pull;
+    src->release = release;
+    src->ctx = ctx;
+    src->priority = priority;
+    src->gain = mixer_gain(gain);
+    src->duck = (duck < 0) ? 0 : (duck > AUDIO_MIXER_ONE) ? AUDIO_MIXER_ONE : duck;
+    src->cur = src->gain;
+    return (int)mixer->count++;
+}
+
+void audio_mixer_enable(audio_mixer_t *mixer, int id, bool enable) {
+    if (id < 0 || (uint32_t)id >= mixer->count) {
+        return;
+    }
+    if (enable) {
+        __atomic_fetch_or(&mixer->enabled, 1u << id, __ATOMIC_RELEASE);
+    } else {
+        __atomic_fetch_and(&mixer->enabled, ~(1u << id), __ATOMIC_RELEASE);
+    }
+}
+
+void audio_mixer_set_gain(audio_mixer_t *mixer, int id, int32_t gain) {
+    if (id < 0 || (uint32_t)id >= mixer->count) {
+        return;
+    }
+    __atomic_store_n(&mixer->src[id].gain, mixer_gain(gain), __ATOMIC_RELAXED);
+}
+
+// first source of the frame stores, the others add; the gain ramps linearly from cur to end
+static void mixer_add(int32_t *acc, const int16_t *x, uint32_t n, int32_t cur, int32_t end, bool first) {
+    if (cur == end) {
+        if (first) {
+            for (uint32_t i = 0; i < n; i++) {
+                acc[i] = x[i] * end;
+            }
+        } else {
+            for (uint32_t i = 0; i < n; i++) {
+                acc[i] += x[i] * end;
+            }
+        }
+        return;
+    }
+
+    const int32_t step = ((end - cur) << 8) / (int32_t)n;
+    int32_t g = cur << 8;
+    for (uint32_t i = 0; i < n; i++) {
+        g += step;
+        acc[i] = (first ? 0 : acc[i]) + x[i] * (g >> 8);
+    }
+}
+
+uint32_t audio_mixer_mix(audio_mixer_t *mixer, int16_t *out, uint32_t n) {
+    const int16_t *frame[AUDIO_MIXER_SOURCES];
+    uint32_t pulled = 0;
+    int top = -1;
+
+    if (n > WBS_PCM_FRAME_SAMPLES) {
+        n = WBS_PCM_FRAME_SAMPLES;
+    }
+
+    // pull every enabled source first, ducking depends on who has a frame
+    for (uint32_t m = __atomic_load_n(&mixer->enabled, __ATOMIC_ACQUIRE); m; m &= m - 1) {
+        const int id = __builtin_ctz(m);
+        audio_mixer_source_t *src = &mixer->src[id];
+        frame[id] = src->pull(src->ctx, n);
+        if (frame[id] == NULL) {
+            continue;
+        }
+        pulled |= 1u << id;
+        top = (src->priority > top) ? src->priority : top;
+    }
+
+    uint32_t mixed = 0;
+    for (uint32_t m = pulled; m; m &= m - 1) {
+        const int id = __builtin_ctz(m);
+        audio_mixer_source_t *src = &mixer->src[id];
+        const int32_t gain = __atomic_load_n(&src->gain, __ATOMIC_RELAXED);
+        int32_t end = gain;
+        if (src->priority < top) {
+            end = (int32_t)(((int64_t)gain * src->duck) >> 12);
+            src->ducked++;
+        }
+        mixer_add(mixer->acc, frame[id], n, src->cur, end, mixed == 0);
+        src->cur = end;
+        src->frames++;
+        mixed++;
+        if (src->release) {
+            src->release(src->ctx);
+        }
+    }
+
+    mixer->frames++;
+    if (mixed == 0) {
+        mixer->empty++;
+        memset(out, 0, n * sizeof(int16_t));
+        return 0;
+    }
+    for (uint32_t i = 0; i < n; i++) {
+        out[i] = sat16((mixer->acc[i] + (1 << 11)) >> 12);
+    }
+    return mixed;
+}
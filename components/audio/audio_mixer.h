@@ -0,0 +1,108 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef __AUDIO_MIXER_H__
+#define __AUDIO_MIXER_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "audio_frame.h"
+
+#define AUDIO_MIXER_SOURCES  (8) // registered sources, bits of the enable mask
+#define AUDIO_MIXER_ONE      (4096) // unity source gain, Q12
+#define AUDIO_MIXER_GAIN_MAX (2 * AUDIO_MIXER_ONE) // +6 dB, keeps the sum of all sources inside 32 bits
+
+/**
+ * @brief     hand over the next frame of samples, NULL if the source has nothing this time.
+ *            The frame stays owned by the source and must stay valid until release
+ */
+typedef const int16_t *(*audio_mixer_pull_t)(void *ctx, uint32_t samples);
+
+/**
+ * @brief     the frame from the last pull has been mixed
+ */
+typedef void (*audio_mixer_release_t)(void *ctx);
+
+typedef struct {
+    audio_mixer_pull_t pull;       /*!< frame supplier */
+    audio_mixer_release_t release; /*!< optional, called after every frame pulled */
+    void *ctx;                     /*!< passed to pull and release */
+    int32_t gain;                  /*!< source gain, Q12 */
+    int32_t duck;                  /*!< gain under an active source of higher priority, Q12 */
+    int32_t cur;                   /*!< gain applied at the end of the last frame, Q12 */
+    uint8_t priority;              /*!< a frame from this source ducks every source of lower priority */
+    uint32_t frames;               /*!< frames mixed */
+    uint32_t ducked;               /*!< frames mixed under ducking */
+} audio_mixer_source_t;
+
+/**
+ * @brief     sums the enabled sources into one frame with per source gain and ducking
+ *
+ *            Sources are visited through a bit mask of the enabled ones, a disabled source costs nothing. Frames are
+ *            read where the source keeps them and summed in 32 bits; each source ramps its gain over the frame when it
+ *            changes, so ducking does not click. The result saturates to 16 bits once.
+ */
+typedef struct {
+    audio_mixer_source_t src[AUDIO_MIXER_SOURCES];
+    uint32_t count;                      /*!< sources registered */
+    uint32_t enabled;                    /*!< bit mask of the sources to pull, changed atomically */
+    int32_t acc[WBS_PCM_FRAME_SAMPLES];  /*!< 32 bit sum */
+    uint32_t frames;                     /*!< frames mixed */
+    uint32_t empty;                      /*!< frames without any source */
+} audio_mixer_t;
+
+/**
+ * @brief     remove all sources
+ */
+void audio_mixer_init(audio_mixer_t *mixer);
+
+/**
+ * @brief     register a disabled source, returns its id or -1 when full
+ */
+int audio_mixer_add(audio_mixer_t *mixer, audio_mixer_pull_t pull, audio_mixer_release_t release, void *ctx, uint8_t priority, int32_t gain,
+                    int32_t duck);
+
+/**
+ * @brief     enable or disable source id, safe from any task
+ */
+void audio_mixer_enable(audio_mixer_t *mixer, int id, bool enable);
+
+/**
+ * @brief     change the gain of source id (Q12, up to AUDIO_MIXER_GAIN_MAX), ramped in over the next frame
+ */
+void audio_mixer_set_gain(audio_mixer_t *mixer, int id, int32_t gain);
+
+/**
+ * @brief     mix n samples of the enabled sources into out, silence if none has a frame.
+ *            Returns the number of sources mixed
+ */
+uint32_t audio_mixer_mix(audio_mixer_t *mixer, int16_t *out, uint32_t n);
+
+#endif /* __AUDIO_MIXER_H__ */
@@ -0,0 +1,151 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "audio_ns.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define NS_RISE_DB_S  (4.0f)  // the noise floor climbs this fast while the signal stays above it
+#define NS_PSD_ALPHA  (0.4f)  // weight of the new frame in the smoothed power
+#define NS_OVER       (2.0f)  // the minimum of the smoothed power sits about 3 dB under the mean noise
+
+static inline int16_t sat16(int32_t v) {
+    return (v > INT16_MAX) ? INT16_MAX : (v < INT16_MIN) ? INT16_MIN : (int16_t)v;
+}
+
+void audio_ns_init(audio_ns_t *ns, uint32_t sample_rate) {
+    memset(ns, 0, sizeof(audio_ns_t));
+    ns->hop = (sample_rate >= 16000) ? WBS_PCM_FRAME_SAMPLES : PCM_FRAME_SAMPLES;
+
+    const uint32_t len = 2 * ns->hop;
+    uint32_t n = 2;
+    while (n < len) {
+        n <<= 1;
+    }
+    audio_fft_init(&ns->fft, n);
+    ns->bins = n / 2 + 1;
+
+    for (uint32_t i = 0; i < len; i++) {
+        ns->win_q15[i] = (int16_t)lrint(sin(M_PI * (i + 0.5) / len) * 32767.0);
+    }
+    ns->floor = powf(10.0f, AUDIO_NS_FLOOR_DB / 20.0f);
+    ns->rise = powf(10.0f, NS_RISE_DB_S / 10.0f * ns->hop / sample_rate);
+    // sum of the squared window (len / 2) times the power of a full scale sample
+    ns->full_scale = (float)ns->hop * 32768.0f * 32768.0f;
+}
+
+void audio_ns_process(audio_ns_t *ns, int16_t *pcm) {
+    const uint32_t hop = ns->hop;
+    const uint32_t len = 2 * hop;
+    const uint32_t n = ns->fft.n;
+    int32_t *re = ns->re;
+    int32_t *im = ns->im;
+
+    memmove(ns->in, ns->in + hop, hop * sizeof(int16_t));
+    memcpy(ns->in + hop, pcm, hop * sizeof(int16_t));
+    for (uint32_t i = 0; i < len; i++) {
+        re[i] = ((int32_t)ns->in[i] * ns->win_q15[i]) >> 15;
+        im[i] = 0;
+    }
+    for (uint32_t i = len; i < n; i++) {
+        re[i] = 0;
+        im[i] = 0;
+    }
+    audio_fft_forward(&ns->fft, re, im);
+
+    float p_in = 0.0f;
+    float p_out = 0.0f;
+    float p_noise = 0.0f;
+    for (uint32_t k = 0; k < ns->bins; k++) {
+        float p = (float)re[k] * re[k] + (float)im[k] * im[k];
+
+        ns->psd[k] += NS_PSD_ALPHA * (p - ns->psd[k]);
+        if (ns->stats.frames == 0 || ns->psd[k] < ns->noise[k]) {
+            ns->noise[k] = ns->psd[k];
+        } else {
+            ns->noise[k] *= ns->rise;
+        }
+
+        float noise = NS_OVER * ns->noise[k] + 1.0f;
+        float post = p / noise;
+        float prio = AUDIO_NS_DD_ALPHA * ns->clean[k] / noise + (1.0f - AUDIO_NS_DD_ALPHA) * ((post > 1.0f) ? post - 1.0f : 0.0f);
+        float g = prio / (1.0f + prio);
+        if (g < ns->floor) {
+            g = ns->floor;
+        }
+        ns->clean[k] = g * g * p;
+        p_in += p;
+        p_out += ns->clean[k];
+        p_noise += ns->noise[k];
+
+        // real input: bin n - k is the conjugate of bin k and takes the same gain
+        int32_t g_q15 = (int32_t)(g * 32767.0f);
+        re[k] = (int32_t)(((int64_t)re[k] * g_q15) >> 15);
+        im[k] = (int32_t)(((int64_t)im[k] * g_q15) >> 15);
+        if (k != 0 && k != n / 2) {
+            re[n - k] = (int32_t)(((int64_t)re[n - k] * g_q15) >> 15);
+            im[n - k] = (int32_t)(((int64_t)im[n - k] * g_q15) >> 15);
+        }
+    }
+    audio_fft_inverse(&ns->fft, re, im);
+
+    // the output frame is complete once the first half of this window is added to the tail of the last one
+    for (uint32_t i = 0; i < hop; i++) {
+        pcm[i] = sat16(ns->ola[i] + (((int64_t)re[i] * ns->win_q15[i]) >> 15));
+        ns->ola[i] = (int32_t)(((int64_t)re[hop + i] * ns->win_q15[hop + i]) >> 15);
+    }
+
+    ns->tail = true;
+    ns->stats.frames++;
+    ns->stats.noise_db = 10.0f * log10f((p_noise / ns->bins + 1.0f) / ns->full_scale);
+    ns->stats.atten_db = 10.0f * log10f((p_out + 1.0f) / (p_in + 1.0f));
+}
+
+bool audio_ns_skip(audio_ns_t *ns, int16_t *pcm) {
+    const bool tail = ns->tail;
+
+    memmove(ns->in, ns->in + ns->hop, ns->hop * sizeof(int16_t));
+    memcpy(ns->in + ns->hop, pcm, ns->hop * sizeof(int16_t));
+    // the second half of the last window is its frame fading out, played once before the overlap starts from silence
+    if (tail) {
+        for (uint32_t i = 0; i < ns->hop; i++) {
+            pcm[i] = sat16(ns->ola[i]);
+        }
+        ns->tail = false;
+    }
+    memset(ns->ola, 0, ns->hop * sizeof(int32_t));
+    return tail;
+}
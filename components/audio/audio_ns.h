@@ -0,0 +1,97 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef __AUDIO_NS_H__
+#define __AUDIO_NS_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "audio_fft.h"
+#include "audio_frame.h"
+
+#define AUDIO_NS_WIN_MAX   (2 * WBS_PCM_FRAME_SAMPLES) // analysis window, two frames
+#define AUDIO_NS_BINS_MAX  (AUDIO_FFT_MAX / 2 + 1)
+#define AUDIO_NS_FLOOR_DB  (-18) // deepest attenuation of a noise-only bin
+#define AUDIO_NS_DD_ALPHA  (0.96f) // decision-directed weight of the previous frame's clean estimate
+
+typedef struct {
+    uint32_t frames;      /*!< frames processed */
+    float noise_db;       /*!< noise floor estimate, dB full scale */
+    float atten_db;       /*!< mean attenuation applied over the last frame */
+} audio_ns_stats_t;
+
+/**
+ * @brief     Wiener noise suppressor, weighted overlap-add with a hop of one frame
+ *
+ *            A sine window of two frames is applied before the FFT and again after the inverse, the squared windows
+ *            sum to one at 50% overlap. Each output frame is finished once the next input frame has arrived, so the
+ *            suppressor adds exactly one frame of latency. The noise floor per bin follows drops at once and rises
+ *            slowly, so speech does not pull it up; the gain uses the decision-directed a priori SNR to avoid
+ *            musical noise.
+ */
+typedef struct {
+    audio_fft_t fft;
+    int16_t win_q15[AUDIO_NS_WIN_MAX];     /*!< sine window */
+    int16_t in[AUDIO_NS_WIN_MAX];          /*!< previous and current input frame */
+    int32_t ola[WBS_PCM_FRAME_SAMPLES];    /*!< second half of the previous output window */
+    int32_t re[AUDIO_FFT_MAX];             /*!< transform buffers */
+    int32_t im[AUDIO_FFT_MAX];
+    float psd[AUDIO_NS_BINS_MAX];          /*!< smoothed power per bin */
+    float noise[AUDIO_NS_BINS_MAX];        /*!< noise power per bin */
+    float clean[AUDIO_NS_BINS_MAX];        /*!< clean power estimate of the previous frame */
+    float floor;                           /*!< smallest gain */
+    float rise;                            /*!< per frame rise of the noise estimate */
+    float full_scale;                      /*!< bin power of full scale white noise */
+    uint32_t hop;                          /*!< samples per frame */
+    uint32_t bins;                         /*!< bins up to Nyquist */
+    bool tail;                             /*!< ola holds the end of the last processed frame, not yet played */
+    audio_ns_stats_t stats;
+} audio_ns_t;
+
+/**
+ * @brief     reset the suppressor for sample_rate (8000 or 16000), one frame per call
+ */
+void audio_ns_init(audio_ns_t *ns, uint32_t sample_rate);
+
+/**
+ * @brief     suppress noise in one frame in place, the output is the previous frame
+ */
+void audio_ns_process(audio_ns_t *ns, int16_t *pcm);
+
+/**
+ * @brief     take one frame into the history without processing it, for frames the caller replaces anyway.
+ *            The next processed frame starts its overlap-add from silence
+ *
+ *            The first skip after a processed frame replaces pcm with the end of that frame, faded out by the window,
+ *            and returns true: the caller plays it rather than replacing it, or the last frame of speech is cut.
+ */
+bool audio_ns_skip(audio_ns_t *ns, int16_t *pcm);
+
+#endif /* __AUDIO_NS_H__ */
@@ -0,0 +1,165 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "audio_plc.h"
+
+#define PLC_HOLD_MS (10) // full level repetition before fading starts
+#define PLC_FADE_MS (50) // fade to silence after the hold time
+
+// normalised cross-correlation pitch search over the newest frame of history, bounded cost per call
+static uint32_t plc_find_pitch(const audio_plc_t *plc) {
+    const int16_t *h = plc->hist;
+    const uint32_t n = plc->hist_len;
+    const uint32_t win = plc->frame_len;
+    const uint32_t d = plc->decim;
+    const int16_t *x = h + n - win;
+    uint32_t best = plc->pitch_max;
+    float best_score = 0.0f;
+
+    for (uint32_t lag = plc->pitch_min; lag <= plc->pitch_max; lag += d) {
+        const int16_t *y = x - lag;
+        int64_t c = 0;
+        int64_t e = 1;
+        for (uint32_t i = 0; i < win; i += d) {
+            c += (int32_t)x[i] * y[i];
+            e += (int32_t)y[i] * y[i];
+        }
+        if (c <= 0) {
+            continue;
+        }
+        float score = (float)c * (float)c / (float)e;
+        if (score > best_score) {
+            best_score = score;
+            best = lag;
+        }
+    }
+
+    // refine the decimated search at full resolution
+    if (d > 1) {
+        uint32_t center = best;
+        for (uint32_t lag = center - 1; lag <= center + 1; lag++) {
+            if (lag < plc->pitch_min || lag > plc->pitch_max) {
+                continue;
+            }
+            const int16_t *y = x - lag;
+            int64_t c = 0;
+            int64_t e = 1;
+            for (uint32_t i = 0; i < win; i++) {
+                c += (int32_t)x[i] * y[i];
+                e += (int32_t)y[i] * y[i];
+            }
+            float score = (c > 0) ? (float)c * (float)c / (float)e : 0.0f;
+            if (score > best_score) {
+                best_score = score;
+                best = lag;
+            }
+        }
+    }
+    return best;
+}
+
+static void plc_start(audio_plc_t *plc) {
+    const int16_t *h = plc->hist;
+    const uint32_t n = plc->hist_len;
+    const uint32_t p = plc_find_pitch(plc);
+    const uint32_t ola = p / 4;
+
+    // last period, with its tail faded into the period before so the wrap back to the start is continuous
+    memcpy(plc->period, h + n - p, p * sizeof(int16_t));
+    for (uint32_t i = 0; i < ola; i++) {
+        uint32_t k = p - ola + i;
+        int32_t w = (int32_t)(((i + 1) << 15) / (ola + 1));
+        plc->period[k] = (int16_t)((h[n - p + k] * (32768 - w) + h[n - 2 * p + k] * w) >> 15);
+    }
+    plc->pitch = p;
+    plc->pos = 0;
+    plc->gain_q15 = 32767;
+}
+
+static inline int16_t plc_next(audio_plc_t *plc) {
+    int16_t s = (int16_t)((plc->period[plc->pos] * plc->gain_q15) >> 15);
+    if (++plc->pos >= plc->pitch) {
+        plc->pos = 0;
+    }
+    return s;
+}
+
+static void plc_push_history(audio_plc_t *plc, const int16_t *frame) {
+    const uint32_t keep = plc->hist_len - plc->frame_len;
+    memmove(plc->hist, plc->hist + plc->frame_len, keep * sizeof(int16_t));
+    memcpy(plc->hist + keep, frame, plc->frame_len * sizeof(int16_t));
+}
+
+void audio_plc_init(audio_plc_t *plc, uint32_t sample_rate) {
+    const uint32_t scale = (sample_rate >= 16000) ? 1 : 2;
+
+    memset(plc, 0, sizeof(audio_plc_t));
+    plc->frame_len = (sample_rate >= 16000) ? WBS_PCM_FRAME_SAMPLES : PCM_FRAME_SAMPLES;
+    plc->pitch_min = AUDIO_PLC_PITCH_MIN / scale;
+    plc->pitch_max = AUDIO_PLC_PITCH_MAX / scale;
+    plc->hist_len = AUDIO_PLC_HIST_MAX / scale;
+    plc->decim = 2 / scale;
+    plc->gain_step = (int32_t)(32768 / (PLC_FADE_MS * sample_rate / 1000));
+}
+
+void audio_plc_process(audio_plc_t *plc, int16_t *frame, bool lost) {
+    const uint32_t len = plc->frame_len;
+    const uint32_t hold = PLC_HOLD_MS * (len * 1000000 / PCM_BLOCK_DURATION_US) / 1000;
+
+    if (lost) {
+        if (plc->lost_samples == 0) {
+            plc_start(plc);
+        }
+        for (uint32_t i = 0; i < len; i++) {
+            frame[i] = plc_next(plc);
+            if (plc->lost_samples + i >= hold && plc->gain_q15 > 0) {
+                plc->gain_q15 -= plc->gain_step;
+                if (plc->gain_q15 < 0) {
+                    plc->gain_q15 = 0;
+                }
+            }
+        }
+        plc->lost_samples += len;
+        plc->concealed++;
+    } else if (plc->lost_samples) {
+        // fade from the synthetic continuation into the real signal over half a frame
+        const uint32_t xfade = len / 2;
+        for (uint32_t i = 0; i < xfade; i++) {
+            int32_t w = (int32_t)(((i + 1) << 15) / (xfade + 1));
+            frame[i] = (int16_t)((frame[i] * w + plc_next(plc) * (32768 - w)) >> 15);
+        }
+        plc->lost_samples = 0;
+        plc->recovered++;
+    }
+
+    plc_push_history(plc, frame);
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef __AUDIO_PLC_H__
+#define __AUDIO_PLC_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "audio_frame.h"
+
+// pitch search range 66..400 Hz, expressed at 16 kHz
+#define AUDIO_PLC_PITCH_MIN (40)
+#define AUDIO_PLC_PITCH_MAX (240)
+#define AUDIO_PLC_HIST_MAX  (2 * AUDIO_PLC_PITCH_MAX)
+
+typedef struct {
+    int16_t hist[AUDIO_PLC_HIST_MAX];     /*!< last output samples, oldest first */
+    int16_t period[AUDIO_PLC_PITCH_MAX];  /*!< one pitch period with a smoothed wrap point */
+    uint32_t frame_len;                   /*!< samples per frame */
+    uint32_t hist_len;                    /*!< valid length of hist for the sample rate */
+    uint32_t pitch_min;                   /*!< shortest searched period in samples */
+    uint32_t pitch_max;                   /*!< longest searched period in samples */
+    uint32_t decim;                       /*!< search decimation, keeps the search cost equal at 8 and 16 kHz */
+    uint32_t pitch;                       /*!< period of the current concealment */
+    uint32_t pos;                         /*!< read position inside period */
+    uint32_t lost_samples;                /*!< samples concealed in the current loss burst */
+    int32_t gain_q15;                     /*!< current synthesis gain */
+    int32_t gain_step;                    /*!< per sample attenuation once fading starts */
+    uint32_t concealed;                   /*!< frames synthesised */
+    uint32_t recovered;                   /*!< loss bursts ended with a cross-fade */
+} audio_plc_t;
+
+/**
+ * @brief     reset the concealer for sample_rate (8000 or 16000)
+ */
+void audio_plc_init(audio_plc_t *plc, uint32_t sample_rate);
+
+/**
+ * @brief     run one frame through the concealer
+ *
+ *            lost: frame content is missing or bad, it is replaced in place by a synthetic frame.
+ *            Otherwise the frame is kept, and cross-faded from the synthetic signal if it ends a loss burst.
+ */
+void audio_plc_process(audio_plc_t *plc, int16_t *frame, bool lost);
+
+#endif /* __AUDIO_PLC_H__ */
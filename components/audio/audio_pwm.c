@@ -0,0 +1,150 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "audio_pwm.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define PWM_Q       (10)        // fraction bits of the duty domain
+#define PWM_MID     (AUDIO_PWM_LEVELS / 2 << PWM_Q)
+#define PWM_SWING   (14)        // levels either side of the middle at full scale, the rest is headroom for the shaper
+#define PWM_ERR_MAX (2 << PWM_Q) // bound of the fed back error, keeps the loop stable after an overload
+#define PWM_CUTOFF  (0.45)      // interpolation passband edge, fraction of the input rate
+
+// prototype low pass of taps * osr points at the output rate, split into osr phases of reversed taps
+static void pwm_build_filter(audio_pwm_t *pwm) {
+    const uint32_t len = AUDIO_PWM_TAPS * pwm->osr;
+    const double fc = PWM_CUTOFF / pwm->osr;
+    const double mid = (len - 1) / 2.0;
+    for (uint32_t p = 0; p < pwm->osr; p++) {
+        double h[AUDIO_PWM_TAPS], sum = 0;
+        for (uint32_t k = 0; k < AUDIO_PWM_TAPS; k++) {
+            double t = p + k * pwm->osr - mid;
+            double sinc = (t == 0) ? 2 * fc : sin(2 * M_PI * fc * t) / (M_PI * t);
+            double win = 0.42 + 0.5 * cos(2 * M_PI * t / len) + 0.08 * cos(4 * M_PI * t / len);
+            h[k] = sinc * win;
+            sum += h[k];
+        }
+        // unity gain on every phase, no ripple at the input sample rate
+        for (uint32_t k = 0; k < AUDIO_PWM_TAPS; k++) {
+            pwm->coef[p][AUDIO_PWM_TAPS - 1 - k] = (int16_t)lrint(h[k] / sum * 32767);
+        }
+    }
+}
+
+// a pulse of level ones centred in the word: any 16 bit half swap of the serial port still gives one pulse per period
+static void pwm_build_pulses(audio_pwm_t *pwm) {
+    for (uint32_t level = 0; level <= AUDIO_PWM_LEVELS; level++) {
+        uint32_t word = 0;
+        uint32_t start = (AUDIO_PWM_LEVELS - level) / 2;
+        for (uint32_t i = start; i < start + level; i++) {
+            word |= 1u << (AUDIO_PWM_LEVELS - 1 - i);
+        }
+        pwm->pulse[level] = word;
+    }
+}
+
+// triangular, one level peak, from a fixed LCG sequence
+static void pwm_build_dither(audio_pwm_t *pwm) {
+    uint32_t seed = 0x2545f491;
+    for (uint32_t i = 0; i < AUDIO_PWM_DITHER; i++) {
+        seed = seed * 1664525 + 1013904223;
+        int32_t a = (int32_t)(seed >> 22) - 512;
+        seed = seed * 1664525 + 1013904223;
+        int32_t b = (int32_t)(seed >> 22) - 512;
+        pwm->dither[i] = (int16_t)(a + b);
+    }
+}
+
+bool audio_pwm_init(audio_pwm_t *pwm, uint32_t sample_rate) {
+    memset(pwm, 0, sizeof(audio_pwm_t));
+    if (sample_rate == 0 || AUDIO_PWM_RATE % sample_rate != 0 || AUDIO_PWM_RATE / sample_rate > AUDIO_PWM_OSR_MAX) {
+        return false;
+    }
+    pwm->osr = AUDIO_PWM_RATE / sample_rate;
+    pwm_build_filter(pwm);
+    pwm_build_pulses(pwm);
+    pwm_build_dither(pwm);
+    return true;
+}
+
+uint32_t audio_pwm_convert(audio_pwm_t *pwm, const int16_t *pcm, uint32_t n, uint32_t *out) {
+    int32_t e1 = pwm->e1, e2 = pwm->e2;
+    uint32_t rnd = pwm->rnd;
+    uint32_t clipped = 0;
+
+    for (uint32_t i = 0; i < n; i++) {
+        int16_t x = pcm ? pcm[i] : 0;
+        pwm->hist[pwm->pos] = x;
+        pwm->hist[pwm->pos + AUDIO_PWM_TAPS] = x;
+        pwm->pos = (pwm->pos + 1) % AUDIO_PWM_TAPS;
+        // oldest to newest
+        const int16_t *w = &pwm->hist[pwm->pos];
+
+        for (uint32_t p = 0; p < pwm->osr; p++) {
+            const int16_t *c = pwm->coef[p];
+            int32_t acc = 0;
+            for (uint32_t k = 0; k < AUDIO_PWM_TAPS; k++) {
+                acc += c[k] * w[k];
+            }
+            int32_t s = acc >> 15;
+            s = (s > INT16_MAX) ? INT16_MAX : (s < INT16_MIN) ? INT16_MIN : s;
+
+            // y = u + (1 - z^-1)^2 e, the error is taken before the dither so the dither is shaped with it
+            int32_t v = PWM_MID + ((s * PWM_SWING) >> (15 - PWM_Q)) - 2 * e1 + e2;
+            int32_t y = (v + pwm->dither[rnd++ & (AUDIO_PWM_DITHER - 1)] + (1 << (PWM_Q - 1))) >> PWM_Q;
+            if (y < 0 || y > AUDIO_PWM_LEVELS) {
+                y = (y < 0) ? 0 : AUDIO_PWM_LEVELS;
+                clipped++;
+            }
+            int32_t e = (y << PWM_Q) - v;
+            e = (e > PWM_ERR_MAX) ? PWM_ERR_MAX : (e < -PWM_ERR_MAX) ? -PWM_ERR_MAX : e;
+            e2 = e1;
+            e1 = e;
+            *out++ = pwm->pulse[y];
+        }
+    }
+
+    pwm->e1 = e1;
+    pwm->e2 = e2;
+    pwm->rnd = rnd;
+    pwm->stats.frames++;
+    if (pcm == NULL) {
+        pwm->stats.silent++;
+    }
+    pwm->stats.clipped += clipped;
+    return n * pwm->osr;
+}
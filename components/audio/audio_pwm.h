@@ -0,0 +1,80 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef __AUDIO_PWM_H__
+#define __AUDIO_PWM_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define AUDIO_PWM_RATE    (128000) // PWM periods per second, whatever the sample rate
+#define AUDIO_PWM_LEVELS  (32)     // duty steps per period, one bit of a 32 bit serial word each
+#define AUDIO_PWM_OSR_MAX (16)     // periods per sample at 8 kHz
+#define AUDIO_PWM_TAPS    (8)      // interpolation filter taps per phase
+#define AUDIO_PWM_DITHER  (256)    // dither table entries, must be a power of two
+
+typedef struct {
+    uint32_t frames;  /*!< frames converted, silence included */
+    uint32_t silent;  /*!< frames converted from silence, the queue was empty */
+    uint32_t clipped; /*!< periods the shaper drove past 0 or full duty */
+} audio_pwm_stats_t;
+
+/**
+ * @brief     PCM to PWM duty converter with noise shaping
+ *
+ *            Each sample is interpolated to AUDIO_PWM_RATE by a polyphase filter, then quantised to one of
+ *            AUDIO_PWM_LEVELS + 1 duties by a second order error feedback loop that pushes the quantisation noise above
+ *            the audio band, where the output RC filter removes it. A duty is emitted as a 32 bit word holding a pulse
+ *            of that many one bits centred in the word, for a serial port clocked at 32 times AUDIO_PWM_RATE. Filter
+ *            phases, pulse words and dither are tables built at init.
+ */
+typedef struct {
+    int16_t coef[AUDIO_PWM_OSR_MAX][AUDIO_PWM_TAPS]; /*!< interpolation filter by output phase, Q15 */
+    uint32_t pulse[AUDIO_PWM_LEVELS + 1];            /*!< serial word of each duty */
+    int16_t dither[AUDIO_PWM_DITHER];                /*!< triangular dither, Q10 levels */
+    int16_t hist[2 * AUDIO_PWM_TAPS];                /*!< last input samples, mirrored so a window is contiguous */
+    uint32_t pos;                                    /*!< next slot of hist */
+    uint32_t osr;                                    /*!< periods per input sample */
+    int32_t e1;                                      /*!< quantisation error of the last period, Q10 levels */
+    int32_t e2;                                      /*!< quantisation error of the period before, Q10 levels */
+    uint32_t rnd;                                    /*!< dither table index */
+    audio_pwm_stats_t stats;
+} audio_pwm_t;
+
+/**
+ * @brief     build the tables for sample_rate, false unless it divides AUDIO_PWM_RATE into at most AUDIO_PWM_OSR_MAX
+ */
+bool audio_pwm_init(audio_pwm_t *pwm, uint32_t sample_rate);
+
+/**
+ * @brief     convert n samples (silence when pcm is NULL) into n * osr serial words, returns the number of words
+ */
+uint32_t audio_pwm_convert(audio_pwm_t *pwm, const int16_t *pcm, uint32_t n, uint32_t *out);
+
+#endif /* __AUDIO_PWM_H__ */
@@ -0,0 +1,171 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "audio_relay.h"
+
+// earliest next frame start without a queued frame, leaves room for the jitter of the sink
+#define RELAY_CONCEAL_US (PCM_BLOCK_DURATION_US * 3 / 4)
+
+bool audio_relay_init(audio_relay_t *relay, uint32_t src_rate, uint32_t dst_rate) {
+    memset(&relay->stats, 0, sizeof(audio_relay_stats_t));
+    audio_trace_reset(&relay->wait);
+    relay->src_size = 0;
+    relay->acc_len = 0;
+    relay->spare = 0;
+    relay->started = false;
+    if (src_rate == 0 || dst_rate == 0) {
+        audio_ring_init(&relay->ring, 0);
+        return true;
+    }
+    if ((src_rate != 8000 && src_rate != 16000) || (dst_rate != 8000 && dst_rate != 16000)) {
+        return false;
+    }
+    relay->convert = (src_rate != dst_rate);
+    if (relay->convert && !audio_resampler_init(&relay->rs, src_rate, dst_rate)) {
+        return false;
+    }
+    relay->dst_size = dst_rate / 1000 * PCM_BLOCK_DURATION_US / 1000 * BYTES_PER_SAMPLE;
+    audio_ring_init(&relay->ring, relay->dst_size);
+    audio_plc_init(&relay->plc, dst_rate);
+    // the first frame start loads a frame
+    relay->play_off = relay->dst_size;
+    relay->src_size = src_rate / 1000 * PCM_BLOCK_DURATION_US / 1000 * BYTES_PER_SAMPLE;
+    return true;
+}
+
+// a complete source frame, converted in place into the ring
+static void audio_relay_push(audio_relay_t *relay, uint32_t now_us) {
+    uint8_t *slot = audio_ring_write_begin(&relay->ring);
+    if (!slot) {
+        relay->stats.overruns++;
+        return;
+    }
+    audio_ring_tag_t *tag = audio_ring_write_tag(&relay->ring);
+    tag->seq = relay->stats.frames;
+    tag->capture_us = now_us;
+    if (relay->convert) {
+        uint32_t n = audio_resampler_process(&relay->rs, (const int16_t *)relay->acc, relay->src_size / BYTES_PER_SAMPLE, (int16_t *)slot,
+                                             relay->dst_size / BYTES_PER_SAMPLE);
+        // the 2:1 and 1:2 filters give exactly one sink frame per source frame, pad anything short
+        memset(slot + n * BYTES_PER_SAMPLE, 0, relay->dst_size - n * BYTES_PER_SAMPLE);
+    } else {
+        memcpy(slot, relay->acc, relay->dst_size);
+    }
+    tag->enqueue_us = now_us;
+    audio_ring_write_commit(&relay->ring);
+    relay->stats.frames++;
+}
+
+void audio_relay_put(audio_relay_t *relay, const uint8_t *buf, uint32_t sz, uint32_t now_us) {
+    if (relay->src_size == 0) {
+        return;
+    }
+    // packets need not be frame aligned, a CVSD frame usually comes in two
+    while (sz) {
+        uint32_t n = relay->src_size - relay->acc_len;
+        if (n > sz) {
+            n = sz;
+        }
+        memcpy(relay->acc + relay->acc_len, buf, n);
+        relay->acc_len += n;
+        buf += n;
+        sz -= n;
+        if (relay->acc_len == relay->src_size) {
+            audio_relay_push(relay, now_us);
+            relay->acc_len = 0;
+        }
+    }
+}
+
+// next sink frame into play, from the ring or from the concealer, false if it is too early to conceal
+static bool audio_relay_load(audio_relay_t *relay, uint32_t now_us) {
+    uint32_t queued = audio_ring_count(&relay->ring);
+    if (queued > 1) {
+        // a spare frame that never drains is a source running ahead of the sink, or a burst that never caught up
+        if (++relay->spare >= AUDIO_RELAY_TRIM_FRAMES) {
+            audio_ring_read_commit(&relay->ring);
+            relay->stats.dropped++;
+            relay->spare = 0;
+        }
+    } else {
+        relay->spare = 0;
+    }
+
+    const uint8_t *frame = audio_ring_read_begin(&relay->ring);
+    if (!frame && relay->started && now_us - relay->start_us < RELAY_CONCEAL_US) {
+        return false;
+    }
+    if (frame) {
+        audio_trace_add(&relay->wait, now_us - audio_ring_read_tag(&relay->ring)->capture_us, audio_ring_read_tag(&relay->ring)->seq);
+        memcpy(relay->play, frame, relay->dst_size);
+        audio_ring_read_commit(&relay->ring);
+        audio_plc_process(&relay->plc, relay->play, false);
+    } else {
+        relay->stats.concealed++;
+        audio_plc_process(&relay->plc, relay->play, true);
+    }
+    relay->play_off = 0;
+    relay->start_us = now_us;
+    relay->started = true;
+    relay->stats.played++;
+    return true;
+}
+
+uint32_t audio_relay_get(audio_relay_t *relay, uint8_t *buf, uint32_t sz, uint32_t now_us) {
+    if (relay->src_size == 0) {
+        return 0;
+    }
+    uint32_t len = 0;
+    while (sz) {
+        if (relay->play_off == relay->dst_size && !audio_relay_load(relay, now_us)) {
+            break;
+        }
+        uint32_t n = relay->dst_size - relay->play_off;
+        if (n > sz) {
+            n = sz;
+        }
+        memcpy(buf, (const uint8_t *)relay->play + relay->play_off, n);
+        relay->play_off += n;
+        buf += n;
+        sz -= n;
+        len += n;
+    }
+    return len;
+}
+
+uint32_t audio_relay_filter_us(const audio_relay_t *relay) {
+    if (relay->src_size == 0 || !relay->convert) {
+        return 0;
+    }
+    return audio_resampler_delay(&relay->rs) * 1000000 / relay->rs.out_rate;
+}
@@ -0,0 +1,102 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef __AUDIO_RELAY_H__
+#define __AUDIO_RELAY_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "audio_frame.h"
+#include "audio_plc.h"
+#include "audio_resample.h"
+#include "audio_ring.h"
+#include "audio_trace.h"
+
+#define AUDIO_RELAY_TRIM_FRAMES (128) // frame starts in a row with a spare frame queued before one is dropped, about 1 s
+
+typedef struct {
+    uint32_t frames;    /*!< frames completed by the source link */
+    uint32_t played;    /*!< frames started by the sink link */
+    uint32_t concealed; /*!< frames started with nothing queued, synthesised by the concealer */
+    uint32_t dropped;   /*!< queued frames dropped to hold the delay at one frame */
+    uint32_t overruns;  /*!< source frames lost on a full ring, the sink is not running */
+} audio_relay_stats_t;
+
+/**
+ * @brief     one direction of a relay between two SCO links
+ *
+ *            The incoming callback of the source link completes frames of the source rate, converts each one
+ *            to the sink rate straight into a ring slot and publishes it. The outgoing callback of the sink
+ *            link plays the oldest frame. The links run on unrelated clocks: a frame start with nothing queued is
+ *            concealed, and a spare frame that stays queued for AUDIO_RELAY_TRIM_FRAMES frame starts is
+ *            dropped, so a frame waits at most one frame period in the relay. Concealment is paced by time, a
+ *            sink that asks again before a frame period has passed gets nothing rather than synthetic audio.
+ */
+typedef struct {
+    audio_ring_t ring;                          /*!< converted frames, source callback to sink callback */
+    audio_resampler_t rs;                       /*!< source to sink rate, unused when they are equal */
+    bool convert;                               /*!< rates differ */
+    uint32_t src_size;                          /*!< bytes per source frame, 0 when the leg is stopped */
+    uint32_t dst_size;                          /*!< bytes per sink frame */
+    uint8_t acc[WBS_PCM_INPUT_DATA_SIZE] __attribute__((aligned(4)));  /*!< source frame being completed */
+    uint32_t acc_len;
+    int16_t play[WBS_PCM_FRAME_SAMPLES];        /*!< sink frame being played */
+    uint32_t play_off;                          /*!< bytes of play already handed to the sink */
+    audio_plc_t plc;
+    uint32_t spare;                             /*!< frame starts in a row that found a spare frame */
+    uint32_t start_us;                          /*!< last frame start */
+    bool started;
+    audio_trace_t wait;                         /*!< source frame complete to sink frame start */
+    audio_relay_stats_t stats;
+} audio_relay_t;
+
+/**
+ * @brief     reset the leg from src_rate to dst_rate (8000 or 16000), a rate of 0 stops it. Neither callback may be running
+ */
+bool audio_relay_init(audio_relay_t *relay, uint32_t src_rate, uint32_t dst_rate);
+
+/**
+ * @brief     source side: sz bytes received by the source link at now_us
+ */
+void audio_relay_put(audio_relay_t *relay, const uint8_t *buf, uint32_t sz, uint32_t now_us);
+
+/**
+ * @brief     sink side: fill up to sz bytes for the sink link at now_us, returns the bytes written
+ *
+ *            Less than sz is only written when the leg is stopped, or nothing is queued and it is too early to conceal.
+ */
+uint32_t audio_relay_get(audio_relay_t *relay, uint8_t *buf, uint32_t sz, uint32_t now_us);
+
+/**
+ * @brief     delay of the rate conversion in microseconds
+ */
+uint32_t audio_relay_filter_us(const audio_relay_t *relay);
+
+#endif /* __AUDIO_RELAY_H__ */
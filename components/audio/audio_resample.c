@@ -0,0 +1,242 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "audio_resample.h"
+
+#define FRAC_BASE_TAPS (20) // taps per output sample period of the lower rate
+#define FRAC_MIN_TAPS  (16)
+#define FRAC_CUTOFF    (0.45f)
+
+// Kaiser windowed lowpass at 0.225 fs (3.6 kHz at 16 kHz), 60 dB stopband from 4.4 kHz, Q15 with unity DC gain
+static const int16_t s_hb_coef[AUDIO_RS_HB_TAPS] = {
+    9,     6,     -24,   -27,   39,    72,    -43,   -145,  15,    244,   72,    -354,
+    -247,  442,   540,   -454,  -984,  307,   1640,  165,   -2737, -1551, 5867,  13532,
+    13532, 5867,  -1551, -2737, 165,   1640,  307,   -984,  -454,  540,   442,   -247,
+    -354,  72,    244,   15,    -145,  -43,   72,    39,    -27,   -24,   6,     9,
+};
+
+static inline int16_t sat16(int32_t v) {
+    if (v > INT16_MAX) {
+        return INT16_MAX;
+    }
+    if (v < INT16_MIN) {
+        return INT16_MIN;
+    }
+    return (int16_t)v;
+}
+
+static void frac_build_bank(audio_resampler_t *rs) {
+    const float ratio = (rs->out_rate < rs->in_rate) ? (float)rs->out_rate / rs->in_rate : 1.0f;
+    const float fc = FRAC_CUTOFF * ratio;
+    const float d = rs->taps / 2.0f;
+    float row[AUDIO_RS_MAX_TAPS];
+
+    for (uint32_t p = 0; p <= AUDIO_RS_PHASES; p++) {
+        float sum = 0.0f;
+        for (uint32_t k = 0; k < rs->taps; k++) {
+            float x = k + (float)p / AUDIO_RS_PHASES - d;
+            float sinc = (fabsf(x) < 1e-6f) ? 2.0f * fc : sinf(2.0f * (float)M_PI * fc * x) / ((float)M_PI * x);
+            float win = 0.42f + 0.5f * cosf((float)M_PI * x / d) + 0.08f * cosf(2.0f * (float)M_PI * x / d);
+            row[k] = (fabsf(x) < d) ? sinc * win : 0.0f;
+            sum += row[k];
+        }
+        // exact unity gain on every phase, so slow ratio changes do not modulate the level
+        for (uint32_t k = 0; k < rs->taps; k++) {
+            rs->coef[p * rs->taps + k] = (int16_t)lrintf(row[k] / sum * 16384.0f);
+        }
+    }
+}
+
+bool audio_resampler_init(audio_resampler_t *rs, uint32_t in_rate, uint32_t out_rate) {
+    if (in_rate == 0 || out_rate == 0 || in_rate > 8 * out_rate || out_rate > 8 * in_rate) {
+        return false;
+    }
+
+    memset(rs, 0, sizeof(audio_resampler_t));
+    rs->in_rate = in_rate;
+    rs->out_rate = out_rate;
+
+    if (in_rate == 2 * out_rate) {
+        rs->mode = AUDIO_RS_DOWN2;
+        rs->taps = AUDIO_RS_HB_TAPS;
+    } else if (out_rate == 2 * in_rate) {
+        rs->mode = AUDIO_RS_UP2;
+        rs->taps = AUDIO_RS_HB_TAPS / 2;
+    } else {
+        uint32_t taps = (in_rate > out_rate) ? FRAC_BASE_TAPS * in_rate / out_rate : FRAC_BASE_TAPS;
+        taps = (taps + 1) & ~1u;
+        rs->mode = AUDIO_RS_FRAC;
+        rs->taps = (taps < FRAC_MIN_TAPS) ? FRAC_MIN_TAPS : (taps > AUDIO_RS_MAX_TAPS) ? AUDIO_RS_MAX_TAPS : taps;
+        rs->base_step = ((uint64_t)in_rate << 32) / out_rate;
+        rs->step = rs->base_step;
+        frac_build_bank(rs);
+    }
+    rs->hist_len = rs->taps - 1;
+    return true;
+}
+
+void audio_resampler_set_ppb(audio_resampler_t *rs, int32_t ppb) {
+    if (rs->mode != AUDIO_RS_FRAC) {
+        return;
+    }
+    rs->step = rs->base_step + (int64_t)rs->base_step / 1000 * ppb / 1000000;
+}
+
+uint32_t audio_resampler_delay(const audio_resampler_t *rs) {
+    switch (rs->mode) {
+        case AUDIO_RS_DOWN2:
+            return AUDIO_RS_HB_TAPS / 4;
+        case AUDIO_RS_UP2:
+            return AUDIO_RS_HB_TAPS / 2;
+        default:
+            return (uint32_t)((uint64_t)rs->taps / 2 * rs->out_rate / rs->in_rate);
+    }
+}
+
+static uint32_t rs_down2(audio_resampler_t *rs, uint32_t n_in, int16_t *out, uint32_t out_max, uint32_t *used) {
+    const int16_t *x0 = rs->buf + rs->hist_len;
+    uint32_t n_out = 0;
+    uint32_t i;
+
+    for (i = rs->skip; i < n_in && n_out < out_max; i += 2) {
+        const int16_t *x = x0 + i;
+        int32_t acc = 0;
+        for (uint32_t k = 0; k < AUDIO_RS_HB_TAPS; k++) {
+            acc += x[-(int32_t)k] * s_hb_coef[k];
+        }
+        out[n_out++] = sat16(acc >> 15);
+    }
+    // a full out stops at the input of the next output, which then starts the block
+    *used = (i < n_in) ? i : n_in;
+    rs->skip = i - *used;
+    return n_out;
+}
+
+static uint32_t rs_up2(audio_resampler_t *rs, uint32_t n_in, int16_t *out, uint32_t out_max, uint32_t *used) {
+    const int16_t *x0 = rs->buf + rs->hist_len;
+    uint32_t n_out = 0;
+    uint32_t i;
+
+    for (i = 0; i < n_in && n_out + 2 <= out_max; i++) {
+        const int16_t *x = x0 + i;
+        int32_t even = 0;
+        int32_t odd = 0;
+        for (uint32_t j = 0; j < AUDIO_RS_HB_TAPS / 2; j++) {
+            even += x[-(int32_t)j] * s_hb_coef[2 * j];
+            odd += x[-(int32_t)j] * s_hb_coef[2 * j + 1];
+        }
+        // each phase carries half of the DC gain, zero stuffing needs twice
+        out[n_out++] = sat16(even >> 14);
+        out[n_out++] = sat16(odd >> 14);
+    }
+    *used = i;
+    return n_out;
+}
+
+static uint32_t rs_frac(audio_resampler_t *rs, uint32_t n_in, int16_t *out, uint32_t out_max, uint32_t *used) {
+    const int16_t *x0 = rs->buf + rs->hist_len;
+    const uint32_t taps = rs->taps;
+    uint32_t n_out = 0;
+
+    while (n_out < out_max) {
+        int32_t ip = (int32_t)(rs->pos >> 32);
+        if (ip >= (int32_t)n_in) {
+            break;
+        }
+        uint32_t frac = (uint32_t)rs->pos;
+        uint32_t ph = frac >> (32 - AUDIO_RS_PHASE_BITS);
+        int32_t w = (frac >> (32 - AUDIO_RS_PHASE_BITS - 15)) & 0x7fff;
+        const int16_t *x = x0 + ip;
+        const int16_t *c0 = rs->coef + ph * taps;
+        const int16_t *c1 = c0 + taps;
+        int32_t a = 0;
+        int32_t b = 0;
+        for (uint32_t k = 0; k < taps; k++) {
+            a += x[-(int32_t)k] * c0[k];
+            b += x[-(int32_t)k] * c1[k];
+        }
+        // linear interpolation between the two nearest phases of the bank
+        int32_t y = a + (int32_t)(((int64_t)(b - a) * w) >> 15);
+        out[n_out++] = sat16(y >> 14);
+        rs->pos += rs->step;
+    }
+    // the position never goes behind the block, its window stays inside the carried history
+    uint32_t ip = (uint32_t)(rs->pos >> 32);
+    *used = (ip < n_in) ? ip : n_in;
+    rs->pos -= (int64_t)*used << 32;
+    return n_out;
+}
+
+// append input behind the history and the samples a full out left unconverted, as much as the block takes
+static void rs_take(audio_resampler_t *rs, const int16_t **in, uint32_t *n_in) {
+    uint32_t n = AUDIO_RS_MAX_IN - rs->fill;
+    n = (n > *n_in) ? *n_in : n;
+    memcpy(rs->buf + rs->hist_len + rs->fill, *in, n * sizeof(int16_t));
+    rs->fill += n;
+    *in += n;
+    *n_in -= n;
+}
+
+uint32_t audio_resampler_process(audio_resampler_t *rs, const int16_t *in, uint32_t n_in, int16_t *out, uint32_t out_max) {
+    uint32_t n_out = 0;
+
+    for (;;) {
+        rs_take(rs, &in, &n_in);
+        if (rs->fill == 0) {
+            break;
+        }
+
+        uint32_t used;
+        switch (rs->mode) {
+            case AUDIO_RS_DOWN2:
+                n_out += rs_down2(rs, rs->fill, out + n_out, out_max - n_out, &used);
+                break;
+            case AUDIO_RS_UP2:
+                n_out += rs_up2(rs, rs->fill, out + n_out, out_max - n_out, &used);
+                break;
+            default:
+                n_out += rs_frac(rs, rs->fill, out + n_out, out_max - n_out, &used);
+                break;
+        }
+        rs->fill -= used;
+        memmove(rs->buf, rs->buf + used, (rs->hist_len + rs->fill) * sizeof(int16_t));
+
+        // out is full, the rest waits in the block for the next call
+        if (rs->fill) {
+            rs_take(rs, &in, &n_in);
+            rs->dropped += n_in;
+            break;
+        }
+    }
+    return n_out;
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef __AUDIO_RESAMPLE_H__
+#define __AUDIO_RESAMPLE_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define AUDIO_RS_MAX_IN      (360) // samples per call, 7.5 ms at 48 kHz
+#define AUDIO_RS_HB_TAPS     (48)  // 2:1 and 1:2 lowpass
+#define AUDIO_RS_PHASE_BITS  (5)
+#define AUDIO_RS_PHASES      (1 << AUDIO_RS_PHASE_BITS)
+#define AUDIO_RS_MAX_TAPS    (64) // arbitrary ratio filter, per phase
+#define AUDIO_RS_HIST_MAX    (AUDIO_RS_MAX_TAPS - 1)
+
+typedef enum {
+    AUDIO_RS_DOWN2 = 0, /*!< 2:1 decimation, e.g. 16 kHz mSBC to 8 kHz CVSD */
+    AUDIO_RS_UP2,       /*!< 1:2 interpolation, e.g. 8 kHz CVSD to 16 kHz mSBC */
+    AUDIO_RS_FRAC,      /*!< any other ratio, e.g. 44.1 or 48 kHz sources, or 1:1 with a ratio trim */
+} audio_rs_mode_t;
+
+/**
+ * @brief     fixed-point polyphase resampler, filter state is kept across calls and nothing is allocated
+ */
+typedef struct {
+    audio_rs_mode_t mode;
+    uint32_t in_rate;
+    uint32_t out_rate;
+    uint32_t taps;                                                /*!< taps per output sample */
+    uint32_t hist_len;                                            /*!< input samples carried to the next call */
+    uint32_t skip;                                                /*!< DOWN2: input samples to skip before the next output */
+    uint64_t base_step;                                           /*!< FRAC: nominal input advance per output, Q32 */
+    uint64_t step;                                                /*!< FRAC: input advance per output with the ratio trim, Q32 */
+    int64_t pos;                                                  /*!< FRAC: position of the next output in the current block, Q32 */
+    uint32_t fill;                                                /*!< input samples in the block, kept when out was full */
+    uint32_t dropped;                                             /*!< input samples lost, out was full and the block too */
+    int16_t buf[AUDIO_RS_HIST_MAX + AUDIO_RS_MAX_IN];             /*!< carried history followed by the current input */
+    int16_t coef[(AUDIO_RS_PHASES + 1) * AUDIO_RS_MAX_TAPS];      /*!< FRAC: Q14 polyphase bank, computed once at init */
+} audio_resampler_t;
+
+/**
+ * @brief     prepare a resampler from in_rate to out_rate, false if the ratio is not supported
+ */
+bool audio_resampler_init(audio_resampler_t *rs, uint32_t in_rate, uint32_t out_rate);
+
+/**
+ * @brief     convert n_in input samples, returns the number of samples written to out
+ *
+ *            A call fills out up to out_max. Input beyond what out could take stays in the converter, up to
+ *            AUDIO_RS_MAX_IN samples, and is converted first by the next call; input beyond that is lost and counted.
+ *            An out_max of n_in * out_rate / in_rate + 2 always takes the whole input.
+ */
+uint32_t audio_resampler_process(audio_resampler_t *rs, const int16_t *in, uint32_t n_in, int16_t *out, uint32_t out_max);
+
+/**
+ * @brief     trim the conversion ratio of a FRAC resampler by ppb parts per billion, positive consumes input faster
+ */
+void audio_resampler_set_ppb(audio_resampler_t *rs, int32_t ppb);
+
+/**
+ * @brief     delay added by the filter, in output samples
+ */
+uint32_t audio_resampler_delay(const audio_resampler_t *rs);
+
+#endif /* __AUDIO_RESAMPLE_H__ */
@@ -0,0 +1,117 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "audio_ring.h"
+
+#define RING_MASK (AUDIO_RING_FRAMES - 1)
+
+void audio_ring_init(audio_ring_t *ring, uint32_t frame_size) {
+    if (frame_size > AUDIO_RING_FRAME_MAX_SIZE) {
+        frame_size = AUDIO_RING_FRAME_MAX_SIZE;
+    }
+    ring->frame_size = frame_size;
+    ring->head = 0;
+    ring->tail = 0;
+    ring->rd_off = 0;
+    memset(&ring->stats, 0, sizeof(ring->stats));
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+uint32_t audio_ring_count(const audio_ring_t *ring) {
+    uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    return head - tail;
+}
+
+uint8_t *audio_ring_write_begin(audio_ring_t *ring) {
+    uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    if (ring->frame_size == 0 || ring->head - tail >= AUDIO_RING_FRAMES) {
+        ring->stats.overruns++;
+        return NULL;
+    }
+    return ring->frame[ring->head & RING_MASK];
+}
+
+audio_ring_tag_t *audio_ring_write_tag(audio_ring_t *ring) {
+    return &ring->tag[ring->head & RING_MASK];
+}
+
+void audio_ring_write_commit(audio_ring_t *ring) {
+    ring->stats.produced++;
+    __atomic_store_n(&ring->head, ring->head + 1, __ATOMIC_RELEASE);
+}
+
+const uint8_t *audio_ring_read_begin(audio_ring_t *ring) {
+    uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    if (ring->frame_size == 0 || head == ring->tail) {
+        return NULL;
+    }
+    return ring->frame[ring->tail & RING_MASK];
+}
+
+const audio_ring_tag_t *audio_ring_read_tag(const audio_ring_t *ring) {
+    return &ring->tag[ring->tail & RING_MASK];
+}
+
+void audio_ring_read_commit(audio_ring_t *ring) {
+    ring->rd_off = 0;
+    ring->stats.consumed++;
+    __atomic_store_n(&ring->tail, ring->tail + 1, __ATOMIC_RELEASE);
+}
+
+uint32_t audio_ring_read_bytes(audio_ring_t *ring, uint8_t *dst, uint32_t sz) {
+    if (ring->frame_size == 0) {
+        return 0;
+    }
+
+    uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    if ((head - ring->tail) * ring->frame_size - ring->rd_off < sz) {
+        // data not enough, do not read
+        ring->stats.underruns++;
+        return 0;
+    }
+
+    uint32_t done = 0;
+    while (done < sz) {
+        uint32_t chunk = ring->frame_size - ring->rd_off;
+        if (chunk > sz - done) {
+            chunk = sz - done;
+        }
+        memcpy(dst + done, ring->frame[ring->tail & RING_MASK] + ring->rd_off, chunk);
+        done += chunk;
+        ring->rd_off += chunk;
+        if (ring->rd_off == ring->frame_size) {
+            audio_ring_read_commit(ring);
+        }
+    }
+    return sz;
+}
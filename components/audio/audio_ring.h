@@ -0,0 +1,114 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef __AUDIO_RING_H__
+#define __AUDIO_RING_H__
+
+#include <stdint.h>
+
+#include "audio_frame.h"
+
+#define AUDIO_RING_FRAMES         (16) // must be a power of two
+#define AUDIO_RING_FRAME_MAX_SIZE (WBS_PCM_INPUT_DATA_SIZE)
+
+typedef struct {
+    uint32_t produced;  /*!< frames committed by the producer */
+    uint32_t consumed;  /*!< frames released by the consumer */
+    uint32_t overruns;  /*!< producer found the ring full */
+    uint32_t underruns; /*!< consumer asked for more data than available */
+} audio_ring_stats_t;
+
+typedef struct {
+    uint32_t seq;        /*!< frame number, set by the producer */
+    uint32_t capture_us; /*!< content generated or first byte received, set by the producer */
+    uint32_t enqueue_us; /*!< frame complete, set by the producer */
+} audio_ring_tag_t;
+
+/**
+ * @brief     single-producer/single-consumer ring of fixed size SCO frames
+ *
+ *            The producer fills a slot in place between write_begin/write_commit and the consumer reads it
+ *            in place, so no frame is ever copied or allocated on the way through the ring.
+ */
+typedef struct {
+    uint8_t frame[AUDIO_RING_FRAMES][AUDIO_RING_FRAME_MAX_SIZE] __attribute__((aligned(4)));
+    audio_ring_tag_t tag[AUDIO_RING_FRAMES]; /*!< timestamps travelling with each frame */
+    uint32_t frame_size; /*!< bytes per frame, 0 when the ring is not in use */
+    uint32_t head;       /*!< next slot to write, owned by the producer */
+    uint32_t tail;       /*!< next slot to read, owned by the consumer */
+    uint32_t rd_off;     /*!< consumer byte offset inside frame[tail] */
+    audio_ring_stats_t stats;
+} audio_ring_t;
+
+/**
+ * @brief     reset the ring for frames of frame_size bytes (0 disables it), neither side may be running
+ */
+void audio_ring_init(audio_ring_t *ring, uint32_t frame_size);
+
+/**
+ * @brief     producer side: get the next free slot, or NULL if the ring is full
+ */
+uint8_t *audio_ring_write_begin(audio_ring_t *ring);
+
+/**
+ * @brief     producer side: publish the slot returned by audio_ring_write_begin
+ */
+void audio_ring_write_commit(audio_ring_t *ring);
+
+/**
+ * @brief     producer side: tag of the slot returned by audio_ring_write_begin, published with the frame
+ */
+audio_ring_tag_t *audio_ring_write_tag(audio_ring_t *ring);
+
+/**
+ * @brief     consumer side: get the oldest complete frame, or NULL if the ring is empty
+ */
+const uint8_t *audio_ring_read_begin(audio_ring_t *ring);
+
+/**
+ * @brief     consumer side: release the frame returned by audio_ring_read_begin
+ */
+void audio_ring_read_commit(audio_ring_t *ring);
+
+/**
+ * @brief     consumer side: tag of the oldest complete frame, only valid while the ring is not empty
+ */
+const audio_ring_tag_t *audio_ring_read_tag(const audio_ring_t *ring);
+
+/**
+ * @brief     consumer side: copy exactly sz bytes of the stream into dst, returns sz or 0 if not enough data
+ */
+uint32_t audio_ring_read_bytes(audio_ring_t *ring, uint8_t *dst, uint32_t sz);
+
+/**
+ * @brief     number of committed frames not yet released
+ */
+uint32_t audio_ring_count(const audio_ring_t *ring);
+
+#endif /* __AUDIO_RING_H__ */
@@ -0,0 +1,157 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "audio_tone.h"
+
+#define SINE_LUT_BITS (8)
+#define SINE_LUT_SIZE (1 << SINE_LUT_BITS)
+
+// one sine period in Q15, with a guard entry for the interpolation of the last step
+static const int16_t s_sine_lut[SINE_LUT_SIZE + 1] = {
+    0,      804,    1608,   2410,   3212,   4011,   4808,   5602,   6393,   7179,   7962,   8739,   9512,   10278,  11039,  11793,
+    12539,  13279,  14010,  14732,  15446,  16151,  16846,  17530,  18204,  18868,  19519,  20159,  20787,  21403,  22005,  22594,
+    23170,  23731,  24279,  24811,  25329,  25832,  26319,  26790,  27245,  27683,  28105,  28510,  28898,  29268,  29621,  29956,
+    30273,  30571,  30852,  31113,  31356,  31580,  31785,  31971,  32137,  32285,  32412,  32521,  32609,  32678,  32728,  32757,
+    32767,  32757,  32728,  32678,  32609,  32521,  32412,  32285,  32137,  31971,  31785,  31580,  31356,  31113,  30852,  30571,
+    30273,  29956,  29621,  29268,  28898,  28510,  28105,  27683,  27245,  26790,  26319,  25832,  25329,  24811,  24279,  23731,
+    23170,  22594,  22005,  21403,  20787,  20159,  19519,  18868,  18204,  17530,  16846,  16151,  15446,  14732,  14010,  13279,
+    12539,  11793,  11039,  10278,  9512,   8739,   7962,   7179,   6393,   5602,   4808,   4011,   3212,   2410,   1608,   804,
+    0,      -804,   -1608,  -2410,  -3212,  -4011,  -4808,  -5602,  -6393,  -7179,  -7962,  -8739,  -9512,  -10278, -11039, -11793,
+    -12539, -13279, -14010, -14732, -15446, -16151, -16846, -17530, -18204, -18868, -19519, -20159, -20787, -21403, -22005, -22594,
+    -23170, -23731, -24279, -24811, -25329, -25832, -26319, -26790, -27245, -27683, -28105, -28510, -28898, -29268, -29621, -29956,
+    -30273, -30571, -30852, -31113, -31356, -31580, -31785, -31971, -32137, -32285, -32412, -32521, -32609, -32678, -32728, -32757,
+    -32767, -32757, -32728, -32678, -32609, -32521, -32412, -32285, -32137, -31971, -31785, -31580, -31356, -31113, -30852, -30571,
+    -30273, -29956, -29621, -29268, -28898, -28510, -28105, -27683, -27245, -26790, -26319, -25832, -25329, -24811, -24279, -23731,
+    -23170, -22594, -22005, -21403, -20787, -20159, -19519, -18868, -18204, -17530, -16846, -16151, -15446, -14732, -14010, -13279,
+    -12539, -11793, -11039, -10278, -9512,  -8739,  -7962,  -7179,  -6393,  -5602,  -4808,  -4011,  -3212,  -2410,  -1608,  -804,
+    0,
+};
+
+static const audio_tone_spec_t s_tone_presets[AUDIO_TONE_MAX] = {
+    [AUDIO_TONE_TEST] = { .freq = { 400, 0 }, .level = { 16384, 0 }, .cadence_ms = { 0 } },
+    [AUDIO_TONE_DIAL] = { .freq = { 350, 440 }, .level = { 8192, 8192 }, .cadence_ms = { 0 } },
+    [AUDIO_TONE_RINGBACK] = { .freq = { 440, 480 }, .level = { 8192, 8192 }, .cadence_ms = { 2000, 4000 } },
+    [AUDIO_TONE_BUSY] = { .freq = { 480, 620 }, .level = { 8192, 8192 }, .cadence_ms = { 500, 500 } },
+    [AUDIO_TONE_CONGESTION] = { .freq = { 480, 620 }, .level = { 8192, 8192 }, .cadence_ms = { 250, 250 } },
+};
+
+static inline int32_t sine_q15(uint32_t phase) {
+    uint32_t idx = phase >> (32 - SINE_LUT_BITS);
+    int32_t frac = (phase >> (32 - SINE_LUT_BITS - 15)) & 0x7fff;
+    int32_t a = s_sine_lut[idx];
+    return a + (((s_sine_lut[idx + 1] - a) * frac) >> 15);
+}
+
+static inline int16_t sat16(int32_t v) {
+    if (v > INT16_MAX) {
+        return INT16_MAX;
+    }
+    if (v < INT16_MIN) {
+        return INT16_MIN;
+    }
+    return (int16_t)v;
+}
+
+static void tone_synth(audio_tone_t *tone, int16_t *out, uint32_t n) {
+    uint32_t p0 = tone->phase[0];
+    uint32_t p1 = tone->phase[1];
+    const uint32_t s0 = tone->step[0];
+    const uint32_t s1 = tone->step[1];
+    const int32_t l0 = tone->level[0];
+    const int32_t l1 = tone->level[1];
+
+    if (s1 == 0) {
+        for (uint32_t i = 0; i < n; i++) {
+            out[i] = sat16((sine_q15(p0) * l0) >> 15);
+            p0 += s0;
+        }
+    } else {
+        for (uint32_t i = 0; i < n; i++) {
+            out[i] = sat16((sine_q15(p0) * l0 + sine_q15(p1) * l1) >> 15);
+            p0 += s0;
+            p1 += s1;
+        }
+    }
+
+    tone->phase[0] = p0;
+    tone->phase[1] = p1;
+}
+
+const audio_tone_spec_t *audio_tone_preset(audio_tone_id_t id) {
+    if (id >= AUDIO_TONE_MAX) {
+        return NULL;
+    }
+    return &s_tone_presets[id];
+}
+
+void audio_tone_init(audio_tone_t *tone, const audio_tone_spec_t *spec, uint32_t sample_rate) {
+    memset(tone, 0, sizeof(audio_tone_t));
+    for (int i = 0; i < 2; i++) {
+        // keep the generator alias free
+        if (spec->freq[i] == 0 || spec->freq[i] >= sample_rate / 2) {
+            continue;
+        }
+        tone->step[i] = (uint32_t)(((uint64_t)spec->freq[i] << 32) / sample_rate);
+        tone->level[i] = spec->level[i];
+    }
+    for (int i = 0; i < AUDIO_TONE_CADENCE_MAX && spec->cadence_ms[i]; i++) {
+        tone->cadence[i] = (uint32_t)spec->cadence_ms[i] * sample_rate / 1000;
+        tone->seg_num++;
+    }
+    tone->seg_left = tone->cadence[0];
+}
+
+void audio_tone_fill(audio_tone_t *tone, int16_t *out, uint32_t samples) {
+    if (tone->seg_num == 0) {
+        tone_synth(tone, out, samples);
+        return;
+    }
+
+    while (samples) {
+        uint32_t n = (tone->seg_left < samples) ? tone->seg_left : samples;
+        if ((tone->seg & 1) == 0) {
+            tone_synth(tone, out, n);
+        } else {
+            memset(out, 0, n * sizeof(int16_t));
+        }
+        out += n;
+        samples -= n;
+        tone->seg_left -= n;
+        if (tone->seg_left == 0) {
+            tone->seg = (tone->seg + 1 < tone->seg_num) ? tone->seg + 1 : 0;
+            tone->seg_left = tone->cadence[tone->seg];
+            // restart bursts at zero phase so every on segment starts without a click
+            tone->phase[0] = 0;
+            tone->phase[1] = 0;
+        }
+    }
+}
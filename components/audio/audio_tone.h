@@ -0,0 +1,77 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef __AUDIO_TONE_H__
+#define __AUDIO_TONE_H__
+
+#include <stdint.h>
+
+#define AUDIO_TONE_CADENCE_MAX (4)
+
+typedef enum {
+    AUDIO_TONE_TEST = 0,   /*!< 400 Hz continuous */
+    AUDIO_TONE_DIAL,       /*!< 350 + 440 Hz continuous */
+    AUDIO_TONE_RINGBACK,   /*!< 440 + 480 Hz, 2 s on / 4 s off */
+    AUDIO_TONE_BUSY,       /*!< 480 + 620 Hz, 0.5 s on / 0.5 s off */
+    AUDIO_TONE_CONGESTION, /*!< 480 + 620 Hz, 0.25 s on / 0.25 s off */
+    AUDIO_TONE_MAX,
+} audio_tone_id_t;
+
+typedef struct {
+    uint16_t freq[2];                            /*!< tone frequencies in Hz, freq[1] = 0 for a single tone */
+    int16_t level[2];                            /*!< Q15 amplitude of each tone */
+    uint16_t cadence_ms[AUDIO_TONE_CADENCE_MAX]; /*!< on, off, on, off durations in ms, cadence_ms[0] = 0 for continuous */
+} audio_tone_spec_t;
+
+typedef struct {
+    uint32_t phase[2];                        /*!< Q32 phase accumulators */
+    uint32_t step[2];                         /*!< Q32 phase increment per sample */
+    int16_t level[2];                         /*!< Q15 amplitudes */
+    uint32_t cadence[AUDIO_TONE_CADENCE_MAX]; /*!< cadence segments in samples */
+    uint8_t seg_num;                          /*!< number of cadence segments, 0 for continuous */
+    uint8_t seg;                              /*!< current cadence segment, even segments are on */
+    uint32_t seg_left;                        /*!< samples left in the current segment */
+} audio_tone_t;
+
+/**
+ * @brief     get the spec of a built-in call progress tone
+ */
+const audio_tone_spec_t *audio_tone_preset(audio_tone_id_t id);
+
+/**
+ * @brief     prepare a generator for spec at sample_rate (8000 or 16000)
+ */
+void audio_tone_init(audio_tone_t *tone, const audio_tone_spec_t *spec, uint32_t sample_rate);
+
+/**
+ * @brief     render the next samples of the tone, cadence included
+ */
+void audio_tone_fill(audio_tone_t *tone, int16_t *out, uint32_t samples);
+
+#endif /* __AUDIO_TONE_H__ */
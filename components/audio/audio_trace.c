@@ -0,0 +1,88 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "audio_trace.h"
+
+void audio_trace_reset(audio_trace_t *tr) {
+    memset(tr, 0, sizeof(audio_trace_t));
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+void audio_trace_add(audio_trace_t *tr, uint32_t us, uint32_t seq) {
+    uint32_t b = us / AUDIO_TRACE_BUCKET_US;
+    if (b >= AUDIO_TRACE_BUCKETS) {
+        b = AUDIO_TRACE_BUCKETS - 1;
+    }
+    __atomic_fetch_add(&tr->bucket[b], 1, __ATOMIC_RELAXED);
+
+    uint32_t worst = __atomic_load_n(&tr->worst_us, __ATOMIC_RELAXED);
+    while (us > worst) {
+        if (__atomic_compare_exchange_n(&tr->worst_us, &worst, us, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            // the frame number may belong to a concurrent, equally bad frame, good enough to find it in a log
+            __atomic_store_n(&tr->worst_seq, seq, __ATOMIC_RELAXED);
+            break;
+        }
+    }
+}
+
+uint32_t audio_trace_count(const audio_trace_t *tr) {
+    uint32_t n = 0;
+    for (uint32_t b = 0; b < AUDIO_TRACE_BUCKETS; b++) {
+        n += __atomic_load_n(&tr->bucket[b], __ATOMIC_RELAXED);
+    }
+    return n;
+}
+
+uint32_t audio_trace_percentile(const audio_trace_t *tr, uint32_t permille) {
+    uint32_t snap[AUDIO_TRACE_BUCKETS];
+    uint64_t n = 0;
+
+    // work on a snapshot, so the total and the walk below see the same counts
+    for (uint32_t b = 0; b < AUDIO_TRACE_BUCKETS; b++) {
+        snap[b] = __atomic_load_n(&tr->bucket[b], __ATOMIC_RELAXED);
+        n += snap[b];
+    }
+    if (n == 0) {
+        return 0;
+    }
+
+    uint64_t rank = (n * permille + 999) / 1000;
+    uint64_t seen = 0;
+    for (uint32_t b = 0; b < AUDIO_TRACE_BUCKETS; b++) {
+        seen += snap[b];
+        if (seen >= rank) {
+            return (b + 1) * AUDIO_TRACE_BUCKET_US;
+        }
+    }
+    return AUDIO_TRACE_BUCKETS * AUDIO_TRACE_BUCKET_US;
+}
@@ -0,0 +1,70 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef __AUDIO_TRACE_H__
+#define __AUDIO_TRACE_H__
+
+#include <stdint.h>
+
+#define AUDIO_TRACE_BUCKET_US (250) // histogram resolution
+#define AUDIO_TRACE_BUCKETS   (128) // covers 32 ms, the last bucket also holds everything above
+
+/**
+ * @brief     fixed-bucket latency histogram
+ *
+ *            audio_trace_add only does atomic increments, so any number of tasks and callbacks may record into the
+ *            same histogram while another one reads it, without a lock on the audio path.
+ */
+typedef struct {
+    uint32_t bucket[AUDIO_TRACE_BUCKETS];
+    uint32_t worst_us;  /*!< highest latency recorded */
+    uint32_t worst_seq; /*!< frame number of the worst latency */
+} audio_trace_t;
+
+/**
+ * @brief     clear the histogram, samples recorded concurrently may be lost
+ */
+void audio_trace_reset(audio_trace_t *tr);
+
+/**
+ * @brief     record the latency us of frame seq
+ */
+void audio_trace_add(audio_trace_t *tr, uint32_t us, uint32_t seq);
+
+/**
+ * @brief     frames recorded
+ */
+uint32_t audio_trace_count(const audio_trace_t *tr);
+
+/**
+ * @brief     latency below which permille of the frames were, as the upper edge of its bucket, 0 when empty
+ */
+uint32_t audio_trace_percentile(const audio_trace_t *tr, uint32_t permille);
+
+#endif /* __AUDIO_TRACE_H__ */
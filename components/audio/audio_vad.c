@@ -0,0 +1,101 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "audio_vad.h"
+
+#define VAD_RISE_DB_S    (3.0f)  // noise floor climb while the signal stays above it
+#define VAD_NOISE_ALPHA  (0.1f)  // per frame smoothing of the comfort noise level
+#define VAD_UNIFORM_RMS  (18919) // rms of a uniform int16 sequence, 32768 / sqrt(3)
+
+void audio_vad_init(audio_vad_t *vad, uint32_t sample_rate, uint32_t frame_samples) {
+    memset(vad, 0, sizeof(audio_vad_t));
+    vad->floor_db = AUDIO_VAD_SILENT_DBFS;
+    vad->rise_db = VAD_RISE_DB_S * frame_samples / sample_rate;
+    vad->hang_len = AUDIO_VAD_HANG_MS * sample_rate / 1000 / frame_samples;
+    vad->seed = 0x2545f491;
+}
+
+bool audio_vad_process(audio_vad_t *vad, const int16_t *pcm, uint32_t n) {
+    int64_t energy = 0;
+    uint32_t crossings = 0;
+
+    for (uint32_t i = 0; i < n; i++) {
+        energy += (int32_t)pcm[i] * pcm[i];
+    }
+    for (uint32_t i = 1; i < n; i++) {
+        crossings += ((pcm[i] ^ pcm[i - 1]) < 0);
+    }
+    vad->level_db = 10.0f * log10f((float)energy / n / (32768.0f * 32768.0f) + 1e-12f);
+    vad->zcr = (float)crossings / n;
+
+    // the first frame seeds the floor, a call rarely opens with speech
+    if (vad->stats.frames == 0 || vad->level_db < vad->floor_db) {
+        vad->floor_db = vad->level_db;
+    } else {
+        vad->floor_db += vad->rise_db;
+    }
+    if (vad->floor_db < AUDIO_VAD_SILENT_DBFS) {
+        vad->floor_db = AUDIO_VAD_SILENT_DBFS;
+    }
+
+    const float over = vad->level_db - vad->floor_db;
+    bool speech = (vad->level_db > AUDIO_VAD_SILENT_DBFS) &&
+                  (over > AUDIO_VAD_SPEECH_DB || (over > AUDIO_VAD_VOICED_DB && vad->zcr < AUDIO_VAD_VOICED_ZCR));
+    if (speech) {
+        vad->hang = vad->hang_len;
+    } else if (vad->hang) {
+        vad->hang--;
+    } else {
+        vad->noise_rms += VAD_NOISE_ALPHA * (sqrtf((float)energy / n) - vad->noise_rms);
+    }
+
+    vad->active = speech || vad->hang;
+    vad->stats.frames++;
+    vad->stats.active += vad->active;
+    return vad->active;
+}
+
+void audio_vad_cng(audio_vad_t *vad, int16_t *pcm, uint32_t n, int32_t gain_q15) {
+    // uniform noise scaled to the silent level, the telephone band shapes it well enough
+    float scale = vad->noise_rms * gain_q15 / VAD_UNIFORM_RMS;
+    const int32_t scale_q15 = (scale > 32767.0f) ? 32767 : (int32_t)scale;
+    uint32_t seed = vad->seed;
+
+    for (uint32_t i = 0; i < n; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        pcm[i] = (int16_t)(((int32_t)(int16_t)(seed >> 16) * scale_q15) >> 15);
+    }
+    vad->seed = seed;
+    vad->stats.cng++;
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef __AUDIO_VAD_H__
+#define __AUDIO_VAD_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define AUDIO_VAD_HANG_MS     (150)   // speech decision held this long, keeps word endings
+#define AUDIO_VAD_SILENT_DBFS (-70.0f) // frames below are silence whatever the noise floor
+#define AUDIO_VAD_SPEECH_DB   (9.0f)  // over the noise floor, speech on energy alone
+#define AUDIO_VAD_VOICED_DB   (4.0f)  // over the noise floor, speech if the zero crossing rate is voiced
+#define AUDIO_VAD_VOICED_ZCR  (0.25f) // zero crossings per sample of voiced speech, noise and fricatives lie above
+
+typedef struct {
+    uint32_t frames; /*!< frames classified */
+    uint32_t active; /*!< frames classified as speech, hangover included */
+    uint32_t cng;    /*!< frames replaced by comfort noise */
+} audio_vad_stats_t;
+
+/**
+ * @brief     energy and zero crossing voice activity detector with comfort noise
+ *
+ *            The noise floor follows the frame energy down at once and climbs slowly, so it settles on the pauses
+ *            between words. The level of the frames judged silent drives a comfort noise generator that can stand in
+ *            for them.
+ */
+typedef struct {
+    float floor_db;       /*!< noise floor, dBFS */
+    float rise_db;        /*!< per frame climb of the floor */
+    float level_db;       /*!< energy of the last frame, dBFS */
+    float zcr;            /*!< zero crossings per sample of the last frame */
+    float noise_rms;      /*!< rms of the silent frames, smoothed */
+    uint32_t hang;        /*!< frames of hangover left */
+    uint32_t hang_len;    /*!< hangover in frames */
+    uint32_t seed;        /*!< comfort noise generator state */
+    bool active;          /*!< last decision */
+    audio_vad_stats_t stats;
+} audio_vad_t;
+
+/**
+ * @brief     reset the detector for frames of frame_samples at sample_rate
+ */
+void audio_vad_init(audio_vad_t *vad, uint32_t sample_rate, uint32_t frame_samples);
+
+/**
+ * @brief     classify one frame, true while there is speech
+ */
+bool audio_vad_process(audio_vad_t *vad, const int16_t *pcm, uint32_t n);
+
+/**
+ * @brief     overwrite n samples with comfort noise at the silent level scaled by gain_q15
+ */
+void audio_vad_cng(audio_vad_t *vad, int16_t *pcm, uint32_t n, int32_t gain_q15);
+
+#endif /* __AUDIO_VAD_H__ */
@@ -0,0 +1,127 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef __TEST_AUDIO_H__
+#define __TEST_AUDIO_H__
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+/**
+ * @brief     fail the current test function, returning 1, if cond does not hold
+ */
+#define TEST_CHECK(cond)                                                     \
+    do {                                                                     \
+        if (!(cond)) {                                                       \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            return 1;                                                        \
+        }                                                                    \
+    } while (0)
+
+/**
+ * @brief     run a test function, counting it in failed
+ */
+#define TEST_RUN(fn, failed)                                   \
+    do {                                                       \
+        int r_ = fn();                                         \
+        printf("%s %s\n", r_ ? "FAIL" : "ok  ", #fn);          \
+        failed += r_;                                          \
+    } while (0)
+
+/**
+ * @brief     sine of amplitude amp and frequency freq at sample_rate, phase continues from *phase
+ */
+static inline void test_sine(int16_t *pcm, uint32_t n, float freq, float amp, uint32_t sample_rate, double *phase) {
+    for (uint32_t i = 0; i < n; i++) {
+        pcm[i] = (int16_t)lrint(amp * sin(*phase));
+        *phase += 2.0 * M_PI * freq / sample_rate;
+    }
+}
+
+// least squares fit of a cos + b sin at freq, returns the power of pcm it explains, times n
+static inline double test_fit(const int16_t *pcm, uint32_t n, float freq, uint32_t sample_rate, double *total) {
+    double c = 0.0, s = 0.0, cc = 0.0, ss = 0.0, cs = 0.0;
+    *total = 0.0;
+    for (uint32_t i = 0; i < n; i++) {
+        double w = 2.0 * M_PI * freq * i / sample_rate;
+        c += pcm[i] * cos(w);
+        s += pcm[i] * sin(w);
+        cc += cos(w) * cos(w);
+        ss += sin(w) * sin(w);
+        cs += cos(w) * sin(w);
+        *total += (double)pcm[i] * pcm[i];
+    }
+    double det = cc * ss - cs * cs;
+    double a = (c * ss - s * cs) / det;
+    double b = (s * cc - c * cs) / det;
+    return a * c + b * s;
+}
+
+/**
+ * @brief     signal to residual ratio in dB of pcm against the best fitting sine of freq, any phase and amplitude
+ */
+static inline double test_snr_db(const int16_t *pcm, uint32_t n, float freq, uint32_t sample_rate) {
+    double total;
+    double fit = test_fit(pcm, n, freq, sample_rate, &total);
+    double noise = total - fit;
+    return 10.0 * log10(fit / (noise > 1e-9 ? noise : 1e-9));
+}
+
+/**
+ * @brief     level in dB relative to a full scale sine of the component of pcm at freq
+ */
+static inline double test_tone_db(const int16_t *pcm, uint32_t n, float freq, uint32_t sample_rate) {
+    double total;
+    double fit = test_fit(pcm, n, freq, sample_rate, &total);
+    return 10.0 * log10(fit / n / (32767.0 * 32767.0 / 2) + 1e-15);
+}
+
+/**
+ * @brief     mean power of pcm
+ */
+static inline double test_power(const int16_t *pcm, uint32_t n) {
+    double p = 0.0;
+    for (uint32_t i = 0; i < n; i++) {
+        p += (double)pcm[i] * pcm[i];
+    }
+    return n ? p / n : 0.0;
+}
+
+/**
+ * @brief     monotonic clock in ns, for the timed loops
+ */
+static inline uint64_t test_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+#endif /* __TEST_AUDIO_H__ */
@@ -0,0 +1,195 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "audio_aec.h"
+#include "audio_frame.h"
+#include "test_audio.h"
+
+#define AEC_TAPS_ECHO (6) // reflections of the synthetic echo path
+
+static audio_aec_t s_aec;
+
+// a room as the handset sees it: a direct path and some reflections, all inside the 16 ms tail and together more than
+// the 6 dB of loss the double-talk detector counts on
+static const uint32_t s_echo_ms10[AEC_TAPS_ECHO] = {10, 22, 35, 61, 97, 140};
+static const float s_echo_gain[AEC_TAPS_ECHO] = {0.25f, -0.10f, 0.06f, -0.04f, 0.02f, 0.01f};
+
+typedef struct {
+    uint32_t rate;
+    uint32_t frame;
+    uint32_t pos;                     // absolute index of the next far-end sample
+    uint32_t seed;
+    float far_amp;                    // peak of the far-end noise
+    int16_t far[AUDIO_AEC_HIST];      // the same history the canceller keeps, to build the echo from
+    double pow_echo;                  // over the current measurement
+    double pow_out;
+    uint64_t ns;                      // spent in audio_aec_process
+    uint32_t runs;
+} aec_sim_t;
+
+static void aec_sim_init(aec_sim_t *sim, uint32_t rate, float far_amp) {
+    memset(sim, 0, sizeof(aec_sim_t));
+    sim->rate = rate;
+    sim->frame = rate / 1000 * PCM_BLOCK_DURATION_US / 1000;
+    sim->seed = 1;
+    sim->far_amp = far_amp;
+    audio_aec_init(&s_aec, rate);
+}
+
+// one frame each way: far-end noise out, echo plus the near-end tone back in, the echo cancelled
+static bool aec_sim_frame(aec_sim_t *sim, float near_amp, double *near_phase) {
+    int16_t far[WBS_PCM_FRAME_SAMPLES], near[WBS_PCM_FRAME_SAMPLES], talk[WBS_PCM_FRAME_SAMPLES];
+    const uint32_t start = sim->pos;
+
+    for (uint32_t i = 0; i < sim->frame; i++) {
+        sim->seed = sim->seed * 1664525u + 1013904223u;
+        far[i] = (int16_t)lrintf(sim->far_amp * ((sim->seed >> 8) / 8388608.0f - 1.0f));
+        sim->far[(start + i) & (AUDIO_AEC_HIST - 1)] = far[i];
+    }
+    audio_aec_far(&s_aec, far, sim->frame);
+    sim->pos += sim->frame;
+
+    test_sine(talk, sim->frame, 1000.0f, near_amp, sim->rate, near_phase);
+    for (uint32_t i = 0; i < sim->frame; i++) {
+        float echo = 0.0f;
+        for (uint32_t k = 0; k < AEC_TAPS_ECHO; k++) {
+            uint32_t delay = s_echo_ms10[k] * sim->rate / 10000;
+            echo += s_echo_gain[k] * sim->far[(start + i - delay) & (AUDIO_AEC_HIST - 1)];
+        }
+        near[i] = (int16_t)lrintf(echo + talk[i]);
+        sim->pow_echo += echo * echo;
+    }
+    uint64_t t0 = test_now_ns();
+    bool done = audio_aec_process(&s_aec, near, sim->frame, start);
+    sim->ns += test_now_ns() - t0;
+    sim->runs++;
+    if (!done) {
+        return false;
+    }
+    for (uint32_t i = 0; i < sim->frame; i++) {
+        float e = near[i] - talk[i];
+        sim->pow_out += e * e;
+    }
+    return true;
+}
+
+// echo return loss enhancement over seconds of far end only talk
+static double aec_sim_erle(aec_sim_t *sim, uint32_t seconds) {
+    double phase = 0.0;
+    sim->pow_echo = sim->pow_out = 0.0;
+    for (uint32_t f = 0; f < seconds * 1000000 / PCM_BLOCK_DURATION_US; f++) {
+        if (!aec_sim_frame(sim, 0.0f, &phase)) {
+            return 0.0;
+        }
+    }
+    return 10.0 * log10((sim->pow_echo + 1.0) / (sim->pow_out + 1.0));
+}
+
+static int aec_check_converge(uint32_t rate, float far_amp) {
+    aec_sim_t sim;
+    aec_sim_init(&sim, rate, far_amp);
+    double first = aec_sim_erle(&sim, 1);
+    double erle = aec_sim_erle(&sim, 1);
+    printf("    %u Hz, far end %.0f dBFS: ERLE %.1f dB over the first second, %.1f dB after, reported %.1f dB\n", (unsigned)rate,
+           20.0 * log10(far_amp / 32767.0), first, erle, s_aec.stats.erle_db);
+    TEST_CHECK(erle > 30.0);
+    TEST_CHECK(fabs(s_aec.stats.erle_db - erle) < 3.0);
+    TEST_CHECK(s_aec.stats.skipped == 0);
+    TEST_CHECK(s_aec.stats.double_talk == 0);
+    return 0;
+}
+
+// the path is learnt within a second from white far-end noise, quiet or at full scale
+static int test_aec_converge(void) {
+    TEST_CHECK(aec_check_converge(8000, 3000.0f) == 0);
+    TEST_CHECK(aec_check_converge(16000, 3000.0f) == 0);
+    TEST_CHECK(aec_check_converge(8000, 32767.0f) == 0);
+    TEST_CHECK(aec_check_converge(16000, 32767.0f) == 0);
+    return 0;
+}
+
+// the near end talking over the far end passes through untouched and does not pull the estimate off
+static int test_aec_double_talk(void) {
+    aec_sim_t sim;
+    double phase = 0.0;
+    aec_sim_init(&sim, 16000, 8000.0f);
+    aec_sim_erle(&sim, 1);
+    TEST_CHECK(aec_sim_erle(&sim, 1) > 30.0);
+
+    const uint32_t frames = 1000000 / PCM_BLOCK_DURATION_US;
+    sim.pow_echo = sim.pow_out = 0.0;
+    for (uint32_t f = 0; f < frames; f++) {
+        TEST_CHECK(aec_sim_frame(&sim, 12000.0f, &phase));
+    }
+    double leak = 10.0 * log10((sim.pow_echo + 1.0) / (sim.pow_out + 1.0));
+    double erle = aec_sim_erle(&sim, 1);
+    printf("    near end at -8.7 dBFS over the echo: ERLE %.1f dB during, %.1f dB after, %u frames frozen\n", leak, erle,
+           (unsigned)s_aec.stats.double_talk);
+    TEST_CHECK(s_aec.stats.double_talk >= frames - 1);
+    TEST_CHECK(leak > 25.0);
+    TEST_CHECK(erle > 30.0);
+    return 0;
+}
+
+// time per 7.5 ms frame, adapting to far end only talk and frozen under double talk
+static int test_aec_bench(void) {
+    const uint32_t rates[] = {8000, 16000};
+    const uint32_t frames = 4 * 1000000 / PCM_BLOCK_DURATION_US;
+    for (uint32_t r = 0; r < 2; r++) {
+        aec_sim_t sim;
+        double phase = 0.0;
+
+        aec_sim_init(&sim, rates[r], 3000.0f);
+        for (uint32_t f = 0; f < frames; f++) {
+            TEST_CHECK(aec_sim_frame(&sim, 0.0f, &phase));
+        }
+        double adapt = (double)sim.ns / sim.runs;
+        sim.ns = 0;
+        sim.runs = 0;
+        for (uint32_t f = 0; f < frames; f++) {
+            TEST_CHECK(aec_sim_frame(&sim, 12000.0f, &phase));
+        }
+        double frozen = (double)sim.ns / sim.runs;
+        printf("    %5u Hz, %3u taps: %6.0f ns per frame adapting, %6.0f ns frozen, %.0fx real time\n", (unsigned)rates[r],
+               (unsigned)s_aec.taps, adapt, frozen, PCM_BLOCK_DURATION_US * 1000.0 / adapt);
+    }
+    return 0;
+}
+
+int main(void) {
+    int failed = 0;
+    TEST_RUN(test_aec_converge, failed);
+    TEST_RUN(test_aec_double_talk, failed);
+    TEST_RUN(test_aec_bench, failed);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,255 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "audio_asrc.h"
+#include "audio_ring.h"
+#include "test_audio.h"
+
+#define SIM_RATE     (8000)
+#define SIM_FRAME    (PCM_FRAME_SAMPLES)
+#define SIM_PRIME    (2)       // frames queued before the reader starts, as in the PWM and ADC drivers
+#define SIM_SETTLE_S (120.0)   // lock in time left out of the bounds, twelve loop time constants
+#define SIM_HOURS    (1.0)     // default simulated time per case, argv overrides it
+#define SIM_JITTER_S (0.00125) // air frames come up to two slots early or late
+
+static audio_asrc_t s_asrc;
+static audio_ring_t s_queue;
+
+typedef struct {
+    uint32_t underruns; /*!< reader found nothing after lock in */
+    uint32_t overruns;  /*!< writer found the queue full after lock in */
+    int32_t fill_min;   /*!< samples queued after lock in */
+    int32_t fill_max;
+    double ppb_avg;     /*!< trim averaged after lock in */
+} sim_result_t;
+
+static void sim_frame(int16_t *pcm, double *phase) {
+    test_sine(pcm, SIM_FRAME, 440.0f, 8000.0f, SIM_RATE, phase);
+}
+
+/**
+ * Two clocks around one frame queue, the local one off by ppm. sink: the air writes frames into the queue and the
+ * local clock plays them through the converter (PWM output). Otherwise the local clock captures frames through the
+ * converter into the queue and the air takes them (ADC microphone).
+ */
+static void asrc_sim(double ppm, double hours, bool sink, sim_result_t *res) {
+    const double t_air = PCM_BLOCK_DURATION_US * 1e-6;
+    const double t_loc = t_air / (1.0 + ppm * 1e-6);
+    const double t_end = hours * 3600.0;
+    int16_t pcm[SIM_FRAME];
+    double phase = 0.0;
+    double next_air = 0.0;
+    double next_loc = t_loc * 0.5;
+    double last_air = 0.0;
+    uint32_t lcg = 1;
+    double ppb_sum = 0.0;
+    uint32_t ppb_n = 0;
+    bool primed = false;
+
+    audio_asrc_init(&s_asrc, SIM_RATE, SIM_FRAME, SIM_PRIME * SIM_FRAME);
+    audio_ring_init(&s_queue, SIM_FRAME * BYTES_PER_SAMPLE);
+    memset(res, 0, sizeof(sim_result_t));
+    res->fill_min = INT32_MAX;
+    res->fill_max = INT32_MIN;
+
+    while (next_air < t_end || next_loc < t_end) {
+        lcg = lcg * 1664525u + 1013904223u;
+        double jitter = ((double)(lcg >> 8) / (1u << 24) - 0.5) * 2.0 * SIM_JITTER_S;
+        bool air = (next_air + jitter <= next_loc);
+        double now = air ? next_air + jitter : next_loc;
+        bool settled = (now >= SIM_SETTLE_S);
+        bool write = (air == sink);
+        int32_t fill = -1;
+
+        if (write) {
+            uint8_t *slot = audio_ring_write_begin(&s_queue);
+            if (sink) {
+                sim_frame(pcm, &phase);
+                if (slot) {
+                    memcpy(slot, pcm, sizeof(pcm));
+                }
+            } else {
+                // capture: one frame through the converter, whole converted frames into the queue
+                sim_frame(pcm, &phase);
+                audio_asrc_put(&s_asrc, pcm);
+                // the air takes its frames in steps, the fill is interpolated by how far it is into the next one
+                fill = (int32_t)audio_ring_count(&s_queue) * SIM_FRAME - (int32_t)((now - last_air) / t_air * SIM_FRAME);
+                int32_t ppb = audio_asrc_track(&s_asrc, fill);
+                if (settled) {
+                    ppb_sum += ppb;
+                    ppb_n++;
+                }
+                fill += s_asrc.count;
+                const int16_t *out = audio_asrc_peek(&s_asrc);
+                while (out) {
+                    slot = audio_ring_write_begin(&s_queue);
+                    if (slot) {
+                        memcpy(slot, out, sizeof(pcm));
+                        audio_ring_write_commit(&s_queue);
+                    }
+                    audio_asrc_release(&s_asrc);
+                    out = audio_asrc_peek(&s_asrc);
+                    slot = (slot || !settled) ? slot : NULL;
+                    res->overruns += (slot == NULL && settled);
+                }
+                slot = (uint8_t *)1;
+            }
+            if (sink) {
+                if (slot) {
+                    audio_ring_write_commit(&s_queue);
+                } else if (settled) {
+                    res->overruns++;
+                }
+            }
+        } else {
+            if (!primed && audio_ring_count(&s_queue) >= SIM_PRIME) {
+                primed = true;
+            }
+            if (sink && primed) {
+                // playback: converted frames from the queue, as many as the next buffer needs
+                while (audio_asrc_peek(&s_asrc) == NULL) {
+                    const uint8_t *frame = audio_ring_read_begin(&s_queue);
+                    if (frame == NULL) {
+                        break;
+                    }
+                    audio_asrc_put(&s_asrc, (const int16_t *)frame);
+                    audio_ring_read_commit(&s_queue);
+                }
+                if (audio_asrc_peek(&s_asrc)) {
+                    audio_asrc_release(&s_asrc);
+                } else {
+                    primed = false;
+                    res->underruns += settled;
+                }
+                // the air adds its frames in steps, the fill is interpolated by how far it is into the next one
+                fill = (int32_t)audio_ring_count(&s_queue) * SIM_FRAME + (int32_t)((now - last_air) / t_air * SIM_FRAME);
+                int32_t ppb = audio_asrc_track(&s_asrc, fill);
+                if (settled) {
+                    ppb_sum += ppb;
+                    ppb_n++;
+                }
+                fill += s_asrc.count;
+            } else if (!sink && primed) {
+                if (audio_ring_read_begin(&s_queue)) {
+                    audio_ring_read_commit(&s_queue);
+                } else {
+                    primed = false;
+                    res->underruns += settled;
+                }
+            }
+        }
+
+        if (settled && fill >= 0) {
+            res->fill_min = (fill < res->fill_min) ? fill : res->fill_min;
+            res->fill_max = (fill > res->fill_max) ? fill : res->fill_max;
+        }
+        if (air) {
+            last_air = now;
+            next_air += t_air;
+        } else {
+            next_loc += t_loc;
+        }
+    }
+    res->ppb_avg = ppb_n ? ppb_sum / ppb_n : 0.0;
+}
+
+static int asrc_check(double ppm, double hours, bool sink) {
+    sim_result_t res;
+    asrc_sim(ppm, hours, sink, &res);
+    // the local clock plays faster: the sink converter stretches, the source one drops samples
+    double expect_ppb = sink ? -ppm * 1000.0 : ppm * 1000.0;
+    printf("    %s %+6.0f ppm, %.1f h: fill %d..%d samples (%.1f..%.1f ms), trim %+.1f ppm, %u underruns, %u overruns\n", sink ? "sink  " : "source", ppm,
+           hours, (int)res.fill_min, (int)res.fill_max, res.fill_min * 1000.0 / SIM_RATE, res.fill_max * 1000.0 / SIM_RATE, res.ppb_avg / 1000.0,
+           (unsigned)res.underruns, (unsigned)res.overruns);
+    TEST_CHECK(res.underruns == 0 && res.overruns == 0);
+    // bounded latency: within half a frame of the target for the whole run, whatever its length
+    TEST_CHECK(res.fill_min >= SIM_PRIME * SIM_FRAME - SIM_FRAME / 2 && res.fill_max <= SIM_PRIME * SIM_FRAME + SIM_FRAME / 2);
+    TEST_CHECK(fabs(res.ppb_avg - expect_ppb) < 5000.0);
+    return 0;
+}
+
+static double s_hours = SIM_HOURS;
+
+static int test_asrc_drift(void) {
+    const double ppm[] = { -300.0, -100.0, 100.0, 300.0 };
+    for (int i = 0; i < 4; i++) {
+        TEST_CHECK(asrc_check(ppm[i], s_hours, true) == 0);
+        TEST_CHECK(asrc_check(ppm[i], s_hours, false) == 0);
+    }
+    return 0;
+}
+
+// the converted tone stays clean with the trim moving under it
+static int test_asrc_quality(void) {
+    static int16_t out[SIM_RATE * 10];
+    int16_t pcm[SIM_FRAME];
+    double phase = 0.0;
+    uint32_t n = 0;
+
+    audio_asrc_init(&s_asrc, SIM_RATE, SIM_FRAME, SIM_PRIME * SIM_FRAME);
+    for (uint32_t f = 0; n + SIM_FRAME <= sizeof(out) / sizeof(out[0]); f++) {
+        sim_frame(pcm, &phase);
+        audio_asrc_put(&s_asrc, pcm);
+        // a fill that keeps the trim away from zero
+        audio_asrc_track(&s_asrc, SIM_PRIME * SIM_FRAME + 10);
+        while (audio_asrc_peek(&s_asrc) && n + SIM_FRAME <= sizeof(out) / sizeof(out[0])) {
+            memcpy(out + n, audio_asrc_peek(&s_asrc), sizeof(pcm));
+            audio_asrc_release(&s_asrc);
+            n += SIM_FRAME;
+        }
+    }
+    TEST_CHECK(s_asrc.drift.ppb > 0);
+    // the last second, at the trimmed frequency
+    double f = 440.0 * (1.0 + s_asrc.drift.ppb * 1e-9);
+    double snr = test_snr_db(out + n - SIM_RATE, SIM_RATE, (float)f, SIM_RATE);
+    printf("    %.1f dB at %+.1f ppm\n", snr, s_asrc.drift.ppb / 1000.0);
+    TEST_CHECK(snr > 50.0);
+    TEST_CHECK(s_asrc.lost == 0);
+    return 0;
+}
+
+// test_audio_asrc [ppm hours]: one case of the drift simulation, both sides, for longer runs by hand
+int main(int argc, char **argv) {
+    int failed = 0;
+    if (argc == 3) {
+        double ppm = atof(argv[1]);
+        double hours = atof(argv[2]);
+        failed += asrc_check(ppm, hours, true);
+        failed += asrc_check(ppm, hours, false);
+        return failed ? 1 : 0;
+    }
+    TEST_RUN(test_asrc_drift, failed);
+    TEST_RUN(test_asrc_quality, failed);
+    return failed ? 1 : 0;
+}
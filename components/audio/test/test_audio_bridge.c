@@ -0,0 +1,179 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "audio_bridge.h"
+#include "audio_frame.h"
+#include "test_audio.h"
+
+#define BR_RATE   (8000)
+#define BR_FRAME  (PCM_FRAME_SAMPLES)
+#define BR_US     (PCM_BLOCK_DURATION_US)
+#define BR_FRAMES (400)
+#define BR_CB_US  (200) // time the callback takes
+
+// a codec DMA on a virtual clock: every BR_US both directions move to their next buffer and report the last one
+typedef struct {
+    int16_t rx[AUDIO_BRIDGE_SLOTS][BR_FRAME];
+    int16_t tx[AUDIO_BRIDGE_SLOTS][BR_FRAME];
+    bool read[AUDIO_BRIDGE_SLOTS];    // rx buffer taken by the callback since its capture
+    bool written[AUDIO_BRIDGE_SLOTS]; // tx buffer filled by the callback since it was played
+    uint32_t k;                       // transfers completed
+    int64_t now_us;
+    bool running;
+    uint32_t unread;    // captures overwritten without the callback seeing them
+    uint32_t unwritten; // frames played without the callback filling them
+    uint32_t wrong;     // callback given a buffer the DMA is on, or not the one of its frame
+} br_drv_t;
+
+static audio_bridge_t s_br;
+static br_drv_t s_drv;
+
+static bool br_start(void *drv, audio_bridge_t *bridge) {
+    br_drv_t *d = drv;
+    memset(d, 0, sizeof(br_drv_t));
+    // tx[0] plays from the start, tx[1] after it is primed with silence
+    d->written[1] = true;
+    d->running = true;
+    return bridge->samples == BR_FRAME;
+}
+
+static void br_stop(void *drv) {
+    ((br_drv_t *)drv)->running = false;
+}
+
+static int64_t br_now_us(void *drv) {
+    return ((br_drv_t *)drv)->now_us;
+}
+
+static const audio_bridge_ops_t s_br_ops = {.start = br_start, .stop = br_stop, .now_us = br_now_us};
+
+// transfer k ends: capture k is in rx[k % 2] and tx[k % 2] has played, the DMA moves on to the other slot of each
+static bool br_complete(br_drv_t *d) {
+    const uint32_t done = d->k % AUDIO_BRIDGE_SLOTS, next = (d->k + 1) % AUDIO_BRIDGE_SLOTS;
+    for (uint32_t i = 0; i < BR_FRAME; i++) {
+        d->rx[done][i] = (int16_t)d->k;
+    }
+    d->read[done] = false;
+    if (d->k > 0 && !d->read[next]) {
+        d->unread++;
+    }
+    if (!d->written[next]) {
+        d->unwritten++;
+    }
+    d->written[next] = false;
+    d->k++;
+
+    bool rx = audio_bridge_rx_done(&s_br, d->rx[done]);
+    bool tx = audio_bridge_tx_done(&s_br, d->tx[done]);
+    return rx || tx;
+}
+
+// the stages: the capture goes back out, a frame late
+static void br_frame(void *ctx, const int16_t *rx, int16_t *tx, uint32_t samples) {
+    br_drv_t *d = ctx;
+    const uint32_t on = d->k % AUDIO_BRIDGE_SLOTS;
+    const uint32_t frame = (uint32_t)rx[0];
+
+    if (rx != d->rx[frame % AUDIO_BRIDGE_SLOTS] || rx == d->rx[on] || tx == d->tx[on] || (tx != d->tx[0] && tx != d->tx[1])) {
+        d->wrong++;
+    }
+    d->read[frame % AUDIO_BRIDGE_SLOTS] = true;
+    memcpy(tx, rx, samples * sizeof(int16_t));
+    d->written[tx == d->tx[1]] = true;
+    d->now_us += BR_CB_US;
+}
+
+// the service task runs wake_us after the completion that woke it; notifications before it runs merge into one
+static int br_run(uint32_t wake_us) {
+    int64_t pending = -1;
+
+    TEST_CHECK(audio_bridge_start(&s_br, BR_RATE, BR_FRAME, br_frame, &s_drv));
+    // BR_FRAMES transfers, then up to the service they woke, so every loss so far has been seen by the bridge
+    for (uint32_t k = 1;;) {
+        const int64_t at = (int64_t)k * BR_US;
+        if (pending >= 0 && pending <= at) {
+            s_drv.now_us = pending;
+            audio_bridge_service(&s_br);
+            pending = -1;
+            continue;
+        }
+        if (k > BR_FRAMES && pending < 0) {
+            break;
+        }
+        s_drv.now_us = at;
+        if (br_complete(&s_drv) && pending < 0) {
+            pending = at + wake_us;
+        }
+        k++;
+    }
+    audio_bridge_stop(&s_br);
+
+    const audio_bridge_stats_t *st = &s_br.stats;
+    printf("    woken %4u us late: %u frames, %u overruns (%u unread), %u underruns (%u unwritten), %u late, worst %u us\n",
+           (unsigned)wake_us, (unsigned)st->frames, (unsigned)st->overruns, (unsigned)s_drv.unread, (unsigned)st->underruns,
+           (unsigned)s_drv.unwritten, (unsigned)st->late, (unsigned)st->lat_max_us);
+    TEST_CHECK(s_drv.wrong == 0);
+    TEST_CHECK(st->overruns == s_drv.unread);
+    TEST_CHECK(st->underruns == s_drv.unwritten);
+    return 0;
+}
+
+// inside the frame every capture is taken and every playout filled, the latency is the wake up plus the callback
+static int test_bridge_on_time(void) {
+    const uint32_t wake[] = {100, 5000};
+    for (uint32_t i = 0; i < 2; i++) {
+        TEST_CHECK(br_run(wake[i]) == 0);
+        TEST_CHECK(s_br.stats.frames == BR_FRAMES);
+        TEST_CHECK(s_br.stats.overruns == 0 && s_br.stats.underruns == 0 && s_br.stats.late == 0);
+        TEST_CHECK(s_br.stats.lat_max_us == wake[i] + BR_CB_US);
+    }
+    return 0;
+}
+
+// past the frame the DMA is back on the buffers: the frames lost are counted as they happened, none handed over stale
+static int test_bridge_late(void) {
+    TEST_CHECK(br_run(8000) == 0);
+    TEST_CHECK(s_br.stats.overruns > BR_FRAMES / 3 && s_br.stats.underruns > BR_FRAMES / 3);
+    TEST_CHECK(s_br.stats.frames + s_br.stats.overruns >= BR_FRAMES);
+    // serviced right after the next completion, which is the frame it hands over
+    TEST_CHECK(s_br.stats.lat_max_us == 8000 - BR_US + BR_CB_US);
+    return 0;
+}
+
+int main(void) {
+    int failed = 0;
+    audio_bridge_init(&s_br, &s_br_ops, &s_drv);
+    TEST_RUN(test_bridge_on_time, failed);
+    TEST_RUN(test_bridge_late, failed);
+    return failed ? 1 : 0;
+}
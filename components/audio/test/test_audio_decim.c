@@ -0,0 +1,184 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "audio_decim.h"
+#include "audio_frame.h"
+#include "test_audio.h"
+
+#define DECIM_SECONDS (1)
+#define DECIM_RAW     (AUDIO_DECIM_IN_RATE * DECIM_SECONDS)
+#define DECIM_BLOCK   (512)  // conversions per call, as the DMA hands them over
+#define DECIM_SETTLE  (8)    // 1/8 s left out of the measurement, the DC tracker settles from the tone start in 16 ms steps
+#define DECIM_MID     (2048) // converter mid scale
+#define DECIM_CHANNEL (6u << 12) // channel number the DMA puts above the conversion bits
+
+static audio_decim_t s_decim;
+static uint16_t s_raw[DECIM_RAW];
+static int16_t s_out[16000 * DECIM_SECONDS];
+
+// a count of triangular noise, as a real converter has at its input; without it the rounding of a tone locked to the
+// conversion rate would be harmonics rather than noise
+static double decim_dither(void) {
+    static uint32_t seed = 1;
+    double r = 0.0;
+    for (int k = 0; k < 2; k++) {
+        seed = seed * 1664525u + 1013904223u;
+        r += (seed >> 8) / 16777216.0 - 0.5;
+    }
+    return r;
+}
+
+// conversions of a sine of amp counts around offset, with the channel bits set as the DMA delivers them
+static void decim_source(float freq, double amp, uint32_t offset) {
+    for (uint32_t i = 0; i < DECIM_RAW; i++) {
+        long v = offset + lrint(amp * sin(2.0 * M_PI * freq * i / AUDIO_DECIM_IN_RATE) + decim_dither());
+        s_raw[i] = (uint16_t)(DECIM_CHANNEL | (uint32_t)((v < 0) ? 0 : (v > 4095) ? 4095 : v));
+    }
+}
+
+static uint32_t decim_run(uint32_t rate) {
+    uint32_t n = 0;
+    if (!audio_decim_init(&s_decim, rate)) {
+        return 0;
+    }
+    for (uint32_t i = 0; i < DECIM_RAW; i += DECIM_BLOCK) {
+        n += audio_decim_process(&s_decim, s_raw + i, DECIM_BLOCK, s_out + n, DECIM_BLOCK / s_decim.factor);
+    }
+    return n;
+}
+
+// 12 bit conversions, the oversampling spreads their quantisation over the whole input band
+static int decim_check_band(uint32_t rate, float freq, double min_db) {
+    const double amp = 1700.0;
+    const double level_db = 20.0 * log10(amp * 16.0 / 32767.0);
+
+    decim_source(freq, amp, DECIM_MID + 300);
+    uint32_t n = decim_run(rate);
+    TEST_CHECK(n == rate * DECIM_SECONDS);
+    double snr = test_snr_db(s_out + rate / DECIM_SETTLE, n - rate / DECIM_SETTLE, freq, rate);
+    double level = test_tone_db(s_out + rate / DECIM_SETTLE, n - rate / DECIM_SETTLE, freq, rate);
+    printf("    %u Hz, %.0f Hz at %.1f dBFS: in band SNR %.1f dB, level %.2f dBFS\n", (unsigned)rate, freq, level_db, snr, level);
+    TEST_CHECK(snr > min_db);
+    TEST_CHECK(fabs(level - level_db) < 0.2);
+    TEST_CHECK(s_decim.stats.clipped == 0);
+    return 0;
+}
+
+// a tone above the output band, measured where it folds to
+static int decim_check_alias(uint32_t rate, float freq, double max_db) {
+    const double amp = 1700.0;
+    const double level_db = 20.0 * log10(amp * 16.0 / 32767.0);
+    float folded = fmodf(freq, (float)rate);
+    folded = (folded > rate / 2) ? rate - folded : folded;
+
+    decim_source(freq, amp, DECIM_MID);
+    uint32_t n = decim_run(rate);
+    double rejection = test_tone_db(s_out + rate / DECIM_SETTLE, n - rate / DECIM_SETTLE, folded, rate) - level_db;
+    printf("    %u Hz, %.0f Hz folding to %.0f Hz: %.1f dB\n", (unsigned)rate, freq, folded, rejection);
+    TEST_CHECK(rejection < max_db);
+    return 0;
+}
+
+static int test_decim_band(void) {
+    TEST_CHECK(decim_check_band(8000, 1000.0f, 70.0) == 0);
+    TEST_CHECK(decim_check_band(8000, 2500.0f, 70.0) == 0);
+    TEST_CHECK(decim_check_band(16000, 1000.0f, 65.0) == 0);
+    TEST_CHECK(decim_check_band(16000, 5000.0f, 65.0) == 0);
+    return 0;
+}
+
+// everything the converter takes above the stop band edge must stay below its own noise
+static int test_decim_alias(void) {
+    const float narrow[] = {5000.0f, 6000.0f, 7000.0f, 9000.0f, 15000.0f, 17000.0f, 31000.0f};
+    const float wide[] = {10000.0f, 12000.0f, 20000.0f, 30000.0f};
+    for (uint32_t i = 0; i < sizeof(narrow) / sizeof(narrow[0]); i++) {
+        TEST_CHECK(decim_check_alias(8000, narrow[i], -65.0) == 0);
+    }
+    for (uint32_t i = 0; i < sizeof(wide) / sizeof(wide[0]); i++) {
+        TEST_CHECK(decim_check_alias(16000, wide[i], -65.0) == 0);
+    }
+    return 0;
+}
+
+// the DC tracker follows a step in the bias within a fraction of a second
+static int test_decim_dc(void) {
+    for (uint32_t i = 0; i < DECIM_RAW; i++) {
+        s_raw[i] = (uint16_t)(DECIM_CHANNEL | ((i < DECIM_RAW / 4) ? DECIM_MID : DECIM_MID + 550));
+    }
+    uint32_t n = decim_run(8000);
+    const uint32_t settled = n / 4 + n / 5;
+    double mean = 0.0;
+    for (uint32_t i = settled; i < n; i++) {
+        mean += s_out[i];
+    }
+    mean /= n - settled;
+    printf("    bias step of 550 counts, mean %.2f after 200 ms\n", mean);
+    TEST_CHECK(fabs(mean) < 4.0);
+    for (uint32_t i = 0; i < n / 4; i++) {
+        TEST_CHECK(s_out[i] == 0);
+    }
+    return 0;
+}
+
+// ns per 7.5 ms frame, the 480 conversions the DMA delivers in that time
+static int test_decim_bench(void) {
+    const uint32_t rates[] = {8000, 16000};
+    const uint32_t frame = AUDIO_DECIM_IN_RATE / 1000 * PCM_BLOCK_DURATION_US / 1000;
+    const uint32_t frames = DECIM_RAW / frame, rounds = 10;
+    decim_source(1000.0f, 1700.0, DECIM_MID);
+    for (uint32_t r = 0; r < 2; r++) {
+        uint32_t n = 0;
+        TEST_CHECK(audio_decim_init(&s_decim, rates[r]));
+        uint64_t t0 = test_now_ns();
+        for (uint32_t k = 0; k < rounds; k++) {
+            n = 0;
+            for (uint32_t f = 0; f < frames; f++) {
+                n += audio_decim_process(&s_decim, s_raw + f * frame, frame, s_out + n, frame / s_decim.factor);
+            }
+        }
+        double ns = (double)(test_now_ns() - t0) / (rounds * frames);
+        printf("    %5u Hz, %u taps: %6.0f ns per %u conversions, %.1f ns per output sample, %.0fx real time (%u)\n", (unsigned)rates[r],
+               (unsigned)s_decim.len, ns, (unsigned)frame, ns * s_decim.factor / frame,
+               PCM_BLOCK_DURATION_US * 1000.0 / ns, (unsigned)(n & 1));
+    }
+    return 0;
+}
+
+int main(void) {
+    int failed = 0;
+    TEST_RUN(test_decim_band, failed);
+    TEST_RUN(test_decim_alias, failed);
+    TEST_RUN(test_decim_dc, failed);
+    TEST_RUN(test_decim_bench, failed);
+    return failed ? 1 : 0;
+}
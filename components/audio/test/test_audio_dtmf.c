@@ -0,0 +1,185 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "audio_dtmf.h"
+#include "audio_frame.h"
+#include "test_audio.h"
+
+#define DTMF_DIGITS "0123456789*#ABCD"
+
+static audio_dtmf_gen_t s_gen;
+static audio_dtmf_det_t s_det;
+
+// frames of noise at noise_amp with the queued digits played over them, whatever the detector reports in digits
+static uint32_t dtmf_loop(uint32_t rate, uint32_t frames, float noise_amp, char *digits, uint32_t max) {
+    int16_t pcm[WBS_PCM_FRAME_SAMPLES];
+    const uint32_t frame = rate / 1000 * PCM_BLOCK_DURATION_US / 1000;
+    uint32_t seed = 1, found = 0;
+    for (uint32_t f = 0; f < frames; f++) {
+        for (uint32_t i = 0; i < frame; i++) {
+            seed = seed * 1664525u + 1013904223u;
+            pcm[i] = (int16_t)lrintf(noise_amp * ((seed >> 8) / 8388608.0f - 1.0f));
+        }
+        audio_dtmf_gen_fill(&s_gen, pcm, frame);
+        char digit = audio_dtmf_det_process(&s_det, pcm, frame);
+        if (digit && found < max) {
+            digits[found++] = digit;
+        }
+    }
+    return found;
+}
+
+static int dtmf_check_round_trip(uint32_t rate, float noise_amp) {
+    char digits[2 * sizeof(DTMF_DIGITS)] = {0};
+    audio_dtmf_gen_init(&s_gen, rate);
+    audio_dtmf_det_init(&s_det, rate);
+    for (const char *d = DTMF_DIGITS; *d; d++) {
+        TEST_CHECK(audio_dtmf_gen_push(&s_gen, *d));
+    }
+    // every digit takes 160 ms, leave the last one time to clear
+    uint32_t frames = (strlen(DTMF_DIGITS) + 1) * (AUDIO_DTMF_ON_MS + AUDIO_DTMF_GAP_MS) * 1000 / PCM_BLOCK_DURATION_US;
+    uint32_t n = dtmf_loop(rate, frames, noise_amp, digits, sizeof(digits) - 1);
+    printf("    %u Hz, noise peak %.0f: \"%s\", %u blocks rejected\n", (unsigned)rate, noise_amp, digits, (unsigned)s_det.stats.rejected);
+    TEST_CHECK(n == strlen(DTMF_DIGITS));
+    TEST_CHECK(strcmp(digits, DTMF_DIGITS) == 0);
+    TEST_CHECK(s_gen.played == strlen(DTMF_DIGITS));
+    TEST_CHECK(s_gen.dropped == 0);
+    return 0;
+}
+
+// every digit the generator plays is detected once, in order, in silence and under noise
+static int test_dtmf_round_trip(void) {
+    TEST_CHECK(dtmf_check_round_trip(8000, 0.0f) == 0);
+    TEST_CHECK(dtmf_check_round_trip(16000, 0.0f) == 0);
+    TEST_CHECK(dtmf_check_round_trip(8000, 1000.0f) == 0);
+    TEST_CHECK(dtmf_check_round_trip(16000, 1000.0f) == 0);
+    return 0;
+}
+
+// a burst of ms of the '5' row and column tones at their own amplitudes, the digit the detector reported
+static char dtmf_pair(uint32_t ms, float row_amp, float col_amp) {
+    static int16_t pcm[16000];
+    const uint32_t rate = 8000, frame = PCM_FRAME_SAMPLES;
+    double lo = 0.0, hi = 0.0;
+    memset(pcm, 0, sizeof(pcm));
+    test_sine(pcm + rate / 4, ms * rate / 1000, 770.0f, row_amp, rate, &lo);
+    for (uint32_t i = 0; i < ms * rate / 1000; i++) {
+        pcm[rate / 4 + i] += (int16_t)lrint(col_amp * sin(hi));
+        hi += 2.0 * M_PI * 1336.0 / rate;
+    }
+    audio_dtmf_det_init(&s_det, rate);
+    char digit = 0;
+    for (uint32_t i = 0; i + frame <= rate; i += frame) {
+        char d = audio_dtmf_det_process(&s_det, pcm + i, frame);
+        digit = d ? d : digit;
+    }
+    return digit;
+}
+
+// bursts of a dual tone of ms length, whether the detector reported them
+static bool dtmf_burst(uint32_t ms) {
+    return dtmf_pair(ms, 8000.0f, 8000.0f) == '5';
+}
+
+// the detector wants about 40 ms of tone and never takes less than 25 ms
+static int test_dtmf_duration(void) {
+    const uint32_t ms[] = {15, 20, 25, 45, 60};
+    bool found[5];
+    for (uint32_t i = 0; i < 5; i++) {
+        found[i] = dtmf_burst(ms[i]);
+        printf("    %u ms burst: %s\n", (unsigned)ms[i], found[i] ? "reported" : "ignored");
+    }
+    TEST_CHECK(!found[0] && !found[1] && !found[2]);
+    TEST_CHECK(found[3] && found[4]);
+    return 0;
+}
+
+// a voiced sound puts energy in row and column bands at once, its harmonics give it away
+static int test_dtmf_talk_off(void) {
+    static int16_t pcm[2 * 8000], partial[2 * 8000];
+    const uint32_t rate = 8000;
+    for (float f0 = 90.0f; f0 < 300.0f; f0 += 7.0f) {
+        memset(pcm, 0, sizeof(pcm));
+        for (uint32_t h = 1; h * f0 < rate / 2; h++) {
+            double phase = h;
+            test_sine(partial, 2 * rate, h * f0, 12000.0f / h, rate, &phase);
+            for (uint32_t i = 0; i < 2 * rate; i++) {
+                pcm[i] += partial[i];
+            }
+        }
+        audio_dtmf_det_init(&s_det, rate);
+        for (uint32_t i = 0; i < 2 * rate; i += PCM_FRAME_SAMPLES) {
+            TEST_CHECK(audio_dtmf_det_process(&s_det, pcm + i, PCM_FRAME_SAMPLES) == 0);
+        }
+    }
+    return 0;
+}
+
+// the column tone from 8 dB under the row tone (normal twist) to 4 dB over it (reverse twist) is a digit, past
+// either limit it is not
+static int test_dtmf_twist(void) {
+    const float db[] = {-7.5f, 3.5f, -8.5f, 4.5f};
+    for (uint32_t i = 0; i < 4; i++) {
+        char digit = dtmf_pair(60, 6000.0f, 6000.0f * powf(10.0f, db[i] / 20.0f));
+        printf("    column %+.1f dB: %s, %u blocks rejected\n", db[i], digit ? "reported" : "ignored", (unsigned)s_det.stats.rejected);
+        if (i < 2) {
+            TEST_CHECK(digit == '5');
+        } else {
+            TEST_CHECK(digit == 0);
+            TEST_CHECK(s_det.stats.rejected > 0);
+        }
+    }
+    return 0;
+}
+
+// unknown digits and digits over a full queue are refused and counted
+static int test_dtmf_queue(void) {
+    audio_dtmf_gen_init(&s_gen, 8000);
+    TEST_CHECK(!audio_dtmf_gen_push(&s_gen, 'x'));
+    for (uint32_t i = 0; i < AUDIO_DTMF_QUEUE; i++) {
+        TEST_CHECK(audio_dtmf_gen_push(&s_gen, '1'));
+    }
+    TEST_CHECK(!audio_dtmf_gen_push(&s_gen, '1'));
+    TEST_CHECK(s_gen.dropped == 2);
+    return 0;
+}
+
+int main(void) {
+    int failed = 0;
+    TEST_RUN(test_dtmf_round_trip, failed);
+    TEST_RUN(test_dtmf_duration, failed);
+    TEST_RUN(test_dtmf_talk_off, failed);
+    TEST_RUN(test_dtmf_twist, failed);
+    TEST_RUN(test_dtmf_queue, failed);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,246 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "audio_frame.h"
+#include "audio_gain.h"
+#include "test_audio.h"
+
+#define GAIN_RATE   (8000)
+#define GAIN_FRAME  (PCM_FRAME_SAMPLES)
+#define GAIN_FRAMES (20)
+
+static audio_gain_t s_gain;
+static audio_agc_t s_agc;
+static int16_t s_pcm[GAIN_FRAMES * GAIN_FRAME];
+
+// the gain applied through frames of GAIN_FRAME samples
+static void gain_run(int16_t *pcm, uint32_t frames) {
+    for (uint32_t f = 0; f < frames; f++) {
+        audio_gain_process(&s_gain, pcm + f * GAIN_FRAME, GAIN_FRAME);
+    }
+}
+
+// a full scale sine at +18 dB clips at the rails, never wraps round
+static int test_gain_saturate(void) {
+    static int16_t in[GAIN_FRAMES * GAIN_FRAME];
+    double phase = 0.0;
+    uint32_t clipped = 0;
+
+    test_sine(in, GAIN_FRAMES * GAIN_FRAME, 1000.0f, 32767.0f, GAIN_RATE, &phase);
+    memcpy(s_pcm, in, sizeof(in));
+    audio_gain_init(&s_gain, GAIN_RATE, AUDIO_GAIN_MAX);
+    gain_run(s_pcm, GAIN_FRAMES);
+    for (uint32_t i = 0; i < GAIN_FRAMES * GAIN_FRAME; i++) {
+        double want = in[i] * (double)AUDIO_GAIN_MAX / AUDIO_GAIN_ONE;
+        want = (want > INT16_MAX) ? INT16_MAX : (want < INT16_MIN) ? INT16_MIN : want;
+        TEST_CHECK(fabs(s_pcm[i] - want) <= 1.0);
+        clipped += (s_pcm[i] == INT16_MAX || s_pcm[i] == INT16_MIN);
+    }
+    printf("    +%.1f dB on full scale: %u of %u samples at the rails\n", 20.0 * log10((double)AUDIO_GAIN_MAX / AUDIO_GAIN_ONE),
+           (unsigned)clipped, (unsigned)(GAIN_FRAMES * GAIN_FRAME));
+    TEST_CHECK(clipped > GAIN_FRAMES * GAIN_FRAME / 2);
+    return 0;
+}
+
+// loud frames after quiet ones: the gain is pulled down at the frame start, no sample goes over the ceiling
+static int test_gain_limit(void) {
+    const int16_t ceiling = 16000;
+    const uint32_t loud = GAIN_FRAMES / 2;
+    double phase = 0.0;
+    int32_t peak = 0;
+
+    test_sine(s_pcm, loud * GAIN_FRAME, 1000.0f, 1000.0f, GAIN_RATE, &phase);
+    test_sine(s_pcm + loud * GAIN_FRAME, (GAIN_FRAMES - loud) * GAIN_FRAME, 1000.0f, 8000.0f, GAIN_RATE, &phase);
+    audio_gain_init(&s_gain, GAIN_RATE, AUDIO_GAIN_ONE);
+    audio_gain_set_ceiling(&s_gain, ceiling);
+    // +12 dB, the loud frames would reach 32000
+    audio_gain_set(&s_gain, 4 * AUDIO_GAIN_ONE);
+    gain_run(s_pcm, GAIN_FRAMES);
+    for (uint32_t i = 0; i < GAIN_FRAMES * GAIN_FRAME; i++) {
+        peak = (abs(s_pcm[i]) > peak) ? abs(s_pcm[i]) : peak;
+    }
+    printf("    ceiling %d: peak %d, %u frames limited\n", ceiling, (int)peak, (unsigned)s_gain.limited);
+    TEST_CHECK(peak <= ceiling);
+    TEST_CHECK(s_gain.limited == GAIN_FRAMES - loud);
+
+    // without the ceiling the same frames go through at full gain
+    audio_gain_set_ceiling(&s_gain, 0);
+    audio_gain_set(&s_gain, 4 * AUDIO_GAIN_ONE);
+    test_sine(s_pcm, GAIN_FRAMES * GAIN_FRAME, 1000.0f, 8000.0f, GAIN_RATE, &phase);
+    gain_run(s_pcm, GAIN_FRAMES);
+    peak = 0;
+    for (uint32_t i = (GAIN_FRAMES - 1) * GAIN_FRAME; i < GAIN_FRAMES * GAIN_FRAME; i++) {
+        peak = (abs(s_pcm[i]) > peak) ? abs(s_pcm[i]) : peak;
+    }
+    TEST_CHECK(peak > 31000);
+    TEST_CHECK(s_gain.limited == GAIN_FRAMES - loud);
+    return 0;
+}
+
+// a constant input shows the gain itself: each ramp rises, or falls, smoothly across frame boundaries
+static int gain_check_ramp(int32_t from, int32_t to) {
+    const int16_t dc = 1000;
+    // the steepest slope on dc, plus a sample of rounding
+    const int32_t max_step = (int32_t)(((int64_t)s_gain.slope_q8 * dc + (AUDIO_GAIN_ONE << 8) - 1) / (AUDIO_GAIN_ONE << 8)) + 1;
+    int32_t worst = 0;
+
+    for (uint32_t i = 0; i < GAIN_FRAMES * GAIN_FRAME; i++) {
+        s_pcm[i] = dc;
+    }
+    audio_gain_init(&s_gain, GAIN_RATE, from);
+    audio_gain_set(&s_gain, to);
+    int32_t prev = (from * dc + (1 << 11)) >> 12;
+    for (uint32_t i = 0; i < GAIN_FRAMES * GAIN_FRAME; i += GAIN_FRAME) {
+        audio_gain_process(&s_gain, s_pcm + i, GAIN_FRAME);
+    }
+    for (uint32_t i = 0; i < GAIN_FRAMES * GAIN_FRAME; i++) {
+        int32_t d = s_pcm[i] - prev;
+        TEST_CHECK((to >= from) ? d >= 0 : d <= 0);
+        worst = (abs(d) > worst) ? abs(d) : worst;
+        prev = s_pcm[i];
+    }
+    printf("    %5d -> %5d: largest step %d of %d allowed, ends at %d\n", (int)from, (int)to, (int)worst, (int)max_step,
+           s_pcm[GAIN_FRAMES * GAIN_FRAME - 1]);
+    TEST_CHECK(worst <= max_step);
+    TEST_CHECK(s_gain.cur == to);
+    TEST_CHECK(s_pcm[GAIN_FRAMES * GAIN_FRAME - 1] == (to * dc + (1 << 11)) >> 12);
+    return 0;
+}
+
+static int test_gain_ramp(void) {
+    audio_gain_init(&s_gain, GAIN_RATE, 0);
+    TEST_CHECK(gain_check_ramp(0, AUDIO_GAIN_MAX) == 0);
+    TEST_CHECK(gain_check_ramp(AUDIO_GAIN_MAX, 0) == 0);
+    TEST_CHECK(gain_check_ramp(AUDIO_GAIN_ONE, 2 * AUDIO_GAIN_ONE) == 0);
+    TEST_CHECK(gain_check_ramp(audio_gain_from_step(15), audio_gain_from_step(4)) == 0);
+    return 0;
+}
+
+// 3 dB per volume step below unity, 0 mutes, steps past the top clamp to it
+static int test_gain_steps(void) {
+    TEST_CHECK(audio_gain_from_step(0) == 0);
+    TEST_CHECK(audio_gain_from_step(AUDIO_GAIN_STEPS - 1) == AUDIO_GAIN_ONE);
+    TEST_CHECK(audio_gain_from_step(AUDIO_GAIN_STEPS + 3) == AUDIO_GAIN_ONE);
+    double worst = 0.0;
+    for (uint32_t s = 1; s < AUDIO_GAIN_STEPS; s++) {
+        double db = 20.0 * log10((double)audio_gain_from_step(s) / AUDIO_GAIN_ONE);
+        double err = fabs(db + AUDIO_GAIN_STEP_DB * (AUDIO_GAIN_STEPS - 1.0 - s));
+        worst = (err > worst) ? err : worst;
+        TEST_CHECK(audio_gain_from_step(s) > audio_gain_from_step(s - 1));
+    }
+    printf("    steps 1..15 within %.2f dB of 3 dB apart, step 1 at %.1f dB\n", worst,
+           20.0 * log10((double)audio_gain_from_step(1) / AUDIO_GAIN_ONE));
+    TEST_CHECK(worst < 0.2);
+    TEST_CHECK(audio_gain_from_db(0.0f) == AUDIO_GAIN_ONE);
+    TEST_CHECK(audio_gain_from_db(40.0f) == AUDIO_GAIN_MAX);
+    return 0;
+}
+
+// seconds of a tone at level_db through the AGC, returns the gain it ends at in dB
+static double agc_run(double level_db, uint32_t seconds, double *phase) {
+    const float amp = (float)(32768.0 * sqrt(2.0) * pow(10.0, level_db / 20.0));
+    int32_t g = 0;
+    for (uint32_t f = 0; f < seconds * 1000000 / PCM_BLOCK_DURATION_US; f++) {
+        test_sine(s_pcm, GAIN_FRAME, 1000.0f, amp, GAIN_RATE, phase);
+        g = audio_agc_process(&s_agc, s_pcm, GAIN_FRAME);
+    }
+    return 20.0 * log10((double)g / AUDIO_GAIN_ONE);
+}
+
+// quiet and loud talkers settle on the target within the boost and cut limits, silence holds the gain
+static int test_agc(void) {
+    double phase = 0.0;
+
+    audio_agc_init(&s_agc, GAIN_RATE, GAIN_FRAME);
+    double one = agc_run(-32.0, 1, &phase);
+    double quiet = agc_run(-32.0, 4, &phase);
+    printf("    -32 dBFS: %+.1f dB after 1 s, %+.1f dB after 5 s\n", one, quiet);
+    TEST_CHECK(one > 4.0 && one < 8.0);
+    TEST_CHECK(fabs(quiet - (AUDIO_AGC_TARGET_DBFS + 32.0)) < 0.5);
+
+    double held = agc_run(AUDIO_AGC_GATE_DBFS - 10.0, 3, &phase);
+    printf("    %d dBFS, under the gate: %+.1f dB held\n", AUDIO_AGC_GATE_DBFS - 10, held);
+    TEST_CHECK(fabs(held - quiet) < 0.01);
+
+    double boost = agc_run(AUDIO_AGC_GATE_DBFS + 5.0, 10, &phase);
+    double cut = agc_run(-2.0, 1, &phase);
+    printf("    %d dBFS: %+.1f dB, -2 dBFS: %+.1f dB after 1 s\n", AUDIO_AGC_GATE_DBFS + 5, boost, cut);
+    TEST_CHECK(fabs(boost - AUDIO_AGC_MAX_DB) < 0.1);
+    TEST_CHECK(fabs(cut - AUDIO_AGC_MIN_DB) < 0.1);
+    return 0;
+}
+
+// ns per sample: unity, a fixed gain, a ramp, the limiter on, and the AGC measuring its frame
+static int test_gain_bench(void) {
+    const uint32_t rounds = 20000;
+    const char *name[] = {"unity", "fixed", "ramp", "limiter"};
+    double phase = 0.0;
+    int32_t sink = 0;
+
+    for (uint32_t m = 0; m < 4; m++) {
+        audio_gain_init(&s_gain, GAIN_RATE, (m == 0) ? AUDIO_GAIN_ONE : 3 * AUDIO_GAIN_ONE);
+        audio_gain_set_ceiling(&s_gain, (m == 3) ? 30000 : 0);
+        test_sine(s_pcm, GAIN_FRAME, 1000.0f, 8000.0f, GAIN_RATE, &phase);
+        uint64_t t0 = test_now_ns();
+        for (uint32_t k = 0; k < rounds; k++) {
+            if (m == 2) {
+                audio_gain_set(&s_gain, (k & 1) ? 0 : AUDIO_GAIN_MAX);
+            }
+            audio_gain_process(&s_gain, s_pcm, GAIN_FRAME);
+            // keep the frame from settling at a rail or at zero
+            s_pcm[k % GAIN_FRAME] ^= 0x155;
+            sink += s_pcm[0];
+        }
+        printf("    %-8s %5.2f ns per sample\n", name[m], (double)(test_now_ns() - t0) / (rounds * GAIN_FRAME));
+    }
+
+    audio_agc_init(&s_agc, GAIN_RATE, GAIN_FRAME);
+    uint64_t t0 = test_now_ns();
+    for (uint32_t k = 0; k < rounds; k++) {
+        sink += audio_agc_process(&s_agc, s_pcm, GAIN_FRAME);
+    }
+    printf("    %-8s %5.2f ns per sample (%d)\n", "agc", (double)(test_now_ns() - t0) / (rounds * GAIN_FRAME), (int)(sink & 1));
+    return 0;
+}
+
+int main(void) {
+    int failed = 0;
+    TEST_RUN(test_gain_saturate, failed);
+    TEST_RUN(test_gain_limit, failed);
+    TEST_RUN(test_gain_ramp, failed);
+    TEST_RUN(test_gain_steps, failed);
+    TEST_RUN(test_agc, failed);
+    TEST_RUN(test_gain_bench, failed);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,145 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "audio_jbuf.h"
+#include "test_audio.h"
+
+static audio_jbuf_t s_jb;
+
+// frame f, sent as two packets of 30 and 90 bytes as a CVSD link may split it
+static void jbuf_send(uint32_t f, int64_t now_us) {
+    uint8_t frame[PCM_INPUT_DATA_SIZE];
+    for (uint32_t i = 0; i < sizeof(frame); i++) {
+        frame[i] = (uint8_t)(f + i);
+    }
+    audio_jbuf_put(&s_jb, frame, 30, now_us);
+    audio_jbuf_put(&s_jb, frame + 30, sizeof(frame) - 30, now_us);
+}
+
+// steady arrivals: frames come out whole and in order, the target settles at the minimum depth
+static int test_jbuf_steady(void) {
+    audio_jbuf_init(&s_jb, PCM_INPUT_DATA_SIZE);
+    int64_t now = 1000;
+    uint32_t next = 0;
+
+    for (uint32_t f = 0; f < 1000; f++, now += PCM_BLOCK_DURATION_US) {
+        jbuf_send(f, now);
+        uint8_t *frame = audio_jbuf_get(&s_jb);
+        if (frame == NULL) {
+            continue;
+        }
+        for (uint32_t i = 0; i < PCM_INPUT_DATA_SIZE; i++) {
+            TEST_CHECK(frame[i] == (uint8_t)(next + i));
+        }
+        TEST_CHECK(audio_jbuf_tag(&s_jb)->seq == next);
+        audio_jbuf_release(&s_jb);
+        next++;
+    }
+
+    audio_jbuf_stats_t st;
+    audio_jbuf_get_stats(&s_jb, &st);
+    TEST_CHECK(st.target == AUDIO_JBUF_MIN_DEPTH);
+    TEST_CHECK(st.underruns == 0 && st.overruns == 0);
+    TEST_CHECK(st.frames_in == 1000 && next >= 990);
+    return 0;
+}
+
+// frames arriving in bursts of four: the target grows to cover the gap, and no frame is lost once it has
+static int test_jbuf_burst(void) {
+    audio_jbuf_init(&s_jb, PCM_INPUT_DATA_SIZE);
+    int64_t now = 1000;
+    uint32_t f = 0;
+    uint32_t underruns_late = 0;
+
+    for (uint32_t tick = 0; tick < 2000; tick++, now += PCM_BLOCK_DURATION_US) {
+        if (tick % 4 == 3) {
+            for (int i = 0; i < 4; i++) {
+                jbuf_send(f++, now);
+            }
+        }
+        uint32_t before = s_jb.underruns;
+        if (audio_jbuf_get(&s_jb)) {
+            audio_jbuf_release(&s_jb);
+        }
+        if (tick >= 100 && s_jb.underruns != before) {
+            underruns_late++;
+        }
+    }
+
+    audio_jbuf_stats_t st;
+    audio_jbuf_get_stats(&s_jb, &st);
+    TEST_CHECK(st.target >= 4 && st.target <= AUDIO_JBUF_MAX_DEPTH);
+    TEST_CHECK(underruns_late == 0);
+    TEST_CHECK(st.overruns == 0);
+    return 0;
+}
+
+// a starved consumer counts one underrun and waits for the target again, a backlog is trimmed down to it
+static int test_jbuf_underrun_and_trim(void) {
+    audio_jbuf_init(&s_jb, PCM_INPUT_DATA_SIZE);
+    int64_t now = 1000;
+    uint32_t f = 0;
+
+    for (; f < 4; f++, now += PCM_BLOCK_DURATION_US) {
+        jbuf_send(f, now);
+    }
+    while (audio_jbuf_get(&s_jb)) {
+        audio_jbuf_release(&s_jb);
+    }
+    TEST_CHECK(s_jb.underruns == 1);
+    TEST_CHECK(audio_jbuf_get(&s_jb) == NULL);
+    TEST_CHECK(s_jb.underruns == 1);
+
+    // a backlog of ten frames, then steady arrivals one per pull
+    for (int i = 0; i < 10; i++) {
+        jbuf_send(f++, now);
+    }
+    for (uint32_t tick = 0; tick < 20 * AUDIO_JBUF_SHRINK_HOLD; tick++, now += PCM_BLOCK_DURATION_US) {
+        jbuf_send(f++, now);
+        TEST_CHECK(audio_jbuf_get(&s_jb) != NULL);
+        audio_jbuf_release(&s_jb);
+    }
+    audio_jbuf_stats_t st;
+    audio_jbuf_get_stats(&s_jb, &st);
+    TEST_CHECK(st.drops > 0);
+    TEST_CHECK(st.depth <= st.target + 1);
+    return 0;
+}
+
+int main(void) {
+    int failed = 0;
+    TEST_RUN(test_jbuf_steady, failed);
+    TEST_RUN(test_jbuf_burst, failed);
+    TEST_RUN(test_jbuf_underrun_and_trim, failed);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,229 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "audio_frame.h"
+#include "audio_mixer.h"
+#include "test_audio.h"
+
+typedef struct {
+    int16_t frame[WBS_PCM_FRAME_SAMPLES];
+    bool active;        // has a frame to give
+    uint32_t pulls;     // frames handed over
+    uint32_t releases;
+} mixer_src_t;
+
+static audio_mixer_t s_mixer;
+
+static const int16_t *mixer_pull(void *ctx, uint32_t samples) {
+    mixer_src_t *src = (mixer_src_t *)ctx;
+    if (!src->active) {
+        return NULL;
+    }
+    src->pulls++;
+    return src->frame;
+}
+
+static void mixer_release(void *ctx) {
+    ((mixer_src_t *)ctx)->releases++;
+}
+
+static void mixer_src_init(mixer_src_t *src, int16_t value) {
+    memset(src, 0, sizeof(mixer_src_t));
+    for (uint32_t i = 0; i < WBS_PCM_FRAME_SAMPLES; i++) {
+        src->frame[i] = value;
+    }
+    src->active = true;
+}
+
+// enabled sources are summed, disabled ones never pulled, and every frame pulled is released once
+static int test_mixer_sum(void) {
+    mixer_src_t a, b, c;
+    int16_t out[WBS_PCM_FRAME_SAMPLES];
+    mixer_src_init(&a, 1000);
+    mixer_src_init(&b, -3000);
+    mixer_src_init(&c, 7);
+    audio_mixer_init(&s_mixer);
+    int ia = audio_mixer_add(&s_mixer, mixer_pull, mixer_release, &a, 0, AUDIO_MIXER_ONE, AUDIO_MIXER_ONE);
+    int ib = audio_mixer_add(&s_mixer, mixer_pull, mixer_release, &b, 0, AUDIO_MIXER_ONE, AUDIO_MIXER_ONE);
+    int ic = audio_mixer_add(&s_mixer, mixer_pull, NULL, &c, 0, AUDIO_MIXER_ONE, AUDIO_MIXER_ONE);
+    TEST_CHECK(ia >= 0 && ib >= 0 && ic >= 0);
+
+    TEST_CHECK(audio_mixer_mix(&s_mixer, out, PCM_FRAME_SAMPLES) == 0);
+    TEST_CHECK(out[0] == 0 && s_mixer.empty == 1);
+
+    audio_mixer_enable(&s_mixer, ia, true);
+    audio_mixer_enable(&s_mixer, ib, true);
+    TEST_CHECK(audio_mixer_mix(&s_mixer, out, PCM_FRAME_SAMPLES) == 2);
+    for (uint32_t i = 0; i < PCM_FRAME_SAMPLES; i++) {
+        TEST_CHECK(out[i] == -2000);
+    }
+    b.active = false;
+    TEST_CHECK(audio_mixer_mix(&s_mixer, out, WBS_PCM_FRAME_SAMPLES) == 1);
+    TEST_CHECK(out[WBS_PCM_FRAME_SAMPLES - 1] == 1000);
+    TEST_CHECK(a.pulls == 2 && a.releases == 2);
+    TEST_CHECK(b.pulls == 1 && b.releases == 1);
+    TEST_CHECK(c.pulls == 0);
+
+    // the sum saturates once, at the end
+    b.active = true;
+    a.frame[0] = b.frame[0] = 30000;
+    a.frame[1] = b.frame[1] = -30000;
+    a.frame[2] = 30000;
+    b.frame[2] = -30000;
+    TEST_CHECK(audio_mixer_mix(&s_mixer, out, PCM_FRAME_SAMPLES) == 2);
+    TEST_CHECK(out[0] == INT16_MAX && out[1] == INT16_MIN && out[2] == 0);
+    return 0;
+}
+
+// a gain change ramps in over one frame and holds from the next
+static int test_mixer_gain(void) {
+    mixer_src_t a;
+    int16_t out[PCM_FRAME_SAMPLES];
+    mixer_src_init(&a, 8000);
+    audio_mixer_init(&s_mixer);
+    int ia = audio_mixer_add(&s_mixer, mixer_pull, mixer_release, &a, 0, AUDIO_MIXER_ONE, AUDIO_MIXER_ONE);
+    audio_mixer_enable(&s_mixer, ia, true);
+    audio_mixer_mix(&s_mixer, out, PCM_FRAME_SAMPLES);
+
+    audio_mixer_set_gain(&s_mixer, ia, AUDIO_MIXER_ONE / 4);
+    audio_mixer_mix(&s_mixer, out, PCM_FRAME_SAMPLES);
+    printf("    unity to -12 dB: %d, %d .. %d, %d\n", out[0], out[1], out[PCM_FRAME_SAMPLES - 2], out[PCM_FRAME_SAMPLES - 1]);
+    for (uint32_t i = 1; i < PCM_FRAME_SAMPLES; i++) {
+        TEST_CHECK(out[i] <= out[i - 1]);
+        TEST_CHECK(out[i - 1] - out[i] < 2 * 6000 / PCM_FRAME_SAMPLES);
+    }
+    TEST_CHECK(out[0] > 7800 && abs(out[PCM_FRAME_SAMPLES - 1] - 2000) <= 120);
+    audio_mixer_mix(&s_mixer, out, PCM_FRAME_SAMPLES);
+    TEST_CHECK(out[0] == 2000 && out[PCM_FRAME_SAMPLES - 1] == 2000);
+
+    // a gain over the limit is held to it
+    audio_mixer_set_gain(&s_mixer, ia, 8 * AUDIO_MIXER_ONE);
+    audio_mixer_mix(&s_mixer, out, PCM_FRAME_SAMPLES);
+    audio_mixer_mix(&s_mixer, out, PCM_FRAME_SAMPLES);
+    TEST_CHECK(out[0] == 16000);
+    return 0;
+}
+
+// a higher priority source ducks the lower ones while it has frames and lets them back when it stops
+static int test_mixer_duck(void) {
+    mixer_src_t music, voice, prompt;
+    int16_t out[PCM_FRAME_SAMPLES] = {0};
+    mixer_src_init(&music, 4000);
+    mixer_src_init(&voice, 0);
+    mixer_src_init(&prompt, 0);
+    audio_mixer_init(&s_mixer);
+    int im = audio_mixer_add(&s_mixer, mixer_pull, NULL, &music, 0, AUDIO_MIXER_ONE, AUDIO_MIXER_ONE / 8);
+    int iv = audio_mixer_add(&s_mixer, mixer_pull, NULL, &voice, 1, AUDIO_MIXER_ONE, AUDIO_MIXER_ONE / 2);
+    int ip = audio_mixer_add(&s_mixer, mixer_pull, NULL, &prompt, 2, AUDIO_MIXER_ONE, AUDIO_MIXER_ONE);
+    audio_mixer_enable(&s_mixer, im, true);
+    audio_mixer_enable(&s_mixer, iv, true);
+    audio_mixer_enable(&s_mixer, ip, true);
+    voice.active = prompt.active = false;
+
+    const struct {
+        bool voice;
+        bool prompt;
+        int16_t music_out; // steady level of the music once the ramp is over
+    } steps[] = {
+        {false, false, 4000}, // alone at unity
+        {true, false, 500},   // under the voice
+        {true, true, 500},    // under both, ducking does not stack
+        {false, false, 4000}, // back
+    };
+    for (uint32_t s = 0; s < sizeof(steps) / sizeof(steps[0]); s++) {
+        voice.active = steps[s].voice;
+        prompt.active = steps[s].prompt;
+        int16_t prev = out[PCM_FRAME_SAMPLES - 1];
+        audio_mixer_mix(&s_mixer, out, PCM_FRAME_SAMPLES);
+        // ramped from where the last frame ended, no step at the frame boundary
+        TEST_CHECK(s == 0 || abs(out[0] - prev) < 4000 / PCM_FRAME_SAMPLES + 2);
+        audio_mixer_mix(&s_mixer, out, PCM_FRAME_SAMPLES);
+        TEST_CHECK(out[0] == steps[s].music_out && out[PCM_FRAME_SAMPLES - 1] == steps[s].music_out);
+    }
+    printf("    music ducked for %u of %u frames, voice ducked for %u\n", (unsigned)s_mixer.src[im].ducked, (unsigned)s_mixer.src[im].frames,
+           (unsigned)s_mixer.src[iv].ducked);
+    TEST_CHECK(s_mixer.src[im].ducked == 4);
+    TEST_CHECK(s_mixer.src[iv].ducked == 2);
+    return 0;
+}
+
+// ns per 16 kHz frame with 0..AUDIO_MIXER_SOURCES sources enabled, out of all registered and out of only as many
+// registered: the disabled ones are never visited
+static double mixer_time(mixer_src_t *src, uint32_t registered, uint32_t enabled, int16_t *out) {
+    const uint32_t rounds = 20000;
+    int32_t sink = 0;
+
+    audio_mixer_init(&s_mixer);
+    for (uint32_t i = 0; i < registered; i++) {
+        mixer_src_init(&src[i], (int16_t)(100 * i + 1));
+        int id = audio_mixer_add(&s_mixer, mixer_pull, mixer_release, &src[i], 0, AUDIO_MIXER_ONE, AUDIO_MIXER_ONE);
+        audio_mixer_enable(&s_mixer, id, (uint32_t)id < enabled);
+    }
+    // the best of a few runs, the host is shared
+    uint64_t best = UINT64_MAX;
+    for (uint32_t r = 0; r < 5; r++) {
+        uint64_t t0 = test_now_ns();
+        for (uint32_t k = 0; k < rounds; k++) {
+            sink += (int32_t)audio_mixer_mix(&s_mixer, out, WBS_PCM_FRAME_SAMPLES) + out[0];
+        }
+        uint64_t dt = test_now_ns() - t0;
+        best = (dt < best) ? dt : best;
+    }
+    out[0] = (int16_t)sink;
+    return (double)best / rounds;
+}
+
+static int test_mixer_bench(void) {
+    mixer_src_t src[AUDIO_MIXER_SOURCES];
+    int16_t out[WBS_PCM_FRAME_SAMPLES];
+    for (uint32_t k = 0; k <= AUDIO_MIXER_SOURCES; k++) {
+        double all = mixer_time(src, AUDIO_MIXER_SOURCES, k, out);
+        for (uint32_t i = k; i < AUDIO_MIXER_SOURCES; i++) {
+            TEST_CHECK(src[i].pulls == 0);
+        }
+        double only = mixer_time(src, k, k, out);
+        printf("    %u enabled: %5.0f ns per frame with %u registered, %5.0f ns with %u (%d)\n", (unsigned)k, all, AUDIO_MIXER_SOURCES,
+               only, (unsigned)k, out[0] & 1);
+    }
+    return 0;
+}
+
+int main(void) {
+    int failed = 0;
+    TEST_RUN(test_mixer_sum, failed);
+    TEST_RUN(test_mixer_gain, failed);
+    TEST_RUN(test_mixer_duck, failed);
+    TEST_RUN(test_mixer_bench, failed);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,207 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "audio_frame.h"
+#include "audio_ns.h"
+#include "test_audio.h"
+
+#define NS_SECONDS (4)
+#define NS_FRAMES  (NS_SECONDS * 1000000 / PCM_BLOCK_DURATION_US)
+
+static audio_ns_t s_ns;
+static int16_t s_in[NS_FRAMES * WBS_PCM_FRAME_SAMPLES];
+static int16_t s_out[NS_FRAMES * WBS_PCM_FRAME_SAMPLES];
+static float s_noise_db[NS_FRAMES];
+
+// white noise of rms dBFS, plus a tone of tone_amp from sample tone_from on
+static void ns_source(int16_t *pcm, uint32_t rate, uint32_t n, double rms_db, float tone_amp, uint32_t tone_from) {
+    const double amp = 32767.0 * pow(10.0, rms_db / 20.0) * sqrt(3.0);
+    uint32_t seed = 1;
+    double phase = 0.0;
+    for (uint32_t i = 0; i < n; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        double v = amp * ((seed >> 8) / 8388608.0 - 1.0);
+        if (i >= tone_from) {
+            v += tone_amp * sin(phase);
+            phase += 2.0 * M_PI * 1000.0 / rate;
+        }
+        pcm[i] = (int16_t)lrint(v);
+    }
+}
+
+// the suppressor over n frames of s_in, s_out lined up with it again by dropping the frame of latency
+static void ns_run(uint32_t rate, uint32_t frames) {
+    const uint32_t frame = rate / 1000 * PCM_BLOCK_DURATION_US / 1000;
+    audio_ns_init(&s_ns, rate);
+    memcpy(s_out, s_in, frames * frame * BYTES_PER_SAMPLE);
+    for (uint32_t f = 0; f < frames; f++) {
+        audio_ns_process(&s_ns, s_out + f * frame);
+        s_noise_db[f] = s_ns.stats.noise_db;
+    }
+    memmove(s_out, s_out + frame, (frames - 1) * frame * BYTES_PER_SAMPLE);
+}
+
+static double ns_db(const int16_t *pcm, uint32_t n) {
+    return 10.0 * log10(test_power(pcm, n) / (32767.0 * 32767.0) + 1e-15);
+}
+
+// steady noise is held down towards the gain floor from the first second on
+static int ns_check_noise(uint32_t rate) {
+    ns_source(s_in, rate, NS_FRAMES * WBS_PCM_FRAME_SAMPLES, -40.0, 0.0f, UINT32_MAX);
+    ns_run(rate, NS_FRAMES);
+    const uint32_t from = rate, n = (NS_SECONDS - 1) * rate - rate / 10;
+    double atten = ns_db(s_out + from, n) - ns_db(s_in + from, n);
+    printf("    %u Hz, noise at -40.0 dBFS: attenuated %.1f dB, floor estimate %.1f dB\n", (unsigned)rate, atten, s_ns.stats.noise_db);
+    TEST_CHECK(atten < -10.0);
+    TEST_CHECK(atten > AUDIO_NS_FLOOR_DB - 3.0);
+    TEST_CHECK(s_ns.stats.atten_db < -10.0f);
+    return 0;
+}
+
+static int test_ns_noise(void) {
+    TEST_CHECK(ns_check_noise(8000) == 0);
+    TEST_CHECK(ns_check_noise(16000) == 0);
+    return 0;
+}
+
+// a tone well over the noise keeps its level while the noise around it goes
+static int ns_check_tone(uint32_t rate) {
+    const float amp = 8000.0f;
+    const uint32_t from = rate + rate / 10, n = rate;
+    ns_source(s_in, rate, NS_FRAMES * WBS_PCM_FRAME_SAMPLES, -45.0, amp, rate);
+    ns_run(rate, NS_FRAMES);
+    double snr_in = test_snr_db(s_in + from, n, 1000.0f, rate);
+    double snr_out = test_snr_db(s_out + from, n, 1000.0f, rate);
+    double level = test_tone_db(s_out + from, n, 1000.0f, rate) - test_tone_db(s_in + from, n, 1000.0f, rate);
+    printf("    %u Hz, tone 30 dB over the noise: SNR %.1f dB in, %.1f dB out, tone level %+.2f dB\n", (unsigned)rate, snr_in, snr_out,
+           level);
+    TEST_CHECK(snr_out > snr_in + 6.0);
+    TEST_CHECK(fabs(level) < 1.0);
+    return 0;
+}
+
+static int test_ns_tone(void) {
+    TEST_CHECK(ns_check_tone(8000) == 0);
+    TEST_CHECK(ns_check_tone(16000) == 0);
+    return 0;
+}
+
+// the floor follows noise dropping within a few frames and climbs back no faster than its rise rate
+static int test_ns_track(void) {
+    const uint32_t rate = 8000, frame = PCM_FRAME_SAMPLES, step = NS_FRAMES / 2;
+    ns_source(s_in, rate, step * frame, -30.0, 0.0f, UINT32_MAX);
+    ns_source(s_in + step * frame, rate, step * frame, -50.0, 0.0f, UINT32_MAX);
+    ns_run(rate, NS_FRAMES);
+
+    double high = s_noise_db[step - 1];
+    double low = s_noise_db[step + 20];
+    printf("    noise down 20 dB: floor estimate %.1f dB, %.1f dB 150 ms later\n", high, low);
+    TEST_CHECK(high - low > 15.0);
+
+    // and back up by 20 dB
+    ns_source(s_in, rate, step * frame, -50.0, 0.0f, UINT32_MAX);
+    ns_source(s_in + step * frame, rate, step * frame, -30.0, 0.0f, UINT32_MAX);
+    ns_run(rate, NS_FRAMES);
+    double rise = (s_noise_db[NS_FRAMES - 1] - s_noise_db[step]) / (NS_SECONDS / 2.0);
+    printf("    noise up 20 dB: floor estimate climbs %.1f dB/s\n", rise);
+    TEST_CHECK(rise > 2.0);
+    TEST_CHECK(rise < 6.0);
+    return 0;
+}
+
+// talk then silence: the first skipped frame carries the faded end of the last processed one, later ones nothing
+static int test_ns_skip_tail(void) {
+    const uint32_t rate = 16000, frame = WBS_PCM_FRAME_SAMPLES, frames = NS_FRAMES / 4;
+    int16_t pcm[WBS_PCM_FRAME_SAMPLES];
+
+    ns_source(s_in, rate, frames * frame, -60.0, 8000.0f, rate / 2);
+    audio_ns_init(&s_ns, rate);
+    memcpy(s_out, s_in, frames * frame * BYTES_PER_SAMPLE);
+    for (uint32_t f = 0; f < frames; f++) {
+        audio_ns_process(&s_ns, s_out + f * frame);
+    }
+    const int16_t last = s_out[frames * frame - 1];
+
+    memset(pcm, 0, sizeof(pcm));
+    TEST_CHECK(audio_ns_skip(&s_ns, pcm));
+    // the window squared over its falling half keeps 3/8 of the power of the last input frame
+    double tail_db = ns_db(pcm, frame);
+    double frame_db = ns_db(s_in + (frames - 1) * frame, frame) + 10.0 * log10(3.0 / 8.0);
+    printf("    tail %.1f dB against %.1f dB expected, joins at %d after %d, ends at %d\n", tail_db, frame_db, pcm[0], last,
+           pcm[frame - 1]);
+    TEST_CHECK(fabs(tail_db - frame_db) < 1.0);
+    // one step of the 1 kHz tone at most, then down to nothing
+    TEST_CHECK(abs(pcm[0] - last) < 4000);
+    TEST_CHECK(abs(pcm[frame - 1]) < 100);
+
+    memset(pcm, 0, sizeof(pcm));
+    TEST_CHECK(!audio_ns_skip(&s_ns, pcm));
+    TEST_CHECK(test_power(pcm, frame) == 0.0);
+    return 0;
+}
+
+// time per 7.5 ms frame over steady noise
+static int test_ns_bench(void) {
+    const uint32_t rates[] = {8000, 16000};
+    for (uint32_t r = 0; r < 2; r++) {
+        const uint32_t rate = rates[r], frame = rate / 1000 * PCM_BLOCK_DURATION_US / 1000;
+        const uint32_t rounds = 5;
+        int32_t sink = 0;
+
+        ns_source(s_in, rate, NS_FRAMES * frame, -40.0, 0.0f, UINT32_MAX);
+        audio_ns_init(&s_ns, rate);
+        uint64_t t0 = test_now_ns();
+        for (uint32_t k = 0; k < rounds; k++) {
+            memcpy(s_out, s_in, NS_FRAMES * frame * BYTES_PER_SAMPLE);
+            for (uint32_t f = 0; f < NS_FRAMES; f++) {
+                audio_ns_process(&s_ns, s_out + f * frame);
+            }
+            sink += s_out[0];
+        }
+        double ns = (double)(test_now_ns() - t0) / (rounds * NS_FRAMES);
+        printf("    %5u Hz, %u point FFT: %6.0f ns per frame, %.0fx real time (%d)\n", (unsigned)rate, (unsigned)s_ns.fft.n, ns,
+               PCM_BLOCK_DURATION_US * 1000.0 / ns, (int)(sink & 1));
+    }
+    return 0;
+}
+
+int main(void) {
+    int failed = 0;
+    TEST_RUN(test_ns_noise, failed);
+    TEST_RUN(test_ns_tone, failed);
+    TEST_RUN(test_ns_track, failed);
+    TEST_RUN(test_ns_skip_tail, failed);
+    TEST_RUN(test_ns_bench, failed);
+    return failed ? 1 : 0;
+}
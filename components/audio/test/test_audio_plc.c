@@ -0,0 +1,117 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "audio_plc.h"
+#include "test_audio.h"
+
+#define PLC_RATE   (16000)
+#define PLC_FRAME  (WBS_PCM_FRAME_SAMPLES)
+#define PLC_PITCH  (200.0f) // voiced speech, 80 samples at 16 kHz
+
+static audio_plc_t s_plc;
+
+// a voiced frame lost after a second of the same tone is continued in phase from the pitch period
+static int test_plc_periodic(void) {
+    int16_t frame[PLC_FRAME];
+    int16_t truth[PLC_FRAME];
+    double phase = 0.0;
+    audio_plc_init(&s_plc, PLC_RATE);
+
+    for (int f = 0; f < 133; f++) {
+        test_sine(frame, PLC_FRAME, PLC_PITCH, 8000.0f, PLC_RATE, &phase);
+        audio_plc_process(&s_plc, frame, false);
+    }
+    test_sine(truth, PLC_FRAME, PLC_PITCH, 8000.0f, PLC_RATE, &phase);
+    memset(frame, 0, sizeof(frame));
+    audio_plc_process(&s_plc, frame, true);
+    TEST_CHECK(s_plc.concealed == 1);
+
+    double err = 0.0;
+    for (int i = 0; i < PLC_FRAME; i++) {
+        err += (double)(frame[i] - truth[i]) * (frame[i] - truth[i]);
+    }
+    double snr = 10.0 * log10(test_power(truth, PLC_FRAME) * PLC_FRAME / (err + 1.0));
+    printf("    concealed frame %.1f dB against the lost one\n", snr);
+    TEST_CHECK(snr > 20.0);
+    return 0;
+}
+
+// a long burst fades out to silence instead of buzzing, and the first good frame is cross-faded in
+static int test_plc_fade_and_recover(void) {
+    int16_t frame[PLC_FRAME];
+    double phase = 0.0;
+    audio_plc_init(&s_plc, PLC_RATE);
+
+    for (int f = 0; f < 20; f++) {
+        test_sine(frame, PLC_FRAME, PLC_PITCH, 8000.0f, PLC_RATE, &phase);
+        audio_plc_process(&s_plc, frame, false);
+    }
+    // 10 ms hold and 50 ms fade, 9 frames of 7.5 ms reach silence
+    for (int f = 0; f < 10; f++) {
+        audio_plc_process(&s_plc, frame, true);
+    }
+    TEST_CHECK(test_power(frame, PLC_FRAME) == 0.0);
+
+    test_sine(frame, PLC_FRAME, PLC_PITCH, 8000.0f, PLC_RATE, &phase);
+    int16_t good = frame[PLC_FRAME - 1];
+    audio_plc_process(&s_plc, frame, false);
+    TEST_CHECK(s_plc.recovered == 1);
+    // faded in from the silent synthesis, not a step to full level
+    TEST_CHECK(abs(frame[0]) < 1000);
+    TEST_CHECK(frame[PLC_FRAME - 1] == good);
+    return 0;
+}
+
+// silence in, silence out, at both rates
+static int test_plc_silence(void) {
+    int16_t frame[PLC_FRAME] = { 0 };
+    const uint32_t rates[] = { 8000, 16000 };
+    for (int r = 0; r < 2; r++) {
+        uint32_t n = rates[r] / 1000 * PCM_BLOCK_DURATION_US / 1000;
+        audio_plc_init(&s_plc, rates[r]);
+        for (int f = 0; f < 10; f++) {
+            audio_plc_process(&s_plc, frame, f % 3 == 2);
+            TEST_CHECK(test_power(frame, n) == 0.0);
+        }
+    }
+    return 0;
+}
+
+int main(void) {
+    int failed = 0;
+    TEST_RUN(test_plc_periodic, failed);
+    TEST_RUN(test_plc_fade_and_recover, failed);
+    TEST_RUN(test_plc_silence, failed);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,153 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "audio_frame.h"
+#include "audio_pwm.h"
+#include "test_audio.h"
+
+#define PWM_SECONDS   (1)
+#define PWM_WORDS     (AUDIO_PWM_RATE * PWM_SECONDS)
+#define PWM_LP_TAPS   (1023) // demodulator low pass at the PWM rate
+#define PWM_SKIP      (64)   // output samples of filter start up left out of the measurement
+#define PWM_FULL_DUTY (14)   // levels either side of half duty at full scale, as in audio_pwm.c
+
+static audio_pwm_t s_pwm;
+static uint32_t s_words[PWM_WORDS];
+static int16_t s_pcm[16000 * PWM_SECONDS];
+static int16_t s_out[16000 * PWM_SECONDS];
+static double s_lp[PWM_LP_TAPS];
+
+// the duty of each period through a brick wall at the band edge, back at the sample rate: what the RC filter lets
+// through and the ear hears, leaving the shaped noise above the band out
+static uint32_t pwm_demod(uint32_t osr, double band_hz, int16_t *out) {
+    const double fc = band_hz / AUDIO_PWM_RATE;
+    const double mid = (PWM_LP_TAPS - 1) / 2.0;
+    double sum = 0.0;
+    for (uint32_t k = 0; k < PWM_LP_TAPS; k++) {
+        double t = k - mid;
+        double sinc = (t == 0) ? 2 * fc : sin(2 * M_PI * fc * t) / (M_PI * t);
+        double win = 0.42 + 0.5 * cos(2 * M_PI * t / PWM_LP_TAPS) + 0.08 * cos(4 * M_PI * t / PWM_LP_TAPS);
+        s_lp[k] = sinc * win;
+        sum += s_lp[k];
+    }
+
+    uint32_t n = 0;
+    for (uint32_t i = PWM_LP_TAPS; i <= PWM_WORDS; i += osr) {
+        double acc = 0.0;
+        for (uint32_t k = 0; k < PWM_LP_TAPS; k++) {
+            acc += s_lp[k] * (__builtin_popcount(s_words[i - PWM_LP_TAPS + k]) - AUDIO_PWM_LEVELS / 2);
+        }
+        acc = acc / sum * 32768.0 / PWM_FULL_DUTY;
+        out[n++] = (int16_t)((acc > 32767.0) ? 32767 : (acc < -32768.0) ? -32768 : lrint(acc));
+    }
+    return n;
+}
+
+static int pwm_check(uint32_t rate, float freq, float amp, double min_db) {
+    const uint32_t frame = rate / 1000 * PCM_BLOCK_DURATION_US / 1000;
+    double phase = 0.0;
+
+    TEST_CHECK(audio_pwm_init(&s_pwm, rate));
+    test_sine(s_pcm, rate * PWM_SECONDS, freq, amp, rate, &phase);
+    uint32_t words = 0;
+    for (uint32_t i = 0; i + frame <= rate * PWM_SECONDS; i += frame) {
+        words += audio_pwm_convert(&s_pwm, s_pcm + i, frame, s_words + words);
+    }
+    TEST_CHECK(words == (rate * PWM_SECONDS / frame) * frame * s_pwm.osr);
+
+    uint32_t n = pwm_demod(s_pwm.osr, 0.45 * rate, s_out);
+    double snr = test_snr_db(s_out + PWM_SKIP, n - PWM_SKIP, freq, rate);
+    double level = test_tone_db(s_out + PWM_SKIP, n - PWM_SKIP, freq, rate);
+    printf("    %u Hz, %.0f Hz at %.1f dBFS: in band SNR %.1f dB, level %.1f dBFS, %u periods clipped\n", (unsigned)rate, freq,
+           20.0 * log10(amp / 32767.0), snr, level, (unsigned)s_pwm.stats.clipped);
+    TEST_CHECK(snr > min_db);
+    // unity gain through interpolation, shaping and the duty scale
+    TEST_CHECK(fabs(level - 20.0 * log10(amp / 32767.0)) < 0.5);
+    TEST_CHECK(s_pwm.stats.clipped == 0);
+    return 0;
+}
+
+// the noise shaper keeps the in band error far below a plain 33 level quantiser (about 30 dB)
+static int test_pwm_snr(void) {
+    TEST_CHECK(pwm_check(8000, 1000.0f, 16384.0f, 60.0) == 0);
+    TEST_CHECK(pwm_check(16000, 1000.0f, 16384.0f, 50.0) == 0);
+    TEST_CHECK(pwm_check(8000, 300.0f, 29000.0f, 60.0) == 0);
+    return 0;
+}
+
+// silence is half duty with the dither shaped out of the band
+static int test_pwm_idle(void) {
+    TEST_CHECK(audio_pwm_init(&s_pwm, 8000));
+    for (uint32_t i = 0; i < PWM_WORDS / (PCM_FRAME_SAMPLES * s_pwm.osr); i++) {
+        audio_pwm_convert(&s_pwm, NULL, PCM_FRAME_SAMPLES, s_words + i * PCM_FRAME_SAMPLES * s_pwm.osr);
+    }
+    uint32_t n = pwm_demod(s_pwm.osr, 3600.0, s_out);
+    double level = 10.0 * log10(test_power(s_out + PWM_SKIP, n - PWM_SKIP) / (32767.0 * 32767.0 / 2) + 1e-15);
+    printf("    idle noise in band %.1f dBFS\n", level);
+    TEST_CHECK(level < -60.0);
+    TEST_CHECK(s_pwm.stats.silent == s_pwm.stats.frames);
+    return 0;
+}
+
+// ns per 7.5 ms frame, a second of tone converted over and over into the 128000 words of one second
+static int test_pwm_bench(void) {
+    const uint32_t rates[] = {8000, 16000};
+    const uint32_t rounds = 10;
+    for (uint32_t r = 0; r < 2; r++) {
+        const uint32_t rate = rates[r], frame = rate / 1000 * PCM_BLOCK_DURATION_US / 1000;
+        const uint32_t frames = rate * PWM_SECONDS / frame;
+        double phase = 0.0;
+
+        TEST_CHECK(audio_pwm_init(&s_pwm, rate));
+        test_sine(s_pcm, rate * PWM_SECONDS, 1000.0f, 16384.0f, rate, &phase);
+        uint64_t t0 = test_now_ns();
+        for (uint32_t k = 0; k < rounds; k++) {
+            uint32_t words = 0;
+            for (uint32_t f = 0; f < frames; f++) {
+                words += audio_pwm_convert(&s_pwm, s_pcm + f * frame, frame, s_words + words);
+            }
+        }
+        double ns = (double)(test_now_ns() - t0) / (rounds * frames);
+        printf("    %5u Hz, %2u periods per sample: %6.0f ns per frame, %.1f ns per period, %.0fx real time (%u)\n", (unsigned)rate,
+               (unsigned)s_pwm.osr, ns, ns / (frame * s_pwm.osr), PCM_BLOCK_DURATION_US * 1000.0 / ns, (unsigned)(s_words[0] & 1));
+    }
+    return 0;
+}
+
+int main(void) {
+    int failed = 0;
+    TEST_RUN(test_pwm_snr, failed);
+    TEST_RUN(test_pwm_idle, failed);
+    TEST_RUN(test_pwm_bench, failed);
+    return failed ? 1 : 0;
+}
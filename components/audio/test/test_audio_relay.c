@@ -0,0 +1,173 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "audio_frame.h"
+#include "audio_relay.h"
+#include "test_audio.h"
+
+#define RL_FRAMES  (200000) // phone frames per run, 25 minutes
+#define RL_RX_JIT  (1000)   // packet delivery jitter of the controller, us
+#define RL_TX_JIT  (300)    // scheduling jitter of the send task, us
+#define RL_TX_OFF  (2100)   // send slot after the receive slot, us
+
+// one SCO link: a CVSD frame travels in two packets, an mSBC frame in one
+typedef struct {
+    uint32_t rate;
+    uint32_t pkt;      // bytes per packet and per request
+    double period_us;  // packet period on the clock of this link
+    double rx_nom_us;  // nominal next receive
+    double tx_nom_us;  // nominal next send
+    double rx_us;      // next receive with its jitter
+    double tx_us;
+    uint32_t rx_pkts;
+    uint32_t tx_short; // requests not filled
+} rl_link_t;
+
+static audio_relay_t s_down; // phone to headset
+static audio_relay_t s_up;   // headset to phone
+static rl_link_t s_phone;
+static rl_link_t s_headset;
+static uint8_t s_pkt[WBS_PCM_INPUT_DATA_SIZE];
+static uint32_t s_seed = 1;
+
+static double rl_jitter(uint32_t max_us) {
+    s_seed = s_seed * 1664525u + 1013904223u;
+    return (s_seed >> 8) / 16777216.0 * max_us;
+}
+
+static void rl_link_init(rl_link_t *link, uint32_t rate, int32_t ppm, double start_us) {
+    memset(link, 0, sizeof(rl_link_t));
+    link->rate = rate;
+    link->pkt = rate == 8000 ? PCM_INPUT_DATA_SIZE / 2 : WBS_PCM_INPUT_DATA_SIZE;
+    // a clock fast by ppm has a shorter period
+    link->period_us = (double)PCM_BLOCK_DURATION_US * link->pkt / (rate / 1000 * PCM_BLOCK_DURATION_US / 1000 * BYTES_PER_SAMPLE) / (1.0 + ppm * 1e-6);
+    link->rx_nom_us = start_us;
+    link->tx_nom_us = start_us + RL_TX_OFF;
+    link->rx_us = link->rx_nom_us + rl_jitter(RL_RX_JIT);
+    link->tx_us = link->tx_nom_us + rl_jitter(RL_TX_JIT);
+}
+
+// earliest pending event of a link, the receive is in in and the send out
+static void rl_link_step(rl_link_t *link, audio_relay_t *in, audio_relay_t *out) {
+    uint8_t buf[WBS_PCM_INPUT_DATA_SIZE];
+    if (link->rx_us <= link->tx_us) {
+        audio_relay_put(in, s_pkt, link->pkt, (uint32_t)link->rx_us);
+        link->rx_pkts++;
+        link->rx_nom_us += link->period_us;
+        link->rx_us = link->rx_nom_us + rl_jitter(RL_RX_JIT);
+    } else {
+        if (audio_relay_get(out, buf, link->pkt, (uint32_t)link->tx_us) != link->pkt) {
+            link->tx_short++;
+        }
+        link->tx_nom_us += link->period_us;
+        link->tx_us = link->tx_nom_us + rl_jitter(RL_TX_JIT);
+    }
+}
+
+static double rl_next_us(const rl_link_t *link) {
+    return link->rx_us < link->tx_us ? link->rx_us : link->tx_us;
+}
+
+// one leg: slips against the frames the clocks drifted apart, and the wait of a frame in the relay
+static int rl_check_leg(const char *name, const audio_relay_t *relay, const rl_link_t *sink, int32_t ppm) {
+    const audio_relay_stats_t *st = &relay->stats;
+    const uint32_t slips = st->dropped + st->concealed;
+    const uint32_t drift = (uint32_t)lrint(RL_FRAMES * fabs(ppm * 1e-6));
+    const uint32_t p99 = audio_trace_percentile(&relay->wait, 990);
+
+    printf("    %s %5u -> %5u Hz, sink %+3d ppm: %u frames, %u concealed, %u dropped, drift %u, wait p99 %u us, worst %u us, filter %u us\n", name,
+           (unsigned)(relay->src_size / BYTES_PER_SAMPLE * 1000000 / PCM_BLOCK_DURATION_US), (unsigned)(relay->dst_size / BYTES_PER_SAMPLE * 1000000 / PCM_BLOCK_DURATION_US),
+           (int)ppm, (unsigned)st->frames, (unsigned)st->concealed, (unsigned)st->dropped, (unsigned)drift, (unsigned)p99, (unsigned)relay->wait.worst_us,
+           (unsigned)audio_relay_filter_us(relay));
+    TEST_CHECK(st->overruns == 0);
+    TEST_CHECK(sink->tx_short == 0);
+    // every frame either played or dropped, and every sink frame start filled
+    TEST_CHECK(st->frames - st->dropped - audio_ring_count(&relay->ring) == st->played - st->concealed);
+    // a fast sink conceals one frame per frame of drift, a slow one drops it
+    const int32_t net = ppm > 0 ? (int32_t)(st->concealed - st->dropped) : (int32_t)(st->dropped - st->concealed);
+    TEST_CHECK(net + 2 >= (int32_t)drift && net <= (int32_t)drift + 2);
+    // while the phase of the links walks through the receive jitter a late frame is concealed and dropped again later,
+    // a slower drift stays there longer but passes less often: a bounded number of such pairs whatever the ppm
+    TEST_CHECK(slips <= drift + 2 * 8);
+    // a frame waits at most a frame period, plus the receive jitter and a spare frame not yet trimmed at the tail
+    TEST_CHECK(p99 <= PCM_BLOCK_DURATION_US + RL_RX_JIT + 1000);
+    return 0;
+}
+
+// phone link on the reference clock, headset link fast by ppm; the down leg plays on the headset clock, the up leg on the phone clock
+static int rl_run(uint32_t phone_rate, uint32_t headset_rate, int32_t ppm) {
+    TEST_CHECK(audio_relay_init(&s_down, phone_rate, headset_rate));
+    TEST_CHECK(audio_relay_init(&s_up, headset_rate, phone_rate));
+    rl_link_init(&s_phone, phone_rate, 0, 1000.0);
+    // the headset link slots fall anywhere in the phone frame
+    rl_link_init(&s_headset, headset_rate, ppm, 1000.0 + rl_jitter(PCM_BLOCK_DURATION_US));
+    const uint32_t pkts = RL_FRAMES * (phone_rate == 8000 ? 2 : 1);
+
+    while (s_phone.rx_pkts < pkts) {
+        if (rl_next_us(&s_phone) <= rl_next_us(&s_headset)) {
+            rl_link_step(&s_phone, &s_down, &s_up);
+        } else {
+            rl_link_step(&s_headset, &s_up, &s_down);
+        }
+    }
+    TEST_CHECK(rl_check_leg("down", &s_down, &s_headset, ppm) == 0);
+    TEST_CHECK(rl_check_leg("up  ", &s_up, &s_phone, -ppm) == 0);
+    return 0;
+}
+
+// the phone on mSBC and the headset on CVSD, both legs convert
+static int test_relay_convert(void) {
+    TEST_CHECK(rl_run(16000, 8000, 0) == 0);
+    TEST_CHECK(rl_run(16000, 8000, 40) == 0);
+    TEST_CHECK(rl_run(16000, 8000, -40) == 0);
+    TEST_CHECK(rl_run(8000, 16000, 40) == 0);
+    return 0;
+}
+
+// same codec on both links, split CVSD packets on both sides
+static int test_relay_same(void) {
+    TEST_CHECK(rl_run(8000, 8000, 0) == 0);
+    TEST_CHECK(rl_run(8000, 8000, 40) == 0);
+    TEST_CHECK(rl_run(8000, 8000, -40) == 0);
+    TEST_CHECK(rl_run(16000, 16000, 20) == 0);
+    TEST_CHECK(rl_run(16000, 16000, -20) == 0);
+    return 0;
+}
+
+int main(void) {
+    int failed = 0;
+    memset(s_pkt, 0x11, sizeof(s_pkt));
+    TEST_RUN(test_relay_convert, failed);
+    TEST_RUN(test_relay_same, failed);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,192 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "audio_frame.h"
+#include "audio_resample.h"
+#include "test_audio.h"
+
+#define RS_SECONDS (1)
+#define RS_IN_MAX  (48000 * RS_SECONDS)
+#define RS_OUT_MAX (2 * RS_IN_MAX + 16)
+#define RS_SKIP    (256) // output samples of filter start up left out of the measurement
+
+static audio_resampler_t s_rs;
+static int16_t s_in[RS_IN_MAX];
+static int16_t s_out[RS_OUT_MAX];
+
+// a tone through the converter in 7.5 ms blocks, as the SCO path feeds it; returns the output samples
+static uint32_t rs_run(uint32_t in_rate, uint32_t out_rate, float freq) {
+    double phase = 0.0;
+    uint32_t n_in = in_rate * RS_SECONDS;
+    uint32_t block = in_rate / 1000 * PCM_BLOCK_DURATION_US / 1000;
+    uint32_t n_out = 0;
+
+    test_sine(s_in, n_in, freq, 16000.0f, in_rate, &phase);
+    for (uint32_t i = 0; i + block <= n_in; i += block) {
+        n_out += audio_resampler_process(&s_rs, s_in + i, block, s_out + n_out, RS_OUT_MAX - n_out);
+    }
+    return n_out;
+}
+
+static int rs_check_snr(uint32_t in_rate, uint32_t out_rate, float freq, double min_db) {
+    TEST_CHECK(audio_resampler_init(&s_rs, in_rate, out_rate));
+    uint32_t n = rs_run(in_rate, out_rate, freq);
+    // the output count follows the ratio to within a sample per block
+    uint32_t expect = (uint64_t)in_rate * RS_SECONDS * out_rate / in_rate;
+    TEST_CHECK(n + 200 > expect && n < expect + 200);
+    double snr = test_snr_db(s_out + RS_SKIP, n - RS_SKIP, freq, out_rate);
+    printf("    %u -> %u Hz, %.0f Hz tone: %.1f dB\n", (unsigned)in_rate, (unsigned)out_rate, freq, snr);
+    TEST_CHECK(snr > min_db);
+    return 0;
+}
+
+static int test_resample_snr(void) {
+    TEST_CHECK(rs_check_snr(16000, 8000, 1000.0f, 60.0) == 0);
+    TEST_CHECK(rs_check_snr(8000, 16000, 1000.0f, 50.0) == 0);
+    TEST_CHECK(rs_check_snr(48000, 16000, 1000.0f, 50.0) == 0);
+    TEST_CHECK(rs_check_snr(44100, 16000, 1000.0f, 50.0) == 0);
+    TEST_CHECK(rs_check_snr(16000, 16000, 1000.0f, 50.0) == 0);
+    return 0;
+}
+
+// a tone above the output Nyquist frequency is filtered out rather than folded into the band
+static int test_resample_alias(void) {
+    TEST_CHECK(audio_resampler_init(&s_rs, 16000, 8000));
+    uint32_t n = rs_run(16000, 8000, 6000.0f);
+    double level = 10.0 * log10(test_power(s_out + RS_SKIP, n - RS_SKIP) / (16000.0 * 16000.0 / 2) + 1e-12);
+    printf("    6 kHz into 8 kHz output: %.1f dB\n", level);
+    TEST_CHECK(level < -50.0);
+
+    TEST_CHECK(audio_resampler_init(&s_rs, 48000, 16000));
+    n = rs_run(48000, 16000, 12000.0f);
+    level = 10.0 * log10(test_power(s_out + RS_SKIP, n - RS_SKIP) / (16000.0 * 16000.0 / 2) + 1e-12);
+    printf("    12 kHz into 16 kHz output: %.1f dB\n", level);
+    TEST_CHECK(level < -40.0);
+    return 0;
+}
+
+// a trimmed 1:1 converter drifts by the trim, and keeps the tone clean while it does
+static int test_resample_trim(void) {
+    TEST_CHECK(audio_resampler_init(&s_rs, 16000, 16000));
+    audio_resampler_set_ppb(&s_rs, 500000);
+    uint32_t n = rs_run(16000, 16000, 1000.0f);
+    // 500 ppm fewer outputs than the 133 whole blocks of input, 8 over the second
+    uint32_t in = 16000 / WBS_PCM_FRAME_SAMPLES * WBS_PCM_FRAME_SAMPLES;
+    TEST_CHECK(n + 6 <= in && n + 10 >= in);
+    TEST_CHECK(test_snr_db(s_out + RS_SKIP, n - RS_SKIP, 1000.0f * 1.0005f, 16000) > 50.0);
+    return 0;
+}
+
+// out too short for a block, the rest of the input is converted by the next calls: the same stream as with room
+static int rs_check_short(uint32_t in_rate, uint32_t out_rate, int32_t ppb) {
+    static int16_t ref[RS_OUT_MAX];
+    const uint32_t block = in_rate / 1000 * PCM_BLOCK_DURATION_US / 1000;
+    const uint32_t need = block * out_rate / in_rate + 2;
+    // short, nothing or odd, each followed by room to catch up
+    const uint32_t limits[] = {need / 2, 3 * need, 0, 3 * need, 1, 3 * need, need / 3 + 1, 3 * need};
+    double phase = 0.0;
+
+    TEST_CHECK(audio_resampler_init(&s_rs, in_rate, out_rate));
+    audio_resampler_set_ppb(&s_rs, ppb);
+    uint32_t n_ref = rs_run(in_rate, out_rate, 1000.0f);
+    memcpy(ref, s_out, n_ref * sizeof(int16_t));
+
+    TEST_CHECK(audio_resampler_init(&s_rs, in_rate, out_rate));
+    audio_resampler_set_ppb(&s_rs, ppb);
+    test_sine(s_in, in_rate * RS_SECONDS, 1000.0f, 16000.0f, in_rate, &phase);
+    uint32_t n = 0;
+    for (uint32_t i = 0, c = 0; i + block <= in_rate * RS_SECONDS; i += block, c++) {
+        n += audio_resampler_process(&s_rs, s_in + i, block, s_out + n, limits[c % 8]);
+    }
+    // what is still held comes out with the next call
+    n += audio_resampler_process(&s_rs, s_in, 0, s_out + n, RS_OUT_MAX - n);
+    printf("    %u -> %u Hz: %u of %u samples through short outputs, %u input samples lost\n", (unsigned)in_rate, (unsigned)out_rate, (unsigned)n,
+           (unsigned)n_ref, (unsigned)s_rs.dropped);
+    TEST_CHECK(s_rs.dropped == 0);
+    TEST_CHECK(n == n_ref);
+    TEST_CHECK(memcmp(s_out, ref, n * sizeof(int16_t)) == 0);
+    return 0;
+}
+
+static int test_resample_short(void) {
+    TEST_CHECK(rs_check_short(16000, 8000, 0) == 0);
+    TEST_CHECK(rs_check_short(8000, 16000, 0) == 0);
+    TEST_CHECK(rs_check_short(48000, 16000, 0) == 0);
+    TEST_CHECK(rs_check_short(16000, 16000, -300000) == 0);
+    TEST_CHECK(rs_check_short(16000, 16000, 300000) == 0);
+
+    // out that never has room: the block keeps what it can and the rest is counted
+    int16_t out[4];
+    TEST_CHECK(audio_resampler_init(&s_rs, 16000, 16000));
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < 10; i++) {
+        n += audio_resampler_process(&s_rs, s_in, WBS_PCM_FRAME_SAMPLES, out, 0);
+    }
+    TEST_CHECK(n == 0);
+    TEST_CHECK(s_rs.fill == AUDIO_RS_MAX_IN && s_rs.dropped == 10 * WBS_PCM_FRAME_SAMPLES - AUDIO_RS_MAX_IN);
+    return 0;
+}
+
+// one 7.5 ms block per call, the conversions the SCO, relay and prompt paths use
+static int test_resample_bench(void) {
+    const uint32_t rates[][2] = {{16000, 8000}, {8000, 16000}, {16000, 16000}, {44100, 16000}, {48000, 16000}, {48000, 8000}};
+    for (uint32_t r = 0; r < sizeof(rates) / sizeof(rates[0]); r++) {
+        const uint32_t in_rate = rates[r][0], out_rate = rates[r][1];
+        const uint32_t block = in_rate / 1000 * PCM_BLOCK_DURATION_US / 1000;
+        const uint32_t blocks = in_rate * RS_SECONDS / block;
+        const uint32_t rounds = 20;
+        uint32_t n = 0;
+
+        TEST_CHECK(audio_resampler_init(&s_rs, in_rate, out_rate));
+        uint64_t t0 = test_now_ns();
+        for (uint32_t k = 0; k < rounds; k++) {
+            for (uint32_t b = 0; b < blocks; b++) {
+                n = audio_resampler_process(&s_rs, s_in + b * block, block, s_out, RS_OUT_MAX);
+            }
+        }
+        double ns = (double)(test_now_ns() - t0) / (rounds * blocks);
+        printf("    %5u -> %5u Hz, %2u taps: %6.0f ns per %u sample block, %.0fx real time (%u)\n", (unsigned)in_rate, (unsigned)out_rate,
+               (unsigned)s_rs.taps, ns, (unsigned)block, PCM_BLOCK_DURATION_US * 1000.0 / ns, (unsigned)(n & 1));
+    }
+    return 0;
+}
+
+int main(void) {
+    int failed = 0;
+    TEST_RUN(test_resample_snr, failed);
+    TEST_RUN(test_resample_alias, failed);
+    TEST_RUN(test_resample_trim, failed);
+    TEST_RUN(test_resample_short, failed);
+    TEST_RUN(test_resample_bench, failed);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,256 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "audio_ring.h"
+#include "test_audio.h"
+
+#define RING_STRESS_FRAMES (200000)
+#define RING_BENCH_FRAMES  (500000)
+#define RING_BYTEBUF_SIZE  (3600) // the FreeRTOS byte ring the HCI path used before
+
+static audio_ring_t s_ring;
+
+// the path before: a heap frame per tick, sent into a locked byte ring and copied out of it again by the callback
+typedef struct {
+    uint8_t buf[RING_BYTEBUF_SIZE];
+    uint32_t head;
+    uint32_t tail;
+    uint32_t used;
+    pthread_mutex_t lock; // the critical section of xRingbufferSend and xRingbufferReceiveUpTo
+    uint32_t copies;
+    uint32_t allocs;
+} ring_bytebuf_t;
+
+static ring_bytebuf_t s_bytebuf = {.lock = PTHREAD_MUTEX_INITIALIZER};
+
+static void bytebuf_copy(uint8_t *dst, const uint8_t *src, uint32_t n) {
+    memcpy(dst, src, n);
+    s_bytebuf.copies++;
+}
+
+static bool bytebuf_send(const uint8_t *data, uint32_t n) {
+    pthread_mutex_lock(&s_bytebuf.lock);
+    bool ok = RING_BYTEBUF_SIZE - s_bytebuf.used >= n;
+    if (ok) {
+        uint32_t first = (n < RING_BYTEBUF_SIZE - s_bytebuf.head) ? n : RING_BYTEBUF_SIZE - s_bytebuf.head;
+        bytebuf_copy(s_bytebuf.buf + s_bytebuf.head, data, first);
+        if (first < n) {
+            memcpy(s_bytebuf.buf, data + first, n - first);
+        }
+        s_bytebuf.head = (s_bytebuf.head + n) % RING_BYTEBUF_SIZE;
+        s_bytebuf.used += n;
+    }
+    pthread_mutex_unlock(&s_bytebuf.lock);
+    return ok;
+}
+
+static uint32_t bytebuf_receive(uint8_t *dst, uint32_t n) {
+    pthread_mutex_lock(&s_bytebuf.lock);
+    if (s_bytebuf.used < n) {
+        n = 0;
+    } else {
+        uint32_t first = (n < RING_BYTEBUF_SIZE - s_bytebuf.tail) ? n : RING_BYTEBUF_SIZE - s_bytebuf.tail;
+        bytebuf_copy(dst, s_bytebuf.buf + s_bytebuf.tail, first);
+        if (first < n) {
+            memcpy(dst + first, s_bytebuf.buf, n - first);
+        }
+        s_bytebuf.tail = (s_bytebuf.tail + n) % RING_BYTEBUF_SIZE;
+        s_bytebuf.used -= n;
+    }
+    pthread_mutex_unlock(&s_bytebuf.lock);
+    return n;
+}
+
+// stands in for bt_app_hf_create_audio_data, the same work on both paths
+static void ring_fill(uint8_t *frame, uint32_t n, uint32_t seq) {
+    for (uint32_t i = 0; i < n; i++) {
+        frame[i] = (uint8_t)(seq + i);
+    }
+}
+
+static int test_ring_full_empty(void) {
+    audio_ring_init(&s_ring, PCM_INPUT_DATA_SIZE);
+    TEST_CHECK(audio_ring_read_begin(&s_ring) == NULL);
+
+    for (uint32_t i = 0; i < AUDIO_RING_FRAMES; i++) {
+        uint8_t *slot = audio_ring_write_begin(&s_ring);
+        TEST_CHECK(slot != NULL);
+        memset(slot, (int)i, PCM_INPUT_DATA_SIZE);
+        audio_ring_write_commit(&s_ring);
+    }
+    TEST_CHECK(audio_ring_count(&s_ring) == AUDIO_RING_FRAMES);
+    TEST_CHECK(audio_ring_write_begin(&s_ring) == NULL);
+    TEST_CHECK(s_ring.stats.overruns == 1);
+
+    for (uint32_t i = 0; i < AUDIO_RING_FRAMES; i++) {
+        const uint8_t *frame = audio_ring_read_begin(&s_ring);
+        TEST_CHECK(frame != NULL && frame[0] == i && frame[PCM_INPUT_DATA_SIZE - 1] == i);
+        audio_ring_read_commit(&s_ring);
+    }
+    TEST_CHECK(audio_ring_read_begin(&s_ring) == NULL);
+    TEST_CHECK(s_ring.stats.produced == AUDIO_RING_FRAMES && s_ring.stats.consumed == AUDIO_RING_FRAMES);
+    return 0;
+}
+
+// byte reads that do not line up with frames, as the SCO callback asks for them
+static int test_ring_read_bytes(void) {
+    uint8_t out[PCM_INPUT_DATA_SIZE * 3];
+    audio_ring_init(&s_ring, PCM_INPUT_DATA_SIZE);
+
+    for (uint32_t f = 0; f < 3; f++) {
+        uint8_t *slot = audio_ring_write_begin(&s_ring);
+        for (uint32_t i = 0; i < PCM_INPUT_DATA_SIZE; i++) {
+            slot[i] = (uint8_t)(f * PCM_INPUT_DATA_SIZE + i);
+        }
+        audio_ring_write_commit(&s_ring);
+    }
+    TEST_CHECK(audio_ring_read_bytes(&s_ring, out, 60) == 60);
+    TEST_CHECK(audio_ring_read_bytes(&s_ring, out + 60, 2 * PCM_INPUT_DATA_SIZE) == 2 * PCM_INPUT_DATA_SIZE);
+    // not enough left, nothing is taken
+    TEST_CHECK(audio_ring_read_bytes(&s_ring, out, PCM_INPUT_DATA_SIZE) == 0);
+    TEST_CHECK(s_ring.stats.underruns == 1);
+    TEST_CHECK(audio_ring_read_bytes(&s_ring, out + 60 + 2 * PCM_INPUT_DATA_SIZE, PCM_INPUT_DATA_SIZE - 60) == PCM_INPUT_DATA_SIZE - 60);
+    for (uint32_t i = 0; i < sizeof(out); i++) {
+        TEST_CHECK(out[i] == (uint8_t)i);
+    }
+    TEST_CHECK(audio_ring_count(&s_ring) == 0);
+    return 0;
+}
+
+static void *ring_producer(void *arg) {
+    for (uint32_t seq = 0; seq < RING_STRESS_FRAMES;) {
+        uint8_t *slot = audio_ring_write_begin(&s_ring);
+        if (slot == NULL) {
+            sched_yield();
+            continue;
+        }
+        for (uint32_t i = 0; i < PCM_INPUT_DATA_SIZE / sizeof(uint32_t); i++) {
+            ((uint32_t *)slot)[i] = seq + i;
+        }
+        audio_ring_write_tag(&s_ring)->seq = seq;
+        audio_ring_write_commit(&s_ring);
+        seq++;
+    }
+    return NULL;
+}
+
+// one producer and one consumer thread, every frame arrives once, complete and in order
+static int test_ring_spsc(void) {
+    pthread_t producer;
+    audio_ring_init(&s_ring, PCM_INPUT_DATA_SIZE);
+    pthread_create(&producer, NULL, ring_producer, NULL);
+
+    bool ok = true;
+    for (uint32_t seq = 0; seq < RING_STRESS_FRAMES;) {
+        const uint8_t *frame = audio_ring_read_begin(&s_ring);
+        if (frame == NULL) {
+            sched_yield();
+            continue;
+        }
+        ok = ok && audio_ring_read_tag(&s_ring)->seq == seq;
+        for (uint32_t i = 0; i < PCM_INPUT_DATA_SIZE / sizeof(uint32_t); i++) {
+            ok = ok && ((const uint32_t *)frame)[i] == seq + i;
+        }
+        audio_ring_read_commit(&s_ring);
+        seq++;
+    }
+    pthread_join(producer, NULL);
+    TEST_CHECK(ok);
+    TEST_CHECK(audio_ring_count(&s_ring) == 0);
+    return 0;
+}
+
+// one producer tick and one outgoing callback per frame, as the HCI path runs them, the old way and through the ring;
+// the time to generate the content is taken out
+static int test_ring_bench(void) {
+    uint8_t out[WBS_PCM_INPUT_DATA_SIZE];
+    const uint32_t sizes[] = {PCM_INPUT_DATA_SIZE, WBS_PCM_INPUT_DATA_SIZE};
+    for (uint32_t s = 0; s < 2; s++) {
+        const uint32_t size = sizes[s];
+        uint32_t sum_old = 0, sum_new = 0, sum_fill = 0;
+
+        memset(&s_bytebuf.buf, 0, sizeof(s_bytebuf.buf));
+        s_bytebuf.head = s_bytebuf.tail = s_bytebuf.used = s_bytebuf.copies = s_bytebuf.allocs = 0;
+        uint64_t t0 = test_now_ns();
+        for (uint32_t seq = 0; seq < RING_BENCH_FRAMES; seq++) {
+            uint8_t *buf = malloc(size);
+            s_bytebuf.allocs++;
+            ring_fill(buf, size, seq);
+            TEST_CHECK(bytebuf_send(buf, size));
+            free(buf);
+            TEST_CHECK(bytebuf_receive(out, size) == size);
+            sum_old += out[size - 1];
+        }
+        uint64_t t1 = test_now_ns();
+
+        audio_ring_init(&s_ring, size);
+        for (uint32_t seq = 0; seq < RING_BENCH_FRAMES; seq++) {
+            uint8_t *slot = audio_ring_write_begin(&s_ring);
+            TEST_CHECK(slot != NULL);
+            ring_fill(slot, size, seq);
+            audio_ring_write_commit(&s_ring);
+            TEST_CHECK(audio_ring_read_bytes(&s_ring, out, size) == size);
+            sum_new += out[size - 1];
+        }
+        uint64_t t2 = test_now_ns();
+
+        // the content alone, left out of both figures
+        for (uint32_t seq = 0; seq < RING_BENCH_FRAMES; seq++) {
+            ring_fill(out, size, seq);
+            sum_fill += out[size - 1];
+        }
+        uint64_t t3 = test_now_ns();
+        const double fill = (double)(t3 - t2) / RING_BENCH_FRAMES;
+
+        // the ring copies once, into the buffer the controller hands the callback, and never allocates
+        printf("    %3u B frames: byte ring %u copies, %u allocations, %.0f ns/frame; audio_ring 1 copy, 0 allocations, %.0f ns/frame\n",
+               (unsigned)size, (unsigned)(s_bytebuf.copies / RING_BENCH_FRAMES), (unsigned)(s_bytebuf.allocs / RING_BENCH_FRAMES),
+               (double)(t1 - t0) / RING_BENCH_FRAMES - fill, (double)(t2 - t1) / RING_BENCH_FRAMES - fill);
+        TEST_CHECK(sum_fill == sum_new);
+        TEST_CHECK(sum_old == sum_new);
+        TEST_CHECK(s_ring.stats.produced == RING_BENCH_FRAMES && s_ring.stats.underruns == 0);
+    }
+    return 0;
+}
+
+int main(void) {
+    int failed = 0;
+    TEST_RUN(test_ring_full_empty, failed);
+    TEST_RUN(test_ring_read_bytes, failed);
+    TEST_RUN(test_ring_spsc, failed);
+    TEST_RUN(test_ring_bench, failed);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,216 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "audio_frame.h"
+#include "audio_tone.h"
+#include "test_audio.h"
+
+#define TONE_BENCH_FRAMES (200000)
+#define TONE_TABLE_SIZE   (100) // the fixed sine the HCI path played before
+#define TONE_TABLE_BYTES  (200)
+
+static audio_tone_t s_tone;
+static int16_t s_pcm[6 * 16000];
+static int16_t s_ref[6 * 16000];
+
+static const int16_t s_sine_int16[TONE_TABLE_SIZE] = {
+    0,      2057,   4107,   6140,   8149,   10126,  12062,  13952,  15786,  17557,  19260,  20886,  22431,  23886,  25247,  26509,  27666,
+    28714,  29648,  30466,  31163,  31738,  32187,  32509,  32702,  32767,  32702,  32509,  32187,  31738,  31163,  30466,  29648,  28714,
+    27666,  26509,  25247,  23886,  22431,  20886,  19260,  17557,  15786,  13952,  12062,  10126,  8149,   6140,   4107,   2057,   0,
+    -2057,  -4107,  -6140,  -8149,  -10126, -12062, -13952, -15786, -17557, -19260, -20886, -22431, -23886, -25247, -26509, -27666, -28714,
+    -29648, -30466, -31163, -31738, -32187, -32509, -32702, -32767, -32702, -32509, -32187, -31738, -31163, -30466, -29648, -28714, -27666,
+    -26509, -25247, -23886, -22431, -20886, -19260, -17557, -15786, -13952, -12062, -10126, -8149,  -6140,  -4107,  -2057,
+};
+
+// the loop audio_tone replaced: the table walked byte by byte with a wrap check on each
+static uint32_t tone_table_fill(uint8_t *p_buf, uint32_t sz) {
+    static int index = 0;
+    const uint8_t *data = (const uint8_t *)s_sine_int16;
+
+    for (uint32_t i = 0; i < sz; i++) {
+        p_buf[i] = data[index++];
+        if (index >= TONE_TABLE_BYTES) {
+            index -= TONE_TABLE_BYTES;
+        }
+    }
+    return sz;
+}
+
+static int tone_check_single(uint32_t rate, uint16_t freq, int16_t level) {
+    const audio_tone_spec_t spec = {.freq = {freq, 0}, .level = {level, 0}};
+    audio_tone_init(&s_tone, &spec, rate);
+    audio_tone_fill(&s_tone, s_pcm, rate);
+    double snr = test_snr_db(s_pcm, rate, freq, rate);
+    double db = test_tone_db(s_pcm, rate, freq, rate);
+    printf("    %5u Hz, %4u Hz at %.1f dBFS: level %.2f dBFS, SNR %.1f dB\n", (unsigned)rate, freq, 20.0 * log10(level / 32767.0), db, snr);
+    TEST_CHECK(fabs(db - 20.0 * log10(level / 32767.0)) < 0.05);
+    TEST_CHECK(snr > 60.0);
+    return 0;
+}
+
+// any frequency below Nyquist, at its level and clean of interpolation error
+static int test_tone_single(void) {
+    TEST_CHECK(tone_check_single(8000, 400, 16384) == 0);
+    TEST_CHECK(tone_check_single(8000, 1234, 32767) == 0);
+    TEST_CHECK(tone_check_single(8000, 3900, 8192) == 0);
+    TEST_CHECK(tone_check_single(16000, 400, 16384) == 0);
+    TEST_CHECK(tone_check_single(16000, 7001, 16384) == 0);
+    return 0;
+}
+
+// both halves of a dual tone at their levels and nothing else
+static int test_tone_dual(void) {
+    const uint32_t rates[] = {8000, 16000};
+    for (uint32_t r = 0; r < 2; r++) {
+        const audio_tone_spec_t *spec = audio_tone_preset(AUDIO_TONE_DIAL);
+        audio_tone_init(&s_tone, spec, rates[r]);
+        audio_tone_fill(&s_tone, s_pcm, rates[r]);
+        double lo = test_tone_db(s_pcm, rates[r], spec->freq[0], rates[r]);
+        double hi = test_tone_db(s_pcm, rates[r], spec->freq[1], rates[r]);
+        double total = 10.0 * log10(test_power(s_pcm, rates[r]) / (32767.0 * 32767.0 / 2));
+        double expect = 20.0 * log10(spec->level[0] / 32767.0);
+        printf("    %5u Hz, %u + %u Hz: %.2f and %.2f dBFS, total %.2f dBFS\n", (unsigned)rates[r], spec->freq[0], spec->freq[1], lo, hi, total);
+        TEST_CHECK(fabs(lo - expect) < 0.05 && fabs(hi - expect) < 0.05);
+        // the sum of two tones of one level is 3 dB over each
+        TEST_CHECK(fabs(total - expect - 10.0 * log10(2.0)) < 0.05);
+    }
+    return 0;
+}
+
+// on segments carry the tone to the sample, off segments are silent
+static int tone_check_cadence(audio_tone_id_t id, uint32_t rate) {
+    const audio_tone_spec_t *spec = audio_tone_preset(id);
+    const uint32_t frame = rate / 1000 * PCM_BLOCK_DURATION_US / 1000;
+    uint32_t cycle = 0;
+    for (uint32_t i = 0; i < AUDIO_TONE_CADENCE_MAX && spec->cadence_ms[i]; i++) {
+        cycle += spec->cadence_ms[i] * rate / 1000;
+    }
+    const uint32_t n = (uint32_t)(sizeof(s_pcm) / sizeof(s_pcm[0])) / cycle * cycle;
+    TEST_CHECK(n > 0);
+
+    audio_tone_init(&s_tone, spec, rate);
+    for (uint32_t i = 0; i < n; i += frame) {
+        audio_tone_fill(&s_tone, s_pcm + i, (n - i < frame) ? n - i : frame);
+    }
+    uint32_t start = 0, segments = 0;
+    while (start < n) {
+        for (uint32_t i = 0; i < AUDIO_TONE_CADENCE_MAX && spec->cadence_ms[i]; i++, segments++) {
+            const uint32_t len = spec->cadence_ms[i] * rate / 1000;
+            for (uint32_t k = 0; k < len; k++) {
+                if ((i & 1) == 0) {
+                    // every burst starts at zero phase, after that a dual tone may cross zero but never twice in a row
+                    TEST_CHECK(k == 0 || s_pcm[start + k] != 0 || s_pcm[start + k - 1] != 0);
+                } else {
+                    TEST_CHECK(s_pcm[start + k] == 0);
+                }
+            }
+            start += len;
+        }
+    }
+    printf("    %5u Hz, %u/%u ms cadence: %u segments exact to the sample\n", (unsigned)rate, spec->cadence_ms[0], spec->cadence_ms[1],
+           (unsigned)segments);
+    return 0;
+}
+
+static int test_tone_cadence(void) {
+    TEST_CHECK(tone_check_cadence(AUDIO_TONE_BUSY, 8000) == 0);
+    TEST_CHECK(tone_check_cadence(AUDIO_TONE_BUSY, 16000) == 0);
+    TEST_CHECK(tone_check_cadence(AUDIO_TONE_CONGESTION, 8000) == 0);
+    TEST_CHECK(tone_check_cadence(AUDIO_TONE_CONGESTION, 16000) == 0);
+    TEST_CHECK(tone_check_cadence(AUDIO_TONE_RINGBACK, 8000) == 0);
+    TEST_CHECK(tone_check_cadence(AUDIO_TONE_RINGBACK, 16000) == 0);
+    return 0;
+}
+
+// rendered in frames of any size, the tone is the same as rendered in one go: the phase runs on across calls
+static int test_tone_phase(void) {
+    const uint32_t chunks[] = {1, 7, 60, 120, 33, 241, 2};
+    const audio_tone_id_t ids[] = {AUDIO_TONE_DIAL, AUDIO_TONE_BUSY};
+    for (uint32_t t = 0; t < 2; t++) {
+        const uint32_t n = 16000 * 3;
+        audio_tone_init(&s_tone, audio_tone_preset(ids[t]), 16000);
+        audio_tone_fill(&s_tone, s_ref, n);
+        audio_tone_init(&s_tone, audio_tone_preset(ids[t]), 16000);
+        for (uint32_t i = 0, c = 0; i < n; c++) {
+            uint32_t len = chunks[c % 7];
+            len = (len < n - i) ? len : n - i;
+            audio_tone_fill(&s_tone, s_pcm + i, len);
+            i += len;
+        }
+        TEST_CHECK(memcmp(s_pcm, s_ref, n * sizeof(int16_t)) == 0);
+    }
+    return 0;
+}
+
+// one 7.5 ms frame per call, the table loop against the generator with one and two tones
+static int test_tone_bench(void) {
+    const uint32_t rates[] = {8000, 16000};
+    static uint8_t frame[WBS_PCM_INPUT_DATA_SIZE] __attribute__((aligned(4)));
+    for (uint32_t r = 0; r < 2; r++) {
+        const uint32_t samples = rates[r] / 1000 * PCM_BLOCK_DURATION_US / 1000;
+        uint32_t sum = 0;
+
+        uint64_t t0 = test_now_ns();
+        for (uint32_t f = 0; f < TONE_BENCH_FRAMES; f++) {
+            tone_table_fill(frame, samples * BYTES_PER_SAMPLE);
+            sum += frame[f % samples];
+        }
+        uint64_t t1 = test_now_ns();
+        audio_tone_init(&s_tone, audio_tone_preset(AUDIO_TONE_TEST), rates[r]);
+        for (uint32_t f = 0; f < TONE_BENCH_FRAMES; f++) {
+            audio_tone_fill(&s_tone, (int16_t *)frame, samples);
+            sum += frame[f % samples];
+        }
+        uint64_t t2 = test_now_ns();
+        audio_tone_init(&s_tone, audio_tone_preset(AUDIO_TONE_DIAL), rates[r]);
+        for (uint32_t f = 0; f < TONE_BENCH_FRAMES; f++) {
+            audio_tone_fill(&s_tone, (int16_t *)frame, samples);
+            sum += frame[f % samples];
+        }
+        uint64_t t3 = test_now_ns();
+        printf("    %5u Hz, %3u samples/frame: table loop %.0f ns, single tone %.0f ns, dual tone %.0f ns (%u)\n", (unsigned)rates[r],
+               (unsigned)samples, (double)(t1 - t0) / TONE_BENCH_FRAMES, (double)(t2 - t1) / TONE_BENCH_FRAMES,
+               (double)(t3 - t2) / TONE_BENCH_FRAMES, (unsigned)(sum & 1));
+    }
+    return 0;
+}
+
+int main(void) {
+    int failed = 0;
+    TEST_RUN(test_tone_single, failed);
+    TEST_RUN(test_tone_dual, failed);
+    TEST_RUN(test_tone_cadence, failed);
+    TEST_RUN(test_tone_phase, failed);
+    TEST_RUN(test_tone_bench, failed);
+    return failed ? 1 : 0;
+}
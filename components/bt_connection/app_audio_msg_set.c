@@ -0,0 +1,382 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "argtable3/argtable3.h"
+#include "esp_console.h"
+#include "esp_log.h"
+
+#include "app_audio_msg_set.h"
+#include "audio_trace.h"
+#include "bt_app_hf.h"
+#include "bt_app_pkt_stat.h"
+#include "bt_app_prompt.h"
+#include "bt_app_rec.h"
+#include "bt_scan.h"
+
+#define AUDIO_CMD_HANDLER(cmd) static int audio_##cmd##_handler(int argn, char **argv)
+
+#if CONFIG_BT_HFP_AUDIO_DATA_PATH_HCI
+static const char *lat_stage_str[] = {
+    "out gen",   //
+    "out queue", //
+    "out total", //
+    "in rx",     //
+    "in queue",  //
+    "in aec",    //
+    "in ns",     //
+    "in total",  //
+};
+#endif /* #if CONFIG_BT_HFP_AUDIO_DATA_PATH_HCI */
+
+// Audio path latency per stage
+AUDIO_CMD_HANDLER(lat) {
+#if CONFIG_BT_HFP_AUDIO_DATA_PATH_HCI
+    if (argn == 2 && strcmp(argv[1], "reset") == 0) {
+        bt_app_hf_reset_latency();
+        printf("Latency histograms cleared\n");
+        return 0;
+    }
+    if (argn != 1) {
+        printf("Invalid argument %s\n", argv[1]);
+        return 1;
+    }
+
+    printf("%-10s %8s %8s %8s %8s %8s %8s\n", "stage", "frames", "p50 us", "p95 us", "p99 us", "worst us", "frame");
+    for (int i = 0; i < BT_APP_LAT_MAX; i++) {
+        const audio_trace_t *tr = bt_app_hf_get_latency(i);
+        printf("%-10s %8" PRIu32 " %8" PRIu32 " %8" PRIu32 " %8" PRIu32 " %8" PRIu32 " %8" PRIu32 "\n", lat_stage_str[i], audio_trace_count(tr),
+               audio_trace_percentile(tr, 500), audio_trace_percentile(tr, 950), audio_trace_percentile(tr, 990), tr->worst_us, tr->worst_seq);
+    }
+    return 0;
+#else
+    printf("Latency is traced on the HCI data path only\n");
+    return 1;
+#endif /* #if CONFIG_BT_HFP_AUDIO_DATA_PATH_HCI */
+}
+
+// share of lost and errored packets in the newest n samples, in 0.1 %
+static uint32_t pkt_bad_permille(const bt_app_pkt_peer_t *peer, uint32_t head, uint32_t n) {
+    uint32_t bad = 0;
+    uint32_t all = 0;
+    for (uint32_t i = 1; i <= n; i++) {
+        const bt_app_pkt_sample_t *s = &peer->sample[(head - i) % BT_APP_PKT_STAT_SAMPLES];
+        bad += s->rx_err + s->rx_lost;
+        all += s->rx_good + s->rx_err + s->rx_lost;
+    }
+    return all ? bad * 1000 / all : 0;
+}
+
+// Synchronous link packet statistics per peer
+AUDIO_CMD_HANDLER(pkt) {
+    int shown = 0;
+    for (int i = 0; i < BT_APP_PKT_STAT_PEERS; i++) {
+        const bt_app_pkt_peer_t *peer = bt_app_pkt_stat_get(i);
+        if (peer == NULL) {
+            continue;
+        }
+        char bda_str[18];
+        uint32_t head = __atomic_load_n(&peer->head, __ATOMIC_ACQUIRE);
+        uint32_t n = (head < BT_APP_PKT_STAT_SAMPLES) ? head : BT_APP_PKT_STAT_SAMPLES;
+        uint32_t recent = (n < 10) ? n : 10;
+        printf("%s %s, handle 0x%04x, %" PRIu32 " samples, the last of %" PRIu32 " ms\n", bda2str((uint8_t *)peer->bda, bda_str, sizeof(bda_str)),
+               peer->active ? "active" : "idle", peer->handle, head, peer->span_ms);
+        if (n) {
+            const bt_app_pkt_sample_t *s = &peer->sample[(head - 1) % BT_APP_PKT_STAT_SAMPLES];
+            printf("  last: rx good %u err %u lost %u, tx %u\n", s->rx_good, s->rx_err, s->rx_lost, s->tx);
+            uint32_t r = pkt_bad_permille(peer, head, recent);
+            uint32_t l = pkt_bad_permille(peer, head, n);
+            printf("  bad: %" PRIu32 ".%" PRIu32 "%% over %" PRIu32 " samples, %" PRIu32 ".%" PRIu32 "%% over %" PRIu32 "\n", r / 10, r % 10, recent,
+                   l / 10, l % 10, n);
+            // one character per sample, oldest first: . <1%, o <5%, x <20%, X above
+            char trend[BT_APP_PKT_STAT_SAMPLES + 1];
+            for (uint32_t k = 0; k < n; k++) {
+                const bt_app_pkt_sample_t *t = &peer->sample[(head - n + k) % BT_APP_PKT_STAT_SAMPLES];
+                uint32_t all = t->rx_good + t->rx_err + t->rx_lost;
+                uint32_t bad = all ? (t->rx_err + t->rx_lost) * 1000 / all : 0;
+                trend[k] = (bad < 10) ? '.' : (bad < 50) ? 'o' : (bad < 200) ? 'x' : 'X';
+            }
+            trend[n] = '\0';
+            printf("  trend: %s\n", trend);
+        }
+        printf("  total: rx good %" PRIu32 " err %" PRIu32 " lost %" PRIu32 ", tx %" PRIu32 "\n", peer->total[0], peer->total[1], peer->total[2],
+               peer->total[3]);
+        shown++;
+    }
+    if (shown == 0) {
+        printf("No audio link sampled yet\n");
+    }
+    return 0;
+}
+
+// Call recording to LittleFS
+AUDIO_CMD_HANDLER(rec) {
+    static const char *dir_str[BT_APP_REC_MAX] = { "in", "out" };
+
+    if (argn >= 2 && strcmp(argv[1], "start") == 0) {
+        uint32_t mask = (1 << BT_APP_REC_IN) | (1 << BT_APP_REC_OUT);
+        if (argn == 3 && strcmp(argv[2], "in") == 0) {
+            mask = 1 << BT_APP_REC_IN;
+        } else if (argn == 3 && strcmp(argv[2], "out") == 0) {
+            mask = 1 << BT_APP_REC_OUT;
+        } else if (argn == 3 && strcmp(argv[2], "both") != 0) {
+            printf("Invalid argument for direction %s\n", argv[2]);
+            return 1;
+        }
+        if (!bt_app_rec_start(mask)) {
+            printf("Recording not started\n");
+            return 1;
+        }
+        printf("Recording\n");
+        return 0;
+    }
+    if (argn == 2 && strcmp(argv[1], "stop") == 0) {
+        bt_app_rec_stop();
+        printf("Recording stopped\n");
+    } else if (argn != 1) {
+        printf("Invalid argument %s\n", argv[1]);
+        return 1;
+    }
+
+    printf("%s\n", bt_app_rec_active() ? "recording" : "not recording");
+    for (int i = 0; i < BT_APP_REC_MAX; i++) {
+        bt_app_rec_stats_t st;
+        bt_app_rec_get_stats(i, &st);
+        printf("  %-3s frames %" PRIu32 ", dropped %" PRIu32 ", %" PRIu32 " bytes in %" PRIu32 " writes, avg %" PRIu32 " us, worst %" PRIu32
+               " us, errors %" PRIu32 "\n",
+               dir_str[i], st.frames, st.dropped, st.bytes, st.flushes, st.flushes ? st.flush_total_us / st.flushes : 0, st.flush_worst_us, st.errors);
+    }
+    return 0;
+}
+
+// Prompt and ringtone store
+AUDIO_CMD_HANDLER(prompt) {
+    if (argn == 4 && strcmp(argv[1], "add") == 0) {
+        if (!bt_app_prompt_add(argv[2], argv[3])) {
+            printf("Can't add %s from %s\n", argv[2], argv[3]);
+            return 1;
+        }
+    } else if (argn >= 3 && strcmp(argv[1], "play") == 0) {
+#if CONFIG_BT_HFP_AUDIO_DATA_PATH_HCI
+        uint32_t rate = bt_app_hf_get_sample_rate();
+        bool loop = (argn == 4 && strcmp(argv[3], "loop") == 0);
+        if (rate == 0) {
+            printf("No audio connection\n");
+            return 1;
+        }
+        if (!bt_app_prompt_play(argv[2], rate, loop)) {
+            printf("Can't play %s\n", argv[2]);
+            return 1;
+        }
+#else
+        printf("Prompts are played on the HCI data path only\n");
+        return 1;
+#endif /* #if CONFIG_BT_HFP_AUDIO_DATA_PATH_HCI */
+    } else if (argn == 2 && strcmp(argv[1], "stop") == 0) {
+        bt_app_prompt_stop();
+    } else if (argn == 2 && strcmp(argv[1], "clear") == 0) {
+        bt_app_prompt_clear();
+    } else if (argn != 1) {
+        printf("Invalid argument %s\n", argv[1]);
+        return 1;
+    }
+
+    bt_app_prompt_stats_t st;
+    bt_app_prompt_get_stats(&st);
+    for (int i = 0; i < bt_app_prompt_count(); i++) {
+        const bt_app_prompt_entry_t *e = bt_app_prompt_get(i);
+        printf("  %-15s %6" PRIu32 " frames, %" PRIu32 " ms\n", e->name, e->frames, e->frames * 15 / 2);
+    }
+    uint32_t served = st.hits + st.misses;
+    printf("%s, cache hits %" PRIu32 "/%" PRIu32 " (%" PRIu32 "%%), flash reads %" PRIu32 ", avg %" PRIu32 " us, worst %" PRIu32 " us\n",
+           bt_app_prompt_playing() ? "playing" : "idle", st.hits, served, served ? st.hits * 100 / served : 100, st.reads,
+           st.reads ? st.read_total_us / st.reads : 0, st.read_worst_us);
+    return 0;
+}
+
+// DTMF in the outgoing stream
+AUDIO_CMD_HANDLER(dtmf) {
+    if (argn != 2) {
+        printf("Insufficient number of arguments");
+        return 1;
+    }
+#if CONFIG_BT_HFP_AUDIO_DATA_PATH_HCI
+    if (!bt_app_hf_send_dtmf(argv[1])) {
+        printf("Can't play all of %s\n", argv[1]);
+        return 1;
+    }
+    return 0;
+#else
+    printf("DTMF is played on the HCI data path only\n");
+    return 1;
+#endif /* #if CONFIG_BT_HFP_AUDIO_DATA_PATH_HCI */
+}
+
+// Voice activity and the work it saved
+AUDIO_CMD_HANDLER(vad) {
+#if CONFIG_BT_HFP_AUDIO_DATA_PATH_HCI
+    bt_app_hf_vad_stats_t st;
+    bt_app_hf_get_vad_stats(&st);
+    printf("in:  active %3" PRIu32 "%% (%" PRIu32 "/%" PRIu32 " frames), comfort noise %" PRIu32 "\n", st.in.frames ? st.in.active * 100 / st.in.frames : 0,
+           st.in.active, st.in.frames, st.in.cng);
+    printf("out: active %3" PRIu32 "%% (%" PRIu32 "/%" PRIu32 " frames)\n", st.out.frames ? st.out.active * 100 / st.out.frames : 0, st.out.active,
+           st.out.frames);
+    uint64_t total_us = st.spent_us + st.saved_us;
+    printf("skipped: aec %" PRIu32 ", ns %" PRIu32 ", cpu spent %" PRIu32 " ms, saved %" PRIu32 " ms (%" PRIu32 "%%)\n", st.aec_skipped, st.ns_skipped,
+           (uint32_t)(st.spent_us / 1000), (uint32_t)(st.saved_us / 1000), total_us ? (uint32_t)(st.saved_us * 100 / total_us) : 0);
+    return 0;
+#else
+    printf("Voice activity is tracked on the HCI data path only\n");
+    return 1;
+#endif /* #if CONFIG_BT_HFP_AUDIO_DATA_PATH_HCI */
+}
+
+static audio_msg_hdl_t audio_cmd_tbl[] = {
+    { "lat", audio_lat_handler },       //
+    { "pkt", audio_pkt_handler },       //
+    { "rec", audio_rec_handler },       //
+    { "prompt", audio_prompt_handler }, //
+    { "dtmf", audio_dtmf_handler },     //
+    { "vad", audio_vad_handler },       //
+};
+
+#define AUDIO_ORDER(name) name##_cmd
+enum audio_cmd_idx {
+    AUDIO_CMD_IDX_LAT = 0, /* audio path latency per stage */
+    AUDIO_CMD_IDX_PKT,     /* synchronous link packet statistics per peer */
+    AUDIO_CMD_IDX_REC,     /* call recording to LittleFS */
+    AUDIO_CMD_IDX_PROMPT,  /* prompt and ringtone store */
+    AUDIO_CMD_IDX_DTMF,    /* DTMF in the outgoing stream */
+    AUDIO_CMD_IDX_VAD,     /* voice activity and the work it saved */
+};
+
+static char *audio_cmd_explain[] = {
+    "audio path latency per stage, p50/p95/p99 and worst frame", //
+    "synchronous link packet statistics per peer",               //
+    "call recording to LittleFS, rec_in.wav and rec_out.wav",    //
+    "prompt and ringtone store, list without arguments",         //
+    "play DTMF digits in the outgoing stream",                   //
+    "voice activity per direction and the processing it saved",  //
+};
+
+typedef struct {
+    struct arg_str *op;
+    struct arg_end *end;
+} lat_args_t;
+
+typedef struct {
+    struct arg_str *op;
+    struct arg_str *dir;
+    struct arg_end *end;
+} rec_args_t;
+
+typedef struct {
+    struct arg_str *op;
+    struct arg_str *name;
+    struct arg_str *arg;
+    struct arg_end *end;
+} prompt_args_t;
+
+typedef struct {
+    struct arg_str *digits;
+    struct arg_end *end;
+} dtmf_args_t;
+
+static lat_args_t lat_args;
+static rec_args_t rec_args;
+static prompt_args_t prompt_args;
+static dtmf_args_t dtmf_args;
+
+void register_audio_cmds(void) {
+    lat_args.op = arg_str0(NULL, NULL, "[reset]", "clear the histograms");
+    lat_args.end = arg_end(1);
+    const esp_console_cmd_t AUDIO_ORDER(lat) = {
+        .command = "lat",                                 //
+        .help = audio_cmd_explain[AUDIO_CMD_IDX_LAT],     //
+        .hint = NULL,                                     //
+        .func = audio_cmd_tbl[AUDIO_CMD_IDX_LAT].handler, //
+        .argtable = &lat_args                             //
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&AUDIO_ORDER(lat)));
+
+    const esp_console_cmd_t AUDIO_ORDER(pkt) = {
+        .command = "pkt",                                 //
+        .help = audio_cmd_explain[AUDIO_CMD_IDX_PKT],     //
+        .hint = NULL,                                     //
+        .func = audio_cmd_tbl[AUDIO_CMD_IDX_PKT].handler, //
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&AUDIO_ORDER(pkt)));
+
+    rec_args.op = arg_str0(NULL, NULL, "[start|stop]", "start or stop recording, status without");
+    rec_args.dir = arg_str0(NULL, NULL, "[in|out|both]", "directions to record, both by default");
+    rec_args.end = arg_end(2);
+    const esp_console_cmd_t AUDIO_ORDER(rec) = {
+        .command = "rec",                                 //
+        .help = audio_cmd_explain[AUDIO_CMD_IDX_REC],     //
+        .hint = NULL,                                     //
+        .func = audio_cmd_tbl[AUDIO_CMD_IDX_REC].handler, //
+        .argtable = &rec_args                             //
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&AUDIO_ORDER(rec)));
+
+    prompt_args.op = arg_str0(NULL, NULL, "[add|play|stop|clear]", "operation");
+    prompt_args.name = arg_str0(NULL, NULL, "[name]", "prompt name, up to 15 characters");
+    prompt_args.arg = arg_str0(NULL, NULL, "[file.wav|loop]", "add: 8 or 16 kHz mono WAV on LittleFS, play: repeat until stopped");
+    prompt_args.end = arg_end(3);
+    const esp_console_cmd_t AUDIO_ORDER(prompt) = {
+        .command = "prompt",                                 //
+        .help = audio_cmd_explain[AUDIO_CMD_IDX_PROMPT],     //
+        .hint = NULL,                                        //
+        .func = audio_cmd_tbl[AUDIO_CMD_IDX_PROMPT].handler, //
+        .argtable = &prompt_args                             //
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&AUDIO_ORDER(prompt)));
+
+    dtmf_args.digits = arg_str1(NULL, NULL, "<digits>", "0-9, *, # and A-D");
+    dtmf_args.end = arg_end(1);
+    const esp_console_cmd_t AUDIO_ORDER(dtmf) = {
+        .command = "dtmf",                                 //
+        .help = audio_cmd_explain[AUDIO_CMD_IDX_DTMF],     //
+        .hint = NULL,                                      //
+        .func = audio_cmd_tbl[AUDIO_CMD_IDX_DTMF].handler, //
+        .argtable = &dtmf_args                             //
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&AUDIO_ORDER(dtmf)));
+
+    const esp_console_cmd_t AUDIO_ORDER(vad) = {
+        .command = "vad",                                 //
+        .help = audio_cmd_explain[AUDIO_CMD_IDX_VAD],     //
+        .hint = NULL,                                     //
+        .func = audio_cmd_tbl[AUDIO_CMD_IDX_VAD].handler, //
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&AUDIO_ORDER(vad)));
+}
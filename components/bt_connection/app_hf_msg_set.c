@@ -27,6 +27,7 @@
  *
  */
 
+#include <inttypes.h>
 #include <stdio.h>
 #include <string.h>
 
@@ -36,7 +37,11 @@
 #include "esp_log.h"
 
 #include "app_hf_msg_set.h"
+#include "bt_app_core.h"
 #include "bt_app_hf.h"
+#include "bt_app_ind.h"
+#include "bt_app_peer.h"
+#include "bt_app_relay.h"
 #include "bt_scan.h"
 
 static const char *TAG = "app_hf_msg_set";
@@ -45,50 +50,132 @@ bt_device_t *scan_devices = NULL;
 uint32_t scan_num_devices = 0;
 
 // if you want to connect a specific device, add it's bda here 0x00, 0x88, 0x24,
-// 0x48, 0x13, 0x2a
-esp_bd_addr_t hf_peer_addr = { 0x00, 0x88, 0x24, 0x48, 0x13, 0x2a };
+// 0x48, 0x13, 0x2a, used while no peer is in the table
+static esp_bd_addr_t s_default_peer = { 0x00, 0x88, 0x24, 0x48, 0x13, 0x2a };
 
 #define HF_CMD_HANDLER(cmd) static int hf_##cmd##_handler(int argn, char **argv)
 
+// address a command acts on, "-p <idx>" after the command picks a peer of the table and is removed from the arguments,
+// otherwise the selected peer, NULL if idx is not in use
+static uint8_t *hf_cmd_peer(int *argn, char **argv) {
+    bt_app_peer_t *peer;
+    int idx;
+    if (*argn >= 3 && strcmp(argv[1], "-p") == 0) {
+        if (sscanf(argv[2], "%d", &idx) != 1 || (peer = bt_app_peer_at(idx)) == NULL) {
+            printf("Invalid peer %s\n", argv[2]);
+            return NULL;
+        }
+        memmove(&argv[1], &argv[3], (*argn - 3) * sizeof(char *));
+        *argn -= 2;
+        return peer->bda;
+    }
+    peer = bt_app_peer_selected();
+    return peer ? peer->bda : s_default_peer;
+}
+
+#define HF_CMD_PEER(bda)                     \
+    uint8_t *bda = hf_cmd_peer(&argn, argv); \
+    if (bda == NULL) {                       \
+        return 1;                            \
+    }
+
+/* event for handler "hf_peer_hdl" */
+enum {
+    HF_PEER_EVT_VOLUME = 0,
+    HF_PEER_EVT_CIEV,
+};
+
+typedef struct {
+    esp_bd_addr_t bda;
+    int type;  /*!< esp_hf_volume_control_target_t or esp_hf_ciev_report_type_t */
+    int value;
+} hf_peer_msg_t;
+
+// the peer table belongs to the application task, console commands that change an entry are run there
+static void hf_peer_hdl(uint16_t event, void *param) {
+    hf_peer_msg_t *msg = param;
+    bt_app_peer_t *peer = bt_app_peer_get(msg->bda);
+
+    switch (event) {
+        case HF_PEER_EVT_VOLUME:
+            if (peer) {
+                peer->volume[msg->type] = msg->value;
+            }
+#if CONFIG_BT_HFP_AUDIO_DATA_PATH_HCI
+            // the audio path plays the one peer with an audio connection
+            if (peer && peer->audio != ESP_HF_AUDIO_STATE_DISCONNECTED) {
+                bt_app_hf_set_volume(msg->type, msg->value);
+            }
+#endif /* #if CONFIG_BT_HFP_AUDIO_DATA_PATH_HCI */
+            break;
+        case HF_PEER_EVT_CIEV:
+            if (peer) {
+                bt_app_ind_set(peer, msg->type, msg->value);
+            } else {
+                esp_hf_ag_ciev_report(msg->bda, msg->type, msg->value);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+static bool hf_peer_dispatch(uint16_t event, const uint8_t *bda, int type, int value) {
+    hf_peer_msg_t msg = { .type = type, .value = value };
+    memcpy(msg.bda, bda, ESP_BD_ADDR_LEN);
+    if (!bt_app_work_dispatch(hf_peer_hdl, event, &msg, sizeof(msg), NULL, BT_APP_LANE_NORMAL)) {
+        printf("Application task busy\n");
+        return false;
+    }
+    return true;
+}
+
 HF_CMD_HANDLER(conn) {
+    HF_CMD_PEER(bda);
     printf("Connect.\n");
-    esp_hf_ag_slc_connect(hf_peer_addr);
+    esp_hf_ag_slc_connect(bda);
     return 0;
 }
 
 HF_CMD_HANDLER(disc) {
+    HF_CMD_PEER(bda);
     printf("Disconnect\n");
-    esp_hf_ag_slc_disconnect(hf_peer_addr);
+    esp_hf_ag_slc_disconnect(bda);
     return 0;
 }
 
 HF_CMD_HANDLER(conn_audio) {
+    HF_CMD_PEER(bda);
     printf("Connect Audio\n");
-    esp_hf_ag_audio_connect(hf_peer_addr);
+    esp_hf_ag_audio_connect(bda);
     return 0;
 }
 
 HF_CMD_HANDLER(disc_audio) {
+    HF_CMD_PEER(bda);
     printf("Disconnect Audio\n");
-    esp_hf_ag_audio_disconnect(hf_peer_addr);
+    esp_hf_ag_audio_disconnect(bda);
     return 0;
 }
 
 // AT+BVRA
 HF_CMD_HANDLER(vra_on) {
+    HF_CMD_PEER(bda);
     printf("Start Voice Recognition.\n");
-    esp_hf_ag_vra_control(hf_peer_addr, 1);
+    esp_hf_ag_vra_control(bda, 1);
     return 0;
 }
 // AT+BVRA
 HF_CMD_HANDLER(vra_off) {
+    HF_CMD_PEER(bda);
     printf("Stop Voicer Recognition.\n");
-    esp_hf_ag_vra_control(hf_peer_addr, 0);
+    esp_hf_ag_vra_control(bda, 0);
     return 0;
 }
 
 // AT+VGS or AT+VGM
 HF_CMD_HANDLER(volume_control) {
+    HF_CMD_PEER(bda);
     if (argn != 3) {
         printf("Insufficient number of arguments");
         return 1;
@@ -103,12 +190,13 @@ HF_CMD_HANDLER(volume_control) {
         return 1;
     }
     printf("Volume Update\n");
-    esp_hf_ag_volume_control(hf_peer_addr, target, volume);
-    return 0;
+    esp_hf_ag_volume_control(bda, target, volume);
+    return hf_peer_dispatch(HF_PEER_EVT_VOLUME, bda, target, volume) ? 0 : 1;
 }
 
 //+CIEV
 HF_CMD_HANDLER(ciev_report) {
+    HF_CMD_PEER(bda);
     if (argn != 3) {
         printf("Insufficient number of arguments");
         return 1;
@@ -153,12 +241,12 @@ HF_CMD_HANDLER(ciev_report) {
     }
 
     printf("Device Indicator Changed!\n");
-    esp_hf_ag_ciev_report(hf_peer_addr, ind_type, value);
-    return 0;
+    return hf_peer_dispatch(HF_PEER_EVT_CIEV, bda, ind_type, value) ? 0 : 1;
 }
 
 // AT+CMEE
 HF_CMD_HANDLER(cme_err) {
+    HF_CMD_PEER(bda);
     if (argn != 3) {
         printf("Insufficient number of arguments");
         return 1;
@@ -178,55 +266,61 @@ HF_CMD_HANDLER(cme_err) {
     }
 
     printf("Send CME Error.\n");
-    esp_hf_ag_cmee_send(hf_peer_addr, response_code, error_code);
+    esp_hf_ag_cmee_send(bda, response_code, error_code);
     return 0;
 }
 
 //+BSIR:1
 HF_CMD_HANDLER(ir_on) {
+    HF_CMD_PEER(bda);
     printf("Enable Voicer Recognition.\n");
-    esp_hf_ag_bsir(hf_peer_addr, 1);
+    esp_hf_ag_bsir(bda, 1);
     return 0;
 }
 
 //+BSIR:0
 HF_CMD_HANDLER(ir_off) {
+    HF_CMD_PEER(bda);
     printf("Disable Voicer Recognition.\n");
-    esp_hf_ag_bsir(hf_peer_addr, 0);
+    esp_hf_ag_bsir(bda, 0);
     return 0;
 }
 
 // Answer Call from AG
 HF_CMD_HANDLER(ac) {
+    HF_CMD_PEER(bda);
     printf("Answer Call from AG.\n");
     char *number = { "123456" };
-    esp_hf_ag_answer_call(hf_peer_addr, 1, 0, 1, 1, number, 0);
+    esp_hf_ag_answer_call(bda, 1, 0, 1, 1, number, 0);
     return 0;
 }
 
 // Reject Call from AG
 HF_CMD_HANDLER(rc) {
+    HF_CMD_PEER(bda);
     printf("Reject Call from AG.\n");
     char *number = { "123456" };
-    esp_hf_ag_reject_call(hf_peer_addr, 0, 0, 0, 0, number, 0);
+    esp_hf_ag_reject_call(bda, 0, 0, 0, 0, number, 0);
     return 0;
 }
 
 // End Call from AG
 HF_CMD_HANDLER(end) {
+    HF_CMD_PEER(bda);
     printf("End Call from AG.\n");
     char *number = { "123456" };
-    esp_hf_ag_end_call(hf_peer_addr, 0, 0, 0, 0, number, 0);
+    esp_hf_ag_end_call(bda, 0, 0, 0, 0, number, 0);
     return 0;
 }
 
 // Dial Call from AG
 HF_CMD_HANDLER(dn) {
+    HF_CMD_PEER(bda);
     if (argn != 2) {
         printf("Insufficient number of arguments");
     } else {
         printf("Dial number %s\n", argv[1]);
-        esp_hf_ag_out_call(hf_peer_addr, 1, 0, 1, 2, argv[1], 0);
+        esp_hf_ag_out_call(bda, 1, 0, 1, 2, argv[1], 0);
     }
     return 0;
 }
@@ -249,6 +343,123 @@ HF_CMD_HANDLER(scan) {
     return 0;
 }
 
+// Select generated tone
+HF_CMD_HANDLER(tone) {
+    int tone_id;
+    if (argn != 2) {
+        printf("Insufficient number of arguments");
+        return 1;
+    }
+    if (sscanf(argv[1], "%d", &tone_id) != 1 || !bt_app_hf_set_tone(tone_id)) {
+        printf("Invalid argument for tone %s\n", argv[1]);
+        return 1;
+    }
+    printf("Tone %d selected\n", tone_id);
+    return 0;
+}
+
+// List peers, or select the one commands act on
+HF_CMD_HANDLER(peer) {
+    int idx;
+    if (argn == 2) {
+        if (sscanf(argv[1], "%d", &idx) != 1 || !bt_app_peer_select(idx)) {
+            printf("Invalid argument for peer %s\n", argv[1]);
+            return 1;
+        }
+        printf("Peer %d selected\n", idx);
+        return 0;
+    }
+
+    const bt_app_peer_t *selected = bt_app_peer_selected();
+    for (idx = 0; idx < BT_APP_PEER_MAX; idx++) {
+        const bt_app_peer_t *peer = bt_app_peer_at(idx);
+        if (!peer) {
+            continue;
+        }
+        char bda_str[18];
+        bda2str((uint8_t *)peer->bda, bda_str, 18);
+        printf("%c%d %s slc %d audio %d%s handle 0x%04x vol %d/%d nrec %d events %" PRIu32 "\n", (peer == selected) ? '*' : ' ', idx, bda_str, peer->conn,
+               peer->audio, (peer->audio == ESP_HF_AUDIO_STATE_CONNECTED_MSBC) ? " msbc" : "", peer->sync_conn_handle,
+               peer->volume[ESP_HF_VOLUME_CONTROL_TARGET_SPK], peer->volume[ESP_HF_VOLUME_CONTROL_TARGET_MIC], peer->nrec, peer->events);
+    }
+    if (!selected) {
+        printf("No peers, commands go to the default address\n");
+    }
+
+    bt_app_peer_stats_t st;
+    bt_app_peer_get_stats(&st);
+    printf("lookups %" PRIu32 ", probes %" PRIu32 " (max %" PRIu32 "), refused %" PRIu32 "\n", st.lookups, st.probes, st.probe_max, st.full);
+    return 0;
+}
+
+// Relay a phone to the headsets: connect to it, disconnect, or report the relay
+HF_CMD_HANDLER(relay) {
+    if (argn == 2 && strcmp(argv[1], "off") == 0) {
+        printf("Disconnect phone\n");
+        bt_app_relay_disconnect();
+        return 0;
+    }
+    if (argn == 2) {
+        unsigned int b[ESP_BD_ADDR_LEN];
+        esp_bd_addr_t bda;
+        if (sscanf(argv[1], "%x:%x:%x:%x:%x:%x", &b[0], &b[1], &b[2], &b[3], &b[4], &b[5]) != ESP_BD_ADDR_LEN) {
+            printf("Invalid argument for phone %s\n", argv[1]);
+            return 1;
+        }
+        for (int i = 0; i < ESP_BD_ADDR_LEN; i++) {
+            bda[i] = (uint8_t)b[i];
+        }
+        if (!bt_app_relay_connect(bda)) {
+            printf("Relay not enabled\n");
+            return 1;
+        }
+        printf("Connect phone %s\n", argv[1]);
+        return 0;
+    }
+    bt_app_relay_report();
+    return 0;
+}
+
+// Report the application task, its lanes and parameter pool
+HF_CMD_HANDLER(task) {
+    static const char *c_lane_str[BT_APP_LANES] = { "high", "normal" };
+    static const char *c_class_str[BT_APP_POOL_CLASSES] = { "small", "medium", "large" };
+    static const uint32_t c_class_size[BT_APP_POOL_CLASSES] = { BT_APP_POOL_SMALL, BT_APP_POOL_MEDIUM, BT_APP_POOL_LARGE };
+    static const uint32_t c_class_blocks[BT_APP_POOL_CLASSES] = { BT_APP_POOL_SMALL_BLOCKS, BT_APP_POOL_MEDIUM_BLOCKS, BT_APP_POOL_LARGE_BLOCKS };
+    bt_app_pool_stats_t st;
+
+    if (argn == 2 && strcmp(argv[1], "reset") == 0) {
+        bt_app_core_reset_lane_wait();
+        printf("Lane wait histograms cleared\n");
+        return 0;
+    }
+    if (argn != 1) {
+        printf("Invalid argument %s\n", argv[1]);
+        return 1;
+    }
+
+    printf("%-6s %8s %8s %8s %8s %8s %8s %8s %8s\n", "lane", "sent", "served", "dropped", "aged", "p50 us", "p99 us", "worst us", "event");
+    for (int i = 0; i < BT_APP_LANES; i++) {
+        bt_app_lane_stats_t ls;
+        bt_app_core_get_lane_stats(i, &ls);
+        const audio_trace_t *tr = bt_app_core_get_lane_wait(i);
+        printf("%-6s %8" PRIu32 " %8" PRIu32 " %8" PRIu32 " %8" PRIu32 " %8" PRIu32 " %8" PRIu32 " %8" PRIu32 " %8" PRIu32 "\n", c_lane_str[i], ls.sent,
+               audio_trace_count(tr), ls.dropped, ls.aged, audio_trace_percentile(tr, 500), audio_trace_percentile(tr, 990), tr->worst_us, tr->worst_seq);
+    }
+    bt_app_core_get_pool_stats(&st);
+    for (int c = 0; c < BT_APP_POOL_CLASSES; c++) {
+        printf("%-6s %3" PRIu32 " B: hits %" PRIu32 ", in use %" PRIu32 ", high water %" PRIu32 "/%" PRIu32 "\n", c_class_str[c], c_class_size[c], st.hits[c],
+               st.in_use[c], st.high_water[c], c_class_blocks[c]);
+    }
+    printf("inline %" PRIu32 ", spills %" PRIu32 ", heap %" PRIu32 ", dropped %" PRIu32 "\n", st.inlined, st.spills, st.fallbacks, st.failures);
+
+    bt_app_ind_stats_t is;
+    bt_app_ind_get_stats(&is);
+    printf("indicators %" PRIu32 " in %" PRIu32 " flushes (%" PRIu32 " merged), +CIEV sent %" PRIu32 ", %" PRIu32 " unchanged, %" PRIu32 " B saved\n",
+           is.updates, is.flushes, is.merged, is.sent, is.unchanged, (is.updates - is.sent) * BT_APP_IND_CIEV_BYTES);
+    return 0;
+}
+
 static hf_msg_hdl_t hf_cmd_tbl[] = {
     { "con", hf_conn_handler },          //
     { "dis", hf_disc_handler },          //
@@ -266,6 +477,10 @@ static hf_msg_hdl_t hf_cmd_tbl[] = {
     { "end", hf_end_handler },           //
     { "dn", hf_dn_handler },             //
     { "scan", hf_scan_handler },         //
+    { "tone", hf_tone_handler },         //
+    { "peer", hf_peer_handler },         //
+    { "relay", hf_relay_handler },       //
+    { "task", hf_task_handler },         //
 };
 
 #define HF_ORDER(name) name##_cmd
@@ -286,6 +501,10 @@ enum hf_cmd_idx {
     HF_CMD_IDX_END,     /* End up a call by AG */
     HF_CMD_IDX_DN,      /* Dial Number by AG, e.g. d 11223344 */
     HF_CMD_IDX_SCAN,    /* Scan devices */
+    HF_CMD_IDX_TONE,    /* select generated tone */
+    HF_CMD_IDX_PEER,    /* list peers, or select the one commands act on */
+    HF_CMD_IDX_RELAY,   /* relay a phone to the headsets */
+    HF_CMD_IDX_TASK,    /* report the application task, or reset the lane waits */
 };
 
 static char *hf_cmd_explain[] = {
@@ -304,7 +523,11 @@ static char *hf_cmd_explain[] = {
     "Reject Incoming Call from AG",                      //
     "End up a call by AG",                               //
     "Dial Number by AG, e.g. d 11223344",                //
-    "Scan devices"                                      //
+    "Scan devices",                                      //
+    "select generated tone",                             //
+    "list peers, or select the one commands act on, \"-p <idx>\" picks one for a single command", //
+    "relay a phone to the headsets, connect, disconnect or report latency", //
+    "report the application task, lane waits and parameter pool, or reset the waits", //
 };
 typedef struct {
     struct arg_str *tgt;
@@ -324,9 +547,15 @@ typedef struct {
     struct arg_end *end;
 } ate_args_t;
 
+typedef struct {
+    struct arg_str *id;
+    struct arg_end *end;
+} tone_args_t;
+
 static vu_args_t vu_args;
 static ind_args_t ind_args;
 static ate_args_t ate_args;
+static tone_args_t tone_args;
 
 void register_hfp_ag(void) {
     const esp_console_cmd_t HF_ORDER(con) = {
@@ -469,4 +698,39 @@ void register_hfp_ag(void) {
         .func = hf_cmd_tbl[HF_CMD_IDX_SCAN].handler, //
     };
     ESP_ERROR_CHECK(esp_console_cmd_register(&HF_ORDER(scan)));
+
+    tone_args.id = arg_str1(NULL, NULL, "<id>", "\n    0-test\n    1-dial\n    2-ringback\n    3-busy\n    4-congestion");
+    tone_args.end = arg_end(1);
+    const esp_console_cmd_t HF_ORDER(tone) = {
+        .command = "tone",                           //
+        .help = hf_cmd_explain[HF_CMD_IDX_TONE],     //
+        .hint = NULL,                                //
+        .func = hf_cmd_tbl[HF_CMD_IDX_TONE].handler, //
+        .argtable = &tone_args                       //
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&HF_ORDER(tone)));
+
+    const esp_console_cmd_t HF_ORDER(peer) = {
+        .command = "peer",                           //
+        .help = hf_cmd_explain[HF_CMD_IDX_PEER],     //
+        .hint = "[<idx>]",                           //
+        .func = hf_cmd_tbl[HF_CMD_IDX_PEER].handler, //
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&HF_ORDER(peer)));
+
+    const esp_console_cmd_t HF_ORDER(relay) = {
+        .command = "relay",                           //
+        .help = hf_cmd_explain[HF_CMD_IDX_RELAY],     //
+        .hint = "[<phone bda>|off]",                  //
+        .func = hf_cmd_tbl[HF_CMD_IDX_RELAY].handler, //
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&HF_ORDER(relay)));
+
+    const esp_console_cmd_t HF_ORDER(task) = {
+        .command = "task",                           //
+        .help = hf_cmd_explain[HF_CMD_IDX_TASK],     //
+        .hint = "[reset]",                           //
+        .func = hf_cmd_tbl[HF_CMD_IDX_TASK].handler, //
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&HF_ORDER(task)));
 }
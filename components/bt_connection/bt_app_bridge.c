@@ -0,0 +1,103 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+
+#include "audio_bridge.h"
+#include "audio_frame.h"
+#include "bt_app_bridge.h"
+#include "gpio_pcm_config.h"
+#include "hal_i2s.h"
+
+static const char *TAG = "bt_app_bridge";
+
+static audio_bridge_t s_bridge;
+static bool s_bridge_ready = false;
+static volatile bt_app_bridge_stage_t s_stage = NULL;
+
+static void bt_app_bridge_frame(void *ctx, const int16_t *rx, int16_t *tx, uint32_t samples) {
+    bt_app_bridge_stage_t stage = s_stage;
+    if (stage) {
+        stage(rx, tx, samples);
+    } else {
+        memcpy(tx, rx, samples * BYTES_PER_SAMPLE);
+    }
+}
+
+bool bt_app_bridge_start(uint32_t sample_rate) {
+    if (!s_bridge_ready) {
+        // clocked by the controller: both ends run on the air clock, no drift to absorb
+        hal_i2s_config_t cfg = {
+            .port = BT_APP_BRIDGE_PORT,
+            .slave = true,
+            .fmt = HAL_I2S_FMT_PCM_SHORT,
+            .mclk = HAL_I2S_PIN_UNUSED,
+            .bclk = GPIO_OUTPUT_PCM_CLK_OUT,
+            .ws = GPIO_OUTPUT_PCM_FSYNC,
+            .dout = GPIO_OUTPUT_CODEC_DOUT,
+            .din = GPIO_OUTPUT_PCM_DOUT,
+            .task_prio = configMAX_PRIORITIES - 3,
+        };
+        audio_bridge_init(&s_bridge, &hal_i2s_bridge_ops, hal_i2s_driver(&cfg));
+        s_bridge_ready = true;
+    }
+
+    // 7.5 ms frames, as on the HCI path
+    uint32_t samples = sample_rate / 1000 * PCM_BLOCK_DURATION_US / 1000;
+    if (!audio_bridge_start(&s_bridge, sample_rate, samples, bt_app_bridge_frame, NULL)) {
+        ESP_LOGE(TAG, "bridge not started at %" PRIu32 " Hz", sample_rate);
+        return false;
+    }
+    // the I2S pin setup takes the controller clock pins as inputs, give them back to the controller
+    app_gpio_pcm_io_cfg();
+    return true;
+}
+
+void bt_app_bridge_stop(void) {
+    if (!s_bridge.running) {
+        return;
+    }
+    audio_bridge_stop(&s_bridge);
+    ESP_LOGI(TAG, "frames %" PRIu32 ", late %" PRIu32 ", overruns %" PRIu32 ", underruns %" PRIu32 ", latency max %" PRIu32 " us", s_bridge.stats.frames,
+             s_bridge.stats.late, s_bridge.stats.overruns, s_bridge.stats.underruns, s_bridge.stats.lat_max_us);
+}
+
+void bt_app_bridge_register_stage(bt_app_bridge_stage_t stage) {
+    s_stage = stage;
+}
+
+void bt_app_bridge_get_stats(audio_bridge_stats_t *stats) {
+    *stats = s_bridge.stats;
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef __BT_APP_BRIDGE_H__
+#define __BT_APP_BRIDGE_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "audio_bridge.h"
+
+// I2S DMA bridge from the controller PCM interface to the codec, needs the codec DAC on GPIO_OUTPUT_CODEC_DOUT
+#define BT_APP_BRIDGE_ENABLE 0
+#define BT_APP_BRIDGE_PORT   0 // I2S peripheral listening on the controller PCM pins
+
+/**
+ * @brief     processing between the controller and the codec: in is the headset voice, out goes to the codec.
+ *            Both are the DMA buffers, called from the bridge task once per frame
+ */
+typedef void (*bt_app_bridge_stage_t)(const int16_t *in, int16_t *out, uint32_t samples);
+
+/**
+ * @brief     start the bridge for an audio connection at sample_rate
+ */
+bool bt_app_bridge_start(uint32_t sample_rate);
+
+/**
+ * @brief     stop the bridge and log its counters
+ */
+void bt_app_bridge_stop(void);
+
+/**
+ * @brief     register the processing stage, NULL passes the frames through
+ */
+void bt_app_bridge_register_stage(bt_app_bridge_stage_t stage);
+
+/**
+ * @brief     counters of the current or last audio connection
+ */
+void bt_app_bridge_get_stats(audio_bridge_stats_t *stats);
+
+#endif /* __BT_APP_BRIDGE_H__ */
@@ -29,24 +29,127 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/queue.h"
 #include "freertos/task.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 
 #include "bt_app_core.h"
+#include "bt_app_pool.h"
 
 static void bt_app_task_handler(void *arg);
-static bool bt_app_send_msg(bt_app_msg_t *msg);
+static bool bt_app_send_msg(bt_app_msg_t *msg, bt_app_lane_t lane);
 static void bt_app_work_dispatched(bt_app_msg_t *msg);
 
-static QueueHandle_t bt_app_task_queue = NULL;
+static QueueHandle_t bt_app_task_queue[BT_APP_LANES] = { NULL };
 static TaskHandle_t bt_app_task_handle = NULL;
+static bt_app_lane_stats_t s_lane_stats[BT_APP_LANES];
+static audio_trace_t s_lane_wait[BT_APP_LANES];
 
-bool bt_app_work_dispatch(bt_app_cb_t p_cback, uint16_t event, void *p_params, int param_len, bt_app_copy_cb_t p_copy_cback) {
-    ESP_LOGD(BT_APP_CORE_TAG, "%s event 0x%x, param len %d", __func__, event, param_len);
+typedef struct {
+    bt_app_cb_t cb;      /*!< set once, the slot then stays with this callback */
+    uint16_t event;
+    uint32_t defer_us;   /*!< time the work was deferred, for the aging */
+} bt_app_defer_t;
+
+static bt_app_defer_t s_defer[BT_APP_DEFER_MAX];
+static uint32_t s_defer_waiting; // bit per slot
+
+static uint8_t s_small_mem[BT_APP_POOL_SMALL_BLOCKS * BT_APP_POOL_SMALL] __attribute__((aligned(8)));
+static uint8_t s_medium_mem[BT_APP_POOL_MEDIUM_BLOCKS * BT_APP_POOL_MEDIUM] __attribute__((aligned(8)));
+static uint8_t s_large_mem[BT_APP_POOL_LARGE_BLOCKS * BT_APP_POOL_LARGE] __attribute__((aligned(8)));
+static uint8_t s_small_next[BT_APP_POOL_SMALL_BLOCKS];
+static uint8_t s_medium_next[BT_APP_POOL_MEDIUM_BLOCKS];
+static uint8_t s_large_next[BT_APP_POOL_LARGE_BLOCKS];
+
+// smallest class first
+static bt_app_pool_t s_pools[BT_APP_POOL_CLASSES] = {
+    { BT_APP_POOL_SMALL, BT_APP_POOL_SMALL_BLOCKS, s_small_mem, s_small_next, 0 },     //
+    { BT_APP_POOL_MEDIUM, BT_APP_POOL_MEDIUM_BLOCKS, s_medium_mem, s_medium_next, 0 }, //
+    { BT_APP_POOL_LARGE, BT_APP_POOL_LARGE_BLOCKS, s_large_mem, s_large_next, 0 },     //
+};
+static bt_app_pool_stats_t s_pool_stats;
+
+static void bt_app_pools_init(void) {
+    for (int c = 0; c < BT_APP_POOL_CLASSES; c++) {
+        bt_app_pool_init(&s_pools[c]);
+    }
+    memset(&s_pool_stats, 0, sizeof(bt_app_pool_stats_t));
+}
+
+static void *bt_app_pool_take(uint32_t len) {
+    bool spill = false;
+    for (int c = 0; c < BT_APP_POOL_CLASSES; c++) {
+        if (len > s_pools[c].size) {
+            continue;
+        }
+        uint32_t used;
+        void *p = bt_app_pool_pop(&s_pools[c], &used);
+        if (p) {
+            __atomic_fetch_add(&s_pool_stats.hits[c], 1, __ATOMIC_RELAXED);
+            uint32_t high = __atomic_load_n(&s_pool_stats.high_water[c], __ATOMIC_RELAXED);
+            while (used > high && !__atomic_compare_exchange_n(&s_pool_stats.high_water[c], &high, used, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            }
+            if (spill) {
+                __atomic_fetch_add(&s_pool_stats.spills, 1, __ATOMIC_RELAXED);
+            }
+            return p;
+        }
+        spill = true;
+    }
+    __atomic_fetch_add(&s_pool_stats.fallbacks, 1, __ATOMIC_RELAXED);
+    return malloc(len);
+}
+
+static void bt_app_pool_give(void *p) {
+    for (int c = 0; c < BT_APP_POOL_CLASSES; c++) {
+        if (bt_app_pool_owns(&s_pools[c], p)) {
+            bt_app_pool_push(&s_pools[c], p);
+            return;
+        }
+    }
+    free(p);
+}
+
+static void bt_app_msg_release(bt_app_msg_t *msg) {
+    if (msg->param && !msg->inlined) {
+        bt_app_pool_give(msg->param);
+    }
+    for (int i = 0; i < BT_APP_MSG_COPIES; i++) {
+        if (msg->copy[i]) {
+            bt_app_pool_give(msg->copy[i]);
+        }
+    }
+}
+
+void *bt_app_msg_alloc(bt_app_msg_t *msg, uint32_t len) {
+    for (int i = 0; i < BT_APP_MSG_COPIES; i++) {
+        if (msg->copy[i] == NULL) {
+            msg->copy[i] = bt_app_pool_take(len);
+            return msg->copy[i];
+        }
+    }
+    return NULL;
+}
+
+char *bt_app_msg_strdup(bt_app_msg_t *msg, const char *src) {
+    if (src == NULL) {
+        return NULL;
+    }
+    uint32_t len = strlen(src) + 1;
+    char *dst = bt_app_msg_alloc(msg, len);
+    if (dst) {
+        memcpy(dst, src, len);
+    }
+    return dst;
+}
+
+bool bt_app_work_dispatch(bt_app_cb_t p_cback, uint16_t event, void *p_params, int param_len, bt_app_copy_cb_t p_copy_cback, bt_app_lane_t lane) {
+    ESP_LOGD(BT_APP_CORE_TAG, "%s event 0x%x, param len %d, lane %d", __func__, event, param_len, lane);
 
     bt_app_msg_t msg;
     memset(&msg, 0, sizeof(bt_app_msg_t));
@@ -56,29 +159,114 @@ bool bt_app_work_dispatch(bt_app_cb_t p_cback, uint16_t event, void *p_params, i
     msg.cb = p_cback;
 
     if (param_len == 0) {
-        return bt_app_send_msg(&msg);
+        return bt_app_send_msg(&msg, lane);
     } else if (p_params && param_len > 0) {
-        if ((msg.param = malloc(param_len)) != NULL) {
-            memcpy(msg.param, p_params, param_len);
-            /* check if caller has provided a copy callback to do the deep copy */
-            if (p_copy_cback) {
-                p_copy_cback(&msg, msg.param, p_params);
-            }
-            return bt_app_send_msg(&msg);
+        if (param_len <= BT_APP_MSG_INLINE) {
+            msg.inlined = true;
+            msg.param = msg.data;
+            __atomic_fetch_add(&s_pool_stats.inlined, 1, __ATOMIC_RELAXED);
+        } else if ((msg.param = bt_app_pool_take(param_len)) == NULL) {
+            __atomic_fetch_add(&s_pool_stats.failures, 1, __ATOMIC_RELAXED);
+            return false;
         }
+        memcpy(msg.param, p_params, param_len);
+        /* check if caller has provided a copy callback to do the deep copy */
+        if (p_copy_cback) {
+            p_copy_cback(&msg, msg.param, p_params);
+        }
+        if (bt_app_send_msg(&msg, lane)) {
+            return true;
+        }
+        bt_app_msg_release(&msg);
+        __atomic_fetch_add(&s_pool_stats.failures, 1, __ATOMIC_RELAXED);
     }
     return false;
 }
 
-static bool bt_app_send_msg(bt_app_msg_t *msg) {
-    if (msg == NULL) {
+static bool bt_app_send_msg(bt_app_msg_t *msg, bt_app_lane_t lane) {
+    if (msg == NULL || lane >= BT_APP_LANES) {
+        return false;
+    }
+
+    msg->enqueue_us = (uint32_t)esp_timer_get_time();
+    if (xQueueSend(bt_app_task_queue[lane], msg, 10 / portTICK_PERIOD_MS) != pdTRUE) {
+        ESP_LOGE(BT_APP_CORE_TAG, "%s xQueue send failed, lane %d", __func__, lane);
+        __atomic_fetch_add(&s_lane_stats[lane].dropped, 1, __ATOMIC_RELAXED);
+        return false;
+    }
+    __atomic_fetch_add(&s_lane_stats[lane].sent, 1, __ATOMIC_RELAXED);
+    // one wake up for any lane, the task serves until both are empty
+    xTaskNotifyGive(bt_app_task_handle);
+    return true;
+}
+
+bool bt_app_work_defer(bt_app_cb_t p_cback, uint16_t event) {
+    int i;
+    for (i = 0; i < BT_APP_DEFER_MAX; i++) {
+        bt_app_cb_t cb = __atomic_load_n(&s_defer[i].cb, __ATOMIC_ACQUIRE);
+        if (cb == NULL && __atomic_compare_exchange_n(&s_defer[i].cb, &cb, p_cback, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            break;
+        }
+        // a slot lost to another task holds the winner, which may be this callback too
+        if (cb == p_cback) {
+            break;
+        }
+    }
+    if (i == BT_APP_DEFER_MAX) {
+        ESP_LOGE(BT_APP_CORE_TAG, "%s no slot, %d callbacks", __func__, BT_APP_DEFER_MAX);
         return false;
     }
+    if (__atomic_load_n(&s_defer_waiting, __ATOMIC_ACQUIRE) & (1u << i)) {
+        return false;
+    }
+    // the slot is filled before its bit publishes it to the task
+    s_defer[i].event = event;
+    s_defer[i].defer_us = (uint32_t)esp_timer_get_time();
+    if (__atomic_fetch_or(&s_defer_waiting, 1u << i, __ATOMIC_RELEASE) & (1u << i)) {
+        return false;
+    }
+    // the task checks the deferred work before it blocks again
+    if (xTaskGetCurrentTaskHandle() != bt_app_task_handle) {
+        xTaskNotifyGive(bt_app_task_handle);
+    }
+    return true;
+}
+
+// deferred work once the lanes are empty, or aged past the limit; true if any ran
+static bool bt_app_run_deferred(bool idle) {
+    uint32_t waiting = __atomic_load_n(&s_defer_waiting, __ATOMIC_ACQUIRE);
+    uint32_t now = (uint32_t)esp_timer_get_time();
+    bool ran = false;
+
+    for (int i = 0; waiting; i++, waiting >>= 1) {
+        if (!(waiting & 1) || (!idle && now - s_defer[i].defer_us < BT_APP_LANE_AGING_US)) {
+            continue;
+        }
+        // read before the bit is cleared, it can be refilled after that
+        uint16_t event = s_defer[i].event;
+        // cleared first, work deferred while it runs waits for the next turn
+        __atomic_fetch_and(&s_defer_waiting, ~(1u << i), __ATOMIC_ACQ_REL);
+        s_defer[i].cb(event, NULL);
+        ran = true;
+    }
+    return ran;
+}
 
-    if (xQueueSend(bt_app_task_queue, msg, 10 / portTICK_PERIOD_MS) != pdTRUE) {
-        ESP_LOGE(BT_APP_CORE_TAG, "%s xQueue send failed", __func__);
+// strict priority, unless the oldest normal message has waited past the aging limit
+static bool bt_app_next_msg(bt_app_msg_t *msg) {
+    uint32_t now = (uint32_t)esp_timer_get_time();
+    bt_app_lane_t lane = BT_APP_LANE_HIGH;
+
+    if (uxQueueMessagesWaiting(bt_app_task_queue[BT_APP_LANE_HIGH]) == 0) {
+        lane = BT_APP_LANE_NORMAL;
+    } else if (xQueuePeek(bt_app_task_queue[BT_APP_LANE_NORMAL], msg, 0) == pdTRUE && now - msg->enqueue_us >= BT_APP_LANE_AGING_US) {
+        lane = BT_APP_LANE_NORMAL;
+        s_lane_stats[lane].aged++;
+    }
+    if (xQueueReceive(bt_app_task_queue[lane], msg, 0) != pdTRUE) {
         return false;
     }
+    audio_trace_add(&s_lane_wait[lane], now - msg->enqueue_us, msg->event);
     return true;
 }
 
@@ -91,27 +279,36 @@ static void bt_app_work_dispatched(bt_app_msg_t *msg) {
 static void bt_app_task_handler(void *arg) {
     bt_app_msg_t msg;
     for (;;) {
-        if (pdTRUE == xQueueReceive(bt_app_task_queue, &msg, (TickType_t)portMAX_DELAY)) {
-            ESP_LOGD(BT_APP_CORE_TAG, "%s, sig 0x%x, 0x%x", __func__, msg.sig, msg.event);
-            switch (msg.sig) {
-                case BT_APP_SIG_WORK_DISPATCH:
-                    bt_app_work_dispatched(&msg);
-                    break;
-                default:
-                    ESP_LOGW(BT_APP_CORE_TAG, "%s, unhandled sig: %d", __func__, msg.sig);
-                    break;
-            } // switch (msg.sig)
-
-            if (msg.param) {
-                free(msg.param);
+        ulTaskNotifyTake(pdTRUE, (TickType_t)portMAX_DELAY);
+        do {
+            while (bt_app_next_msg(&msg)) {
+                // the queue copied the message, an inline parameter moved with it
+                if (msg.inlined) {
+                    msg.param = msg.data;
+                }
+                ESP_LOGD(BT_APP_CORE_TAG, "%s, sig 0x%x, 0x%x", __func__, msg.sig, msg.event);
+                switch (msg.sig) {
+                    case BT_APP_SIG_WORK_DISPATCH:
+                        bt_app_work_dispatched(&msg);
+                        break;
+                    default:
+                        ESP_LOGW(BT_APP_CORE_TAG, "%s, unhandled sig: %d", __func__, msg.sig);
+                        break;
+                } // switch (msg.sig)
+
+                bt_app_msg_release(&msg);
+                bt_app_run_deferred(false);
             }
-        }
+            // deferred work may have dispatched more
+        } while (bt_app_run_deferred(true));
     }
 }
 
 void bt_app_task_start_up(void) {
-    bt_app_task_queue = xQueueCreate(10, sizeof(bt_app_msg_t));
-    xTaskCreate(bt_app_task_handler, "BtAppT", 2048, NULL, configMAX_PRIORITIES - 3, &bt_app_task_handle);
+    bt_app_pools_init();
+    bt_app_task_queue[BT_APP_LANE_HIGH] = xQueueCreate(BT_APP_TASK_HIGH_LEN, sizeof(bt_app_msg_t));
+    bt_app_task_queue[BT_APP_LANE_NORMAL] = xQueueCreate(BT_APP_TASK_QUEUE_LEN, sizeof(bt_app_msg_t));
+    xTaskCreate(bt_app_task_handler, "BtAppT", BT_APP_TASK_STACK, NULL, configMAX_PRIORITIES - 3, &bt_app_task_handle);
     return;
 }
 
@@ -120,8 +317,31 @@ void bt_app_task_shut_down(void) {
         vTaskDelete(bt_app_task_handle);
         bt_app_task_handle = NULL;
     }
-    if (bt_app_task_queue) {
-        vQueueDelete(bt_app_task_queue);
-        bt_app_task_queue = NULL;
+    for (int i = 0; i < BT_APP_LANES; i++) {
+        if (bt_app_task_queue[i]) {
+            vQueueDelete(bt_app_task_queue[i]);
+            bt_app_task_queue[i] = NULL;
+        }
+    }
+}
+
+void bt_app_core_get_pool_stats(bt_app_pool_stats_t *st) {
+    memcpy(st, &s_pool_stats, sizeof(bt_app_pool_stats_t));
+    for (int c = 0; c < BT_APP_POOL_CLASSES; c++) {
+        st->in_use[c] = bt_app_pool_used(&s_pools[c]);
+    }
+}
+
+void bt_app_core_get_lane_stats(bt_app_lane_t lane, bt_app_lane_stats_t *st) {
+    memcpy(st, &s_lane_stats[lane], sizeof(bt_app_lane_stats_t));
+}
+
+const audio_trace_t *bt_app_core_get_lane_wait(bt_app_lane_t lane) {
+    return &s_lane_wait[lane];
+}
+
+void bt_app_core_reset_lane_wait(void) {
+    for (int i = 0; i < BT_APP_LANES; i++) {
+        audio_trace_reset(&s_lane_wait[i]);
     }
 }
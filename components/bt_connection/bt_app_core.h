@@ -33,9 +33,38 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#include "audio_trace.h"
+
 #define BT_APP_CORE_TAG          "BT_APP_CORE"
 #define BT_APP_SIG_WORK_DISPATCH (0x01)
 
+#define BT_APP_TASK_QUEUE_LEN (16) // normal lane
+#define BT_APP_TASK_HIGH_LEN  (8)  // high lane
+#define BT_APP_LANE_AGING_US  (20000) // a normal message or deferred work waiting this long is served ahead of the high lane
+#define BT_APP_DEFER_MAX      (4)  // distinct deferred work callbacks
+#define BT_APP_TASK_STACK     (4096) // runs the HFP event handlers
+#define BT_APP_MSG_INLINE     (16)   // parameters up to this size travel inside the message
+#define BT_APP_MSG_COPIES     (2)    // deep copied buffers per message
+
+// parameter pool size classes, a block goes to the smallest class that fits and spills to the next one when it is empty
+#define BT_APP_POOL_CLASSES (3)
+#define BT_APP_POOL_SMALL   (32)  // HFP AG and client callback parameters, short AT strings
+#define BT_APP_POOL_MEDIUM  (64)  // longer AT strings, dialled numbers
+#define BT_APP_POOL_LARGE   (272) // GAP callback parameters, a remote name is 249 bytes
+// blocks per class, a message in the queue holds up to one parameter and BT_APP_MSG_COPIES copies
+#define BT_APP_POOL_SMALL_BLOCKS  (2 * (BT_APP_TASK_QUEUE_LEN + BT_APP_TASK_HIGH_LEN))
+#define BT_APP_POOL_MEDIUM_BLOCKS (8)
+#define BT_APP_POOL_LARGE_BLOCKS  (4)
+
+/**
+ * @brief     lanes of the application task, served by strict priority with aging
+ */
+typedef enum {
+    BT_APP_LANE_HIGH = 0, /*!< audio setup, codec negotiation */
+    BT_APP_LANE_NORMAL,   /*!< indicators, call control and everything else */
+    BT_APP_LANES,
+} bt_app_lane_t;
+
 /**
  * @brief     handler for the dispatched work
  */
@@ -43,24 +72,72 @@ typedef void (*bt_app_cb_t)(uint16_t event, void *param);
 
 /* message to be sent */
 typedef struct {
-    uint16_t sig;   /*!< signal to bt_app_task */
-    uint16_t event; /*!< message event id */
-    bt_app_cb_t cb; /*!< context switch callback */
-    void *param;    /*!< parameter area needs to be last */
+    uint16_t sig;                       /*!< signal to bt_app_task */
+    uint16_t event;                     /*!< message event id */
+    bt_app_cb_t cb;                     /*!< context switch callback */
+    bool inlined;                       /*!< param is in data, it is pointed at again on reception */
+    uint32_t enqueue_us;                /*!< time the message was queued, for the lane wait */
+    void *copy[BT_APP_MSG_COPIES];      /*!< deep copies, released with the message */
+    uint32_t data[BT_APP_MSG_INLINE / sizeof(uint32_t)];
+    void *param;                        /*!< parameter area needs to be last */
 } bt_app_msg_t;
 
+typedef struct {
+    uint32_t hits[BT_APP_POOL_CLASSES];       /*!< blocks taken per class */
+    uint32_t in_use[BT_APP_POOL_CLASSES];     /*!< blocks currently taken */
+    uint32_t high_water[BT_APP_POOL_CLASSES]; /*!< most blocks taken at once */
+    uint32_t inlined;                         /*!< parameters carried inside the message */
+    uint32_t spills;                          /*!< blocks taken from a larger class than their size, the smaller one was empty */
+    uint32_t fallbacks;                       /*!< blocks taken from the heap, larger than BT_APP_POOL_LARGE or every class empty */
+    uint32_t failures;                        /*!< messages not sent, no memory or the queue stayed full */
+} bt_app_pool_stats_t;
+
+typedef struct {
+    uint32_t sent;    /*!< messages queued */
+    uint32_t dropped; /*!< messages refused, the lane stayed full */
+    uint32_t aged;    /*!< messages served ahead of a waiting high lane message */
+} bt_app_lane_stats_t;
+
 /**
  * @brief     parameter deep-copy function to be customized
  */
 typedef void (*bt_app_copy_cb_t)(bt_app_msg_t *msg, void *p_dest, void *p_src);
 
 /**
- * @brief     work dispatcher for the application task
+ * @brief     buffer of len bytes for a deep copy, released with the message, for use by copy callbacks. NULL when out of memory
+ *            or when the message already holds BT_APP_MSG_COPIES copies
+ */
+void *bt_app_msg_alloc(bt_app_msg_t *msg, uint32_t len);
+
+/**
+ * @brief     copy of a string with bt_app_msg_alloc, NULL for a NULL string or when out of memory
  */
-bool bt_app_work_dispatch(bt_app_cb_t p_cback, uint16_t event, void *p_params, int param_len, bt_app_copy_cb_t p_copy_cback);
+char *bt_app_msg_strdup(bt_app_msg_t *msg, const char *src);
+
+/**
+ * @brief     work dispatcher for the application task, the message waits in the given lane
+ */
+bool bt_app_work_dispatch(bt_app_cb_t p_cback, uint16_t event, void *p_params, int param_len, bt_app_copy_cb_t p_copy_cback, bt_app_lane_t lane);
+
+/**
+ * @brief     run p_cback once from the application task when both lanes are empty, or after BT_APP_LANE_AGING_US at the
+ *            latest. Work that is already waiting is not added again, false then
+ */
+bool bt_app_work_defer(bt_app_cb_t p_cback, uint16_t event);
 
 void bt_app_task_start_up(void);
 
 void bt_app_task_shut_down(void);
 
+void bt_app_core_get_pool_stats(bt_app_pool_stats_t *st);
+
+void bt_app_core_get_lane_stats(bt_app_lane_t lane, bt_app_lane_stats_t *st);
+
+/**
+ * @brief     histogram of the time messages of a lane waited to be served, the event is recorded as the frame number
+ */
+const audio_trace_t *bt_app_core_get_lane_wait(bt_app_lane_t lane);
+
+void bt_app_core_reset_lane_wait(void);
+
 #endif /* __BT_APP_CORE_H__ */
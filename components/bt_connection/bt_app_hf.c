@@ -37,13 +37,32 @@
 #include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/queue.h"
-#include "freertos/ringbuf.h"
-#include "freertos/semphr.h"
 #include "freertos/task.h"
-#include "osi/allocator.h"
 #include "time.h"
 
+#include "audio_aec.h"
+#include "audio_drift.h"
+#include "audio_dtmf.h"
+#include "audio_frame.h"
+#include "audio_gain.h"
+#include "audio_jbuf.h"
+#include "audio_mixer.h"
+#include "audio_ns.h"
+#include "audio_plc.h"
+#include "audio_ring.h"
+#include "audio_tone.h"
+#include "audio_trace.h"
+#include "bt_app_bridge.h"
+#include "bt_app_core.h"
 #include "bt_app_hf.h"
+#include "bt_app_ind.h"
+#include "bt_app_peer.h"
+#include "bt_app_pkt_stat.h"
+#include "bt_app_prompt.h"
+#include "bt_app_rec.h"
+#include "bt_app_relay.h"
+#include "hal_adc_audio.h"
+#include "hal_pwm_audio.h"
 
 static const char *TAG = "bt_app_hf";
 
@@ -126,194 +145,703 @@ const char *c_codec_mode_str[] = {
 };
 
 #if CONFIG_BT_HFP_AUDIO_DATA_PATH_HCI
-#define TABLE_SIZE      100
-#define TABLE_SIZE_BYTE 200
-// Produce a sine audio
-static const int16_t sine_int16[TABLE_SIZE] = {
-    0,      2057,   4107,   6140,   8149,   10126,  12062,  13952,  15786,  17557,  19260,  20886,  22431,  23886,  25247,  26509,  27666,
-    28714,  29648,  30466,  31163,  31738,  32187,  32509,  32702,  32767,  32702,  32509,  32187,  31738,  31163,  30466,  29648,  28714,
-    27666,  26509,  25247,  23886,  22431,  20886,  19260,  17557,  15786,  13952,  12062,  10126,  8149,   6140,   4107,   2057,   0,
-    -2057,  -4107,  -6140,  -8149,  -10126, -12062, -13952, -15786, -17557, -19260, -20886, -22431, -23886, -25247, -26509, -27666, -28714,
-    -29648, -30466, -31163, -31738, -32187, -32509, -32702, -32767, -32702, -32509, -32187, -31738, -31163, -30466, -29648, -28714, -27666,
-    -26509, -25247, -23886, -22431, -20886, -19260, -17557, -15786, -13952, -12062, -10126, -8149,  -6140,  -4107,  -2057,
-};
-
-#define ESP_HFP_RINGBUF_SIZE 3600
-
-// 7500 microseconds(=12 slots) is aligned to 1 msbc frame duration, and is multiple of common Tesco for eSCO link with EV3 or 2-EV3 packet type
-#define PCM_BLOCK_DURATION_US (7500)
-
-#define WBS_PCM_SAMPLING_RATE_KHZ (16)
-#define PCM_SAMPLING_RATE_KHZ     (8)
-
-#define BYTES_PER_SAMPLE (2)
-
-// input can refer to Enhanced Setup Synchronous Connection Command in core spec4.2 Vol2, Part E
-#define WBS_PCM_INPUT_DATA_SIZE (WBS_PCM_SAMPLING_RATE_KHZ * PCM_BLOCK_DURATION_US / 1000 * BYTES_PER_SAMPLE) // 240
-#define PCM_INPUT_DATA_SIZE     (PCM_SAMPLING_RATE_KHZ * PCM_BLOCK_DURATION_US / 1000 * BYTES_PER_SAMPLE)     // 120
+// the producer is woken by the outgoing callback below the low water mark and fills up to the high water mark,
+// which also bounds the outgoing latency to PCM_RING_HIGH_WATER frames
+#define PCM_RING_LOW_WATER  (2)
+#define PCM_RING_HIGH_WATER (4)
 
+// tick of a timer driven producer, reference for the wakeups avoided
 #define PCM_GENERATOR_TICK_US (4000)
 
+// the producer runs the whole incoming chain, jitter buffer to recorder, and the mixer with its sources. The deepest
+// call, the NS transform or a mixer source, takes about 0.5 KB on the host (-fstack-usage); twice that for the windowed
+// ABI, plus the FPU save area and the frame callback, leaves half of this free. The high water mark is logged at stop
+#define PCM_PRODUCER_STACK (4096)
+
 static long s_data_num = 0;
-static RingbufHandle_t s_m_rb = NULL;
+// outgoing frames are generated in place and read in place by the controller callback, no heap traffic on the audio path
+static audio_ring_t s_out_ring;
 static uint64_t s_time_new, s_time_old;
-static esp_timer_handle_t s_periodic_timer;
-static uint64_t s_last_enter_time, s_now_enter_time;
-static uint64_t s_us_duration;
-static SemaphoreHandle_t s_send_data_Semaphore = NULL;
+static uint64_t s_producer_start;
+static uint32_t s_producer_wakeups;
+static uint32_t s_producer_consumed;
 static TaskHandle_t s_bt_app_send_data_task_handler = NULL;
 static esp_hf_audio_state_t s_audio_code;
+static esp_bd_addr_t s_audio_owner; // peer whose audio has the local audio path
+static bool s_audio_owned = false;
+static audio_tone_t s_tone;
+static audio_tone_id_t s_tone_id = AUDIO_TONE_TEST;
+static int16_t s_tone_frame[WBS_PCM_FRAME_SAMPLES];
+// every outgoing frame is the mix of the enabled sources
+static audio_mixer_t s_mixer;
+static bool s_mixer_ready = false;
+#if BT_APP_HF_ADC_MIC_ENABLE
+static int s_adc_source = -1;
+#endif /* BT_APP_HF_ADC_MIC_ENABLE */
+// incoming frames are re-timed by the jitter buffer and pulled at the outgoing frame rate
+static audio_jbuf_t s_in_jbuf;
+static bt_app_hf_frame_cb_t s_incoming_frame_cb = NULL;
+static audio_plc_t s_in_plc;
+static int16_t s_plc_frame[WBS_PCM_FRAME_SAMPLES];
+#if BT_APP_HF_SOFT_AEC_ENABLE
+// the outgoing frames are the far-end reference for the incoming ones
+static audio_aec_t s_aec;
+#endif /* BT_APP_HF_SOFT_AEC_ENABLE */
+#if BT_APP_HF_SOFT_NS_ENABLE
+static audio_ns_t s_ns;
+static bool s_ns_running = false;
+#endif /* BT_APP_HF_SOFT_NS_ENABLE */
+#if BT_APP_HF_SOFT_VOLUME_ENABLE
+#define BT_APP_HF_MIC_CEILING 29204 // -1 dBFS
+static audio_gain_t s_out_gain;
+static audio_gain_t s_in_gain;
+#if BT_APP_HF_MIC_AGC_ENABLE
+static audio_agc_t s_in_agc;
+#endif /* BT_APP_HF_MIC_AGC_ENABLE */
+#endif /* BT_APP_HF_SOFT_VOLUME_ENABLE */
+#if BT_APP_HF_DTMF_ENABLE
+static audio_dtmf_gen_t s_dtmf_gen;
+static audio_dtmf_det_t s_dtmf_det;
+static bt_app_hf_dtmf_cb_t s_dtmf_cb = NULL;
+#endif /* BT_APP_HF_DTMF_ENABLE */
+#if BT_APP_HF_VAD_ENABLE
+static audio_vad_t s_vad_in;
+static audio_vad_t s_vad_out;
+// cost of the gated stages, the skipped frames are valued at the mean of the processed ones
+static uint32_t s_aec_runs, s_aec_skipped, s_ns_runs, s_ns_skipped;
+static uint64_t s_aec_us, s_ns_us;
+#endif /* BT_APP_HF_VAD_ENABLE */
+// volume steps by esp_hf_volume_control_target_t, unity until the HF reports its own
+static volatile uint8_t s_volume[2] = { 15, 15 };
+// echo cancellation and noise reduction requested by the HF, on until it sends AT+NREC=0
+static volatile bool s_nrec = true;
+// per stage latency of every frame, recorded lock free from the callbacks and the producer task
+static audio_trace_t s_lat[BT_APP_LAT_MAX];
+// a virtual producer paced by esp_timer against the frames the controller takes, the loop locks to the offset of the
+// esp_timer clock from the air clock; reported only, the PWM and ADC drivers trim their own clocks through audio_asrc
+static audio_drift_t s_air_drift;
+static uint32_t s_sample_rate;
+static int64_t s_local_last_us;
+static int64_t s_local_samples_e6; // samples of the virtual producer, 1e-6 units
 
 static void print_speed(void);
 
 static uint32_t bt_app_hf_outgoing_cb(uint8_t *p_buf, uint32_t sz) {
-    size_t item_size = 0;
-    uint8_t *data;
-    if (!s_m_rb) {
-        return 0;
-    }
-    vRingbufferGetInfo(s_m_rb, NULL, NULL, NULL, NULL, &item_size);
-    if (item_size >= sz) {
-        data = xRingbufferReceiveUpTo(s_m_rb, &item_size, 0, sz);
-        memcpy(p_buf, data, item_size);
-        vRingbufferReturnItem(s_m_rb, data);
-        return sz;
-    } else {
-        // data not enough, do not read\n
-        return 0;
+    // a frame is dequeued when the controller starts on it, copy its tag before the read releases the slot
+    bool start = (s_out_ring.rd_off == 0 && audio_ring_count(&s_out_ring) > 0);
+    audio_ring_tag_t tag = *audio_ring_read_tag(&s_out_ring);
+    uint32_t len = audio_ring_read_bytes(&s_out_ring, p_buf, sz);
+    if (len && start) {
+        uint32_t now = (uint32_t)esp_timer_get_time();
+        audio_trace_add(&s_lat[BT_APP_LAT_OUT_QUEUE], now - tag.enqueue_us, tag.seq);
+        audio_trace_add(&s_lat[BT_APP_LAT_OUT_TOTAL], now - tag.capture_us, tag.seq);
+    }
+    if (audio_ring_count(&s_out_ring) < PCM_RING_LOW_WATER && s_bt_app_send_data_task_handler) {
+        xTaskNotifyGive(s_bt_app_send_data_task_handler);
     }
-    return 0;
+    return len;
 }
 
 static void bt_app_hf_incoming_cb(const uint8_t *buf, uint32_t sz) {
     s_time_new = esp_timer_get_time();
     s_data_num += sz;
+    audio_jbuf_put(&s_in_jbuf, buf, sz, s_time_new);
     if ((s_time_new - s_time_old) >= 3000000) {
         print_speed();
     }
 }
 
+static const int16_t *bt_app_hf_tone_pull(void *ctx, uint32_t samples) {
+    audio_tone_fill(&s_tone, s_tone_frame, samples);
+    return s_tone_frame;
+}
+
+static const int16_t *bt_app_hf_prompt_pull(void *ctx, uint32_t samples) {
+    return bt_app_prompt_peek(samples, s_sample_rate);
+}
+
+static void bt_app_hf_prompt_release(void *ctx) {
+    bt_app_prompt_release();
+}
+
+#if BT_APP_HF_ADC_MIC_ENABLE
+static const int16_t *bt_app_hf_adc_pull(void *ctx, uint32_t samples) {
+    return hal_adc_audio_peek(samples);
+}
+
+static void bt_app_hf_adc_release(void *ctx) {
+    hal_adc_audio_release();
+}
+#endif /* BT_APP_HF_ADC_MIC_ENABLE */
+
+// built-in sources first, external ones may register before the first audio connection
+static audio_mixer_t *bt_app_hf_mixer(void) {
+    if (!s_mixer_ready) {
+        audio_mixer_init(&s_mixer);
+        int tone = audio_mixer_add(&s_mixer, bt_app_hf_tone_pull, NULL, NULL, BT_APP_HF_MIX_PRIO_TONE, AUDIO_MIXER_ONE, 0);
+        int prompt = audio_mixer_add(&s_mixer, bt_app_hf_prompt_pull, bt_app_hf_prompt_release, NULL, BT_APP_HF_MIX_PRIO_PROMPT, AUDIO_MIXER_ONE,
+                                     AUDIO_MIXER_ONE);
+        audio_mixer_enable(&s_mixer, tone, true);
+        audio_mixer_enable(&s_mixer, prompt, true);
+#if BT_APP_HF_ADC_MIC_ENABLE
+        // enabled while the microphone runs, prompts take it down 12 dB
+        s_adc_source = audio_mixer_add(&s_mixer, bt_app_hf_adc_pull, bt_app_hf_adc_release, NULL, BT_APP_HF_MIX_PRIO_STREAM, AUDIO_MIXER_ONE,
+                                       AUDIO_MIXER_ONE / 4);
+#endif /* BT_APP_HF_ADC_MIC_ENABLE */
+        s_mixer_ready = true;
+    }
+    return &s_mixer;
+}
+
 static uint32_t bt_app_hf_create_audio_data(uint8_t *p_buf, uint32_t sz) {
-    static int index = 0;
-    uint8_t *data = (uint8_t *)sine_int16;
+    // ring slots are 4 byte aligned and frames hold whole samples
+    audio_mixer_mix(&s_mixer, (int16_t *)p_buf, sz / BYTES_PER_SAMPLE);
+#if BT_APP_HF_DTMF_ENABLE
+    audio_dtmf_gen_fill(&s_dtmf_gen, (int16_t *)p_buf, sz / BYTES_PER_SAMPLE);
+#endif /* BT_APP_HF_DTMF_ENABLE */
+#if BT_APP_HF_SOFT_VOLUME_ENABLE
+    audio_gain_set(&s_out_gain, audio_gain_from_step(s_volume[ESP_HF_VOLUME_CONTROL_TARGET_SPK]));
+    audio_gain_process(&s_out_gain, (int16_t *)p_buf, sz / BYTES_PER_SAMPLE);
+#endif /* BT_APP_HF_SOFT_VOLUME_ENABLE */
+#if BT_APP_HF_VAD_ENABLE
+    audio_vad_process(&s_vad_out, (int16_t *)p_buf, sz / BYTES_PER_SAMPLE);
+#endif /* BT_APP_HF_VAD_ENABLE */
+    bt_app_rec_frame(BT_APP_REC_OUT, (int16_t *)p_buf, sz / BYTES_PER_SAMPLE, s_sample_rate);
+#if BT_APP_HF_SOFT_AEC_ENABLE
+    audio_aec_far(&s_aec, (int16_t *)p_buf, sz / BYTES_PER_SAMPLE);
+#endif /* BT_APP_HF_SOFT_AEC_ENABLE */
+    return sz;
+}
+
+#if BT_APP_HF_DTMF_ENABLE
+/* event for handler "bt_app_hf_dtmf_hdl" */
+enum {
+    BT_APP_HF_EVT_DTMF = 0,
+};
+
+static void bt_app_hf_dtmf_hdl(uint16_t event, void *param) {
+    char digit = *(char *)param;
+
+    ESP_LOGI(TAG, "--DTMF detected: %c", digit);
+    if (s_dtmf_cb) {
+        s_dtmf_cb(digit);
+    }
+}
+#endif /* BT_APP_HF_DTMF_ENABLE */
+
+static void bt_app_hf_pull_incoming(void) {
+    const uint32_t samples = s_in_jbuf.ring.frame_size / BYTES_PER_SAMPLE;
+    uint32_t now = (uint32_t)esp_timer_get_time();
+    int16_t *pcm = (int16_t *)audio_jbuf_get(&s_in_jbuf);
+    bool lost = (pcm == NULL);
+    audio_ring_tag_t tag = { 0 };
 
-    for (uint32_t i = 0; i < sz; i++) {
-        p_buf[i] = data[index++];
-        if (index >= TABLE_SIZE_BYTE) {
-            index -= TABLE_SIZE_BYTE;
+    if (!lost) {
+        tag = *audio_jbuf_tag(&s_in_jbuf);
+        audio_trace_add(&s_lat[BT_APP_LAT_IN_RX], tag.enqueue_us - tag.capture_us, tag.seq);
+        audio_trace_add(&s_lat[BT_APP_LAT_IN_QUEUE], now - tag.enqueue_us, tag.seq);
+    }
+    // a concealed frame keeps the decision of the last received one
+    bool talk = true;
+#if BT_APP_HF_VAD_ENABLE
+    talk = lost ? s_vad_in.active : audio_vad_process(&s_vad_in, pcm, samples);
+#endif /* BT_APP_HF_VAD_ENABLE */
+#if BT_APP_HF_SOFT_AEC_ENABLE
+    if (!lost && s_nrec) {
+#if BT_APP_HF_VAD_ENABLE
+        // without far-end speech there is no echo, without near-end activity the frame becomes comfort noise
+        if (!talk || !s_vad_out.active) {
+            s_aec_skipped++;
+        } else
+#endif /* BT_APP_HF_VAD_ENABLE */
+        {
+            // incoming frame n shares its air slot with outgoing frame n, shifted by each slot the out ring missed
+            uint32_t far_pos = (tag.seq - s_out_ring.stats.underruns) * samples - BT_APP_HF_AEC_DELAY_MS * s_sample_rate / 1000;
+            uint32_t aec_start = (uint32_t)esp_timer_get_time();
+            audio_aec_process(&s_aec, pcm, samples, far_pos);
+            uint32_t aec_us = (uint32_t)esp_timer_get_time() - aec_start;
+            audio_trace_add(&s_lat[BT_APP_LAT_IN_AEC], aec_us, tag.seq);
+#if BT_APP_HF_VAD_ENABLE
+            s_aec_runs++;
+            s_aec_us += aec_us;
+#endif /* BT_APP_HF_VAD_ENABLE */
         }
     }
-    return sz;
+#endif /* BT_APP_HF_SOFT_AEC_ENABLE */
+
+    // a frame missing at its play out time is concealed from the history
+    if (lost) {
+        pcm = s_plc_frame;
+    }
+    audio_plc_process(&s_in_plc, pcm, lost);
+#if BT_APP_HF_DTMF_ENABLE
+    // ahead of the noise suppressor and the AGC, the echo of our own tones is already cancelled
+    char digit = audio_dtmf_det_process(&s_dtmf_det, pcm, samples);
+    if (digit) {
+        bt_app_work_dispatch(bt_app_hf_dtmf_hdl, BT_APP_HF_EVT_DTMF, &digit, sizeof(digit), NULL, BT_APP_LANE_NORMAL);
+    }
+#endif /* BT_APP_HF_DTMF_ENABLE */
+#if BT_APP_HF_SOFT_NS_ENABLE
+    // after concealment, the overlap-add needs every frame; restarted clean when the HF turns it back on
+    if (s_nrec) {
+        uint32_t ns_start = (uint32_t)esp_timer_get_time();
+        if (!s_ns_running) {
+            audio_ns_init(&s_ns, s_sample_rate);
+            s_ns_running = true;
+        }
+        if (talk) {
+            audio_ns_process(&s_ns, pcm);
+            uint32_t ns_us = (uint32_t)esp_timer_get_time() - ns_start;
+            audio_trace_add(&s_lat[BT_APP_LAT_IN_NS], ns_us, tag.seq);
+#if BT_APP_HF_VAD_ENABLE
+            s_ns_runs++;
+            s_ns_us += ns_us;
+        } else {
+            // the end of the last frame of speech is still in the overlap, it goes out instead of comfort noise
+            if (audio_ns_skip(&s_ns, pcm)) {
+                talk = true;
+            }
+            s_ns_skipped++;
+#endif /* BT_APP_HF_VAD_ENABLE */
+        }
+    } else {
+        s_ns_running = false;
+    }
+#endif /* BT_APP_HF_SOFT_NS_ENABLE */
+    if (talk) {
+#if BT_APP_HF_SOFT_VOLUME_ENABLE
+        int32_t mic_gain = audio_gain_from_step(s_volume[ESP_HF_VOLUME_CONTROL_TARGET_MIC]);
+#if BT_APP_HF_MIC_AGC_ENABLE
+        // the AGC measures the frame before any gain, so its level is independent of the volume step
+        mic_gain = (mic_gain * audio_agc_process(&s_in_agc, pcm, samples)) >> 12;
+#endif /* BT_APP_HF_MIC_AGC_ENABLE */
+        audio_gain_set(&s_in_gain, mic_gain);
+        audio_gain_process(&s_in_gain, pcm, samples);
+#endif /* BT_APP_HF_SOFT_VOLUME_ENABLE */
+    } else {
+#if BT_APP_HF_VAD_ENABLE
+        // comfort noise at the level the processed silence would have had
+        int32_t cng_q15 = 32767;
+#if BT_APP_HF_SOFT_NS_ENABLE
+        if (s_nrec) {
+            cng_q15 = (int32_t)(s_ns.floor * cng_q15);
+        }
+#endif /* BT_APP_HF_SOFT_NS_ENABLE */
+#if BT_APP_HF_SOFT_VOLUME_ENABLE
+        cng_q15 = (int32_t)(((int64_t)cng_q15 * s_in_gain.cur) >> 12);
+#endif /* BT_APP_HF_SOFT_VOLUME_ENABLE */
+        audio_vad_cng(&s_vad_in, pcm, samples, cng_q15);
+#endif /* BT_APP_HF_VAD_ENABLE */
+    }
+    bt_app_rec_frame(BT_APP_REC_IN, pcm, samples, s_sample_rate);
+    if (s_incoming_frame_cb) {
+        s_incoming_frame_cb(pcm, samples);
+    }
+#if BT_APP_HF_PWM_OUT_ENABLE
+    hal_pwm_audio_write(pcm, samples);
+#endif /* BT_APP_HF_PWM_OUT_ENABLE */
+    if (!lost) {
+        audio_trace_add(&s_lat[BT_APP_LAT_IN_TOTAL], (uint32_t)esp_timer_get_time() - tag.capture_us, tag.seq);
+        audio_jbuf_release(&s_in_jbuf);
+    }
+}
+
+static void bt_app_hf_track_air_clock(int64_t now_us) {
+    const int64_t consumed = (int64_t)s_producer_consumed * (s_out_ring.frame_size / BYTES_PER_SAMPLE);
+
+    // start at the first frame taken, so the loop does not have to pull in the setup time
+    if (s_local_last_us == 0) {
+        s_local_last_us = now_us;
+        s_local_samples_e6 = consumed * 1000000;
+    }
+    // the trim is taken off the elapsed samples rather than multiplied into them, which would overflow after 0.5 s of
+    // stalled link at 16 kHz
+    const int64_t elapsed_e6 = (now_us - s_local_last_us) * s_sample_rate;
+    s_local_samples_e6 += elapsed_e6 - elapsed_e6 / 1000 * s_air_drift.ppb / 1000000;
+    s_local_last_us = now_us;
+    audio_drift_update(&s_air_drift, (int32_t)(s_local_samples_e6 / 1000000 - consumed));
 }
 
 static void print_speed(void) {
+    audio_jbuf_stats_t jb;
     float tick_s = (s_time_new - s_time_old) / 1000000.0;
     float speed = s_data_num * 8 / tick_s / 1000.0;
     ESP_LOGI(TAG, "speed(%fs ~ %fs): %f kbit/s", s_time_old / 1000000.0, s_time_new / 1000000.0, speed);
+    audio_jbuf_get_stats(&s_in_jbuf, &jb);
+    ESP_LOGI(TAG, "jbuf: depth %" PRIu32 "/%" PRIu32 ", jitter %" PRIu32 " us, underruns %" PRIu32 ", overruns %" PRIu32 ", drops %" PRIu32, jb.depth,
+             jb.target, jb.jitter_us, jb.underruns, jb.overruns, jb.drops);
+    ESP_LOGI(TAG, "plc: concealed %" PRIu32 ", recovered %" PRIu32, s_in_plc.concealed, s_in_plc.recovered);
+#if BT_APP_HF_SOFT_AEC_ENABLE
+    ESP_LOGI(TAG, "aec: erle %.1f dB, frames %" PRIu32 ", double talk %" PRIu32 ", skipped %" PRIu32, s_aec.stats.erle_db, s_aec.stats.frames,
+             s_aec.stats.double_talk, s_aec.stats.skipped);
+#endif /* BT_APP_HF_SOFT_AEC_ENABLE */
+#if BT_APP_HF_SOFT_NS_ENABLE
+    if (s_ns_running) {
+        ESP_LOGI(TAG, "ns: noise %.1f dBFS, attenuation %.1f dB", s_ns.stats.noise_db, s_ns.stats.atten_db);
+    }
+#endif /* BT_APP_HF_SOFT_NS_ENABLE */
+    ESP_LOGI(TAG, "mixer: %" PRIu32 " sources, frames %" PRIu32 ", empty %" PRIu32, s_mixer.count, s_mixer.frames, s_mixer.empty);
+#if BT_APP_HF_DTMF_ENABLE
+    ESP_LOGI(TAG, "dtmf: played %" PRIu32 ", dropped %" PRIu32 ", detected %" PRIu32 ", rejected blocks %" PRIu32, s_dtmf_gen.played, s_dtmf_gen.dropped,
+             s_dtmf_det.stats.digits, s_dtmf_det.stats.rejected);
+#endif /* BT_APP_HF_DTMF_ENABLE */
+#if BT_APP_HF_SOFT_VOLUME_ENABLE
+#if BT_APP_HF_MIC_AGC_ENABLE
+    ESP_LOGI(TAG, "gain: spk step %u, mic step %u, agc %+.1f dB, limited %" PRIu32, s_volume[ESP_HF_VOLUME_CONTROL_TARGET_SPK],
+             s_volume[ESP_HF_VOLUME_CONTROL_TARGET_MIC], s_in_agc.gain_db, s_in_gain.limited);
+#else
+    ESP_LOGI(TAG, "gain: spk step %u, mic step %u, limited %" PRIu32, s_volume[ESP_HF_VOLUME_CONTROL_TARGET_SPK], s_volume[ESP_HF_VOLUME_CONTROL_TARGET_MIC],
+             s_in_gain.limited);
+#endif /* BT_APP_HF_MIC_AGC_ENABLE */
+#endif /* BT_APP_HF_SOFT_VOLUME_ENABLE */
+    uint32_t ticks = (s_time_new - s_producer_start) / PCM_GENERATOR_TICK_US;
+    ESP_LOGI(TAG, "producer: wakeups %" PRIu32 ", avoided %" PRIu32, s_producer_wakeups, (ticks > s_producer_wakeups) ? ticks - s_producer_wakeups : 0);
+    ESP_LOGI(TAG, "clock: local %+.1f ppm vs air, fill error %" PRId32 "..%" PRId32 " samples", s_air_drift.ppb / 1000.0f, s_air_drift.err_min,
+             s_air_drift.err_max);
     s_data_num = 0;
     s_time_old = s_time_new;
 }
 
-static void bt_app_send_data_timer_cb(void *arg) {
-    if (!xSemaphoreGive(s_send_data_Semaphore)) {
-        ESP_LOGE(TAG, "%s xSemaphoreGive failed", __func__);
-        return;
-    }
-    return;
-}
-
 static void bt_app_send_data_task(void *arg) {
-    uint64_t frame_data_num;
-    size_t item_size = 0;
-    uint8_t *buf = NULL;
+    uint8_t *frame;
+    audio_ring_tag_t *tag;
+    uint32_t consumed;
+    int64_t now_us;
     for (;;) {
-        if (xSemaphoreTake(s_send_data_Semaphore, (TickType_t)portMAX_DELAY)) {
-            s_now_enter_time = esp_timer_get_time();
-            s_us_duration = s_now_enter_time - s_last_enter_time;
-            if (s_audio_code == ESP_HF_AUDIO_STATE_CONNECTED_MSBC) {
-                // time of a frame is 7.5ms, sample is 120, data is 2 (byte/sample), so a frame is 240 byte (HF_SBC_ENC_RAW_DATA_SIZE)
-                frame_data_num = s_us_duration / PCM_BLOCK_DURATION_US * WBS_PCM_INPUT_DATA_SIZE;
-                s_last_enter_time += frame_data_num / WBS_PCM_INPUT_DATA_SIZE * PCM_BLOCK_DURATION_US;
-            } else {
-                frame_data_num = s_us_duration / PCM_BLOCK_DURATION_US * PCM_INPUT_DATA_SIZE;
-                s_last_enter_time += frame_data_num / PCM_INPUT_DATA_SIZE * PCM_BLOCK_DURATION_US;
-            }
-            if (frame_data_num == 0) {
-                continue;
-            }
-            buf = osi_malloc(frame_data_num);
-            if (!buf) {
-                ESP_LOGE(TAG, "%s, no mem", __FUNCTION__);
-                continue;
-            }
-            bt_app_hf_create_audio_data(buf, frame_data_num);
-            BaseType_t done = xRingbufferSend(s_m_rb, buf, frame_data_num, 0);
-            if (!done) {
-                ESP_LOGE(TAG, "rb send fail");
-            }
-            osi_free(buf);
-            vRingbufferGetInfo(s_m_rb, NULL, NULL, NULL, NULL, &item_size);
+        ulTaskNotifyTake(pdTRUE, (TickType_t)portMAX_DELAY);
+        s_producer_wakeups++;
+        now_us = esp_timer_get_time();
 
-            if (s_audio_code == ESP_HF_AUDIO_STATE_CONNECTED_MSBC) {
-                if (item_size >= WBS_PCM_INPUT_DATA_SIZE) {
-                    esp_hf_ag_outgoing_data_ready();
-                }
-            } else {
-                if (item_size >= PCM_INPUT_DATA_SIZE) {
-                    esp_hf_ag_outgoing_data_ready();
-                }
+        // pull one incoming frame per outgoing frame the controller took, both legs run on the air clock
+        consumed = s_out_ring.stats.consumed;
+        while (s_producer_consumed != consumed) {
+            bt_app_hf_pull_incoming();
+            s_producer_consumed++;
+            bt_app_hf_track_air_clock(now_us);
+        }
+
+        while (audio_ring_count(&s_out_ring) < PCM_RING_HIGH_WATER) {
+            frame = audio_ring_write_begin(&s_out_ring);
+            if (!frame) {
+                break;
             }
+            tag = audio_ring_write_tag(&s_out_ring);
+            tag->seq = s_out_ring.stats.produced;
+            tag->capture_us = (uint32_t)esp_timer_get_time();
+            bt_app_hf_create_audio_data(frame, s_out_ring.frame_size);
+            tag->enqueue_us = (uint32_t)esp_timer_get_time();
+            audio_trace_add(&s_lat[BT_APP_LAT_OUT_GEN], tag->enqueue_us - tag->capture_us, s_out_ring.stats.produced);
+            audio_ring_write_commit(&s_out_ring);
         }
+        esp_hf_ag_outgoing_data_ready();
     }
 }
+
 void bt_app_send_data(void) {
-    s_send_data_Semaphore = xSemaphoreCreateBinary();
-    xTaskCreate(bt_app_send_data_task, "BtAppSendDataTask", 2048, NULL, configMAX_PRIORITIES - 3, &s_bt_app_send_data_task_handler);
-    s_m_rb = xRingbufferCreate(ESP_HFP_RINGBUF_SIZE, RINGBUF_TYPE_BYTEBUF);
-    const esp_timer_create_args_t c_periodic_timer_args = { .callback = &bt_app_send_data_timer_cb, .name = "periodic" };
-    ESP_ERROR_CHECK(esp_timer_create(&c_periodic_timer_args, &s_periodic_timer));
-    ESP_ERROR_CHECK(esp_timer_start_periodic(s_periodic_timer, PCM_GENERATOR_TICK_US));
-    s_last_enter_time = esp_timer_get_time();
+    bool wbs = (s_audio_code == ESP_HF_AUDIO_STATE_CONNECTED_MSBC);
+    s_sample_rate = wbs ? WBS_PCM_SAMPLING_RATE_KHZ * 1000 : PCM_SAMPLING_RATE_KHZ * 1000;
+    audio_tone_init(&s_tone, audio_tone_preset(s_tone_id), s_sample_rate);
+    bt_app_hf_mixer();
+    audio_ring_init(&s_out_ring, wbs ? WBS_PCM_INPUT_DATA_SIZE : PCM_INPUT_DATA_SIZE);
+    audio_jbuf_init(&s_in_jbuf, wbs ? WBS_PCM_INPUT_DATA_SIZE : PCM_INPUT_DATA_SIZE);
+    audio_plc_init(&s_in_plc, s_sample_rate);
+#if BT_APP_HF_SOFT_AEC_ENABLE
+    audio_aec_init(&s_aec, s_sample_rate);
+#endif /* BT_APP_HF_SOFT_AEC_ENABLE */
+#if BT_APP_HF_SOFT_NS_ENABLE
+    s_ns_running = false;
+#endif /* BT_APP_HF_SOFT_NS_ENABLE */
+#if BT_APP_HF_VAD_ENABLE
+    audio_vad_init(&s_vad_in, s_sample_rate, s_in_jbuf.ring.frame_size / BYTES_PER_SAMPLE);
+    audio_vad_init(&s_vad_out, s_sample_rate, s_out_ring.frame_size / BYTES_PER_SAMPLE);
+    s_aec_runs = s_aec_skipped = s_ns_runs = s_ns_skipped = 0;
+    s_aec_us = s_ns_us = 0;
+#endif /* BT_APP_HF_VAD_ENABLE */
+#if BT_APP_HF_DTMF_ENABLE
+    audio_dtmf_gen_init(&s_dtmf_gen, s_sample_rate);
+    audio_dtmf_det_init(&s_dtmf_det, s_sample_rate);
+#endif /* BT_APP_HF_DTMF_ENABLE */
+#if BT_APP_HF_SOFT_VOLUME_ENABLE
+    audio_gain_init(&s_out_gain, s_sample_rate, audio_gain_from_step(s_volume[ESP_HF_VOLUME_CONTROL_TARGET_SPK]));
+    audio_gain_init(&s_in_gain, s_sample_rate, audio_gain_from_step(s_volume[ESP_HF_VOLUME_CONTROL_TARGET_MIC]));
+    audio_gain_set_ceiling(&s_in_gain, BT_APP_HF_MIC_CEILING);
+#if BT_APP_HF_MIC_AGC_ENABLE
+    audio_agc_init(&s_in_agc, s_sample_rate, s_in_jbuf.ring.frame_size / BYTES_PER_SAMPLE);
+#endif /* BT_APP_HF_MIC_AGC_ENABLE */
+#endif /* BT_APP_HF_SOFT_VOLUME_ENABLE */
+    audio_drift_init(&s_air_drift, s_sample_rate, s_out_ring.frame_size / BYTES_PER_SAMPLE, 0);
+    s_local_last_us = 0;
+    bt_app_hf_reset_latency();
+    s_producer_start = esp_timer_get_time();
+    s_producer_wakeups = 0;
+    s_producer_consumed = 0;
+#if BT_APP_HF_PWM_OUT_ENABLE
+    hal_pwm_audio_config_t pwm_cfg = {
+        .port = BT_APP_HF_PWM_OUT_PORT,
+        .pin = BT_APP_HF_PWM_OUT_PIN,
+        .task_prio = configMAX_PRIORITIES - 3,
+    };
+    hal_pwm_audio_start(&pwm_cfg, s_sample_rate);
+#endif /* BT_APP_HF_PWM_OUT_ENABLE */
+#if BT_APP_HF_ADC_MIC_ENABLE
+    hal_adc_audio_config_t adc_cfg = {
+        .channel = BT_APP_HF_ADC_MIC_CHANNEL,
+        .task_prio = configMAX_PRIORITIES - 3,
+    };
+    audio_mixer_enable(&s_mixer, s_adc_source, hal_adc_audio_start(&adc_cfg, s_sample_rate));
+#endif /* BT_APP_HF_ADC_MIC_ENABLE */
+    xTaskCreate(bt_app_send_data_task, "BtAppSendDataTask", PCM_PRODUCER_STACK, NULL, configMAX_PRIORITIES - 3, &s_bt_app_send_data_task_handler);
+    // first fill, later ones are requested by the outgoing callback
+    xTaskNotifyGive(s_bt_app_send_data_task_handler);
     return;
 }
 
 void bt_app_send_data_shut_down(void) {
     if (s_bt_app_send_data_task_handler) {
+        ESP_LOGI(TAG, "producer: stack %u of %u bytes never used", (unsigned)uxTaskGetStackHighWaterMark(s_bt_app_send_data_task_handler),
+                 (unsigned)PCM_PRODUCER_STACK);
         vTaskDelete(s_bt_app_send_data_task_handler);
         s_bt_app_send_data_task_handler = NULL;
     }
-    if (s_periodic_timer) {
-        ESP_ERROR_CHECK(esp_timer_stop(s_periodic_timer));
-        ESP_ERROR_CHECK(esp_timer_delete(s_periodic_timer));
+#if BT_APP_HF_PWM_OUT_ENABLE
+    hal_pwm_audio_stop();
+#endif /* BT_APP_HF_PWM_OUT_ENABLE */
+#if BT_APP_HF_ADC_MIC_ENABLE
+    audio_mixer_enable(&s_mixer, s_adc_source, false);
+    hal_adc_audio_stop();
+#endif /* BT_APP_HF_ADC_MIC_ENABLE */
+    ESP_LOGI(TAG, "out ring: produced %" PRIu32 ", consumed %" PRIu32 ", overruns %" PRIu32 ", underruns %" PRIu32, s_out_ring.stats.produced,
+             s_out_ring.stats.consumed, s_out_ring.stats.overruns, s_out_ring.stats.underruns);
+    ESP_LOGI(TAG, "producer: wakeups %" PRIu32 " in %" PRIu64 " us", s_producer_wakeups, esp_timer_get_time() - s_producer_start);
+    audio_ring_init(&s_out_ring, 0);
+    audio_jbuf_init(&s_in_jbuf, 0);
+    s_sample_rate = 0;
+    return;
+}
+
+void bt_app_hf_register_incoming_frame_cb(bt_app_hf_frame_cb_t cb) {
+    s_incoming_frame_cb = cb;
+}
+
+void bt_app_hf_register_dtmf_cb(bt_app_hf_dtmf_cb_t cb) {
+#if BT_APP_HF_DTMF_ENABLE
+    s_dtmf_cb = cb;
+#endif /* BT_APP_HF_DTMF_ENABLE */
+}
+
+bool bt_app_hf_send_dtmf(const char *digits) {
+#if BT_APP_HF_DTMF_ENABLE
+    bool ok = true;
+
+    // the generator is reset with every audio connection, digits only queue while one is up
+    if (s_sample_rate == 0) {
+        return false;
+    }
+    for (; *digits; digits++) {
+        ok = audio_dtmf_gen_push(&s_dtmf_gen, *digits) && ok;
+    }
+    return ok;
+#else
+    return false;
+#endif /* BT_APP_HF_DTMF_ENABLE */
+}
+
+int bt_app_hf_add_source(audio_mixer_pull_t pull, audio_mixer_release_t release, void *ctx, uint8_t priority, int32_t gain, int32_t duck) {
+    return audio_mixer_add(bt_app_hf_mixer(), pull, release, ctx, priority, gain, duck);
+}
+
+void bt_app_hf_enable_source(int id, bool enable) {
+    audio_mixer_enable(bt_app_hf_mixer(), id, enable);
+}
+
+void bt_app_hf_set_source_gain(int id, int32_t gain) {
+    audio_mixer_set_gain(bt_app_hf_mixer(), id, gain);
+}
+
+void bt_app_hf_get_vad_stats(bt_app_hf_vad_stats_t *st) {
+    memset(st, 0, sizeof(bt_app_hf_vad_stats_t));
+#if BT_APP_HF_VAD_ENABLE
+    st->in = s_vad_in.stats;
+    st->out = s_vad_out.stats;
+    st->aec_skipped = s_aec_skipped;
+    st->ns_skipped = s_ns_skipped;
+    st->spent_us = s_aec_us + s_ns_us;
+    st->saved_us = (s_aec_runs ? s_aec_us * s_aec_skipped / s_aec_runs : 0) + (s_ns_runs ? s_ns_us * s_ns_skipped / s_ns_runs : 0);
+#endif /* BT_APP_HF_VAD_ENABLE */
+}
+
+uint32_t bt_app_hf_get_sample_rate(void) {
+    return s_sample_rate;
+}
+
+void bt_app_hf_set_volume(int target, int volume) {
+    if ((target != ESP_HF_VOLUME_CONTROL_TARGET_SPK && target != ESP_HF_VOLUME_CONTROL_TARGET_MIC) || volume < 0 || volume > 15) {
+        return;
     }
-    if (s_send_data_Semaphore) {
-        vSemaphoreDelete(s_send_data_Semaphore);
-        s_send_data_Semaphore = NULL;
+    // picked up by the audio path on its next frame, the gain ramps there
+    s_volume[target] = (uint8_t)volume;
+}
+
+void bt_app_hf_set_nrec(bool enable) {
+    s_nrec = enable;
+}
+
+const audio_trace_t *bt_app_hf_get_latency(bt_app_lat_stage_t stage) {
+    return (stage < BT_APP_LAT_MAX) ? &s_lat[stage] : NULL;
+}
+
+void bt_app_hf_reset_latency(void) {
+    for (int i = 0; i < BT_APP_LAT_MAX; i++) {
+        audio_trace_reset(&s_lat[i]);
     }
-    if (s_m_rb) {
-        vRingbufferDelete(s_m_rb);
+}
+
+bool bt_app_hf_set_tone(int tone_id) {
+    if (tone_id < 0 || tone_id >= AUDIO_TONE_MAX) {
+        return false;
     }
-    return;
+    // takes effect on the next audio connection
+    s_tone_id = tone_id;
+    return true;
 }
 #endif /* #if CONFIG_BT_HFP_AUDIO_DATA_PATH_HCI */
 
-void bt_app_hf_cb(esp_hf_cb_event_t event, esp_hf_cb_param_t *param) {
-    if (event <= ESP_HF_PROF_STATE_EVT) {
+// peer an event comes from, added on its first connection event, NULL for events without a peer or when the table is full
+static bt_app_peer_t *bt_app_hf_event_peer(esp_hf_cb_event_t event, esp_hf_cb_param_t *param) {
+    if (event == ESP_HF_PKT_STAT_NUMS_GET_EVT || event == ESP_HF_PROF_STATE_EVT) {
+        return NULL;
+    }
+    // every other member of the parameter union starts with the peer address
+    if (event == ESP_HF_CONNECTION_STATE_EVT && param->conn_stat.state != ESP_HF_CONNECTION_STATE_DISCONNECTED) {
+        bt_app_peer_t *peer = bt_app_peer_add(param->conn_stat.remote_bda);
+        if (!peer) {
+            ESP_LOGW(TAG, "--peer table full, %d peers", BT_APP_PEER_MAX);
+        }
+        return peer;
+    }
+    return bt_app_peer_get(param->conn_stat.remote_bda);
+}
+
+// indicator to a peer, coalesced with the ones pending for it when it has an entry
+static void bt_app_hf_ciev_report(bt_app_peer_t *peer, esp_bd_addr_t bda, esp_hf_ciev_report_type_t type, int value) {
+    if (peer) {
+        bt_app_ind_set(peer, type, value);
+    } else {
+        esp_hf_ag_ciev_report(bda, type, value);
+    }
+}
+
+// the strings of an event belong to the BTC task and are gone once the callback returns
+static void bt_app_hf_copy_param(bt_app_msg_t *msg, void *p_dest, void *p_src) {
+    esp_hf_cb_param_t *dst = p_dest;
+    esp_hf_cb_param_t *src = p_src;
+
+    switch (msg->event) {
+        case ESP_HF_UNAT_RESPONSE_EVT:
+            dst->unat_rep.unat = bt_app_msg_strdup(msg, src->unat_rep.unat);
+            break;
+        case ESP_HF_VTS_RESPONSE_EVT:
+            dst->vts_rep.code = bt_app_msg_strdup(msg, src->vts_rep.code);
+            break;
+        case ESP_HF_DIAL_EVT:
+            dst->out_call.num_or_loc = bt_app_msg_strdup(msg, src->out_call.num_or_loc);
+            break;
+        default:
+            break;
+    }
+}
+
+#if BT_APP_BRIDGE_ENABLE || CONFIG_BT_HFP_AUDIO_DATA_PATH_HCI
+// the local audio path, bridge or HCI, carries one connection: the peer whose audio came up first owns it until that
+// audio goes down. Audio of another peer is refused, and its state changes leave the path alone
+static bool bt_app_hf_audio_owner(uint8_t *bda, esp_hf_audio_state_t state) {
+    const bool mine = s_audio_owned && memcmp(s_audio_owner, bda, ESP_BD_ADDR_LEN) == 0;
+
+    if (state == ESP_HF_AUDIO_STATE_CONNECTED || state == ESP_HF_AUDIO_STATE_CONNECTED_MSBC) {
+        if (s_audio_owned && !mine) {
+            ESP_LOGW(TAG, "--audio path in use by another peer, audio refused");
+            esp_hf_ag_audio_disconnect(bda);
+            return false;
+        }
+        memcpy(s_audio_owner, bda, ESP_BD_ADDR_LEN);
+        s_audio_owned = true;
+        return true;
+    }
+    if (state == ESP_HF_AUDIO_STATE_DISCONNECTED && mine) {
+        s_audio_owned = false;
+        return true;
+    }
+    return false;
+}
+#endif /* BT_APP_BRIDGE_ENABLE || CONFIG_BT_HFP_AUDIO_DATA_PATH_HCI */
+
+static void bt_app_hf_hdl(uint16_t event, void *p_param) {
+    esp_hf_cb_param_t *param = p_param;
+    bt_app_peer_t *peer = bt_app_hf_event_peer(event, param);
+    if (peer) {
+        peer->events++;
+    }
+
+    if (event == ESP_HF_PKT_STAT_NUMS_GET_EVT) {
+        // answers the packet statistics sampler every second, logged at debug level below
+    } else if (event <= ESP_HF_PROF_STATE_EVT) {
         ESP_LOGI(TAG, "APP HFP event: %s", c_hf_evt_str[event]);
     } else {
         ESP_LOGE(TAG, "APP HFP invalid event %d", event);
     }
 
+#if BT_APP_RELAY_ENABLE
+    // with a phone connected, call control and audio of the headsets go through it
+    if (bt_app_relay_ag_event(event, param, peer)) {
+        return;
+    }
+#endif /* BT_APP_RELAY_ENABLE */
+
     switch (event) {
         case ESP_HF_CONNECTION_STATE_EVT: {
             ESP_LOGI(TAG, "--connection state %s, peer feats 0x%" PRIx32 ", chld_feats 0x%" PRIx32, c_connection_state_str[param->conn_stat.state],
                      param->conn_stat.peer_feat, param->conn_stat.chld_feat);
-            memcpy(hf_peer_addr, param->conn_stat.remote_bda, ESP_BD_ADDR_LEN);
+            if (param->conn_stat.state == ESP_HF_CONNECTION_STATE_DISCONNECTED) {
+                if (peer) {
+                    bt_app_ind_drop(peer);
+                }
+                bt_app_peer_remove(param->conn_stat.remote_bda);
+            } else if (peer) {
+                peer->conn = param->conn_stat.state;
+                peer->peer_feat = param->conn_stat.peer_feat;
+                peer->chld_feat = param->conn_stat.chld_feat;
+                // every service level connection starts with echo cancellation and noise reduction on
+                if (param->conn_stat.state == ESP_HF_CONNECTION_STATE_SLC_CONNECTED) {
+                    peer->nrec = true;
+                }
+            }
             break;
         }
 
         case ESP_HF_AUDIO_STATE_EVT: {
             ESP_LOGI(TAG, "--Audio State %s", c_audio_state_str[param->audio_stat.state]);
+            if (peer) {
+                peer->audio = param->audio_stat.state;
+                peer->sync_conn_handle = param->audio_stat.sync_conn_handle;
+            }
+            if (param->audio_stat.state == ESP_HF_AUDIO_STATE_CONNECTED || param->audio_stat.state == ESP_HF_AUDIO_STATE_CONNECTED_MSBC) {
+                bt_app_pkt_stat_start(param->audio_stat.remote_addr, param->audio_stat.sync_conn_handle);
+            } else if (param->audio_stat.state == ESP_HF_AUDIO_STATE_DISCONNECTED) {
+                bt_app_pkt_stat_stop(param->audio_stat.remote_addr);
+            }
+#if BT_APP_BRIDGE_ENABLE || CONFIG_BT_HFP_AUDIO_DATA_PATH_HCI
+            if (!bt_app_hf_audio_owner(param->audio_stat.remote_addr, param->audio_stat.state)) {
+                break;
+            }
+#endif /* BT_APP_BRIDGE_ENABLE || CONFIG_BT_HFP_AUDIO_DATA_PATH_HCI */
+#if BT_APP_BRIDGE_ENABLE
+            if (param->audio_stat.state == ESP_HF_AUDIO_STATE_CONNECTED || param->audio_stat.state == ESP_HF_AUDIO_STATE_CONNECTED_MSBC) {
+                bool wbs = (param->audio_stat.state == ESP_HF_AUDIO_STATE_CONNECTED_MSBC);
+                bt_app_bridge_start(wbs ? WBS_PCM_SAMPLING_RATE_KHZ * 1000 : PCM_SAMPLING_RATE_KHZ * 1000);
+            } else if (param->audio_stat.state == ESP_HF_AUDIO_STATE_DISCONNECTED) {
+                bt_app_bridge_stop();
+            }
+#endif /* BT_APP_BRIDGE_ENABLE */
 #if CONFIG_BT_HFP_AUDIO_DATA_PATH_HCI
             if (param->audio_stat.state == ESP_HF_AUDIO_STATE_CONNECTED || param->audio_stat.state == ESP_HF_AUDIO_STATE_CONNECTED_MSBC) {
                 if (param->audio_stat.state == ESP_HF_AUDIO_STATE_CONNECTED) {
@@ -322,9 +850,15 @@ void bt_app_hf_cb(esp_hf_cb_event_t event, esp_hf_cb_param_t *param) {
                     s_audio_code = ESP_HF_AUDIO_STATE_CONNECTED_MSBC;
                 }
                 s_time_old = esp_timer_get_time();
-                esp_hf_ag_register_data_callback(bt_app_hf_incoming_cb, bt_app_hf_outgoing_cb);
-                /* Begin send esco data task */
+                // the audio path carries one connection, it takes the settings of the peer it belongs to
+                if (peer) {
+                    bt_app_hf_set_volume(ESP_HF_VOLUME_CONTROL_TARGET_SPK, peer->volume[ESP_HF_VOLUME_CONTROL_TARGET_SPK]);
+                    bt_app_hf_set_volume(ESP_HF_VOLUME_CONTROL_TARGET_MIC, peer->volume[ESP_HF_VOLUME_CONTROL_TARGET_MIC]);
+                    bt_app_hf_set_nrec(peer->nrec);
+                }
+                /* Begin send esco data task, buffers must be ready before the data callbacks run */
                 bt_app_send_data();
+                esp_hf_ag_register_data_callback(bt_app_hf_incoming_cb, bt_app_hf_outgoing_cb);
             } else if (param->audio_stat.state == ESP_HF_AUDIO_STATE_DISCONNECTED) {
                 ESP_LOGI(TAG, "--ESP AG Audio Connection Disconnected.");
                 bt_app_send_data_shut_down();
@@ -340,11 +874,19 @@ void bt_app_hf_cb(esp_hf_cb_event_t event, esp_hf_cb_param_t *param) {
 
         case ESP_HF_VOLUME_CONTROL_EVT: {
             ESP_LOGI(TAG, "--Volume Target: %s, Volume %d", c_volume_control_target_str[param->volume_control.type], param->volume_control.volume);
+            if (peer) {
+                peer->volume[param->volume_control.type] = param->volume_control.volume;
+            }
+#if CONFIG_BT_HFP_AUDIO_DATA_PATH_HCI
+            if (!peer || peer->audio != ESP_HF_AUDIO_STATE_DISCONNECTED) {
+                bt_app_hf_set_volume(param->volume_control.type, param->volume_control.volume);
+            }
+#endif /* #if CONFIG_BT_HFP_AUDIO_DATA_PATH_HCI */
             break;
         }
 
         case ESP_HF_UNAT_RESPONSE_EVT: {
-            ESP_LOGI(TAG, "--UNKOW AT CMD: %s", param->unat_rep.unat);
+            ESP_LOGI(TAG, "--UNKOW AT CMD: %s", param->unat_rep.unat ? param->unat_rep.unat : "");
             esp_hf_ag_unknown_at_send(param->unat_rep.remote_addr, NULL);
             break;
         }
@@ -356,11 +898,11 @@ void bt_app_hf_cb(esp_hf_cb_event_t event, esp_hf_cb_param_t *param) {
             esp_hf_network_state_t ntk_state = 1;
             int signal = 2;
             int battery = 3;
-            esp_hf_ag_ciev_report(param->ind_upd.remote_addr, ESP_HF_IND_TYPE_CALL, call_state);
-            esp_hf_ag_ciev_report(param->ind_upd.remote_addr, ESP_HF_IND_TYPE_CALLSETUP, call_setup_state);
-            esp_hf_ag_ciev_report(param->ind_upd.remote_addr, ESP_HF_IND_TYPE_SERVICE, ntk_state);
-            esp_hf_ag_ciev_report(param->ind_upd.remote_addr, ESP_HF_IND_TYPE_SIGNAL, signal);
-            esp_hf_ag_ciev_report(param->ind_upd.remote_addr, ESP_HF_IND_TYPE_BATTCHG, battery);
+            bt_app_hf_ciev_report(peer, param->ind_upd.remote_addr, ESP_HF_IND_TYPE_CALL, call_state);
+            bt_app_hf_ciev_report(peer, param->ind_upd.remote_addr, ESP_HF_IND_TYPE_CALLSETUP, call_setup_state);
+            bt_app_hf_ciev_report(peer, param->ind_upd.remote_addr, ESP_HF_IND_TYPE_SERVICE, ntk_state);
+            bt_app_hf_ciev_report(peer, param->ind_upd.remote_addr, ESP_HF_IND_TYPE_SIGNAL, signal);
+            bt_app_hf_ciev_report(peer, param->ind_upd.remote_addr, ESP_HF_IND_TYPE_BATTCHG, battery);
             break;
         }
 
@@ -374,6 +916,15 @@ void bt_app_hf_cb(esp_hf_cb_event_t event, esp_hf_cb_param_t *param) {
             int batt_lev = 3;
             esp_hf_call_held_status_t call_held_status = 0;
             esp_hf_ag_cind_response(param->cind_rep.remote_addr, call_status, call_setup_status, ntk_state, signal, roam, batt_lev, call_held_status);
+            if (peer) {
+                peer->ind[ESP_HF_IND_TYPE_CALL] = call_status;
+                peer->ind[ESP_HF_IND_TYPE_CALLSETUP] = call_setup_status;
+                peer->ind[ESP_HF_IND_TYPE_SERVICE] = ntk_state;
+                peer->ind[ESP_HF_IND_TYPE_SIGNAL] = signal;
+                peer->ind[ESP_HF_IND_TYPE_ROAM] = roam;
+                peer->ind[ESP_HF_IND_TYPE_BATTCHG] = batt_lev;
+                peer->ind[ESP_HF_IND_TYPE_CALLHELD] = call_held_status;
+            }
             break;
         }
 
@@ -414,17 +965,33 @@ void bt_app_hf_cb(esp_hf_cb_event_t event, esp_hf_cb_param_t *param) {
             } else {
                 ESP_LOGI(TAG, "--Current Number is %s, Number Type is %d, Service Type is %s.", number, number_type, c_subscriber_service_type_str[0]);
             }
-            esp_hf_ag_cnum_response(hf_peer_addr, number, number_type, service_type);
+            esp_hf_ag_cnum_response(param->cnum_rep.remote_addr, number, number_type, service_type);
             break;
         }
 
         case ESP_HF_VTS_RESPONSE_EVT: {
+            if (param->vts_rep.code == NULL) {
+                break;
+            }
             ESP_LOGI(TAG, "--DTMF code is: %s.", param->vts_rep.code);
+#if CONFIG_BT_HFP_AUDIO_DATA_PATH_HCI
+            if (!bt_app_hf_send_dtmf(param->vts_rep.code)) {
+                ESP_LOGW(TAG, "--DTMF not played, no audio connection or queue full");
+            }
+#endif /* #if CONFIG_BT_HFP_AUDIO_DATA_PATH_HCI */
             break;
         }
 
         case ESP_HF_NREC_RESPONSE_EVT: {
             ESP_LOGI(TAG, "--NREC status is: %s.", c_nrec_status_str[param->nrec.state]);
+            if (peer) {
+                peer->nrec = (param->nrec.state == ESP_HF_NREC_START);
+            }
+#if CONFIG_BT_HFP_AUDIO_DATA_PATH_HCI
+            if (!peer || peer->audio != ESP_HF_AUDIO_STATE_DISCONNECTED) {
+                bt_app_hf_set_nrec(param->nrec.state == ESP_HF_NREC_START);
+            }
+#endif /* #if CONFIG_BT_HFP_AUDIO_DATA_PATH_HCI */
             break;
         }
 
@@ -480,7 +1047,10 @@ void bt_app_hf_cb(esp_hf_cb_event_t event, esp_hf_cb_param_t *param) {
             break;
         }
         case ESP_HF_PKT_STAT_NUMS_GET_EVT: {
-            ESP_LOGI(TAG, "ESP_HF_PKT_STAT_NUMS_GET_EVT: %d.", event);
+            ESP_LOGD(TAG, "--pkt rx %" PRIu32 " ok %" PRIu32 " err %" PRIu32 " none %" PRIu32 " lost %" PRIu32 ", tx %" PRIu32 " discarded %" PRIu32,
+                     param->pkt_nums.rx_total, param->pkt_nums.rx_correct, param->pkt_nums.rx_err, param->pkt_nums.rx_none, param->pkt_nums.rx_lost,
+                     param->pkt_nums.tx_total, param->pkt_nums.tx_discarded);
+            bt_app_pkt_stat_update(param);
             break;
         }
         case ESP_HF_PROF_STATE_EVT: {
@@ -499,3 +1069,16 @@ void bt_app_hf_cb(esp_hf_cb_event_t event, esp_hf_cb_param_t *param) {
             break;
     }
 }
+
+void bt_app_hf_cb(esp_hf_cb_event_t event, esp_hf_cb_param_t *param) {
+    // audio setup does not wait behind indicator bursts and call control
+    bt_app_lane_t lane = BT_APP_LANE_NORMAL;
+    if (event == ESP_HF_AUDIO_STATE_EVT || event == ESP_HF_WBS_RESPONSE_EVT || event == ESP_HF_BCS_RESPONSE_EVT) {
+        lane = BT_APP_LANE_HIGH;
+    }
+
+    // handled in the application task, with the console commands and the relay
+    if (!bt_app_work_dispatch(bt_app_hf_hdl, event, param, sizeof(esp_hf_cb_param_t), bt_app_hf_copy_param, lane)) {
+        ESP_LOGE(TAG, "APP HFP event %d dropped", event);
+    }
+}
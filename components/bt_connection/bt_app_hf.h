@@ -30,16 +30,149 @@
 #ifndef __BT_APP_HF_H__
 #define __BT_APP_HF_H__
 
+#include <stdbool.h>
+#include <stdint.h>
+
 #include "esp_bt_defs.h"
 #include "esp_hf_ag_api.h"
 
-extern esp_bd_addr_t hf_peer_addr; // Declaration of peer device bdaddr
+#include "audio_mixer.h"
+#include "audio_trace.h"
+#include "audio_vad.h"
 
 #define CONFIG_BT_HFP_AUDIO_DATA_PATH_HCI 1
 
+// software echo canceller on the HCI data path, for boards without the external AEC chip
+#define BT_APP_HF_SOFT_AEC_ENABLE 1
+// echo delay of the headset beyond the frame it arrives in, loudspeaker to microphone
+#define BT_APP_HF_AEC_DELAY_MS    8
+// software noise suppressor on the HCI data path, one frame of latency
+#define BT_APP_HF_SOFT_NS_ENABLE  1
+// HFP volume steps applied as digital gain, for headsets without their own volume control
+#define BT_APP_HF_SOFT_VOLUME_ENABLE 1
+// level control and limiter on the microphone leg, on top of its volume step
+#define BT_APP_HF_MIC_AGC_ENABLE     1
+// DTMF tones played for AT+VTS and detected in the microphone stream
+#define BT_APP_HF_DTMF_ENABLE        1
+// voice activity gates the echo canceller and noise suppressor, silent microphone frames become comfort noise
+#define BT_APP_HF_VAD_ENABLE         1
+// headset voice played as noise shaped PWM, for boards without a codec
+#define BT_APP_HF_PWM_OUT_ENABLE     0
+#define BT_APP_HF_PWM_OUT_PIN        (32) // to the RC filter and the amplifier
+#define BT_APP_HF_PWM_OUT_PORT       (1)  // I2S peripheral used as the serialiser
+// ADC microphone mixed into the stream to the headset, takes I2S0 on the ESP32 (not with BT_APP_BRIDGE_ENABLE)
+#define BT_APP_HF_ADC_MIC_ENABLE     0
+#define BT_APP_HF_ADC_MIC_CHANNEL    (6) // ADC1 channel 6, GPIO34
+
+// mixer priorities of the outgoing sources, a source with a frame ducks every source of lower priority
+#define BT_APP_HF_MIX_PRIO_TONE   0 // call progress tone, muted under anything else
+#define BT_APP_HF_MIX_PRIO_STREAM 1 // network stream, local microphone
+#define BT_APP_HF_MIX_PRIO_PROMPT 2 // file prompts
+
 /**
  * @brief     callback function for HF client
  */
 void bt_app_hf_cb(esp_hf_cb_event_t event, esp_hf_cb_param_t *param);
 
+#if CONFIG_BT_HFP_AUDIO_DATA_PATH_HCI
+typedef enum {
+    BT_APP_LAT_OUT_GEN = 0, /*!< outgoing: frame generation */
+    BT_APP_LAT_OUT_QUEUE,   /*!< outgoing: ring until the controller takes the frame */
+    BT_APP_LAT_OUT_TOTAL,   /*!< outgoing: generation start until the controller takes the frame */
+    BT_APP_LAT_IN_RX,       /*!< incoming: first until last byte of the frame received */
+    BT_APP_LAT_IN_QUEUE,    /*!< incoming: jitter buffer */
+    BT_APP_LAT_IN_AEC,      /*!< incoming: echo cancellation of one frame */
+    BT_APP_LAT_IN_NS,       /*!< incoming: noise suppression of one frame */
+    BT_APP_LAT_IN_TOTAL,    /*!< incoming: first byte received until the frame consumer returns */
+    BT_APP_LAT_MAX,
+} bt_app_lat_stage_t;
+
+typedef struct {
+    audio_vad_stats_t in;  /*!< headset microphone stream */
+    audio_vad_stats_t out; /*!< stream to the headset */
+    uint32_t aec_skipped;  /*!< frames the echo canceller left out, one side silent */
+    uint32_t ns_skipped;   /*!< frames the noise suppressor left out, replaced by comfort noise */
+    uint64_t spent_us;     /*!< time in the echo canceller and the noise suppressor */
+    uint64_t saved_us;     /*!< estimated time the skipped frames would have taken */
+} bt_app_hf_vad_stats_t;
+
+/**
+ * @brief     consumer of frame aligned 16-bit PCM audio
+ */
+typedef void (*bt_app_hf_frame_cb_t)(int16_t *pcm, uint32_t samples);
+
+/**
+ * @brief     register the consumer of the re-timed incoming (headset microphone) stream, NULL to remove it
+ */
+void bt_app_hf_register_incoming_frame_cb(bt_app_hf_frame_cb_t cb);
+
+/**
+ * @brief     consumer of the DTMF digits detected in the incoming stream, called from the application task
+ */
+typedef void (*bt_app_hf_dtmf_cb_t)(char digit);
+
+/**
+ * @brief     register the consumer of detected DTMF digits, NULL to remove it
+ */
+void bt_app_hf_register_dtmf_cb(bt_app_hf_dtmf_cb_t cb);
+
+/**
+ * @brief     play DTMF digits (0-9, *, #, A-D) in the outgoing stream, false if any was refused
+ */
+bool bt_app_hf_send_dtmf(const char *digits);
+
+/**
+ * @brief     add a source to the outgoing mix, disabled until bt_app_hf_enable_source. Returns its id, -1 when full
+ *
+ *            pull hands over each frame in place, gain and duck (the gain under a source of higher priority) are Q12.
+ *            Sources stay registered across audio connections.
+ */
+int bt_app_hf_add_source(audio_mixer_pull_t pull, audio_mixer_release_t release, void *ctx, uint8_t priority, int32_t gain, int32_t duck);
+
+/**
+ * @brief     enable or disable a source of the outgoing mix, a disabled source costs nothing
+ */
+void bt_app_hf_enable_source(int id, bool enable);
+
+/**
+ * @brief     gain (Q12) of a source of the outgoing mix
+ */
+void bt_app_hf_set_source_gain(int id, int32_t gain);
+
+/**
+ * @brief     select the call progress tone sent on the next audio connection (audio_tone_id_t)
+ */
+bool bt_app_hf_set_tone(int tone_id);
+
+/**
+ * @brief     sample rate of the audio connection, 0 when there is none
+ */
+uint32_t bt_app_hf_get_sample_rate(void);
+
+/**
+ * @brief     volume step (0..15) of target (esp_hf_volume_control_target_t), as reported by AT+VGS/VGM or sent with +VGS/+VGM
+ */
+void bt_app_hf_set_volume(int target, int volume);
+
+/**
+ * @brief     switch echo cancellation and noise reduction of the incoming stream, as negotiated with AT+NREC
+ */
+void bt_app_hf_set_nrec(bool enable);
+
+/**
+ * @brief     voice activity and the processing it saved on the current audio connection
+ */
+void bt_app_hf_get_vad_stats(bt_app_hf_vad_stats_t *st);
+
+/**
+ * @brief     latency histogram of one stage of the audio path
+ */
+const audio_trace_t *bt_app_hf_get_latency(bt_app_lat_stage_t stage);
+
+/**
+ * @brief     clear all latency histograms
+ */
+void bt_app_hf_reset_latency(void);
+#endif /* #if CONFIG_BT_HFP_AUDIO_DATA_PATH_HCI */
+
 #endif /* __BT_APP_HF_H__*/
@@ -0,0 +1,102 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "esp_hf_ag_api.h"
+
+#include "bt_app_core.h"
+#include "bt_app_ind.h"
+#include "bt_app_peer.h"
+
+enum {
+    BT_APP_IND_EVT_FLUSH = 0,
+};
+
+// latest value per peer and indicator, valid where the dirty bit of the indicator is set
+static int8_t s_value[BT_APP_PEER_MAX][BT_APP_PEER_INDS];
+static uint32_t s_dirty[BT_APP_PEER_MAX];
+static bt_app_ind_stats_t s_stats;
+
+// the value is remembered so the next flush sends only what changed
+static void bt_app_ind_report(bt_app_peer_t *peer, esp_hf_ciev_report_type_t type, int8_t value) {
+    peer->ind[type] = value;
+    esp_hf_ag_ciev_report(peer->bda, type, value);
+}
+
+static void bt_app_ind_flush(uint16_t event, void *param) {
+    for (int i = 0; i < BT_APP_PEER_MAX; i++) {
+        uint32_t dirty = __atomic_exchange_n(&s_dirty[i], 0, __ATOMIC_ACQUIRE);
+        bt_app_peer_t *peer = bt_app_peer_at(i);
+        if (!dirty || !peer) {
+            continue;
+        }
+        // call before call setup, an answered call reads call 1 then callsetup 0
+        for (int type = ESP_HF_IND_TYPE_CALL; type < BT_APP_PEER_INDS; type++) {
+            if (!(dirty & (1u << type))) {
+                continue;
+            }
+            int8_t value = __atomic_load_n(&s_value[i][type], __ATOMIC_RELAXED);
+            if (peer->ind[type] == value) {
+                s_stats.unchanged++;
+                continue;
+            }
+            bt_app_ind_report(peer, type, value);
+            s_stats.sent++;
+        }
+    }
+}
+
+void bt_app_ind_set(bt_app_peer_t *peer, esp_hf_ciev_report_type_t type, int value) {
+    int idx = bt_app_peer_index(peer);
+    if (type < ESP_HF_IND_TYPE_CALL || type >= BT_APP_PEER_INDS) {
+        return;
+    }
+
+    __atomic_fetch_add(&s_stats.updates, 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&s_value[idx][type], (int8_t)value, __ATOMIC_RELAXED);
+    if (__atomic_fetch_or(&s_dirty[idx], 1u << type, __ATOMIC_RELEASE) & (1u << type)) {
+        __atomic_fetch_add(&s_stats.merged, 1, __ATOMIC_RELAXED);
+    }
+
+    // one flush carries every value given until it runs, the dispatcher does not add it twice
+    if (bt_app_work_defer(bt_app_ind_flush, BT_APP_IND_EVT_FLUSH)) {
+        __atomic_fetch_add(&s_stats.flushes, 1, __ATOMIC_RELAXED);
+    }
+}
+
+void bt_app_ind_drop(bt_app_peer_t *peer) {
+    __atomic_store_n(&s_dirty[bt_app_peer_index(peer)], 0, __ATOMIC_RELAXED);
+}
+
+void bt_app_ind_get_stats(bt_app_ind_stats_t *st) {
+    memcpy(st, &s_stats, sizeof(bt_app_ind_stats_t));
+}
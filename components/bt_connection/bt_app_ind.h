@@ -0,0 +1,63 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef __BT_APP_IND_H__
+#define __BT_APP_IND_H__
+
+#include <stdint.h>
+
+#include "esp_hf_ag_api.h"
+#include "bt_app_peer.h"
+
+#define BT_APP_IND_CIEV_BYTES (14) // "\r\n+CIEV: 2,1\r\n", for the airtime saved
+
+typedef struct {
+    uint32_t updates;   /*!< indicator values given */
+    uint32_t flushes;   /*!< flushes deferred to the application task, each carrying every value given before it ran */
+    uint32_t merged;    /*!< values that replaced a pending one of the same peer and indicator */
+    uint32_t sent;      /*!< +CIEV reports sent */
+    uint32_t unchanged; /*!< pending values dropped, the peer already had them */
+} bt_app_ind_stats_t;
+
+/**
+ * @brief     indicator for a peer, sent from the application task once its lanes are empty
+ *
+ *            Values given before the flush runs merge into the latest per peer and indicator, and only the ones that
+ *            differ from what the peer was last sent go out. Any task may call it.
+ */
+void bt_app_ind_set(bt_app_peer_t *peer, esp_hf_ciev_report_type_t type, int value);
+
+/**
+ * @brief     drop the values pending for a peer, before its entry is removed
+ */
+void bt_app_ind_drop(bt_app_peer_t *peer);
+
+void bt_app_ind_get_stats(bt_app_ind_stats_t *st);
+
+#endif /* __BT_APP_IND_H__ */
@@ -0,0 +1,112 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "bt_app_peer.h"
+
+// changed in the application task only, where the HFP callbacks and the console commands that write an entry are
+// dispatched; the console reads entries, the selection and the statistics unlocked, as a possibly stale snapshot
+static bt_app_peer_t s_peers[BT_APP_PEER_MAX];
+static bt_app_peer_tab_t s_tab;
+static volatile int s_selected = -1;
+
+bt_app_peer_t *bt_app_peer_get(const uint8_t *bda) {
+    int idx = bt_app_peer_tab_find(&s_tab, bda);
+    return (idx < 0) ? NULL : &s_peers[idx];
+}
+
+bt_app_peer_t *bt_app_peer_add(const uint8_t *bda) {
+    bt_app_peer_t *peer = bt_app_peer_get(bda);
+    if (peer) {
+        return peer;
+    }
+    int idx = 0;
+    while (idx < BT_APP_PEER_MAX && s_peers[idx].used) {
+        idx++;
+    }
+    if (idx == BT_APP_PEER_MAX) {
+        s_tab.stats.full++;
+        return NULL;
+    }
+    // never refused, the table has room for twice the entries
+    bt_app_peer_tab_insert(&s_tab, bda, idx);
+
+    peer = &s_peers[idx];
+    memset(peer, 0, sizeof(bt_app_peer_t));
+    memcpy(peer->bda, bda, ESP_BD_ADDR_LEN);
+    peer->conn = ESP_HF_CONNECTION_STATE_DISCONNECTED;
+    peer->audio = ESP_HF_AUDIO_STATE_DISCONNECTED;
+    peer->nrec = true;
+    peer->volume[ESP_HF_VOLUME_CONTROL_TARGET_SPK] = BT_APP_PEER_VOLUME;
+    peer->volume[ESP_HF_VOLUME_CONTROL_TARGET_MIC] = BT_APP_PEER_VOLUME;
+    memset(peer->ind, -1, sizeof(peer->ind));
+    peer->used = true;
+    return peer;
+}
+
+void bt_app_peer_remove(const uint8_t *bda) {
+    int idx = bt_app_peer_tab_remove(&s_tab, bda);
+    if (idx < 0) {
+        return;
+    }
+    s_peers[idx].used = false;
+    if (s_selected == idx) {
+        s_selected = -1;
+    }
+}
+
+bt_app_peer_t *bt_app_peer_at(int idx) {
+    return (idx >= 0 && idx < BT_APP_PEER_MAX && s_peers[idx].used) ? &s_peers[idx] : NULL;
+}
+
+int bt_app_peer_index(const bt_app_peer_t *peer) {
+    return (int)(peer - s_peers);
+}
+
+bool bt_app_peer_select(int idx) {
+    if (!bt_app_peer_at(idx)) {
+        return false;
+    }
+    s_selected = idx;
+    return true;
+}
+
+bt_app_peer_t *bt_app_peer_selected(void) {
+    bt_app_peer_t *peer = bt_app_peer_at(s_selected);
+    for (int i = 0; !peer && i < BT_APP_PEER_MAX; i++) {
+        peer = bt_app_peer_at(i);
+    }
+    return peer;
+}
+
+void bt_app_peer_get_stats(bt_app_peer_stats_t *st) {
+    *st = s_tab.stats;
+}
@@ -0,0 +1,104 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef __BT_APP_PEER_H__
+#define __BT_APP_PEER_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_bt_defs.h"
+#include "esp_hf_ag_api.h"
+#include "sdkconfig.h"
+
+#include "bt_app_peer_tab.h"
+
+// peers served at once, one per BR/EDR ACL link of the controller (one less while the relay holds a phone)
+#define BT_APP_PEER_MAX    (CONFIG_BTDM_CTRL_BR_EDR_MAX_ACL_CONN)
+#if BT_APP_PEER_SLOTS < 2 * BT_APP_PEER_MAX
+#error "BT_APP_PEER_SLOTS too small for the ACL connections of the controller"
+#endif
+#define BT_APP_PEER_INDS   (ESP_HF_IND_TYPE_CALLHELD + 1)
+#define BT_APP_PEER_VOLUME (15) // volume assumed until the headset reports one
+
+/**
+ * @brief     state of one headset
+ */
+typedef struct {
+    esp_bd_addr_t bda;
+    bool used;
+    esp_hf_connection_state_t conn;        /*!< service level connection state */
+    esp_hf_audio_state_t audio;            /*!< audio connection state, ESP_HF_AUDIO_STATE_CONNECTED_MSBC for mSBC */
+    uint16_t sync_conn_handle;             /*!< synchronous connection handle while audio is connected */
+    uint32_t peer_feat;                    /*!< HF features from the service level connection */
+    uint32_t chld_feat;                    /*!< call hold features from the service level connection */
+    bool nrec;                             /*!< echo cancellation and noise reduction requested */
+    uint8_t volume[2];                     /*!< speaker and microphone volume, by esp_hf_volume_control_target_t */
+    int8_t ind[BT_APP_PEER_INDS];          /*!< last indicator values sent, by esp_hf_ciev_report_type_t, -1 never sent */
+    uint32_t events;                       /*!< HFP events routed to this peer */
+} bt_app_peer_t;
+
+/**
+ * @brief     entry of peer bda, NULL if not in the table
+ */
+bt_app_peer_t *bt_app_peer_get(const uint8_t *bda);
+
+/**
+ * @brief     entry of peer bda, added with default state if not in the table, NULL if the table is full
+ */
+bt_app_peer_t *bt_app_peer_add(const uint8_t *bda);
+
+/**
+ * @brief     forget peer bda, a selection of it is dropped
+ */
+void bt_app_peer_remove(const uint8_t *bda);
+
+/**
+ * @brief     entry idx, NULL if unused
+ */
+bt_app_peer_t *bt_app_peer_at(int idx);
+
+/**
+ * @brief     index of an entry, as taken by bt_app_peer_at()
+ */
+int bt_app_peer_index(const bt_app_peer_t *peer);
+
+/**
+ * @brief     make entry idx the target of commands given without a peer, false if unused
+ */
+bool bt_app_peer_select(int idx);
+
+/**
+ * @brief     selected entry, the first used one if none was selected, NULL if the table is empty
+ */
+bt_app_peer_t *bt_app_peer_selected(void);
+
+void bt_app_peer_get_stats(bt_app_peer_stats_t *st);
+
+#endif /* __BT_APP_PEER_H__ */
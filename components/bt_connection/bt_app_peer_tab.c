@@ -0,0 +1,113 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "bt_app_peer_tab.h"
+
+#define PEER_SLOT_MASK  (BT_APP_PEER_SLOTS - 1)
+#define PEER_SLOT_EMPTY (0)
+
+// FNV-1a over the address, the low bits are well mixed for the sequential addresses of one vendor
+static uint32_t bt_app_peer_hash(const uint8_t *addr) {
+    uint32_t h = 2166136261u;
+    for (int i = 0; i < BT_APP_PEER_TAB_ADDR; i++) {
+        h = (h ^ addr[i]) * 16777619u;
+    }
+    return h & PEER_SLOT_MASK;
+}
+
+// slot holding addr, or the empty slot that ends its probe sequence
+static uint32_t bt_app_peer_probe(bt_app_peer_tab_t *tab, const uint8_t *addr) {
+    uint32_t slot = bt_app_peer_hash(addr);
+    uint32_t probes = 1;
+    // at most half the slots are taken, an empty one is always reached
+    while (tab->slot[slot].entry != PEER_SLOT_EMPTY && memcmp(tab->slot[slot].addr, addr, BT_APP_PEER_TAB_ADDR) != 0) {
+        slot = (slot + 1) & PEER_SLOT_MASK;
+        probes++;
+    }
+    tab->stats.lookups++;
+    tab->stats.probes += probes;
+    if (probes > tab->stats.probe_max) {
+        tab->stats.probe_max = probes;
+    }
+    return slot;
+}
+
+void bt_app_peer_tab_init(bt_app_peer_tab_t *tab) {
+    memset(tab, 0, sizeof(bt_app_peer_tab_t));
+}
+
+int bt_app_peer_tab_find(bt_app_peer_tab_t *tab, const uint8_t *addr) {
+    return tab->slot[bt_app_peer_probe(tab, addr)].entry - 1;
+}
+
+bool bt_app_peer_tab_insert(bt_app_peer_tab_t *tab, const uint8_t *addr, int entry) {
+    if (entry < 0 || entry >= UINT8_MAX) {
+        return false;
+    }
+    uint32_t slot = bt_app_peer_probe(tab, addr);
+    if (tab->slot[slot].entry != PEER_SLOT_EMPTY) {
+        return false;
+    }
+    if (tab->count == BT_APP_PEER_SLOTS / 2) {
+        tab->stats.full++;
+        return false;
+    }
+    memcpy(tab->slot[slot].addr, addr, BT_APP_PEER_TAB_ADDR);
+    tab->slot[slot].entry = (uint8_t)(entry + 1);
+    tab->count++;
+    return true;
+}
+
+int bt_app_peer_tab_remove(bt_app_peer_tab_t *tab, const uint8_t *addr) {
+    uint32_t slot = bt_app_peer_probe(tab, addr);
+    int entry = tab->slot[slot].entry - 1;
+    if (entry < 0) {
+        return -1;
+    }
+
+    // backward shift, entries after the hole move up unless that takes them before their home slot,
+    // so probe sequences never cross an empty slot and no tombstones are needed
+    uint32_t hole = slot;
+    uint32_t next = (slot + 1) & PEER_SLOT_MASK;
+    while (tab->slot[next].entry != PEER_SLOT_EMPTY) {
+        uint32_t home = bt_app_peer_hash(tab->slot[next].addr);
+        if (((next - home) & PEER_SLOT_MASK) >= ((next - hole) & PEER_SLOT_MASK)) {
+            tab->slot[hole] = tab->slot[next];
+            hole = next;
+        }
+        next = (next + 1) & PEER_SLOT_MASK;
+    }
+    tab->slot[hole].entry = PEER_SLOT_EMPTY;
+    tab->count--;
+    return entry;
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef __BT_APP_PEER_TAB_H__
+#define __BT_APP_PEER_TAB_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define BT_APP_PEER_TAB_ADDR (6)  // bytes of a device address
+#define BT_APP_PEER_SLOTS    (16) // hash slots, must be a power of two and at least twice the peers held
+
+typedef struct {
+    uint32_t lookups;   /*!< table lookups by address */
+    uint32_t probes;    /*!< slots compared over all lookups */
+    uint32_t probe_max; /*!< most slots compared by one lookup */
+    uint32_t full;      /*!< peers refused because the table was full */
+} bt_app_peer_stats_t;
+
+/**
+ * @brief     slot of the address table, the address is kept in the slot so a probe never leaves the table
+ */
+typedef struct {
+    uint8_t addr[BT_APP_PEER_TAB_ADDR];
+    uint8_t entry; /*!< entry index plus one, 0 if the slot is free */
+} bt_app_peer_slot_t;
+
+/**
+ * @brief     open addressing hash of device addresses to entry indices
+ *
+ *            Linear probing from an FNV-1a hash of the address; removal shifts the following entries back, so there are
+ *            no tombstones and a lookup stops at the first free slot. Holds at most BT_APP_PEER_SLOTS / 2 addresses,
+ *            which keeps the probe sequences short. No locking, the owner serialises the calls.
+ */
+typedef struct {
+    bt_app_peer_slot_t slot[BT_APP_PEER_SLOTS];
+    uint32_t count; /*!< addresses held */
+    bt_app_peer_stats_t stats;
+} bt_app_peer_tab_t;
+
+/**
+ * @brief     empty the table, statistics included
+ */
+void bt_app_peer_tab_init(bt_app_peer_tab_t *tab);
+
+/**
+ * @brief     entry index of addr, -1 if not in the table
+ */
+int bt_app_peer_tab_find(bt_app_peer_tab_t *tab, const uint8_t *addr);
+
+/**
+ * @brief     map addr to entry (0..254), false if addr is already in the table or the table is full
+ */
+bool bt_app_peer_tab_insert(bt_app_peer_tab_t *tab, const uint8_t *addr, int entry);
+
+/**
+ * @brief     forget addr, returns the entry index it had, -1 if it was not in the table
+ */
+int bt_app_peer_tab_remove(bt_app_peer_tab_t *tab, const uint8_t *addr);
+
+#endif /* __BT_APP_PEER_TAB_H__ */
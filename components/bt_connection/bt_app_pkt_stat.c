@@ -0,0 +1,178 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "esp_hf_ag_api.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "bt_app_pkt_stat.h"
+
+#define PKT_STAT_MASK (BT_APP_PKT_STAT_SAMPLES - 1)
+
+static const char *TAG = "bt_app_pkt_stat";
+
+static bt_app_pkt_peer_t s_peers[BT_APP_PKT_STAT_PEERS];
+// peer of the request in flight, the answer does not carry the handle it was asked for
+static bt_app_pkt_peer_t *s_asked = NULL;
+static int s_turn;
+static esp_timer_handle_t s_timer = NULL;
+static uint32_t s_peer_age[BT_APP_PKT_STAT_PEERS];
+static uint32_t s_age;
+
+// the active peers take turns, one request per period
+static void bt_app_pkt_stat_timer_cb(void *arg) {
+    for (int k = 1; k <= BT_APP_PKT_STAT_PEERS; k++) {
+        int i = (s_turn + k) % BT_APP_PKT_STAT_PEERS;
+        if (__atomic_load_n(&s_peers[i].active, __ATOMIC_ACQUIRE)) {
+            s_turn = i;
+            __atomic_store_n(&s_asked, &s_peers[i], __ATOMIC_RELEASE);
+            esp_hf_ag_pkt_stat_nums_get(s_peers[i].handle);
+            return;
+        }
+    }
+}
+
+static bt_app_pkt_peer_t *bt_app_pkt_stat_find(esp_bd_addr_t bda) {
+    for (int i = 0; i < BT_APP_PKT_STAT_PEERS; i++) {
+        if (s_peer_age[i] && memcmp(s_peers[i].bda, bda, ESP_BD_ADDR_LEN) == 0) {
+            return &s_peers[i];
+        }
+    }
+    return NULL;
+}
+
+static bool bt_app_pkt_stat_any_active(void) {
+    for (int i = 0; i < BT_APP_PKT_STAT_PEERS; i++) {
+        if (s_peers[i].active) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// slot of bda, or the least recently started one not being sampled
+static bt_app_pkt_peer_t *bt_app_pkt_stat_slot(esp_bd_addr_t bda) {
+    bt_app_pkt_peer_t *peer = bt_app_pkt_stat_find(bda);
+    if (peer) {
+        s_peer_age[peer - s_peers] = ++s_age;
+        return peer;
+    }
+    int oldest = -1;
+    for (int i = 0; i < BT_APP_PKT_STAT_PEERS; i++) {
+        if (!s_peers[i].active && (oldest < 0 || s_peer_age[i] < s_peer_age[oldest])) {
+            oldest = i;
+        }
+    }
+    if (oldest < 0) {
+        return NULL;
+    }
+    memset(&s_peers[oldest], 0, sizeof(bt_app_pkt_peer_t));
+    memcpy(s_peers[oldest].bda, bda, ESP_BD_ADDR_LEN);
+    s_peer_age[oldest] = ++s_age;
+    return &s_peers[oldest];
+}
+
+void bt_app_pkt_stat_start(esp_bd_addr_t bda, uint16_t handle) {
+    if (s_timer == NULL) {
+        const esp_timer_create_args_t args = {
+            .callback = bt_app_pkt_stat_timer_cb, //
+            .name = "pkt_stat",                   //
+        };
+        if (esp_timer_create(&args, &s_timer) != ESP_OK) {
+            ESP_LOGE(TAG, "%s timer create failed", __func__);
+            return;
+        }
+    }
+
+    bool running = bt_app_pkt_stat_any_active();
+    bt_app_pkt_peer_t *peer = bt_app_pkt_stat_slot(bda);
+    if (peer == NULL) {
+        ESP_LOGW(TAG, "%s no free slot for handle 0x%04x", __func__, handle);
+        return;
+    }
+    // the controller counts from zero on every synchronous connection
+    memset(peer->last, 0, sizeof(peer->last));
+    peer->handle = handle;
+    peer->last_us = (uint32_t)esp_timer_get_time();
+    __atomic_store_n(&peer->active, true, __ATOMIC_RELEASE);
+    if (!running) {
+        esp_timer_start_periodic(s_timer, BT_APP_PKT_STAT_PERIOD_MS * 1000);
+    }
+}
+
+void bt_app_pkt_stat_stop(esp_bd_addr_t bda) {
+    bt_app_pkt_peer_t *peer = bt_app_pkt_stat_find(bda);
+    if (peer == NULL || !peer->active) {
+        return;
+    }
+    __atomic_store_n(&peer->active, false, __ATOMIC_RELEASE);
+    // an answer still on its way for this peer is dropped
+    bt_app_pkt_peer_t *asked = peer;
+    __atomic_compare_exchange_n(&s_asked, &asked, NULL, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+    if (s_timer && !bt_app_pkt_stat_any_active()) {
+        esp_timer_stop(s_timer);
+    }
+}
+
+static uint16_t bt_app_pkt_stat_delta(bt_app_pkt_peer_t *peer, int idx, uint32_t now) {
+    // a counter going backwards was reset by the stack, count from zero
+    uint32_t delta = (now >= peer->last[idx]) ? now - peer->last[idx] : now;
+    peer->last[idx] = now;
+    peer->total[idx] += delta;
+    return (delta > UINT16_MAX) ? UINT16_MAX : (uint16_t)delta;
+}
+
+void bt_app_pkt_stat_update(const esp_hf_cb_param_t *param) {
+    bt_app_pkt_peer_t *peer = __atomic_exchange_n(&s_asked, NULL, __ATOMIC_ACQ_REL);
+    if (peer == NULL || !peer->active) {
+        return;
+    }
+
+    bt_app_pkt_sample_t *s = &peer->sample[peer->head & PKT_STAT_MASK];
+    s->rx_good = bt_app_pkt_stat_delta(peer, 0, param->pkt_nums.rx_correct);
+    s->rx_err = bt_app_pkt_stat_delta(peer, 1, param->pkt_nums.rx_err);
+    s->rx_lost = bt_app_pkt_stat_delta(peer, 2, param->pkt_nums.rx_none + param->pkt_nums.rx_lost);
+    s->tx = bt_app_pkt_stat_delta(peer, 3, param->pkt_nums.tx_total);
+    uint32_t now_us = (uint32_t)esp_timer_get_time();
+    peer->span_ms = (now_us - peer->last_us) / 1000;
+    peer->last_us = now_us;
+    // publish the sample to the console reader
+    __atomic_store_n(&peer->head, peer->head + 1, __ATOMIC_RELEASE);
+}
+
+const bt_app_pkt_peer_t *bt_app_pkt_stat_get(int idx) {
+    if (idx < 0 || idx >= BT_APP_PKT_STAT_PEERS || s_peer_age[idx] == 0) {
+        return NULL;
+    }
+    return &s_peers[idx];
+}
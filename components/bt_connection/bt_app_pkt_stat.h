@@ -0,0 +1,85 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef __BT_APP_PKT_STAT_H__
+#define __BT_APP_PKT_STAT_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_bt_defs.h"
+#include "esp_hf_ag_api.h"
+
+#define BT_APP_PKT_STAT_PEERS     (2)    // peers remembered, matches the ACL connections of the controller
+#define BT_APP_PKT_STAT_SAMPLES   (32)   // samples per peer, must be a power of two
+#define BT_APP_PKT_STAT_PERIOD_MS (1000) // one peer is asked per period, the peers with audio take turns
+
+/**
+ * @brief     packets counted during one sampling period
+ */
+typedef struct {
+    uint16_t rx_good; /*!< received correctly */
+    uint16_t rx_err;  /*!< received with errors */
+    uint16_t rx_lost; /*!< expected but not received */
+    uint16_t tx;      /*!< sent */
+} bt_app_pkt_sample_t;
+
+typedef struct {
+    esp_bd_addr_t bda;
+    bool active;       /*!< audio connected and being sampled */
+    uint16_t handle;   /*!< synchronous connection handle */
+    uint32_t last[4];  /*!< controller totals at the previous sample, rx_good, rx_err, rx_lost, tx */
+    uint32_t total[4]; /*!< totals over all audio connections */
+    uint32_t head;     /*!< samples written, the newest is sample[(head - 1) % BT_APP_PKT_STAT_SAMPLES] */
+    uint32_t last_us;  /*!< time of the previous sample */
+    uint32_t span_ms;  /*!< time covered by the newest sample, one period per peer with audio */
+    bt_app_pkt_sample_t sample[BT_APP_PKT_STAT_SAMPLES];
+} bt_app_pkt_peer_t;
+
+/**
+ * @brief     start sampling the synchronous connection handle of peer bda, alongside the other peers with audio
+ */
+void bt_app_pkt_stat_start(esp_bd_addr_t bda, uint16_t handle);
+
+/**
+ * @brief     stop sampling peer bda, the samples are kept for inspection
+ */
+void bt_app_pkt_stat_stop(esp_bd_addr_t bda);
+
+/**
+ * @brief     store the answer to a sampling request, called on ESP_HF_PKT_STAT_NUMS_GET_EVT
+ */
+void bt_app_pkt_stat_update(const esp_hf_cb_param_t *param);
+
+/**
+ * @brief     peer slot idx, NULL if unused
+ */
+const bt_app_pkt_peer_t *bt_app_pkt_stat_get(int idx);
+
+#endif /* __BT_APP_PKT_STAT_H__ */
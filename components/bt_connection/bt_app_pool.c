@@ -0,0 +1,77 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "bt_app_pool.h"
+
+void bt_app_pool_init(bt_app_pool_t *pool) {
+    for (uint32_t i = 0; i < pool->blocks; i++) {
+        pool->next[i] = (i + 1 < pool->blocks) ? i + 2 : 0;
+    }
+    __atomic_store_n(&pool->head, pool->blocks ? 1 : 0, __ATOMIC_RELEASE);
+}
+
+static inline uint32_t bt_app_pool_head(uint32_t head, uint32_t first, uint32_t used) {
+    return ((head >> BT_APP_POOL_TAG_SHIFT) + 1) << BT_APP_POOL_TAG_SHIFT | used << BT_APP_POOL_USED_SHIFT | first;
+}
+
+void *bt_app_pool_pop(bt_app_pool_t *pool, uint32_t *used) {
+    uint32_t head = __atomic_load_n(&pool->head, __ATOMIC_ACQUIRE);
+    uint32_t idx;
+    do {
+        idx = head & BT_APP_POOL_FIELD_MASK;
+        if (idx == 0) {
+            return NULL;
+        }
+        *used = ((head >> BT_APP_POOL_USED_SHIFT) & BT_APP_POOL_FIELD_MASK) + 1;
+        // next may be stale if the block was taken meanwhile, the tag then fails the swap
+    } while (!__atomic_compare_exchange_n(&pool->head, &head, bt_app_pool_head(head, pool->next[idx - 1], *used), false, __ATOMIC_ACQ_REL,
+                                          __ATOMIC_ACQUIRE));
+    return pool->mem + (idx - 1) * pool->size;
+}
+
+void bt_app_pool_push(bt_app_pool_t *pool, void *block) {
+    uint32_t idx = ((uint8_t *)block - pool->mem) / pool->size;
+    uint32_t head = __atomic_load_n(&pool->head, __ATOMIC_RELAXED);
+    do {
+        pool->next[idx] = head & BT_APP_POOL_FIELD_MASK;
+    } while (!__atomic_compare_exchange_n(&pool->head, &head,
+                                          bt_app_pool_head(head, idx + 1, ((head >> BT_APP_POOL_USED_SHIFT) & BT_APP_POOL_FIELD_MASK) - 1), false,
+                                          __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+bool bt_app_pool_owns(const bt_app_pool_t *pool, const void *p) {
+    return (const uint8_t *)p >= pool->mem && (const uint8_t *)p < pool->mem + pool->blocks * pool->size;
+}
+
+uint32_t bt_app_pool_used(const bt_app_pool_t *pool) {
+    return (__atomic_load_n(&pool->head, __ATOMIC_RELAXED) >> BT_APP_POOL_USED_SHIFT) & BT_APP_POOL_FIELD_MASK;
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+#ifndef __BT_APP_POOL_H__
+#define __BT_APP_POOL_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define BT_APP_POOL_FIELD_MASK (0xffu) // most blocks in a pool
+#define BT_APP_POOL_USED_SHIFT (8)
+#define BT_APP_POOL_TAG_SHIFT  (16)
+
+/**
+ * @brief     fixed size blocks on a lock-free free list
+ *
+ *            Any task may take a block and any task may give one back. The list head packs the first free block and
+ *            the count of blocks taken with a tag bumped on every change, so a compare-and-swap never succeeds on a
+ *            head that was popped and pushed back in between.
+ */
+typedef struct {
+    uint32_t size;   /*!< bytes per block */
+    uint32_t blocks; /*!< blocks in the pool, up to BT_APP_POOL_FIELD_MASK */
+    uint8_t *mem;
+    uint8_t *next;   /*!< per block, next free block plus one, 0 ends the list */
+    uint32_t head;   /*!< bits 0-7 first free block plus one, bits 8-15 blocks taken, bits 16-31 the tag */
+} bt_app_pool_t;
+
+/**
+ * @brief     put every block on the free list. No block may be taken or given meanwhile
+ */
+void bt_app_pool_init(bt_app_pool_t *pool);
+
+/**
+ * @brief     take a block, NULL if none is free. used is set to the blocks taken including this one
+ */
+void *bt_app_pool_pop(bt_app_pool_t *pool, uint32_t *used);
+
+/**
+ * @brief     give back a block taken from the pool
+ */
+void bt_app_pool_push(bt_app_pool_t *pool, void *block);
+
+/**
+ * @brief     p is a block of the pool
+ */
+bool bt_app_pool_owns(const bt_app_pool_t *pool, const void *p);
+
+/**
+ * @brief     blocks currently taken
+ */
+uint32_t bt_app_pool_used(const bt_app_pool_t *pool);
+
+#endif /* __BT_APP_POOL_H__ */
@@ -0,0 +1,457 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "audio_frame.h"
+#include "audio_resample.h"
+#include "audio_ring.h"
+#include "bt_app_prompt.h"
+#include "hal_fs.h"
+
+#define PROMPT_TASK_STACK      (3072)
+#define PROMPT_REQ_TIMEOUT_MS  (1000)
+#define PROMPT_CHUNK_SAMPLES   (AUDIO_RS_MAX_IN / 2) // input per resampler call, leaves room for 1:2
+#define PROMPT_RATE_IDX(rate)  (((rate) == WBS_PCM_SAMPLING_RATE_KHZ * 1000) ? 1 : 0)
+
+typedef enum {
+    PROMPT_REQ_NONE = 0,
+    PROMPT_REQ_PLAY,
+    PROMPT_REQ_STOP,
+} prompt_req_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t count;
+} prompt_index_hdr_t;
+
+static const char *TAG = "bt_app_prompt";
+
+static bt_app_prompt_entry_t s_index[BT_APP_PROMPT_MAX];
+static int s_count;
+static TaskHandle_t s_loader = NULL;
+static TaskHandle_t s_waiter = NULL;
+// request from the console, served by the loader task
+static volatile prompt_req_t s_req;
+static int s_req_idx;
+static uint32_t s_req_rate;
+static bool s_req_loop;
+static bool s_req_ok;
+// loader side
+static FILE *s_play_f = NULL;
+static const bt_app_prompt_entry_t *s_play;
+static uint32_t s_play_pos;
+static bool s_play_loop;
+static uint32_t s_play_eof;
+// read-ahead cache, filled by the loader and emptied by the producer
+static audio_ring_t s_cache;
+static uint32_t s_play_rate;
+static uint32_t s_playing;
+static uint32_t s_busy; // the producer holds a frame, from bt_app_prompt_peek to bt_app_prompt_release
+static bool s_peeked;   // the frame held is a cache slot, released on bt_app_prompt_release
+static const int16_t s_silence[WBS_PCM_FRAME_SAMPLES];
+static bt_app_prompt_stats_t s_stats;
+
+static int prompt_find(const char *name) {
+    for (int i = 0; i < s_count; i++) {
+        if (strncmp(s_index[i].name, name, BT_APP_PROMPT_NAME_LEN) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static bool prompt_save_index(void) {
+    prompt_index_hdr_t hdr = { .magic = BT_APP_PROMPT_MAGIC, .count = (uint32_t)s_count };
+    FILE *f = fs_open(BT_APP_PROMPT_INDEX, "wb");
+    if (f == NULL) {
+        return false;
+    }
+    bool ok = fwrite(&hdr, sizeof(hdr), 1, f) == 1 && fwrite(s_index, sizeof(bt_app_prompt_entry_t), s_count, f) == (size_t)s_count;
+    fclose(f);
+    return ok;
+}
+
+static void prompt_load_index(void) {
+    prompt_index_hdr_t hdr;
+    FILE *f = fs_open(BT_APP_PROMPT_INDEX, "rb");
+
+    s_count = 0;
+    if (f == NULL) {
+        return;
+    }
+    if (fread(&hdr, sizeof(hdr), 1, f) == 1 && hdr.magic == BT_APP_PROMPT_MAGIC && hdr.count <= BT_APP_PROMPT_MAX &&
+        fread(s_index, sizeof(bt_app_prompt_entry_t), hdr.count, f) == hdr.count) {
+        s_count = hdr.count;
+    } else {
+        ESP_LOGW(TAG, "%s invalid, store ignored", BT_APP_PROMPT_INDEX);
+    }
+    fclose(f);
+}
+
+// loader side: read frames until the cache is full or the clip ends
+static void prompt_refill(void) {
+    const uint32_t frame_size = s_cache.frame_size;
+    uint8_t *slot;
+
+    while (!s_play_eof && (slot = audio_ring_write_begin(&s_cache)) != NULL) {
+        if (s_play_pos == s_play->frames) {
+            if (!s_play_loop) {
+                __atomic_store_n(&s_play_eof, 1, __ATOMIC_RELEASE);
+                break;
+            }
+            s_play_pos = 0;
+            fseek(s_play_f, s_play->offset[PROMPT_RATE_IDX(s_play_rate)], SEEK_SET);
+        }
+        int64_t t0 = esp_timer_get_time();
+        size_t n = fread(slot, 1, frame_size, s_play_f);
+        uint32_t dt = (uint32_t)(esp_timer_get_time() - t0);
+        s_stats.reads++;
+        s_stats.read_total_us += dt;
+        if (dt > s_stats.read_worst_us) {
+            s_stats.read_worst_us = dt;
+        }
+        if (n != frame_size) {
+            ESP_LOGE(TAG, "%s short read at frame %" PRIu32, s_play->name, s_play_pos);
+            __atomic_store_n(&s_play_eof, 1, __ATOMIC_RELEASE);
+            break;
+        }
+        audio_ring_write_commit(&s_cache);
+        s_play_pos++;
+    }
+}
+
+// loader side: stop the producer reading, then drop the current clip
+static void prompt_close(void) {
+    __atomic_store_n(&s_playing, 0, __ATOMIC_SEQ_CST);
+    while (__atomic_load_n(&s_busy, __ATOMIC_SEQ_CST)) {
+        vTaskDelay(1);
+    }
+    if (s_play_f) {
+        fclose(s_play_f);
+        s_play_f = NULL;
+    }
+    audio_ring_init(&s_cache, 0);
+}
+
+static bool prompt_open(int idx, uint32_t rate, bool loop) {
+    const uint32_t r = PROMPT_RATE_IDX(rate);
+
+    s_play_f = fs_open(BT_APP_PROMPT_DATA, "rb");
+    if (s_play_f == NULL || fseek(s_play_f, s_index[idx].offset[r], SEEK_SET) != 0) {
+        ESP_LOGE(TAG, "%s can't open %s", __func__, s_index[idx].name);
+        prompt_close();
+        return false;
+    }
+    s_play = &s_index[idx];
+    s_play_pos = 0;
+    s_play_loop = loop;
+    s_play_rate = rate;
+    s_play_eof = 0;
+    audio_ring_init(&s_cache, r ? WBS_PCM_INPUT_DATA_SIZE : PCM_INPUT_DATA_SIZE);
+    // the producer only sees the clip once the whole cache is loaded
+    prompt_refill();
+    __atomic_store_n(&s_playing, 1, __ATOMIC_SEQ_CST);
+    return true;
+}
+
+static void bt_app_prompt_task(void *arg) {
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, (TickType_t)portMAX_DELAY);
+        if (s_req != PROMPT_REQ_NONE) {
+            prompt_close();
+            s_req_ok = (s_req == PROMPT_REQ_PLAY) ? prompt_open(s_req_idx, s_req_rate, s_req_loop) : true;
+            s_req = PROMPT_REQ_NONE;
+            if (s_waiter) {
+                xTaskNotifyGive(s_waiter);
+            }
+        } else if (__atomic_load_n(&s_playing, __ATOMIC_SEQ_CST)) {
+            prompt_refill();
+        } else if (s_play_f) {
+            // played to the end
+            prompt_close();
+        }
+    }
+}
+
+static bool prompt_request(prompt_req_t req, int idx, uint32_t rate, bool loop) {
+    if (s_loader == NULL) {
+        return false;
+    }
+    s_req_idx = idx;
+    s_req_rate = rate;
+    s_req_loop = loop;
+    s_req_ok = false;
+    s_waiter = xTaskGetCurrentTaskHandle();
+    s_req = req;
+    xTaskNotifyGive(s_loader);
+    bool done = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(PROMPT_REQ_TIMEOUT_MS)) != 0;
+    s_waiter = NULL;
+    return done && s_req_ok;
+}
+
+bool bt_app_prompt_init(void) {
+    prompt_load_index();
+    audio_ring_init(&s_cache, 0);
+    if (s_loader == NULL && xTaskCreate(bt_app_prompt_task, "BtAppPromptTask", PROMPT_TASK_STACK, NULL, tskIDLE_PRIORITY + 2, &s_loader) != pdPASS) {
+        ESP_LOGE(TAG, "%s task create failed", __func__);
+        return false;
+    }
+    ESP_LOGI(TAG, "%d prompts", s_count);
+    return true;
+}
+
+int bt_app_prompt_count(void) {
+    return s_count;
+}
+
+const bt_app_prompt_entry_t *bt_app_prompt_get(int idx) {
+    return (idx >= 0 && idx < s_count) ? &s_index[idx] : NULL;
+}
+
+// find the data chunk of a 16-bit mono PCM WAV file
+static bool prompt_wav_parse(FILE *f, uint32_t *rate, uint32_t *data_len) {
+    uint8_t h[12];
+    uint8_t c[8];
+    uint8_t fmt[16];
+    bool have_fmt = false;
+
+    if (fread(h, 1, sizeof(h), f) != sizeof(h) || memcmp(h, "RIFF", 4) != 0 || memcmp(h + 8, "WAVE", 4) != 0) {
+        return false;
+    }
+    while (fread(c, 1, sizeof(c), f) == sizeof(c)) {
+        uint32_t len = c[4] | (c[5] << 8) | (c[6] << 16) | ((uint32_t)c[7] << 24);
+        if (memcmp(c, "fmt ", 4) == 0 && len >= sizeof(fmt)) {
+            if (fread(fmt, 1, sizeof(fmt), f) != sizeof(fmt)) {
+                return false;
+            }
+            // PCM, one channel, 16 bits
+            if ((fmt[0] | (fmt[1] << 8)) != 1 || (fmt[2] | (fmt[3] << 8)) != 1 || (fmt[14] | (fmt[15] << 8)) != 16) {
+                return false;
+            }
+            *rate = fmt[4] | (fmt[5] << 8) | (fmt[6] << 16) | ((uint32_t)fmt[7] << 24);
+            have_fmt = true;
+            len -= sizeof(fmt);
+        } else if (memcmp(c, "data", 4) == 0) {
+            *data_len = len;
+            return have_fmt;
+        }
+        if (fseek(f, (len + 1) & ~1u, SEEK_CUR) != 0) {
+            return false;
+        }
+    }
+    return false;
+}
+
+// write frames 7.5 ms frames of the clip at out_rate, converted from in_rate when they differ
+static bool prompt_write_rate(FILE *in, long data_pos, uint32_t samples, uint32_t in_rate, uint32_t out_rate, uint32_t frames, FILE *out) {
+    const uint32_t frame_samples = (out_rate == WBS_PCM_SAMPLING_RATE_KHZ * 1000) ? WBS_PCM_FRAME_SAMPLES : PCM_FRAME_SAMPLES;
+    int16_t chunk[PROMPT_CHUNK_SAMPLES];
+    int16_t conv[2 * PROMPT_CHUNK_SAMPLES];
+    int16_t frame[WBS_PCM_FRAME_SAMPLES];
+    audio_resampler_t *rs = NULL;
+    uint32_t fill = 0;
+    uint32_t written = 0;
+    bool ok = true;
+
+    if (in_rate != out_rate) {
+        rs = malloc(sizeof(audio_resampler_t));
+        if (rs == NULL || !audio_resampler_init(rs, in_rate, out_rate)) {
+            free(rs);
+            return false;
+        }
+    }
+    fseek(in, data_pos, SEEK_SET);
+
+    while (ok && written < frames) {
+        uint32_t n = 0;
+        if (samples) {
+            n = (samples > PROMPT_CHUNK_SAMPLES) ? PROMPT_CHUNK_SAMPLES : samples;
+            if (fread(chunk, sizeof(int16_t), n, in) != n) {
+                ok = false;
+                break;
+            }
+            samples -= n;
+        }
+        const int16_t *src = chunk;
+        if (n == 0) {
+            // clip done, pad the last frame with silence
+            memset(chunk, 0, sizeof(chunk));
+            n = PROMPT_CHUNK_SAMPLES;
+        }
+        if (rs) {
+            n = audio_resampler_process(rs, chunk, n, conv, sizeof(conv) / sizeof(conv[0]));
+            src = conv;
+        }
+        for (uint32_t i = 0; i < n && written < frames; i++) {
+            frame[fill++] = src[i];
+            if (fill == frame_samples) {
+                ok = fwrite(frame, sizeof(int16_t), frame_samples, out) == frame_samples;
+                fill = 0;
+                written++;
+            }
+        }
+    }
+    free(rs);
+    return ok;
+}
+
+bool bt_app_prompt_add(const char *name, const char *wav_file) {
+    bt_app_prompt_entry_t e = { 0 };
+    uint32_t rate = 0;
+    uint32_t data_len = 0;
+
+    if (s_count >= BT_APP_PROMPT_MAX || name[0] == '\0' || strlen(name) >= BT_APP_PROMPT_NAME_LEN || prompt_find(name) >= 0) {
+        return false;
+    }
+    bt_app_prompt_stop();
+
+    FILE *in = fs_open(wav_file, "rb");
+    if (in == NULL) {
+        return false;
+    }
+    if (!prompt_wav_parse(in, &rate, &data_len) || (rate != PCM_SAMPLING_RATE_KHZ * 1000 && rate != WBS_PCM_SAMPLING_RATE_KHZ * 1000)) {
+        ESP_LOGE(TAG, "%s: 16-bit mono WAV at 8 or 16 kHz expected", wav_file);
+        fclose(in);
+        return false;
+    }
+    FILE *out = fs_open(BT_APP_PROMPT_DATA, "ab");
+    if (out == NULL) {
+        fclose(in);
+        return false;
+    }
+
+    long data_pos = ftell(in);
+    uint32_t samples = data_len / sizeof(int16_t);
+    uint32_t frame_samples = PROMPT_RATE_IDX(rate) ? WBS_PCM_FRAME_SAMPLES : PCM_FRAME_SAMPLES;
+    bool ok = (fseek(out, 0, SEEK_END) == 0);
+
+    strncpy(e.name, name, BT_APP_PROMPT_NAME_LEN - 1);
+    e.frames = (samples + frame_samples - 1) / frame_samples;
+    for (int r = 0; ok && r < 2; r++) {
+        e.offset[r] = (uint32_t)ftell(out);
+        ok = prompt_write_rate(in, data_pos, samples, rate, r ? WBS_PCM_SAMPLING_RATE_KHZ * 1000 : PCM_SAMPLING_RATE_KHZ * 1000, e.frames, out);
+    }
+    fclose(out);
+    fclose(in);
+    if (!ok) {
+        ESP_LOGE(TAG, "%s: frame file write failed", name);
+        return false;
+    }
+
+    s_index[s_count++] = e;
+    if (!prompt_save_index()) {
+        s_count--;
+        return false;
+    }
+    ESP_LOGI(TAG, "%s: %" PRIu32 " frames", name, e.frames);
+    return true;
+}
+
+bool bt_app_prompt_clear(void) {
+    bt_app_prompt_stop();
+    s_count = 0;
+    fs_remove(BT_APP_PROMPT_DATA);
+    return prompt_save_index();
+}
+
+bool bt_app_prompt_play(const char *name, uint32_t sample_rate, bool loop) {
+    int idx = prompt_find(name);
+    if (idx < 0 || (sample_rate != PCM_SAMPLING_RATE_KHZ * 1000 && sample_rate != WBS_PCM_SAMPLING_RATE_KHZ * 1000)) {
+        return false;
+    }
+    return prompt_request(PROMPT_REQ_PLAY, idx, sample_rate, loop);
+}
+
+void bt_app_prompt_stop(void) {
+    prompt_request(PROMPT_REQ_STOP, 0, 0, false);
+}
+
+bool bt_app_prompt_playing(void) {
+    return __atomic_load_n(&s_playing, __ATOMIC_SEQ_CST) != 0;
+}
+
+const int16_t *bt_app_prompt_peek(uint32_t samples, uint32_t sample_rate) {
+    const int16_t *frame = NULL;
+
+    __atomic_store_n(&s_busy, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&s_playing, __ATOMIC_SEQ_CST) && sample_rate == s_play_rate && samples * sizeof(int16_t) == s_cache.frame_size) {
+        frame = (const int16_t *)audio_ring_read_begin(&s_cache);
+        if (frame) {
+            s_stats.hits++;
+            s_peeked = true;
+        } else if (__atomic_load_n(&s_play_eof, __ATOMIC_ACQUIRE)) {
+            // clip over, the loader closes it
+            __atomic_store_n(&s_playing, 0, __ATOMIC_SEQ_CST);
+        } else {
+            frame = s_silence;
+            s_stats.misses++;
+        }
+        // refill once half the cache is played
+        if (audio_ring_count(&s_cache) <= AUDIO_RING_FRAMES / 2) {
+            xTaskNotifyGive(s_loader);
+        }
+    }
+    if (frame == NULL) {
+        __atomic_store_n(&s_busy, 0, __ATOMIC_SEQ_CST);
+    }
+    return frame;
+}
+
+void bt_app_prompt_release(void) {
+    if (s_peeked) {
+        audio_ring_read_commit(&s_cache);
+        s_peeked = false;
+    }
+    __atomic_store_n(&s_busy, 0, __ATOMIC_SEQ_CST);
+}
+
+bool bt_app_prompt_read(int16_t *pcm, uint32_t samples, uint32_t sample_rate) {
+    const int16_t *frame = bt_app_prompt_peek(samples, sample_rate);
+
+    if (frame == NULL) {
+        return false;
+    }
+    memcpy(pcm, frame, samples * sizeof(int16_t));
+    bt_app_prompt_release();
+    return true;
+}
+
+void bt_app_prompt_get_stats(bt_app_prompt_stats_t *stats) {
+    *stats = s_stats;
+}
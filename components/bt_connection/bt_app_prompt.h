@@ -0,0 +1,122 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef __BT_APP_PROMPT_H__
+#define __BT_APP_PROMPT_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define BT_APP_PROMPT_MAX      (16)            // clips in the store
+#define BT_APP_PROMPT_NAME_LEN (16)            // including the terminating zero
+#define BT_APP_PROMPT_INDEX    "prompts.idx"   // index file on LittleFS
+#define BT_APP_PROMPT_DATA     "prompts.bin"   // frame file on LittleFS
+#define BT_APP_PROMPT_MAGIC    (0x58444950UL)  // "PIDX"
+
+/**
+ * @brief     index entry, frame k of a clip at 8 kHz (r = 0) or 16 kHz (r = 1) starts at offset[r] + k * frame size
+ */
+typedef struct {
+    char name[BT_APP_PROMPT_NAME_LEN];
+    uint32_t frames;    /*!< 7.5 ms frames, the same count at both rates */
+    uint32_t offset[2]; /*!< first byte of the 8 kHz and 16 kHz frames in the frame file */
+} bt_app_prompt_entry_t;
+
+typedef struct {
+    uint32_t hits;          /*!< frames served from the read-ahead cache */
+    uint32_t misses;        /*!< frames the cache did not have in time, played as silence */
+    uint32_t reads;         /*!< frames read from flash */
+    uint32_t read_worst_us; /*!< slowest frame read */
+    uint32_t read_total_us; /*!< time spent reading frames */
+} bt_app_prompt_stats_t;
+
+/**
+ * @brief     load the index and start the loader task, LittleFS must be mounted
+ */
+bool bt_app_prompt_init(void);
+
+/**
+ * @brief     number of clips in the store
+ */
+int bt_app_prompt_count(void);
+
+/**
+ * @brief     index entry idx, NULL if out of range
+ */
+const bt_app_prompt_entry_t *bt_app_prompt_get(int idx);
+
+/**
+ * @brief     add a clip from a 16-bit mono 8 or 16 kHz WAV file on LittleFS, framed at both rates
+ */
+bool bt_app_prompt_add(const char *name, const char *wav_file);
+
+/**
+ * @brief     remove all clips
+ */
+bool bt_app_prompt_clear(void);
+
+/**
+ * @brief     start playing clip name at sample_rate, returns once the cache is primed
+ */
+bool bt_app_prompt_play(const char *name, uint32_t sample_rate, bool loop);
+
+/**
+ * @brief     stop playing
+ */
+void bt_app_prompt_stop(void);
+
+/**
+ * @brief     true while a clip is playing
+ */
+bool bt_app_prompt_playing(void);
+
+/**
+ * @brief     producer side: fill pcm with the next frame, false when no clip is playing at sample_rate
+ *
+ *            Never touches flash, a frame not yet cached is played as silence and counted as a miss.
+ */
+bool bt_app_prompt_read(int16_t *pcm, uint32_t samples, uint32_t sample_rate);
+
+/**
+ * @brief     producer side without copy: the next frame in place, NULL when no clip is playing at sample_rate.
+ *            A frame returned is held until bt_app_prompt_release
+ */
+const int16_t *bt_app_prompt_peek(uint32_t samples, uint32_t sample_rate);
+
+/**
+ * @brief     give back the frame of the last successful bt_app_prompt_peek
+ */
+void bt_app_prompt_release(void);
+
+/**
+ * @brief     cache and flash read counters
+ */
+void bt_app_prompt_get_stats(bt_app_prompt_stats_t *stats);
+
+#endif /* __BT_APP_PROMPT_H__ */
@@ -0,0 +1,296 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "bt_app_rec.h"
+#include "hal_fs.h"
+
+#define REC_WAV_HEADER_SIZE (44)
+#define REC_TASK_STACK      (3072)
+#define REC_STOP_TIMEOUT_MS (5000)
+
+typedef struct {
+    const char *file;
+    FILE *f;
+    uint8_t *buf[2];
+    uint32_t len[2];  /*!< bytes in each buffer */
+    uint32_t full[2]; /*!< buffer handed to the writer, cleared by the writer once it is on flash */
+    uint32_t cur;     /*!< buffer being filled, owned by the producer */
+    uint32_t flush;   /*!< next buffer to write, owned by the writer */
+    uint32_t rate;    /*!< sample rate of the file, taken from the first frame */
+    bool failed;      /*!< a write failed, the stream is stopped */
+    bt_app_rec_stats_t stats;
+} rec_stream_t;
+
+static const char *TAG = "bt_app_rec";
+
+static rec_stream_t s_rec[BT_APP_REC_MAX] = {
+    { .file = "rec_in.wav" },  //
+    { .file = "rec_out.wav" }, //
+};
+static TaskHandle_t s_rec_task = NULL;
+static TaskHandle_t s_rec_waiter = NULL;
+static uint32_t s_rec_active; // frames are accepted
+static uint32_t s_rec_busy;   // the producer is inside bt_app_rec_frame
+
+static void rec_put_le(uint8_t *p, uint32_t v, int bytes) {
+    for (int i = 0; i < bytes; i++) {
+        p[i] = (uint8_t)(v >> (8 * i));
+    }
+}
+
+// 16-bit mono PCM WAV header
+static void rec_wav_header(uint8_t *h, uint32_t rate, uint32_t data_bytes) {
+    memcpy(h, "RIFF", 4);
+    rec_put_le(h + 4, 36 + data_bytes, 4);
+    memcpy(h + 8, "WAVEfmt ", 8);
+    rec_put_le(h + 16, 16, 4);
+    rec_put_le(h + 20, 1, 2);
+    rec_put_le(h + 22, 1, 2);
+    rec_put_le(h + 24, rate, 4);
+    rec_put_le(h + 28, rate * 2, 4);
+    rec_put_le(h + 32, 2, 2);
+    rec_put_le(h + 34, 16, 2);
+    memcpy(h + 36, "data", 4);
+    rec_put_le(h + 40, data_bytes, 4);
+}
+
+static void rec_write(rec_stream_t *st, const uint8_t *buf, uint32_t len) {
+    if (st->failed || len == 0) {
+        return;
+    }
+    int64_t t0 = esp_timer_get_time();
+    size_t n = fwrite(buf, 1, len, st->f);
+    uint32_t dt = (uint32_t)(esp_timer_get_time() - t0);
+
+    st->stats.flushes++;
+    st->stats.flush_total_us += dt;
+    if (dt > st->stats.flush_worst_us) {
+        st->stats.flush_worst_us = dt;
+    }
+    if (n != len) {
+        // most likely the partition is full, keep what was written
+        ESP_LOGE(TAG, "%s write failed after %" PRIu32 " bytes", st->file, st->stats.bytes);
+        st->stats.errors++;
+        st->failed = true;
+        return;
+    }
+    st->stats.bytes += len;
+}
+
+static void rec_drain(rec_stream_t *st) {
+    while (__atomic_load_n(&st->full[st->flush], __ATOMIC_ACQUIRE)) {
+        rec_write(st, st->buf[st->flush], st->len[st->flush]);
+        st->len[st->flush] = 0;
+        __atomic_store_n(&st->full[st->flush], 0, __ATOMIC_RELEASE);
+        st->flush ^= 1;
+    }
+}
+
+static void rec_close(rec_stream_t *st) {
+    uint8_t h[REC_WAV_HEADER_SIZE];
+
+    // the partial buffer is the one after the last full one
+    rec_drain(st);
+    rec_write(st, st->buf[st->cur], st->len[st->cur]);
+
+    uint32_t data = (st->stats.bytes > REC_WAV_HEADER_SIZE) ? st->stats.bytes - REC_WAV_HEADER_SIZE : 0;
+    rec_wav_header(h, st->rate ? st->rate : 8000, data);
+    if (fseek(st->f, 0, SEEK_SET) != 0 || fwrite(h, 1, sizeof(h), st->f) != sizeof(h)) {
+        ESP_LOGE(TAG, "%s header update failed", st->file);
+    }
+    fclose(st->f);
+    st->f = NULL;
+    free(st->buf[0]);
+    st->buf[0] = NULL;
+    st->buf[1] = NULL;
+    ESP_LOGI(TAG, "%s: %" PRIu32 " frames, %" PRIu32 " dropped, %" PRIu32 " bytes in %" PRIu32 " writes, worst %" PRIu32 " us", st->file,
+             st->stats.frames, st->stats.dropped, st->stats.bytes, st->stats.flushes, st->stats.flush_worst_us);
+}
+
+static void bt_app_rec_task(void *arg) {
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, (TickType_t)portMAX_DELAY);
+        for (int i = 0; i < BT_APP_REC_MAX; i++) {
+            if (s_rec[i].f) {
+                rec_drain(&s_rec[i]);
+            }
+        }
+        if (__atomic_load_n(&s_rec_active, __ATOMIC_SEQ_CST)) {
+            continue;
+        }
+
+        // stop requested, wait for a frame still being stored
+        while (__atomic_load_n(&s_rec_busy, __ATOMIC_SEQ_CST)) {
+            vTaskDelay(1);
+        }
+        for (int i = 0; i < BT_APP_REC_MAX; i++) {
+            if (s_rec[i].f) {
+                rec_close(&s_rec[i]);
+            }
+        }
+        s_rec_task = NULL;
+        if (s_rec_waiter) {
+            xTaskNotifyGive(s_rec_waiter);
+        }
+        vTaskDelete(NULL);
+    }
+}
+
+bool bt_app_rec_start(uint32_t mask) {
+    if (s_rec_task || (mask & ((1 << BT_APP_REC_MAX) - 1)) == 0) {
+        return false;
+    }
+
+    for (int i = 0; i < BT_APP_REC_MAX; i++) {
+        rec_stream_t *st = &s_rec[i];
+        if (!(mask & (1 << i))) {
+            continue;
+        }
+        // both buffers in one allocation, made before the call so the audio path never allocates
+        st->buf[0] = malloc(2 * BT_APP_REC_BUF_SIZE);
+        st->f = st->buf[0] ? fs_open(st->file, "wb") : NULL;
+        if (st->f == NULL) {
+            ESP_LOGE(TAG, "%s can't record %s", __func__, st->file);
+            free(st->buf[0]);
+            st->buf[0] = NULL;
+            for (int j = 0; j < i; j++) {
+                if (s_rec[j].f) {
+                    fclose(s_rec[j].f);
+                    s_rec[j].f = NULL;
+                    free(s_rec[j].buf[0]);
+                    s_rec[j].buf[0] = NULL;
+                }
+            }
+            return false;
+        }
+        // whole buffers go straight to the file system, no extra copy in stdio
+        setvbuf(st->f, NULL, _IONBF, 0);
+        st->buf[1] = st->buf[0] + BT_APP_REC_BUF_SIZE;
+        st->full[0] = 0;
+        st->full[1] = 0;
+        st->cur = 0;
+        st->flush = 0;
+        st->rate = 0;
+        st->failed = false;
+        memset(&st->stats, 0, sizeof(st->stats));
+        // room for the header, completed when the file is closed
+        memset(st->buf[0], 0, REC_WAV_HEADER_SIZE);
+        st->len[0] = REC_WAV_HEADER_SIZE;
+        st->len[1] = 0;
+    }
+
+    __atomic_store_n(&s_rec_active, 1, __ATOMIC_SEQ_CST);
+    if (xTaskCreate(bt_app_rec_task, "BtAppRecTask", REC_TASK_STACK, NULL, tskIDLE_PRIORITY + 1, &s_rec_task) != pdPASS) {
+        ESP_LOGE(TAG, "%s task create failed", __func__);
+        __atomic_store_n(&s_rec_active, 0, __ATOMIC_SEQ_CST);
+        for (int i = 0; i < BT_APP_REC_MAX; i++) {
+            if (s_rec[i].f) {
+                fclose(s_rec[i].f);
+                s_rec[i].f = NULL;
+                free(s_rec[i].buf[0]);
+                s_rec[i].buf[0] = NULL;
+            }
+        }
+        s_rec_task = NULL;
+        return false;
+    }
+    return true;
+}
+
+void bt_app_rec_stop(void) {
+    TaskHandle_t task = s_rec_task;
+    if (task == NULL) {
+        return;
+    }
+    s_rec_waiter = xTaskGetCurrentTaskHandle();
+    __atomic_store_n(&s_rec_active, 0, __ATOMIC_SEQ_CST);
+    xTaskNotifyGive(task);
+    if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(REC_STOP_TIMEOUT_MS)) == 0) {
+        ESP_LOGW(TAG, "%s writer still busy", __func__);
+    }
+    s_rec_waiter = NULL;
+}
+
+bool bt_app_rec_active(void) {
+    return __atomic_load_n(&s_rec_active, __ATOMIC_SEQ_CST) != 0;
+}
+
+void bt_app_rec_frame(bt_app_rec_dir_t dir, const int16_t *pcm, uint32_t samples, uint32_t sample_rate) {
+    rec_stream_t *st = &s_rec[dir];
+    const uint8_t *src = (const uint8_t *)pcm;
+    uint32_t bytes = samples * sizeof(int16_t);
+
+    __atomic_store_n(&s_rec_busy, 1, __ATOMIC_SEQ_CST);
+    if (!__atomic_load_n(&s_rec_active, __ATOMIC_SEQ_CST) || st->f == NULL || st->failed) {
+        __atomic_store_n(&s_rec_busy, 0, __ATOMIC_SEQ_CST);
+        return;
+    }
+
+    if (st->rate == 0) {
+        st->rate = sample_rate;
+    }
+    uint32_t cur = st->cur;
+    uint32_t room = BT_APP_REC_BUF_SIZE - st->len[cur];
+    // one file holds one sample rate, and a frame only goes in if it fits without waiting for the writer:
+    // one that fills the buffer, even exactly, makes the other buffer current, so that one must be back from flash
+    if (sample_rate != st->rate || (bytes >= room && __atomic_load_n(&st->full[cur ^ 1], __ATOMIC_ACQUIRE))) {
+        st->stats.dropped++;
+        __atomic_store_n(&s_rec_busy, 0, __ATOMIC_SEQ_CST);
+        return;
+    }
+
+    uint32_t n = (bytes < room) ? bytes : room;
+    memcpy(st->buf[cur] + st->len[cur], src, n);
+    st->len[cur] += n;
+    if (st->len[cur] == BT_APP_REC_BUF_SIZE) {
+        __atomic_store_n(&st->full[cur], 1, __ATOMIC_RELEASE);
+        xTaskNotifyGive(s_rec_task);
+        cur ^= 1;
+        st->cur = cur;
+        memcpy(st->buf[cur], src + n, bytes - n);
+        st->len[cur] = bytes - n;
+    }
+    st->stats.frames++;
+    __atomic_store_n(&s_rec_busy, 0, __ATOMIC_SEQ_CST);
+}
+
+void bt_app_rec_get_stats(bt_app_rec_dir_t dir, bt_app_rec_stats_t *stats) {
+    *stats = s_rec[dir].stats;
+}
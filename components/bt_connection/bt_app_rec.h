@@ -0,0 +1,81 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef __BT_APP_REC_H__
+#define __BT_APP_REC_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define BT_APP_REC_BUF_SIZE (4096) // bytes per buffer, written to flash in one piece
+
+typedef enum {
+    BT_APP_REC_IN = 0, /*!< incoming stream, headset microphone */
+    BT_APP_REC_OUT,    /*!< outgoing stream, sent to the headset */
+    BT_APP_REC_MAX,
+} bt_app_rec_dir_t;
+
+typedef struct {
+    uint32_t frames;         /*!< frames stored */
+    uint32_t dropped;        /*!< frames dropped because both buffers were waiting for the writer */
+    uint32_t bytes;          /*!< bytes written to the file */
+    uint32_t flushes;        /*!< buffers written */
+    uint32_t flush_worst_us; /*!< slowest buffer write */
+    uint32_t flush_total_us; /*!< time spent writing buffers */
+    uint32_t errors;         /*!< failed writes, the stream stops at the first one */
+} bt_app_rec_stats_t;
+
+/**
+ * @brief     start recording the directions set in mask (1 << bt_app_rec_dir_t) to LittleFS
+ */
+bool bt_app_rec_start(uint32_t mask);
+
+/**
+ * @brief     stop recording, flushes the buffers and completes the files
+ */
+void bt_app_rec_stop(void);
+
+/**
+ * @brief     true while recording
+ */
+bool bt_app_rec_active(void);
+
+/**
+ * @brief     store one frame of dir, never blocks, the frame is dropped if the writer is behind
+ *
+ *            Both directions must be fed from the same task, the audio producer.
+ */
+void bt_app_rec_frame(bt_app_rec_dir_t dir, const int16_t *pcm, uint32_t samples, uint32_t sample_rate);
+
+/**
+ * @brief     counters of dir
+ */
+void bt_app_rec_get_stats(bt_app_rec_dir_t dir, bt_app_rec_stats_t *stats);
+
+#endif /* __BT_APP_REC_H__ */
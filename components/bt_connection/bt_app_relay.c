@@ -0,0 +1,524 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_hf_ag_api.h"
+#include "esp_hf_client_api.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "audio_frame.h"
+#include "audio_relay.h"
+#include "audio_trace.h"
+#include "bt_app_core.h"
+#include "bt_app_ind.h"
+#include "bt_app_peer.h"
+#include "bt_app_relay.h"
+
+static const char *TAG = "bt_app_relay";
+
+// headset command waiting for the phone's outcome before it is answered
+typedef enum {
+    RELAY_CMD_NONE = 0,
+    RELAY_CMD_ANSWER, /*!< ATA, answered when the phone reports the call active */
+    RELAY_CMD_HANGUP, /*!< AT+CHUP, answered when the phone reports the call or its setup gone */
+    RELAY_CMD_DIAL,   /*!< ATD, answered when the phone reports an outgoing call setup */
+    RELAY_CMD_CLCC,   /*!< AT+CLCC, the phone's list is passed on and closed on its final response */
+} bt_app_relay_cmd_t;
+
+typedef struct {
+    bt_app_relay_cmd_t cmd;
+    esp_bd_addr_t bda;
+    char number[BT_APP_RELAY_NUMBER_MAX];
+} bt_app_relay_pending_t;
+
+// call control state lives in the application task, both profile callbacks are dispatched there
+static bool s_ready = false;
+static esp_bd_addr_t s_phone;
+static esp_hf_client_connection_state_t s_phone_conn = ESP_HF_CLIENT_CONNECTION_STATE_DISCONNECTED;
+static uint32_t s_phone_rate;   // 0 without audio
+static uint32_t s_headset_rate; // 0 without audio
+static esp_bd_addr_t s_headset; // headset carrying the audio
+static bool s_headset_owned;    // its audio link was taken by the relay, not by the HCI data path
+static int s_ind[BT_APP_PEER_INDS];
+static char s_clip[BT_APP_RELAY_NUMBER_MAX];
+static char s_operator[17];
+static bt_app_relay_pending_t s_pending;
+static uint32_t s_commands, s_indicators, s_answered;
+// audio goes from one link's incoming callback to the other link's outgoing callback, converted on the way in
+static audio_relay_t s_down; // phone to headset
+static audio_relay_t s_up;   // headset to phone
+static volatile bool s_running = false;
+
+static void bt_app_relay_phone_in(const uint8_t *buf, uint32_t sz) {
+    if (s_running) {
+        audio_relay_put(&s_down, buf, sz, (uint32_t)esp_timer_get_time());
+        esp_hf_ag_outgoing_data_ready();
+    }
+}
+
+static uint32_t bt_app_relay_phone_out(uint8_t *buf, uint32_t sz) {
+    return s_running ? audio_relay_get(&s_up, buf, sz, (uint32_t)esp_timer_get_time()) : 0;
+}
+
+static void bt_app_relay_headset_in(const uint8_t *buf, uint32_t sz) {
+    if (s_running) {
+        audio_relay_put(&s_up, buf, sz, (uint32_t)esp_timer_get_time());
+        esp_hf_client_outgoing_data_ready();
+    }
+}
+
+static uint32_t bt_app_relay_headset_out(uint8_t *buf, uint32_t sz) {
+    return s_running ? audio_relay_get(&s_down, buf, sz, (uint32_t)esp_timer_get_time()) : 0;
+}
+
+// both legs run while both links have audio, the counters stay until the next call
+static void bt_app_relay_update_audio(void) {
+    bool both = (s_phone_rate != 0 && s_headset_rate != 0);
+    if (both && !s_running) {
+        audio_relay_init(&s_down, s_phone_rate, s_headset_rate);
+        audio_relay_init(&s_up, s_headset_rate, s_phone_rate);
+        s_running = true;
+        ESP_LOGI(TAG, "relaying audio, phone %" PRIu32 " Hz, headset %" PRIu32 " Hz", s_phone_rate, s_headset_rate);
+    } else if (!both && s_running) {
+        s_running = false;
+        bt_app_relay_report();
+    }
+}
+
+// the one audio path is in use by a headset other than peer, through the relay or the HCI data path
+static bool bt_app_relay_audio_busy(const bt_app_peer_t *peer) {
+    if (s_headset_owned) {
+        return true;
+    }
+    for (int i = 0; i < BT_APP_PEER_MAX; i++) {
+        const bt_app_peer_t *other = bt_app_peer_at(i);
+        if (other && other != peer && other->audio != ESP_HF_AUDIO_STATE_DISCONNECTED) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void bt_app_relay_wait(bt_app_relay_cmd_t cmd, esp_bd_addr_t bda, const char *number) {
+    s_pending.cmd = cmd;
+    memcpy(s_pending.bda, bda, ESP_BD_ADDR_LEN);
+    snprintf(s_pending.number, sizeof(s_pending.number), "%s", number ? number : "");
+    s_commands++;
+}
+
+// answer the waiting headset if the phone's indicator is the outcome of its command
+static bool bt_app_relay_resolve(bt_app_peer_t *hs, esp_hf_ciev_report_type_t type, int value) {
+    switch (s_pending.cmd) {
+        case RELAY_CMD_ANSWER:
+            if (type != ESP_HF_IND_TYPE_CALL || value != ESP_HF_CALL_STATUS_CALL_IN_PROGRESS) {
+                return false;
+            }
+            esp_hf_ag_answer_call(hs->bda, 1, 0, ESP_HF_CALL_STATUS_CALL_IN_PROGRESS, ESP_HF_CALL_SETUP_STATUS_IDLE, s_clip, ESP_HF_CALL_ADDR_TYPE_UNKNOWN);
+            break;
+        case RELAY_CMD_HANGUP:
+            if (type == ESP_HF_IND_TYPE_CALL && value == ESP_HF_CALL_STATUS_NO_CALLS) {
+                esp_hf_ag_end_call(hs->bda, 0, 0, ESP_HF_CALL_STATUS_NO_CALLS, ESP_HF_CALL_SETUP_STATUS_IDLE, s_clip, ESP_HF_CALL_ADDR_TYPE_UNKNOWN);
+            } else if (type == ESP_HF_IND_TYPE_CALLSETUP && value == ESP_HF_CALL_SETUP_STATUS_IDLE && s_ind[ESP_HF_IND_TYPE_CALL] == ESP_HF_CALL_STATUS_NO_CALLS) {
+                // a ringing or dialling call that never became active
+                esp_hf_ag_reject_call(hs->bda, 0, 0, ESP_HF_CALL_STATUS_NO_CALLS, ESP_HF_CALL_SETUP_STATUS_IDLE, s_clip, ESP_HF_CALL_ADDR_TYPE_UNKNOWN);
+            } else {
+                return false;
+            }
+            break;
+        case RELAY_CMD_DIAL:
+            if (type != ESP_HF_IND_TYPE_CALLSETUP ||
+                (value != ESP_HF_CALL_SETUP_STATUS_OUTGOING_DIALING && value != ESP_HF_CALL_SETUP_STATUS_OUTGOING_ALERTING)) {
+                return false;
+            }
+            esp_hf_ag_out_call(hs->bda, 0, 0, s_ind[ESP_HF_IND_TYPE_CALL], value, s_pending.number, ESP_HF_CALL_ADDR_TYPE_UNKNOWN);
+            break;
+        default:
+            return false;
+    }
+    // the answer carries the call indicators, the copies below would repeat them
+    hs->ind[ESP_HF_IND_TYPE_CALL] = s_ind[ESP_HF_IND_TYPE_CALL];
+    hs->ind[ESP_HF_IND_TYPE_CALLSETUP] = s_ind[ESP_HF_IND_TYPE_CALLSETUP];
+    s_pending.cmd = RELAY_CMD_NONE;
+    s_answered++;
+    return true;
+}
+
+// an indicator of the phone to every headset, sent to those that do not have it yet
+static void bt_app_relay_indicator(esp_hf_ciev_report_type_t type, int value) {
+    s_ind[type] = value;
+    if (s_pending.cmd != RELAY_CMD_NONE) {
+        bt_app_peer_t *hs = bt_app_peer_get(s_pending.bda);
+        if (hs) {
+            bt_app_relay_resolve(hs, type, value);
+        }
+    }
+    for (int i = 0; i < BT_APP_PEER_MAX; i++) {
+        bt_app_peer_t *peer = bt_app_peer_at(i);
+        if (peer && peer->conn == ESP_HF_CONNECTION_STATE_SLC_CONNECTED) {
+            bt_app_ind_set(peer, type, value);
+            s_indicators++;
+        }
+    }
+}
+
+// the strings of an event belong to the BTC task and are gone once the callback returns
+static void bt_app_relay_copy_param(bt_app_msg_t *msg, void *p_dest, void *p_src) {
+    esp_hf_client_cb_param_t *dst = p_dest;
+    esp_hf_client_cb_param_t *src = p_src;
+
+    switch (msg->event) {
+        case ESP_HF_CLIENT_COPS_CURRENT_OPERATOR_EVT:
+            dst->cops.name = bt_app_msg_strdup(msg, src->cops.name);
+            break;
+        case ESP_HF_CLIENT_CLIP_EVT:
+            dst->clip.number = bt_app_msg_strdup(msg, src->clip.number);
+            break;
+        case ESP_HF_CLIENT_CLCC_EVT:
+            dst->clcc.number = bt_app_msg_strdup(msg, src->clcc.number);
+            break;
+        default:
+            break;
+    }
+}
+
+static void bt_app_relay_client_hdl(uint16_t event, void *p_param) {
+    esp_hf_client_cb_param_t *param = p_param;
+    bt_app_peer_t *peer;
+    switch (event) {
+        case ESP_HF_CLIENT_CONNECTION_STATE_EVT: {
+            ESP_LOGI(TAG, "--phone connection state %d, peer feats 0x%" PRIx32, param->conn_stat.state, param->conn_stat.peer_feat);
+            s_phone_conn = param->conn_stat.state;
+            memcpy(s_phone, param->conn_stat.remote_bda, ESP_BD_ADDR_LEN);
+            if (s_phone_conn == ESP_HF_CLIENT_CONNECTION_STATE_SLC_CONNECTED) {
+                esp_hf_client_query_current_operator_name();
+            } else if (s_phone_conn == ESP_HF_CLIENT_CONNECTION_STATE_DISCONNECTED) {
+                s_pending.cmd = RELAY_CMD_NONE;
+            }
+            break;
+        }
+
+        case ESP_HF_CLIENT_AUDIO_STATE_EVT: {
+            ESP_LOGI(TAG, "--phone audio state %d", param->audio_stat.state);
+            // the headset audio follows the phone's
+            peer = bt_app_peer_selected();
+            if (param->audio_stat.state == ESP_HF_CLIENT_AUDIO_STATE_CONNECTED || param->audio_stat.state == ESP_HF_CLIENT_AUDIO_STATE_CONNECTED_MSBC) {
+                bool wbs = (param->audio_stat.state == ESP_HF_CLIENT_AUDIO_STATE_CONNECTED_MSBC);
+                s_phone_rate = wbs ? WBS_PCM_SAMPLING_RATE_KHZ * 1000 : PCM_SAMPLING_RATE_KHZ * 1000;
+                if (s_headset_rate == 0 && peer && peer->conn == ESP_HF_CONNECTION_STATE_SLC_CONNECTED && peer->audio == ESP_HF_AUDIO_STATE_DISCONNECTED &&
+                    !bt_app_relay_audio_busy(peer)) {
+                    esp_hf_ag_audio_connect(peer->bda);
+                }
+            } else if (param->audio_stat.state == ESP_HF_CLIENT_AUDIO_STATE_DISCONNECTED) {
+                s_phone_rate = 0;
+                if (s_headset_rate != 0) {
+                    esp_hf_ag_audio_disconnect(s_headset);
+                }
+            }
+            bt_app_relay_update_audio();
+            break;
+        }
+
+        case ESP_HF_CLIENT_CIND_CALL_EVT:
+            bt_app_relay_indicator(ESP_HF_IND_TYPE_CALL, param->call.status);
+            break;
+        case ESP_HF_CLIENT_CIND_CALL_SETUP_EVT:
+            bt_app_relay_indicator(ESP_HF_IND_TYPE_CALLSETUP, param->call_setup.status);
+            break;
+        case ESP_HF_CLIENT_CIND_CALL_HELD_EVT:
+            bt_app_relay_indicator(ESP_HF_IND_TYPE_CALLHELD, param->call_held.status);
+            break;
+        case ESP_HF_CLIENT_CIND_SERVICE_AVAILABILITY_EVT:
+            bt_app_relay_indicator(ESP_HF_IND_TYPE_SERVICE, param->service_availability.status);
+            break;
+        case ESP_HF_CLIENT_CIND_SIGNAL_STRENGTH_EVT:
+            bt_app_relay_indicator(ESP_HF_IND_TYPE_SIGNAL, param->signal_strength.value);
+            break;
+        case ESP_HF_CLIENT_CIND_ROAMING_STATUS_EVT:
+            bt_app_relay_indicator(ESP_HF_IND_TYPE_ROAM, param->roaming.status);
+            break;
+        case ESP_HF_CLIENT_CIND_BATTERY_LEVEL_EVT:
+            bt_app_relay_indicator(ESP_HF_IND_TYPE_BATTCHG, param->battery_level.value);
+            break;
+
+        case ESP_HF_CLIENT_COPS_CURRENT_OPERATOR_EVT:
+            snprintf(s_operator, sizeof(s_operator), "%s", param->cops.name ? param->cops.name : "");
+            break;
+
+        case ESP_HF_CLIENT_CLIP_EVT:
+            snprintf(s_clip, sizeof(s_clip), "%s", param->clip.number ? param->clip.number : "");
+            break;
+
+        case ESP_HF_CLIENT_CLCC_EVT: {
+            if (s_pending.cmd == RELAY_CMD_CLCC) {
+                esp_hf_ag_clcc_response(s_pending.bda, param->clcc.idx, param->clcc.dir, param->clcc.status, ESP_HF_CURRENT_CALL_MODE_VOICE, param->clcc.mpty,
+                                        param->clcc.number, ESP_HF_CALL_ADDR_TYPE_UNKNOWN);
+            }
+            break;
+        }
+
+        case ESP_HF_CLIENT_AT_RESPONSE_EVT: {
+            if (s_pending.cmd == RELAY_CMD_CLCC) {
+                // index 0 closes the list with OK
+                esp_hf_ag_clcc_response(s_pending.bda, 0, 0, 0, 0, 0, NULL, 0);
+                s_pending.cmd = RELAY_CMD_NONE;
+                s_answered++;
+            } else if (s_pending.cmd != RELAY_CMD_NONE && param->at_response.code != ESP_HF_AT_RESPONSE_CODE_OK) {
+                ESP_LOGW(TAG, "--phone refused command %d, code %d cme %d", s_pending.cmd, param->at_response.code, param->at_response.cme);
+                esp_hf_ag_cmee_send(s_pending.bda, param->at_response.code, param->at_response.cme);
+                s_pending.cmd = RELAY_CMD_NONE;
+                s_answered++;
+            }
+            break;
+        }
+
+        case ESP_HF_CLIENT_VOLUME_CONTROL_EVT:
+        case ESP_HF_CLIENT_BVRA_EVT:
+        case ESP_HF_CLIENT_BSIR_EVT: {
+            for (int i = 0; i < BT_APP_PEER_MAX; i++) {
+                peer = bt_app_peer_at(i);
+                if (!peer || peer->conn != ESP_HF_CONNECTION_STATE_SLC_CONNECTED) {
+                    continue;
+                }
+                if (event == ESP_HF_CLIENT_VOLUME_CONTROL_EVT) {
+                    esp_hf_ag_volume_control(peer->bda, param->volume_control.type, param->volume_control.volume);
+                    peer->volume[param->volume_control.type] = param->volume_control.volume;
+                } else if (event == ESP_HF_CLIENT_BVRA_EVT) {
+                    esp_hf_ag_vra_control(peer->bda, param->bvra.value);
+                } else {
+                    esp_hf_ag_bsir(peer->bda, param->bsir.state);
+                }
+            }
+            break;
+        }
+
+        case ESP_HF_CLIENT_PROF_STATE_EVT:
+            ESP_LOGI(TAG, "--hands-free profile state changed");
+            break;
+
+        default:
+            break;
+    }
+}
+
+static void bt_app_relay_client_cb(esp_hf_client_cb_event_t event, esp_hf_client_cb_param_t *param) {
+    bt_app_lane_t lane = (event == ESP_HF_CLIENT_AUDIO_STATE_EVT) ? BT_APP_LANE_HIGH : BT_APP_LANE_NORMAL;
+    if (!bt_app_work_dispatch(bt_app_relay_client_hdl, event, param, sizeof(esp_hf_client_cb_param_t), bt_app_relay_copy_param, lane)) {
+        ESP_LOGE(TAG, "phone event %d dropped", event);
+    }
+}
+
+void bt_app_relay_init(void) {
+    esp_hf_client_register_callback(bt_app_relay_client_cb);
+    esp_hf_client_init();
+    esp_hf_client_register_data_callback(bt_app_relay_phone_in, bt_app_relay_phone_out);
+    s_ready = true;
+}
+
+bool bt_app_relay_connect(esp_bd_addr_t bda) {
+    if (!s_ready) {
+        return false;
+    }
+    return esp_hf_client_connect(bda) == ESP_OK;
+}
+
+void bt_app_relay_disconnect(void) {
+    if (s_ready && s_phone_conn != ESP_HF_CLIENT_CONNECTION_STATE_DISCONNECTED) {
+        esp_hf_client_disconnect(s_phone);
+    }
+}
+
+// headset audio the relay carries: a link connected while the phone is and the audio path is free, until it closes.
+// Any other link stays with the HCI data path, which started it and has to stop it.
+static bool bt_app_relay_ag_audio(esp_hf_cb_param_t *param, bt_app_peer_t *peer) {
+    esp_hf_audio_state_t state = param->audio_stat.state;
+    bool connected = (state == ESP_HF_AUDIO_STATE_CONNECTED || state == ESP_HF_AUDIO_STATE_CONNECTED_MSBC);
+
+    if (s_headset_owned) {
+        if (memcmp(s_headset, param->audio_stat.remote_addr, ESP_BD_ADDR_LEN) != 0) {
+            return false;
+        }
+    } else if (!connected || s_phone_conn != ESP_HF_CLIENT_CONNECTION_STATE_SLC_CONNECTED || bt_app_relay_audio_busy(peer)) {
+        return false;
+    }
+
+    if (peer) {
+        peer->audio = state;
+        peer->sync_conn_handle = param->audio_stat.sync_conn_handle;
+    }
+    if (connected) {
+        memcpy(s_headset, param->audio_stat.remote_addr, ESP_BD_ADDR_LEN);
+        s_headset_owned = true;
+        s_headset_rate = (state == ESP_HF_AUDIO_STATE_CONNECTED_MSBC) ? WBS_PCM_SAMPLING_RATE_KHZ * 1000 : PCM_SAMPLING_RATE_KHZ * 1000;
+        esp_hf_ag_register_data_callback(bt_app_relay_headset_in, bt_app_relay_headset_out);
+        if (s_phone_rate == 0 && s_phone_conn == ESP_HF_CLIENT_CONNECTION_STATE_SLC_CONNECTED) {
+            esp_hf_client_connect_audio(s_phone);
+        }
+    } else if (state == ESP_HF_AUDIO_STATE_DISCONNECTED) {
+        s_headset_owned = false;
+        s_headset_rate = 0;
+        if (s_phone_rate != 0) {
+            esp_hf_client_disconnect_audio(s_phone);
+        }
+    }
+    bt_app_relay_update_audio();
+    return true;
+}
+
+bool bt_app_relay_ag_event(esp_hf_cb_event_t event, esp_hf_cb_param_t *param, bt_app_peer_t *peer) {
+    // a relayed link is followed to its end, also when the phone is gone before it
+    if (event == ESP_HF_AUDIO_STATE_EVT) {
+        return bt_app_relay_ag_audio(param, peer);
+    }
+    if (s_phone_conn != ESP_HF_CLIENT_CONNECTION_STATE_SLC_CONNECTED) {
+        return false;
+    }
+
+    switch (event) {
+        case ESP_HF_ATA_RESPONSE_EVT:
+            bt_app_relay_wait(RELAY_CMD_ANSWER, param->ata_rep.remote_addr, NULL);
+            esp_hf_client_answer_call();
+            return true;
+
+        case ESP_HF_CHUP_RESPONSE_EVT:
+            bt_app_relay_wait(RELAY_CMD_HANGUP, param->chup_rep.remote_addr, NULL);
+            esp_hf_client_reject_call();
+            return true;
+
+        case ESP_HF_DIAL_EVT: {
+            const char *num = param->out_call.num_or_loc;
+            bt_app_relay_wait(RELAY_CMD_DIAL, param->out_call.remote_addr, num);
+            if (num && param->out_call.type == ESP_HF_DIAL_MEM) {
+                esp_hf_client_dial_memory(atoi(num));
+            } else {
+                // no number redials the last one
+                esp_hf_client_dial(num);
+            }
+            return true;
+        }
+
+        case ESP_HF_CLCC_RESPONSE_EVT:
+            bt_app_relay_wait(RELAY_CMD_CLCC, param->clcc_rep.remote_addr, NULL);
+            esp_hf_client_query_current_calls();
+            return true;
+
+        case ESP_HF_VTS_RESPONSE_EVT:
+            // one AT+VTS to the phone per digit
+            for (const char *code = param->vts_rep.code; code && *code; code++) {
+                esp_hf_client_send_dtmf(*code);
+                s_commands++;
+            }
+            return true;
+
+        case ESP_HF_BVRA_RESPONSE_EVT:
+            if (param->vra_rep.value == ESP_HF_VR_STATE_ENABLED) {
+                esp_hf_client_start_voice_recognition();
+            } else {
+                esp_hf_client_stop_voice_recognition();
+            }
+            s_commands++;
+            return true;
+
+        case ESP_HF_CIND_RESPONSE_EVT:
+            esp_hf_ag_cind_response(param->cind_rep.remote_addr, s_ind[ESP_HF_IND_TYPE_CALL], s_ind[ESP_HF_IND_TYPE_CALLSETUP], s_ind[ESP_HF_IND_TYPE_SERVICE],
+                                    s_ind[ESP_HF_IND_TYPE_SIGNAL], s_ind[ESP_HF_IND_TYPE_ROAM], s_ind[ESP_HF_IND_TYPE_BATTCHG], s_ind[ESP_HF_IND_TYPE_CALLHELD]);
+            if (peer) {
+                for (int type = ESP_HF_IND_TYPE_CALL; type < BT_APP_PEER_INDS; type++) {
+                    peer->ind[type] = s_ind[type];
+                }
+            }
+            return true;
+
+        case ESP_HF_IND_UPDATE_EVT:
+            if (peer) {
+                for (int type = ESP_HF_IND_TYPE_CALL; type < BT_APP_PEER_INDS; type++) {
+                    bt_app_ind_set(peer, type, s_ind[type]);
+                }
+            }
+            return true;
+
+        case ESP_HF_COPS_RESPONSE_EVT:
+            esp_hf_ag_cops_response(param->cops_rep.remote_addr, s_operator);
+            return true;
+
+        // recorded for the headset as well, not consumed
+        case ESP_HF_VOLUME_CONTROL_EVT:
+            esp_hf_client_volume_update(param->volume_control.type, param->volume_control.volume);
+            s_commands++;
+            return false;
+
+        case ESP_HF_NREC_RESPONSE_EVT:
+            // the hands-free role can only ask the phone to turn its processing off
+            if (param->nrec.state == ESP_HF_NREC_STOP) {
+                esp_hf_client_send_nrec();
+                s_commands++;
+            }
+            return false;
+
+        default:
+            return false;
+    }
+}
+
+void bt_app_relay_get_stats(bt_app_relay_stats_t *st) {
+    st->down = s_down.stats;
+    st->up = s_up.stats;
+    st->down_wait_us[0] = audio_trace_percentile(&s_down.wait, 500);
+    st->down_wait_us[1] = audio_trace_percentile(&s_down.wait, 990);
+    st->up_wait_us[0] = audio_trace_percentile(&s_up.wait, 500);
+    st->up_wait_us[1] = audio_trace_percentile(&s_up.wait, 990);
+    st->down_filter_us = audio_relay_filter_us(&s_down);
+    st->up_filter_us = audio_relay_filter_us(&s_up);
+    st->commands = s_commands;
+    st->indicators = s_indicators;
+    st->answered = s_answered;
+}
+
+void bt_app_relay_report(void) {
+    bt_app_relay_stats_t st;
+    bt_app_relay_get_stats(&st);
+    ESP_LOGI(TAG, "phone -> headset: %" PRIu32 " frames, %" PRIu32 " concealed, %" PRIu32 " dropped, wait %" PRIu32 "/%" PRIu32 " us (p50/p99), filter %" PRIu32 " us",
+             st.down.frames, st.down.concealed, st.down.dropped, st.down_wait_us[0], st.down_wait_us[1], st.down_filter_us);
+    ESP_LOGI(TAG, "headset -> phone: %" PRIu32 " frames, %" PRIu32 " concealed, %" PRIu32 " dropped, wait %" PRIu32 "/%" PRIu32 " us (p50/p99), filter %" PRIu32 " us",
+             st.up.frames, st.up.concealed, st.up.dropped, st.up_wait_us[0], st.up_wait_us[1], st.up_filter_us);
+    ESP_LOGI(TAG, "commands %" PRIu32 " (%" PRIu32 " answered from the phone), indicators %" PRIu32, st.commands, st.answered, st.indicators);
+
+    // a direct connection is one link, the relay adds a second link plus its own wait and conversion
+    uint32_t relay_up = st.up_wait_us[1] + st.up_filter_us;
+    uint32_t relay_down = st.down_wait_us[1] + st.down_filter_us;
+    ESP_LOGI(TAG, "budget mouth -> phone: link %d + relay %" PRIu32 " + link %d = %" PRIu32 " us, %" PRIu32 " us over a direct connection", BT_APP_RELAY_LINK_US,
+             relay_up, BT_APP_RELAY_LINK_US, 2 * BT_APP_RELAY_LINK_US + relay_up, BT_APP_RELAY_LINK_US + relay_up);
+    ESP_LOGI(TAG, "budget phone -> ear: link %d + relay %" PRIu32 " + link %d = %" PRIu32 " us, %" PRIu32 " us over a direct connection", BT_APP_RELAY_LINK_US,
+             relay_down, BT_APP_RELAY_LINK_US, 2 * BT_APP_RELAY_LINK_US + relay_down, BT_APP_RELAY_LINK_US + relay_down);
+}
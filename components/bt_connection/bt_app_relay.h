@@ -0,0 +1,102 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef __BT_APP_RELAY_H__
+#define __BT_APP_RELAY_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_bt_defs.h"
+#include "esp_hf_ag_api.h"
+
+#include "audio_frame.h"
+#include "audio_relay.h"
+#include "bt_app_peer.h"
+
+// hands-free unit to a phone relayed to the headsets, needs CONFIG_BTDM_CTRL_BR_EDR_MAX_SYNC_CONN 2 in sdkconfig, which
+// is left at 1 otherwise: each synchronous link the controller allows reserves its memory whether used or not. The phone
+// takes one of the CONFIG_BTDM_CTRL_BR_EDR_MAX_ACL_CONN links: with the default 2 a single headset is served, raise it
+// for more. The audio of one headset at a time is relayed, the indicators go to all of them.
+#define BT_APP_RELAY_ENABLE 0
+#if BT_APP_RELAY_ENABLE && CONFIG_BTDM_CTRL_BR_EDR_MAX_ACL_CONN < 2
+#error "BT_APP_RELAY_ENABLE needs an ACL link for the phone and one per headset"
+#endif
+#if BT_APP_RELAY_ENABLE && CONFIG_BTDM_CTRL_BR_EDR_MAX_SYNC_CONN < 2
+#error "BT_APP_RELAY_ENABLE needs a synchronous link for the phone and one for the headset, set CONFIG_BTDM_CTRL_BR_EDR_MAX_SYNC_CONN=2"
+#endif
+#define BT_APP_RELAY_NUMBER_MAX (32)
+// one SCO link in the latency budget: the frame is complete before it is sent, then up to one eSCO interval with its retransmission window on air
+#define BT_APP_RELAY_LINK_US (2 * PCM_BLOCK_DURATION_US)
+
+typedef struct {
+    audio_relay_stats_t down;  /*!< phone to headset */
+    audio_relay_stats_t up;    /*!< headset to phone */
+    uint32_t down_wait_us[2];  /*!< median and 99th percentile wait of the phone frames */
+    uint32_t up_wait_us[2];    /*!< median and 99th percentile wait of the headset frames */
+    uint32_t down_filter_us;   /*!< rate conversion delay, phone to headset */
+    uint32_t up_filter_us;     /*!< rate conversion delay, headset to phone */
+    uint32_t commands;         /*!< headset commands forwarded to the phone */
+    uint32_t indicators;       /*!< phone indicators forwarded to the headsets, before coalescing */
+    uint32_t answered;         /*!< forwarded commands answered to the headset from the phone's outcome */
+} bt_app_relay_stats_t;
+
+/**
+ * @brief     register the hands-free role, called once the stack is up
+ */
+void bt_app_relay_init(void);
+
+/**
+ * @brief     connect to the phone at bda as a hands-free unit, false if the relay is not initialised
+ */
+bool bt_app_relay_connect(esp_bd_addr_t bda);
+
+/**
+ * @brief     disconnect from the phone
+ */
+void bt_app_relay_disconnect(void);
+
+/**
+ * @brief     hand an audio gateway event to the relay, true if it was handled there.
+ *            Only consumes events while a phone is connected, and the audio state of the one headset link it carries;
+ *            peer is the headset the event comes from
+ */
+bool bt_app_relay_ag_event(esp_hf_cb_event_t event, esp_hf_cb_param_t *param, bt_app_peer_t *peer);
+
+/**
+ * @brief     counters and latency of the current or last relayed call
+ */
+void bt_app_relay_get_stats(bt_app_relay_stats_t *st);
+
+/**
+ * @brief     log the mouth to ear latency budget of both directions
+ */
+void bt_app_relay_report(void);
+
+#endif /* __BT_APP_RELAY_H__ */
@@ -34,12 +34,15 @@
 
 #include "bt_app_core.h"
 #include "bt_app_hf.h"
+#include "bt_app_prompt.h"
+#include "bt_app_relay.h"
 #include "esp_bt_device.h"
 #include "esp_console.h"
 #include "esp_gap_bt_api.h"
 #include "esp_hf_ag_api.h"
 #include "esp_log.h"
 
+#include "app_audio_msg_set.h"
 #include "app_hf_msg_set.h"
 #include "gpio_pcm_config.h"
 #include "bt_connection.h"
@@ -65,6 +68,11 @@ static void bt_hf_hdl_stack_evt(uint16_t event, void *p_param) {
             // init and register for HFP_AG functions
             esp_hf_ag_init();
 
+#if BT_APP_RELAY_ENABLE
+            // hands-free role towards a phone, relayed to the headsets
+            bt_app_relay_init();
+#endif /* BT_APP_RELAY_ENABLE */
+
             /*
              * Set default parameters for Legacy Pairing
              * Use variable pin, input pin code when pairing
@@ -97,7 +105,7 @@ bt_connection_error_t bt_connection_start(void) {
     bt_app_task_start_up();
 
     /* Bluetooth device name, connection mode and profile set up */
-    bt_app_work_dispatch(bt_hf_hdl_stack_evt, BT_APP_EVT_STACK_UP, NULL, 0, NULL);
+    bt_app_work_dispatch(bt_hf_hdl_stack_evt, BT_APP_EVT_STACK_UP, NULL, 0, NULL, BT_APP_LANE_NORMAL);
 
 #if CONFIG_BT_HFP_AUDIO_DATA_PATH_PCM
     /* configure the PCM interface and PINs used */
@@ -109,6 +117,9 @@ bt_connection_error_t bt_connection_start(void) {
     app_gpio_aec_io_cfg();
 #endif /* ACOUSTIC_ECHO_CANCELLATION_ENABLE */
 
+    /* prompts and ringtones stored on LittleFS */
+    bt_app_prompt_init();
+
     esp_console_repl_t *repl = NULL;
     esp_console_repl_config_t repl_config = ESP_CONSOLE_REPL_CONFIG_DEFAULT();
     esp_console_dev_uart_config_t uart_config = ESP_CONSOLE_DEV_UART_CONFIG_DEFAULT();
@@ -119,6 +130,7 @@ bt_connection_error_t bt_connection_start(void) {
 
     /* Register commands */
     register_hfp_ag();
+    register_audio_cmds();
     printf("\n ==================================================\n");
     printf(" |      'help' to gain overview of commands      |\n");
     printf(" =================================================\n\n");
@@ -32,10 +32,6 @@
 #include "esp_rom_gpio.h"
 #include "soc/gpio_sig_map.h"
 
-#define GPIO_OUTPUT_PCM_FSYNC   (25)
-#define GPIO_OUTPUT_PCM_CLK_OUT (5)
-#define GPIO_OUTPUT_PCM_DOUT    (26)
-#define GPIO_INPUT_PCM_DIN      (35)
 #define GPIO_OUTPUT_PCM_PIN_SEL ((1ULL << GPIO_OUTPUT_PCM_FSYNC) | (1ULL << GPIO_OUTPUT_PCM_CLK_OUT) | (1ULL << GPIO_OUTPUT_PCM_DOUT))
 #define GPIO_INPUT_PCM_PIN_SEL  (1ULL << GPIO_INPUT_PCM_DIN)
 
@@ -44,8 +40,8 @@ void app_gpio_pcm_io_cfg(void) {
     /// configure the PCM output pins
     // disable interrupt
     io_conf.intr_type = GPIO_INTR_DISABLE;
-    // set as output mode
-    io_conf.mode = GPIO_MODE_OUTPUT;
+    // set as output mode, readable back by the I2S bridge listening on the controller
+    io_conf.mode = GPIO_MODE_INPUT_OUTPUT;
     // bit mask of the pins that you want to set,e.g.GPIO18/19
     io_conf.pin_bit_mask = GPIO_OUTPUT_PCM_PIN_SEL;
     // disable pull-down mode
@@ -32,6 +32,13 @@
 
 #define ACOUSTIC_ECHO_CANCELLATION_ENABLE 1
 
+#define GPIO_OUTPUT_PCM_FSYNC   (25)
+#define GPIO_OUTPUT_PCM_CLK_OUT (5)
+#define GPIO_OUTPUT_PCM_DOUT    (26)
+#define GPIO_INPUT_PCM_DIN      (35)
+// codec DAC input, fed by the I2S bridge (the codec ADC drives GPIO_INPUT_PCM_DIN directly)
+#define GPIO_OUTPUT_CODEC_DOUT  (27)
+
 void app_gpio_pcm_io_cfg(void);
 
 #if ACOUSTIC_ECHO_CANCELLATION_ENABLE
@@ -0,0 +1,247 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+
+struct stub_task {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint32_t notify;
+    TaskFunction_t fn;
+    void *arg;
+};
+
+static __thread struct stub_task *s_self;
+
+// deadline ticks from now, on the clock pthread_cond_timedwait uses
+static struct timespec stub_deadline(TickType_t ticks) {
+    struct timespec until;
+    clock_gettime(CLOCK_REALTIME, &until);
+    until.tv_sec += ticks / 1000;
+    until.tv_nsec += (long)(ticks % 1000) * 1000000;
+    if (until.tv_nsec >= 1000000000) {
+        until.tv_sec++;
+        until.tv_nsec -= 1000000000;
+    }
+    return until;
+}
+
+static struct stub_task *stub_task_new(void) {
+    struct stub_task *t = calloc(1, sizeof(*t));
+    if (t) {
+        pthread_mutex_init(&t->lock, NULL);
+        pthread_cond_init(&t->cond, NULL);
+    }
+    return t;
+}
+
+static void *stub_task_main(void *arg) {
+    s_self = arg;
+    s_self->fn(s_self->arg);
+    return NULL;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack, void *arg, UBaseType_t prio, TaskHandle_t *task) {
+    struct stub_task *t = stub_task_new();
+    if (t == NULL) {
+        return pdFAIL;
+    }
+    t->fn = fn;
+    t->arg = arg;
+    if (task) {
+        *task = t;
+    }
+    if (pthread_create(&t->thread, NULL, stub_task_main, t) != 0) {
+        free(t);
+        return pdFAIL;
+    }
+    pthread_detach(t->thread);
+    return pdPASS;
+}
+
+// the handle is kept, a notification may still be given to a task that is gone
+void vTaskDelete(TaskHandle_t task) {
+    if (task == NULL || task == s_self) {
+        pthread_exit(NULL);
+    }
+}
+
+void vTaskDelay(TickType_t ticks) {
+    struct timespec ts = {.tv_sec = ticks / 1000, .tv_nsec = (long)(ticks % 1000) * 1000000};
+    nanosleep(&ts, NULL);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+    if (s_self == NULL) {
+        s_self = stub_task_new();
+    }
+    return s_self;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    pthread_mutex_lock(&task->lock);
+    task->notify++;
+    pthread_cond_signal(&task->cond);
+    pthread_mutex_unlock(&task->lock);
+    return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks) {
+    struct stub_task *t = xTaskGetCurrentTaskHandle();
+    struct timespec until = stub_deadline(ticks);
+
+    pthread_mutex_lock(&t->lock);
+    while (t->notify == 0) {
+        if (ticks == portMAX_DELAY) {
+            pthread_cond_wait(&t->cond, &t->lock);
+        } else if (pthread_cond_timedwait(&t->cond, &t->lock, &until) == ETIMEDOUT) {
+            break;
+        }
+    }
+    uint32_t n = t->notify;
+    if (n) {
+        t->notify = clear ? 0 : n - 1;
+    }
+    pthread_mutex_unlock(&t->lock);
+    return n;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) {
+    return 0;
+}
+
+struct stub_queue {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint32_t len;
+    uint32_t size;
+    uint32_t head;
+    uint32_t count;
+    uint8_t *items;
+};
+
+// waits while the condition of the queue is false, with the lock held; false on timeout
+static bool stub_queue_wait(struct stub_queue *q, bool sending, TickType_t ticks) {
+    struct timespec until = stub_deadline(ticks);
+    while (sending ? q->count == q->len : q->count == 0) {
+        if (ticks == 0) {
+            return false;
+        }
+        if (ticks == portMAX_DELAY) {
+            pthread_cond_wait(&q->cond, &q->lock);
+        } else if (pthread_cond_timedwait(&q->cond, &q->lock, &until) == ETIMEDOUT) {
+            return sending ? q->count < q->len : q->count > 0;
+        }
+    }
+    return true;
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t len, UBaseType_t item_size) {
+    struct stub_queue *q = calloc(1, sizeof(*q));
+    if (q == NULL) {
+        return NULL;
+    }
+    q->items = malloc((size_t)len * item_size);
+    if (q->items == NULL) {
+        free(q);
+        return NULL;
+    }
+    pthread_mutex_init(&q->lock, NULL);
+    pthread_cond_init(&q->cond, NULL);
+    q->len = len;
+    q->size = item_size;
+    return q;
+}
+
+void vQueueDelete(QueueHandle_t q) {
+    pthread_mutex_destroy(&q->lock);
+    pthread_cond_destroy(&q->cond);
+    free(q->items);
+    free(q);
+}
+
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t ticks) {
+    pthread_mutex_lock(&q->lock);
+    if (!stub_queue_wait(q, true, ticks)) {
+        pthread_mutex_unlock(&q->lock);
+        return pdFALSE;
+    }
+    memcpy(q->items + (size_t)((q->head + q->count) % q->len) * q->size, item, q->size);
+    q->count++;
+    pthread_cond_broadcast(&q->cond);
+    pthread_mutex_unlock(&q->lock);
+    return pdTRUE;
+}
+
+static BaseType_t stub_queue_take(QueueHandle_t q, void *item, TickType_t ticks, bool remove) {
+    pthread_mutex_lock(&q->lock);
+    if (!stub_queue_wait(q, false, ticks)) {
+        pthread_mutex_unlock(&q->lock);
+        return pdFALSE;
+    }
+    memcpy(item, q->items + (size_t)q->head * q->size, q->size);
+    if (remove) {
+        q->head = (q->head + 1) % q->len;
+        q->count--;
+        pthread_cond_broadcast(&q->cond);
+    }
+    pthread_mutex_unlock(&q->lock);
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t ticks) {
+    return stub_queue_take(q, item, ticks, true);
+}
+
+BaseType_t xQueuePeek(QueueHandle_t q, void *item, TickType_t ticks) {
+    return stub_queue_take(q, item, ticks, false);
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q) {
+    pthread_mutex_lock(&q->lock);
+    UBaseType_t n = q->count;
+    pthread_mutex_unlock(&q->lock);
+    return n;
+}
+
+int64_t esp_timer_get_time(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
@@ -0,0 +1,141 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "bt_app_core.h"
+#include "test_audio.h"
+
+#define CORE_MSGS (50000) // messages per parameter size
+
+// a callback parameter with a string to deep copy, as the HFP AG events with a number or an AT command
+typedef struct {
+    char *str;
+    uint8_t data[BT_APP_POOL_LARGE];
+} core_param_t;
+
+static const char s_str[] = "+CLIP: \"+15551234567\",145";
+static uint32_t s_calls;
+static uint32_t s_bad;
+static uint32_t s_len;
+
+static void core_fill(uint8_t *data, uint32_t len, uint16_t event) {
+    for (uint32_t i = 0; i < len; i++) {
+        data[i] = (uint8_t)(event + i);
+    }
+}
+
+static void core_cb(uint16_t event, void *param) {
+    const core_param_t *p = param;
+    uint8_t want[BT_APP_POOL_LARGE];
+    uint32_t len = s_len - offsetof(core_param_t, data);
+    core_fill(want, len, event);
+    if (memcmp(p->data, want, len) != 0 || (p->str && strcmp(p->str, s_str) != 0)) {
+        s_bad++;
+    }
+    __atomic_fetch_add(&s_calls, 1, __ATOMIC_RELEASE);
+}
+
+static void core_copy(bt_app_msg_t *msg, void *p_dest, void *p_src) {
+    core_param_t *dst = p_dest;
+    dst->str = bt_app_msg_strdup(msg, ((core_param_t *)p_src)->str);
+}
+
+// CORE_MSGS messages with len bytes of parameter through both lanes, the time per message from the dispatch to the end
+// of its callback
+static int core_run(uint32_t len, bool deep, bt_app_pool_stats_t *delta) {
+    core_param_t param;
+    bt_app_pool_stats_t before, after;
+
+    param.str = deep ? (char *)s_str : NULL;
+    s_len = len;
+    s_calls = 0;
+    s_bad = 0;
+    bt_app_core_get_pool_stats(&before);
+    uint64_t t0 = test_now_ns();
+    for (uint32_t k = 0; k < CORE_MSGS; k++) {
+        core_fill(param.data, len - offsetof(core_param_t, data), (uint16_t)k);
+        TEST_CHECK(bt_app_work_dispatch(core_cb, (uint16_t)k, &param, len, deep ? core_copy : NULL, k & 1 ? BT_APP_LANE_HIGH : BT_APP_LANE_NORMAL));
+    }
+    while (__atomic_load_n(&s_calls, __ATOMIC_ACQUIRE) < CORE_MSGS) {
+        vTaskDelay(0);
+    }
+    double ns = (double)(test_now_ns() - t0) / CORE_MSGS;
+    bt_app_core_get_pool_stats(&after);
+
+    delta->inlined = after.inlined - before.inlined;
+    delta->spills = after.spills - before.spills;
+    delta->fallbacks = after.fallbacks - before.fallbacks;
+    delta->failures = after.failures - before.failures;
+    for (int c = 0; c < BT_APP_POOL_CLASSES; c++) {
+        delta->hits[c] = after.hits[c] - before.hits[c];
+        delta->in_use[c] = after.in_use[c];
+    }
+    printf("    %3u byte parameter%s: %5.0f ns per message, %u inline, %u/%u/%u pool, %u heap\n", (unsigned)len, deep ? " and string" : "           ", ns,
+           (unsigned)delta->inlined, (unsigned)delta->hits[0], (unsigned)delta->hits[1], (unsigned)delta->hits[2], (unsigned)delta->fallbacks);
+    TEST_CHECK(s_calls == CORE_MSGS && s_bad == 0);
+    TEST_CHECK(delta->failures == 0);
+    // every block is back once the last callback has returned
+    TEST_CHECK(delta->in_use[0] == 0 && delta->in_use[1] == 0 && delta->in_use[2] == 0);
+    return 0;
+}
+
+// the parameter of each size goes where the classes say: inline, the smallest class that fits or the heap. The lanes are
+// flooded, deeper than the medium and large classes, so those spill to the next class and the heap
+static int test_core_dispatch(void) {
+    bt_app_pool_stats_t d;
+
+    TEST_CHECK(core_run(BT_APP_MSG_INLINE, false, &d) == 0);
+    TEST_CHECK(d.inlined == CORE_MSGS && d.hits[0] + d.hits[1] + d.hits[2] + d.fallbacks == 0);
+    TEST_CHECK(core_run(28, false, &d) == 0);
+    TEST_CHECK(d.hits[0] == CORE_MSGS && d.spills == 0 && d.fallbacks == 0);
+    // both lanes full hold every small block, one more spills to the next class
+    TEST_CHECK(core_run(28, true, &d) == 0);
+    TEST_CHECK(d.hits[0] + d.hits[1] == 2 * CORE_MSGS && d.spills == d.hits[1] && d.fallbacks == 0);
+    TEST_CHECK(core_run(BT_APP_POOL_MEDIUM, false, &d) == 0);
+    TEST_CHECK(d.hits[0] == 0 && d.hits[1] + d.hits[2] + d.fallbacks == CORE_MSGS && d.spills == d.hits[2]);
+    TEST_CHECK(core_run(BT_APP_POOL_LARGE, false, &d) == 0);
+    TEST_CHECK(d.hits[0] + d.hits[1] == 0 && d.hits[2] + d.fallbacks == CORE_MSGS);
+    TEST_CHECK(core_run(sizeof(core_param_t), false, &d) == 0);
+    TEST_CHECK(d.fallbacks == CORE_MSGS);
+    return 0;
+}
+
+int main(void) {
+    int failed = 0;
+    bt_app_task_start_up();
+    TEST_RUN(test_core_dispatch, failed);
+    bt_app_task_shut_down();
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,179 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "bt_app_peer_tab.h"
+#include "test_audio.h"
+
+#define TAB_MAX  (BT_APP_PEER_SLOTS / 2)
+#define TAB_POOL (40)     // addresses the random operations draw from
+#define TAB_OPS  (200000)
+
+static bt_app_peer_tab_t s_tab;
+
+// reference: the entry of each pool address, -1 when absent
+typedef struct {
+    uint8_t addr[TAB_POOL][BT_APP_PEER_TAB_ADDR];
+    int entry[TAB_POOL];
+    bool taken[TAB_MAX];
+    uint32_t count;
+} tab_ref_t;
+
+static uint32_t s_seed = 1;
+
+static uint32_t tab_rand(uint32_t n) {
+    s_seed = s_seed * 1664525u + 1013904223u;
+    return (s_seed >> 8) % n;
+}
+
+// headsets of one vendor: a shared OUI and serial numbers counting up
+static void tab_vendor_addr(uint8_t *addr, uint32_t serial) {
+    const uint8_t oui[3] = {0x00, 0x1b, 0x66};
+    memcpy(addr, oui, 3);
+    addr[3] = (uint8_t)(serial >> 16);
+    addr[4] = (uint8_t)(serial >> 8);
+    addr[5] = (uint8_t)serial;
+}
+
+static int tab_check_all(tab_ref_t *ref) {
+    for (uint32_t i = 0; i < TAB_POOL; i++) {
+        TEST_CHECK(bt_app_peer_tab_find(&s_tab, ref->addr[i]) == ref->entry[i]);
+    }
+    TEST_CHECK(s_tab.count == ref->count);
+    return 0;
+}
+
+// random adds, removes and lookups, half over sequential and half over random addresses, against a plain array
+static int test_tab_random(void) {
+    static tab_ref_t ref;
+    memset(&ref, 0, sizeof(ref));
+    for (uint32_t i = 0; i < TAB_POOL; i++) {
+        if (i < TAB_POOL / 2) {
+            tab_vendor_addr(ref.addr[i], 0x4000 + i);
+        } else {
+            for (int b = 0; b < BT_APP_PEER_TAB_ADDR; b++) {
+                ref.addr[i][b] = (uint8_t)tab_rand(256);
+            }
+        }
+        ref.entry[i] = -1;
+    }
+    bt_app_peer_tab_init(&s_tab);
+
+    uint32_t adds = 0, removes = 0, refused = 0;
+    for (uint32_t op = 0; op < TAB_OPS; op++) {
+        const uint32_t a = tab_rand(TAB_POOL);
+        switch (tab_rand(3)) {
+        case 0: {
+            int entry = 0;
+            while (entry < TAB_MAX && ref.taken[entry]) {
+                entry++;
+            }
+            bool ok = bt_app_peer_tab_insert(&s_tab, ref.addr[a], (entry < TAB_MAX) ? entry : 0);
+            if (ref.entry[a] >= 0 || entry == TAB_MAX) {
+                TEST_CHECK(!ok);
+                refused += (entry == TAB_MAX && ref.entry[a] < 0);
+            } else {
+                TEST_CHECK(ok);
+                ref.entry[a] = entry;
+                ref.taken[entry] = true;
+                ref.count++;
+                adds++;
+            }
+            break;
+        }
+        case 1:
+            TEST_CHECK(bt_app_peer_tab_remove(&s_tab, ref.addr[a]) == ref.entry[a]);
+            if (ref.entry[a] >= 0) {
+                ref.taken[ref.entry[a]] = false;
+                ref.entry[a] = -1;
+                ref.count--;
+                removes++;
+            }
+            break;
+        default:
+            TEST_CHECK(bt_app_peer_tab_find(&s_tab, ref.addr[a]) == ref.entry[a]);
+            break;
+        }
+        // every address, after every change, in the first part of the run
+        if (op < TAB_OPS / 10) {
+            TEST_CHECK(tab_check_all(&ref) == 0);
+        }
+    }
+    TEST_CHECK(tab_check_all(&ref) == 0);
+    printf("    %u operations: %u added, %u removed, %u refused full; %.2f probes per lookup, at most %u\n", TAB_OPS, (unsigned)adds,
+           (unsigned)removes, (unsigned)refused, (double)s_tab.stats.probes / s_tab.stats.lookups, (unsigned)s_tab.stats.probe_max);
+    TEST_CHECK(refused > 0 && s_tab.stats.full == refused);
+    TEST_CHECK(s_tab.stats.probe_max <= TAB_MAX + 1);
+    return 0;
+}
+
+// n headsets of one vendor looked up in turn, as their HFP events interleave
+static int tab_check_peers(uint32_t n, double max_mean, uint32_t max_probes) {
+    uint8_t addr[TAB_MAX][BT_APP_PEER_TAB_ADDR];
+    bt_app_peer_tab_init(&s_tab);
+    for (uint32_t i = 0; i < n; i++) {
+        tab_vendor_addr(addr[i], 0x12340 + i);
+        TEST_CHECK(bt_app_peer_tab_insert(&s_tab, addr[i], (int)i));
+    }
+    memset(&s_tab.stats, 0, sizeof(s_tab.stats));
+    for (uint32_t k = 0; k < 10000; k++) {
+        for (uint32_t i = 0; i < n; i++) {
+            TEST_CHECK(bt_app_peer_tab_find(&s_tab, addr[i]) == (int)i);
+        }
+    }
+    double mean = (double)s_tab.stats.probes / s_tab.stats.lookups;
+    printf("    %u peers: %.2f probes per lookup, at most %u\n", (unsigned)n, mean, (unsigned)s_tab.stats.probe_max);
+    TEST_CHECK(mean <= max_mean);
+    TEST_CHECK(s_tab.stats.probe_max <= max_probes);
+    return 0;
+}
+
+static int test_tab_peers(void) {
+    TEST_CHECK(tab_check_peers(2, 1.0, 1) == 0);
+    TEST_CHECK(tab_check_peers(4, 1.5, 2) == 0);
+    TEST_CHECK(tab_check_peers(TAB_MAX, 2.0, 4) == 0);
+
+    // and the one more that does not fit
+    uint8_t extra[BT_APP_PEER_TAB_ADDR];
+    tab_vendor_addr(extra, 0x99999);
+    TEST_CHECK(!bt_app_peer_tab_insert(&s_tab, extra, 0));
+    TEST_CHECK(s_tab.stats.full == 1);
+    return 0;
+}
+
+int main(void) {
+    int failed = 0;
+    TEST_RUN(test_tab_random, failed);
+    TEST_RUN(test_tab_peers, failed);
+    return failed ? 1 : 0;
+}
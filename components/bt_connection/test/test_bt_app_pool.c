@@ -0,0 +1,249 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+#include <pthread.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bt_app_pool.h"
+#include "test_audio.h"
+
+#define POOL_THREADS (8)
+#define POOL_BLOCKS  (4 * POOL_THREADS) // two blocks per thread and two for its interrupt, at most
+#define POOL_SIZE    (32)
+#define POOL_OPS     (1000000) // takes per thread
+#define POOL_IRQ_NS  (20000)   // interrupt period of each thread
+#define POOL_BENCH   (1000000)
+
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+
+static uint8_t s_mem[POOL_BLOCKS * POOL_SIZE] __attribute__((aligned(8)));
+static uint8_t s_next[POOL_BLOCKS];
+static bt_app_pool_t s_pool = {POOL_SIZE, POOL_BLOCKS, s_mem, s_next, 0};
+static uint32_t s_owner[POOL_BLOCKS]; // holder of the block plus one, threads then their interrupts
+static uint32_t s_errors;
+static uint32_t s_empty;
+static uint32_t s_irqs;
+static __thread uint32_t s_id;
+static __thread void *s_irq_held;
+
+static uint32_t pool_idx(const void *p) {
+    return ((const uint8_t *)p - s_mem) / POOL_SIZE;
+}
+
+// a block handed out twice shows as an owner already set, or as the mark of another holder in it
+static void pool_claim(void *p, uint32_t id) {
+    if (!bt_app_pool_owns(&s_pool, p) || ((uint8_t *)p - s_mem) % POOL_SIZE || __atomic_exchange_n(&s_owner[pool_idx(p)], id, __ATOMIC_ACQ_REL) != 0) {
+        __atomic_fetch_add(&s_errors, 1, __ATOMIC_RELAXED);
+    }
+    memset(p, (int)id, POOL_SIZE);
+}
+
+static void pool_release(void *p, uint32_t id) {
+    const uint8_t *b = p;
+    for (uint32_t j = 0; j < POOL_SIZE; j++) {
+        if (b[j] != (uint8_t)id) {
+            __atomic_fetch_add(&s_errors, 1, __ATOMIC_RELAXED);
+            break;
+        }
+    }
+    if (__atomic_exchange_n(&s_owner[pool_idx(p)], 0, __ATOMIC_ACQ_REL) != id) {
+        __atomic_fetch_add(&s_errors, 1, __ATOMIC_RELAXED);
+    }
+    bt_app_pool_push(&s_pool, p);
+}
+
+// runs between any two instructions of its thread, maybe between the load of the head and its swap: takes two blocks,
+// gives back the one it held and the first one, the head then shows the same block and count with another next
+static void pool_irq(int sig) {
+    const uint32_t id = s_id + POOL_THREADS;
+    uint32_t used;
+    __atomic_fetch_add(&s_irqs, 1, __ATOMIC_RELAXED);
+    void *a = bt_app_pool_pop(&s_pool, &used);
+    void *b = bt_app_pool_pop(&s_pool, &used);
+    if (s_irq_held) {
+        pool_release(s_irq_held, id);
+        s_irq_held = NULL;
+    }
+    if (a) {
+        pool_claim(a, id);
+        pool_release(a, id);
+    }
+    if (b) {
+        pool_claim(b, id);
+        s_irq_held = b;
+    }
+}
+
+static void *pool_stress(void *arg) {
+    s_id = (uint32_t)(uintptr_t)arg + 1;
+    uint32_t seed = s_id;
+    void *held = NULL;
+
+    timer_t timer;
+    struct sigevent sev = {.sigev_notify = SIGEV_THREAD_ID, .sigev_signo = SIGALRM};
+    sev.sigev_notify_thread_id = gettid();
+    struct itimerspec its = {.it_interval = {0, POOL_IRQ_NS}, .it_value = {0, POOL_IRQ_NS}};
+    if (timer_create(CLOCK_MONOTONIC, &sev, &timer) != 0 || timer_settime(timer, 0, &its, NULL) != 0) {
+        __atomic_fetch_add(&s_errors, 1, __ATOMIC_RELAXED);
+        return NULL;
+    }
+    for (uint32_t k = 0; k < POOL_OPS; k++) {
+        uint32_t used;
+        void *p = bt_app_pool_pop(&s_pool, &used);
+        if (p == NULL) {
+            __atomic_fetch_add(&s_empty, 1, __ATOMIC_RELAXED);
+        } else {
+            if (used > POOL_BLOCKS) {
+                __atomic_fetch_add(&s_errors, 1, __ATOMIC_RELAXED);
+            }
+            pool_claim(p, s_id);
+        }
+        // hold one block, give back the older one or now and then the new one
+        seed = seed * 1664525u + 1013904223u;
+        if (held && p) {
+            pool_release((seed >> 16) & 1 ? held : p, s_id);
+            held = (seed >> 16) & 1 ? p : held;
+        } else if (p) {
+            held = p;
+        }
+    }
+    timer_delete(timer);
+    // the signal mask keeps a late interrupt out while the last blocks go back
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGALRM);
+    pthread_sigmask(SIG_BLOCK, &set, NULL);
+    if (held) {
+        pool_release(held, s_id);
+    }
+    if (s_irq_held) {
+        pool_release(s_irq_held, s_id + POOL_THREADS);
+        s_irq_held = NULL;
+    }
+    return NULL;
+}
+
+// eight threads, each interrupted every 20 us by a handler that takes and gives blocks too: no block is ever held twice,
+// and all of them are free in the end. The same run without the tag in the head hands out blocks twice
+static int test_pool_aba(void) {
+    pthread_t th[POOL_THREADS];
+    struct sigaction sa = {.sa_handler = pool_irq, .sa_flags = SA_RESTART};
+    sigemptyset(&sa.sa_mask);
+    TEST_CHECK(sigaction(SIGALRM, &sa, NULL) == 0);
+
+    bt_app_pool_init(&s_pool);
+    uint64_t t0 = test_now_ns();
+    for (uintptr_t i = 0; i < POOL_THREADS; i++) {
+        TEST_CHECK(pthread_create(&th[i], NULL, pool_stress, (void *)i) == 0);
+    }
+    for (int i = 0; i < POOL_THREADS; i++) {
+        pthread_join(th[i], NULL);
+    }
+    signal(SIGALRM, SIG_IGN);
+    printf("    %u threads, %u takes each, %u interrupts: %u errors, %u found the pool empty, %.1f ms\n", POOL_THREADS, POOL_OPS, (unsigned)s_irqs,
+           (unsigned)s_errors, (unsigned)s_empty, (test_now_ns() - t0) / 1e6);
+    TEST_CHECK(s_errors == 0);
+    TEST_CHECK(bt_app_pool_used(&s_pool) == 0);
+
+    // the free list holds every block exactly once
+    bool seen[POOL_BLOCKS] = {false};
+    uint32_t idx = __atomic_load_n(&s_pool.head, __ATOMIC_ACQUIRE) & BT_APP_POOL_FIELD_MASK, n = 0;
+    while (idx) {
+        TEST_CHECK(idx <= POOL_BLOCKS && !seen[idx - 1] && n < POOL_BLOCKS);
+        seen[idx - 1] = true;
+        idx = s_next[idx - 1];
+        n++;
+    }
+    TEST_CHECK(n == POOL_BLOCKS);
+    return 0;
+}
+
+// a take and a give against malloc and free of a 28 byte parameter, the common HFP AG callback size
+static void *pool_bench_run(void *arg) {
+    bool heap = arg != NULL;
+    uint32_t used;
+    for (uint32_t k = 0; k < POOL_BENCH; k++) {
+        void *p = heap ? malloc(28) : bt_app_pool_pop(&s_pool, &used);
+        // more threads than blocks, a thread that finds the pool empty tries again
+        if (p == NULL) {
+            continue;
+        }
+        *(volatile uint8_t *)p = (uint8_t)k;
+        if (heap) {
+            free(p);
+        } else {
+            bt_app_pool_push(&s_pool, p);
+        }
+    }
+    return NULL;
+}
+
+static double pool_bench(bool heap, int threads) {
+    pthread_t th[POOL_THREADS];
+    double best = 1e9;
+    for (int r = 0; r < 3; r++) {
+        bt_app_pool_init(&s_pool);
+        uint64_t t0 = test_now_ns();
+        for (int i = 0; i < threads; i++) {
+            pthread_create(&th[i], NULL, pool_bench_run, heap ? (void *)1 : NULL);
+        }
+        for (int i = 0; i < threads; i++) {
+            pthread_join(th[i], NULL);
+        }
+        double ns = (double)(test_now_ns() - t0) / ((double)POOL_BENCH * threads);
+        best = ns < best ? ns : best;
+    }
+    return best;
+}
+
+// glibc serves small blocks from a per-thread cache without a lock, the heap of ESP-IDF takes a lock on every call: the
+// host numbers set the pool against the fastest malloc there is, not against the one of the target
+static int test_pool_bench(void) {
+    const int threads[] = {1, 2, 8};
+    for (uint32_t i = 0; i < sizeof(threads) / sizeof(threads[0]); i++) {
+        printf("    %d thread(s): pool %.1f ns, malloc %.1f ns per take and give\n", threads[i], pool_bench(false, threads[i]), pool_bench(true, threads[i]));
+    }
+    TEST_CHECK(bt_app_pool_used(&s_pool) == 0);
+    return 0;
+}
+
+int main(void) {
+    int failed = 0;
+    TEST_RUN(test_pool_aba, failed);
+    TEST_RUN(test_pool_bench, failed);
+    return failed ? 1 : 0;
+}
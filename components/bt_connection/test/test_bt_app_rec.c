@@ -0,0 +1,251 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "audio_frame.h"
+#include "bt_app_rec.h"
+#include "hal_fs.h"
+#include "test_audio.h"
+
+// RAM block device in place of the LittleFS partition, with the erase and program times of a typical SPI NOR flash
+#define BD_BLOCK      (4096)
+#define BD_PAGE       (256)
+#define BD_FILE_MAX   (256 * 1024)
+#define BD_ERASE_US   (45000) // per block, the first write into it
+#define BD_PROG_US    (700)   // per page, partial pages cost a whole one
+
+#define REC_RATE      (16000)
+#define REC_FRAME     (120) // 7.5 ms at 16 kHz
+#define REC_SECONDS   (2)
+#define REC_HEADER    (44)
+
+typedef struct {
+    char name[32];
+    uint8_t img[BD_FILE_MAX];
+    uint32_t size;
+    uint32_t pos;
+    uint32_t erased; // blocks erased so far, a file is written front to back
+} bd_file_t;
+
+static struct {
+    bd_file_t files[BT_APP_REC_MAX];
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    bool stall;   // writes wait until it is cleared
+    bool entered; // a write is waiting on stall
+} s_bd = {.lock = PTHREAD_MUTEX_INITIALIZER, .cond = PTHREAD_COND_INITIALIZER};
+
+static void bd_sleep_us(uint32_t us) {
+    struct timespec ts = {.tv_sec = us / 1000000, .tv_nsec = (long)(us % 1000000) * 1000};
+    nanosleep(&ts, NULL);
+}
+
+static ssize_t bd_write(void *cookie, const char *buf, size_t len) {
+    bd_file_t *f = cookie;
+
+    pthread_mutex_lock(&s_bd.lock);
+    s_bd.entered = true;
+    while (s_bd.stall) {
+        pthread_cond_wait(&s_bd.cond, &s_bd.lock);
+    }
+    pthread_mutex_unlock(&s_bd.lock);
+
+    if (f->pos + len > BD_FILE_MAX) {
+        return 0;
+    }
+    // a rewrite of an erased block is a copy of the block to a fresh one
+    uint32_t first = f->pos / BD_BLOCK, last = (f->pos + len - 1) / BD_BLOCK;
+    uint32_t erase = (last + 1 > f->erased) ? last + 1 - f->erased : 0;
+    if (first < f->erased) {
+        erase++;
+    }
+    if (last + 1 > f->erased) {
+        f->erased = last + 1;
+    }
+    uint32_t pages = (f->pos + len - 1) / BD_PAGE - f->pos / BD_PAGE + 1;
+    bd_sleep_us(erase * BD_ERASE_US + pages * BD_PROG_US);
+
+    memcpy(f->img + f->pos, buf, len);
+    f->pos += len;
+    if (f->pos > f->size) {
+        f->size = f->pos;
+    }
+    return len;
+}
+
+static int bd_seek(void *cookie, off64_t *off, int whence) {
+    bd_file_t *f = cookie;
+    int64_t pos = (whence == SEEK_SET) ? *off : (whence == SEEK_CUR) ? f->pos + *off : f->size + *off;
+    if (pos < 0 || pos > BD_FILE_MAX) {
+        return -1;
+    }
+    f->pos = (uint32_t)pos;
+    *off = pos;
+    return 0;
+}
+
+static int bd_close(void *cookie) {
+    return 0;
+}
+
+FILE *littlefs_fopen(const char *file, const char *mode) {
+    for (int i = 0; i < BT_APP_REC_MAX; i++) {
+        bd_file_t *f = &s_bd.files[i];
+        if (f->name[0] == 0 || strcmp(f->name, file) == 0) {
+            snprintf(f->name, sizeof(f->name), "%s", file);
+            f->size = 0;
+            f->pos = 0;
+            f->erased = 0;
+            cookie_io_functions_t io = {.write = bd_write, .seek = bd_seek, .close = bd_close};
+            return fopencookie(f, mode, io);
+        }
+    }
+    return NULL;
+}
+
+static bd_file_t *bd_find(const char *file) {
+    for (int i = 0; i < BT_APP_REC_MAX; i++) {
+        if (strcmp(s_bd.files[i].name, file) == 0) {
+            return &s_bd.files[i];
+        }
+    }
+    return NULL;
+}
+
+static uint32_t rd_le(const uint8_t *p, int bytes) {
+    uint32_t v = 0;
+    for (int i = bytes - 1; i >= 0; i--) {
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+// samples count up from first, so a lost, doubled or overwritten frame shows in the file
+static void rec_pattern(int16_t *pcm, uint32_t n, uint16_t first) {
+    for (uint32_t i = 0; i < n; i++) {
+        pcm[i] = (int16_t)(first + i);
+    }
+}
+
+static int rec_check_file(const char *file, const int16_t *expect, uint32_t samples) {
+    bd_file_t *f = bd_find(file);
+    TEST_CHECK(f != NULL);
+    TEST_CHECK(f->size == REC_HEADER + samples * sizeof(int16_t));
+    TEST_CHECK(memcmp(f->img, "RIFF", 4) == 0 && memcmp(f->img + 8, "WAVEfmt ", 8) == 0);
+    TEST_CHECK(rd_le(f->img + 24, 4) == REC_RATE);
+    TEST_CHECK(rd_le(f->img + 40, 4) == samples * sizeof(int16_t));
+    TEST_CHECK(memcmp(f->img + REC_HEADER, expect, samples * sizeof(int16_t)) == 0);
+    return 0;
+}
+
+// 16 kHz mono in 7.5 ms frames at the real pace, for as long as several erase blocks take to fill
+static int test_rec_sustained(void) {
+    static int16_t all[REC_RATE * REC_SECONDS];
+    const uint32_t frames = REC_RATE * REC_SECONDS / REC_FRAME;
+    bt_app_rec_stats_t st;
+    struct timespec next;
+
+    rec_pattern(all, frames * REC_FRAME, 0);
+    TEST_CHECK(bt_app_rec_start(1 << BT_APP_REC_IN));
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    for (uint32_t i = 0; i < frames; i++) {
+        bt_app_rec_frame(BT_APP_REC_IN, all + i * REC_FRAME, REC_FRAME, REC_RATE);
+        next.tv_nsec += PCM_BLOCK_DURATION_US * 1000;
+        if (next.tv_nsec >= 1000000000) {
+            next.tv_sec++;
+            next.tv_nsec -= 1000000000;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+    }
+    bt_app_rec_stop();
+    bt_app_rec_get_stats(BT_APP_REC_IN, &st);
+
+    double need = REC_RATE * sizeof(int16_t);
+    double rate = st.flush_total_us ? st.bytes * 1e6 / st.flush_total_us : 0.0;
+    printf("    %u frames, %u dropped, %u bytes in %u writes, worst %u us\n", (unsigned)st.frames, (unsigned)st.dropped, (unsigned)st.bytes,
+           (unsigned)st.flushes, (unsigned)st.flush_worst_us);
+    printf("    writer %.0f B/s against %.0f B/s of 16 kHz mono, %.1fx\n", rate, need, rate / need);
+    TEST_CHECK(st.frames == frames && st.dropped == 0 && st.errors == 0);
+    TEST_CHECK(rate > need);
+    // a buffer is on flash before the other one fills
+    TEST_CHECK(st.flush_worst_us < BT_APP_REC_BUF_SIZE * 1000000ull / (REC_RATE * sizeof(int16_t)));
+    TEST_CHECK(rec_check_file("rec_in.wav", all, frames * REC_FRAME) == 0);
+    return 0;
+}
+
+// a frame that exactly fills the buffer while the other is still on its way to flash is dropped, not written over it
+static int test_rec_full_buffer(void) {
+    static int16_t pcm[BT_APP_REC_BUF_SIZE / 2], expect[BT_APP_REC_BUF_SIZE];
+    const uint32_t a = (BT_APP_REC_BUF_SIZE - REC_HEADER) / 2, b = BT_APP_REC_BUF_SIZE / 2;
+    bt_app_rec_stats_t st;
+
+    s_bd.stall = true;
+    s_bd.entered = false;
+    TEST_CHECK(bt_app_rec_start(1 << BT_APP_REC_IN));
+
+    // fills the first buffer behind the header, the writer takes it and stalls
+    rec_pattern(pcm, a, 0);
+    memcpy(expect, pcm, a * sizeof(int16_t));
+    bt_app_rec_frame(BT_APP_REC_IN, pcm, a, REC_RATE);
+    while (!__atomic_load_n(&s_bd.entered, __ATOMIC_ACQUIRE)) {
+        sched_yield();
+    }
+    // exactly the room of the second buffer, taking it would make the first one current again
+    rec_pattern(pcm, b, 10000);
+    bt_app_rec_frame(BT_APP_REC_IN, pcm, b, REC_RATE);
+    rec_pattern(pcm, REC_FRAME, 30000);
+    memcpy(expect + a, pcm, REC_FRAME * sizeof(int16_t));
+    bt_app_rec_frame(BT_APP_REC_IN, pcm, REC_FRAME, REC_RATE);
+
+    pthread_mutex_lock(&s_bd.lock);
+    s_bd.stall = false;
+    pthread_cond_broadcast(&s_bd.cond);
+    pthread_mutex_unlock(&s_bd.lock);
+    bt_app_rec_stop();
+
+    bt_app_rec_get_stats(BT_APP_REC_IN, &st);
+    printf("    %u frames, %u dropped, %u bytes\n", (unsigned)st.frames, (unsigned)st.dropped, (unsigned)st.bytes);
+    TEST_CHECK(st.frames == 2 && st.dropped == 1);
+    TEST_CHECK(rec_check_file("rec_in.wav", expect, a + REC_FRAME) == 0);
+    return 0;
+}
+
+int main(void) {
+    int failed = 0;
+    TEST_RUN(test_rec_full_buffer, failed);
+    TEST_RUN(test_rec_sustained, failed);
+    return failed ? 1 : 0;
+}
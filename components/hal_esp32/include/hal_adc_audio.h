@@ -0,0 +1,94 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef HAL_ADC_AUDIO_H_
+#define HAL_ADC_AUDIO_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "audio_decim.h"
+
+#define HAL_ADC_AUDIO_PRIME (2) // frames captured before the consumer gets any, again after running dry
+
+typedef struct {
+    int channel;       /**< ADC1 channel of the microphone amplifier */
+    uint8_t task_prio; /**< priority of the capture task */
+} hal_adc_audio_config_t; /**< ADC microphone */
+
+typedef struct {
+    uint32_t frames;           /**< frames captured */
+    uint32_t dropped;          /**< frames lost because the consumer was behind */
+    uint32_t overflows;        /**< conversion frames lost inside the ADC driver */
+    uint32_t dry;              /**< frames asked for while none was captured */
+    int32_t trim_ppb;          /**< rate trim of the captured frames, positive when the ADC clock is faster than the air */
+    audio_decim_stats_t decim; /**< decimator counters */
+} hal_adc_audio_stats_t;  /**< ADC microphone counters */
+
+/**
+ * @brief Start capturing frames at sample_rate
+ *
+ * The ADC runs in continuous mode at AUDIO_DECIM_IN_RATE with one 7.5 ms block per DMA conversion frame, so every
+ * completion gives exactly one output frame. A task decimates each block and passes it through a 1:1 audio_asrc into a
+ * frame queue; the converter is trimmed to hold the queue at HAL_ADC_AUDIO_PRIME frames while the audio task takes them
+ * on the air clock, so clock offsets do not slip whole frames. On the ESP32 the ADC DMA goes through I2S0, which is then
+ * not available for anything else.
+ *
+ * @param cfg channel and task priority
+ * @param sample_rate 8000 or 16000
+ * @return true if running
+ */
+bool hal_adc_audio_start(const hal_adc_audio_config_t *cfg, uint32_t sample_rate);
+
+/**
+ * @brief Stop capturing and log the counters
+ */
+void hal_adc_audio_stop(void);
+
+/**
+ * @brief Oldest captured frame, valid until hal_adc_audio_release
+ *
+ * @param samples frame length, as at start
+ * @return the frame in place, NULL if none is ready
+ */
+const int16_t *hal_adc_audio_peek(uint32_t samples);
+
+/**
+ * @brief Release the frame returned by hal_adc_audio_peek
+ */
+void hal_adc_audio_release(void);
+
+/**
+ * @brief Counters of the current or last run
+ *
+ * @param stats filled in
+ */
+void hal_adc_audio_get_stats(hal_adc_audio_stats_t *stats);
+
+#endif /* HAL_ADC_AUDIO_H_ */
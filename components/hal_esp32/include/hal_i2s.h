@@ -0,0 +1,73 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef HAL_I2S_H_
+#define HAL_I2S_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "audio_bridge.h"
+
+#define HAL_I2S_PIN_UNUSED (-1)
+
+typedef enum {
+    HAL_I2S_FMT_PHILIPS = 0, /**< standard I2S, word select a sample wide */
+    HAL_I2S_FMT_PCM_SHORT,   /**< PCM short frame sync, as driven by the Bluetooth controller PCM interface */
+} hal_i2s_fmt_t;             /**< serial frame format */
+
+typedef struct {
+    int port;          /**< I2S peripheral, 0 or 1 */
+    bool slave;        /**< bit clock and word select are inputs */
+    hal_i2s_fmt_t fmt; /**< serial frame format */
+    int mclk;          /**< master clock output, HAL_I2S_PIN_UNUSED if the codec needs none */
+    int bclk;          /**< bit clock */
+    int ws;            /**< word select / frame sync */
+    int dout;          /**< data to the codec */
+    int din;           /**< data from the codec */
+    uint8_t task_prio; /**< priority of the task running the frame callback */
+} hal_i2s_config_t;    /**< I2S port behind an audio bridge */
+
+/**
+ * @brief Bridge driver for the ESP32 I2S peripheral
+ *
+ * Mono 16 bit, full duplex, two DMA buffers of one frame per direction. Frames are serviced by a task woken from the
+ * DMA interrupt. An unserviced transmit buffer is cleared by the driver, so an underrun plays silence.
+ */
+extern const audio_bridge_ops_t hal_i2s_bridge_ops;
+
+/**
+ * @brief Driver instance for the bridge
+ *
+ * @param cfg port and pins, copied
+ * @return driver for audio_bridge_init, NULL if the port does not exist
+ */
+void *hal_i2s_driver(const hal_i2s_config_t *cfg);
+
+#endif /* HAL_I2S_H_ */
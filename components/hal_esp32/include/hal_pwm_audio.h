@@ -0,0 +1,92 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef HAL_PWM_AUDIO_H_
+#define HAL_PWM_AUDIO_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "audio_pwm.h"
+
+#define HAL_PWM_AUDIO_PRIME (2) // frames queued before playback starts or resumes after running dry
+
+typedef struct {
+    int port;          /**< I2S peripheral used as the PWM serialiser */
+    int pin;           /**< PWM output, to the RC filter and the amplifier */
+    uint8_t task_prio; /**< priority of the refill task */
+} hal_pwm_audio_config_t; /**< PWM audio output */
+
+typedef struct {
+    uint32_t queued;         /**< frames accepted by hal_pwm_audio_write */
+    uint32_t dropped;        /**< frames refused, the queue was full */
+    uint32_t refills;        /**< DMA buffers refilled */
+    uint32_t silent;         /**< DMA buffers refilled with silence, the queue was dry */
+    uint32_t missed;         /**< DMA buffers played again because the refill came too late */
+    uint32_t convert_max_us; /**< slowest refill */
+    int32_t trim_ppb;        /**< rate trim of the queued frames, positive when the air clock is faster than the APLL */
+    audio_pwm_stats_t pwm;   /**< converter counters */
+} hal_pwm_audio_stats_t;  /**< PWM audio output counters */
+
+/**
+ * @brief Start the PWM output for frames at sample_rate
+ *
+ * The I2S port shifts out one 32 bit word per PWM period at AUDIO_PWM_RATE from two DMA buffers of one frame. The DMA
+ * interrupt hands each played buffer to a task that refills it in place from the frame queue through audio_pwm. The
+ * frames come on the air clock and play on the APLL, so they pass a 1:1 audio_asrc trimmed to hold the queue at
+ * HAL_PWM_AUDIO_PRIME frames; clock offsets do not slip whole frames.
+ *
+ * @param cfg port, pin and task priority
+ * @param sample_rate 8000 or 16000
+ * @return true if running
+ */
+bool hal_pwm_audio_start(const hal_pwm_audio_config_t *cfg, uint32_t sample_rate);
+
+/**
+ * @brief Stop the PWM output and log its counters
+ */
+void hal_pwm_audio_stop(void);
+
+/**
+ * @brief Queue one frame for playback, never blocks
+ *
+ * @param pcm samples, copied
+ * @param samples frame length, as at start
+ * @return false if the frame was dropped
+ */
+bool hal_pwm_audio_write(const int16_t *pcm, uint32_t samples);
+
+/**
+ * @brief Counters of the current or last run
+ *
+ * @param stats filled in
+ */
+void hal_pwm_audio_get_stats(hal_pwm_audio_stats_t *stats);
+
+#endif /* HAL_PWM_AUDIO_H_ */
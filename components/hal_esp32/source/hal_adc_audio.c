@@ -0,0 +1,215 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_adc/adc_continuous.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+
+#include "audio_asrc.h"
+#include "audio_decim.h"
+#include "audio_frame.h"
+#include "audio_ring.h"
+#include "hal_adc_audio.h"
+
+static const char *TAG = "hal_adc_audio";
+
+#define HAL_ADC_AUDIO_CONV       (AUDIO_DECIM_IN_RATE / 1000 * PCM_BLOCK_DURATION_US / 1000) // conversions per frame, 480
+#define HAL_ADC_AUDIO_POOL       (4) // conversion frames the driver can hold
+#define HAL_ADC_AUDIO_TASK_STACK (3072)
+
+static adc_continuous_handle_t s_adc = NULL;
+static TaskHandle_t s_task = NULL;
+static audio_decim_t s_decim;
+// frames from the capture task to the audio task
+static audio_ring_t s_frames;
+static uint32_t s_read_us; // last frame released by the audio task, the fill is interpolated from it
+// the ADC runs on its own clock, the frames reach the air clock through a 1:1 converter trimmed by the queue fill
+static audio_asrc_t s_asrc;
+static uint32_t s_samples;
+static bool s_primed;
+static uint16_t s_raw[HAL_ADC_AUDIO_CONV] __attribute__((aligned(4)));
+static int16_t s_block[WBS_PCM_FRAME_SAMPLES];
+static hal_adc_audio_stats_t s_stats;
+
+static bool IRAM_ATTR hal_adc_audio_on_conv_done(adc_continuous_handle_t handle, const adc_continuous_evt_data_t *edata, void *user_data) {
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(s_task, &woken);
+    return woken == pdTRUE;
+}
+
+static bool IRAM_ATTR hal_adc_audio_on_pool_ovf(adc_continuous_handle_t handle, const adc_continuous_evt_data_t *edata, void *user_data) {
+    s_stats.overflows++;
+    return false;
+}
+
+static void hal_adc_audio_task(void *arg) {
+    uint32_t len;
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, (TickType_t)portMAX_DELAY);
+        while (adc_continuous_read(s_adc, (uint8_t *)s_raw, sizeof(s_raw), &len, 0) == ESP_OK && len == sizeof(s_raw)) {
+#if CONFIG_IDF_TARGET_ESP32
+            // the I2S based ADC DMA stores each pair of conversions in swapped order
+            uint32_t *pair = (uint32_t *)s_raw;
+            for (uint32_t i = 0; i < HAL_ADC_AUDIO_CONV / 2; i++) {
+                pair[i] = (pair[i] >> 16) | (pair[i] << 16);
+            }
+#endif
+            audio_decim_process(&s_decim, s_raw, HAL_ADC_AUDIO_CONV, s_block, s_samples);
+            audio_asrc_put(&s_asrc, s_block);
+            // the audio task takes whole frames, the part of the next one already due is no longer queued;
+            // the loop only runs while it takes them
+            uint32_t since_us = (uint32_t)esp_timer_get_time() - __atomic_load_n(&s_read_us, __ATOMIC_RELAXED);
+            if (since_us <= 2 * PCM_BLOCK_DURATION_US) {
+                if (since_us > PCM_BLOCK_DURATION_US) {
+                    since_us = PCM_BLOCK_DURATION_US;
+                }
+                audio_asrc_track(&s_asrc, (int32_t)(audio_ring_count(&s_frames) * s_samples) - (int32_t)(since_us * s_samples / PCM_BLOCK_DURATION_US));
+            }
+            // a trimmed block may complete no frame or, rarely, two
+            for (const int16_t *pcm = audio_asrc_peek(&s_asrc); pcm; pcm = audio_asrc_peek(&s_asrc)) {
+                int16_t *frame = (int16_t *)audio_ring_write_begin(&s_frames);
+                if (frame) {
+                    memcpy(frame, pcm, s_samples * BYTES_PER_SAMPLE);
+                    audio_ring_write_commit(&s_frames);
+                    s_stats.frames++;
+                } else {
+                    s_stats.dropped++;
+                }
+                audio_asrc_release(&s_asrc);
+            }
+        }
+    }
+}
+
+bool hal_adc_audio_start(const hal_adc_audio_config_t *cfg, uint32_t sample_rate) {
+    if (s_adc != NULL || !audio_decim_init(&s_decim, sample_rate)) {
+        return false;
+    }
+    s_samples = HAL_ADC_AUDIO_CONV / s_decim.factor;
+    if (!audio_asrc_init(&s_asrc, sample_rate, s_samples, HAL_ADC_AUDIO_PRIME * s_samples)) {
+        return false;
+    }
+    audio_ring_init(&s_frames, s_samples * BYTES_PER_SAMPLE);
+    s_read_us = (uint32_t)esp_timer_get_time() - 4 * PCM_BLOCK_DURATION_US;
+    s_primed = false;
+    memset(&s_stats, 0, sizeof(hal_adc_audio_stats_t));
+
+    adc_continuous_handle_cfg_t handle_cfg = {
+        .max_store_buf_size = HAL_ADC_AUDIO_POOL * sizeof(s_raw),
+        .conv_frame_size = sizeof(s_raw),
+    };
+    if (adc_continuous_new_handle(&handle_cfg, &s_adc) != ESP_OK) {
+        ESP_LOGE(TAG, "no ADC handle");
+        s_adc = NULL;
+        return false;
+    }
+    adc_digi_pattern_config_t pattern = {
+        .atten = ADC_ATTEN_DB_12,
+        .channel = cfg->channel,
+        .unit = ADC_UNIT_1,
+        .bit_width = AUDIO_DECIM_IN_BITS,
+    };
+    adc_continuous_config_t dig_cfg = {
+        .pattern_num = 1,
+        .adc_pattern = &pattern,
+        .sample_freq_hz = AUDIO_DECIM_IN_RATE,
+        .conv_mode = ADC_CONV_SINGLE_UNIT_1,
+        .format = ADC_DIGI_OUTPUT_FORMAT_TYPE1,
+    };
+    if (adc_continuous_config(s_adc, &dig_cfg) != ESP_OK) {
+        ESP_LOGE(TAG, "channel %d refused", cfg->channel);
+        adc_continuous_deinit(s_adc);
+        s_adc = NULL;
+        return false;
+    }
+
+    adc_continuous_evt_cbs_t cbs = {
+        .on_conv_done = hal_adc_audio_on_conv_done,
+        .on_pool_ovf = hal_adc_audio_on_pool_ovf,
+    };
+    xTaskCreate(hal_adc_audio_task, "HalAdcAudioTask", HAL_ADC_AUDIO_TASK_STACK, NULL, cfg->task_prio, &s_task);
+    adc_continuous_register_event_callbacks(s_adc, &cbs, NULL);
+    adc_continuous_start(s_adc);
+    ESP_LOGI(TAG, "channel %d: %d Hz to %" PRIu32 " Hz, %" PRIu32 " samples per frame", cfg->channel, AUDIO_DECIM_IN_RATE, sample_rate, s_samples);
+    return true;
+}
+
+void hal_adc_audio_stop(void) {
+    if (s_adc == NULL) {
+        return;
+    }
+    adc_continuous_stop(s_adc);
+    if (s_task) {
+        vTaskDelete(s_task);
+        s_task = NULL;
+    }
+    adc_continuous_deinit(s_adc);
+    s_adc = NULL;
+    s_stats.decim = s_decim.stats;
+    s_stats.trim_ppb = s_asrc.drift.ppb;
+    ESP_LOGI(TAG, "frames %" PRIu32 ", dropped %" PRIu32 ", overflows %" PRIu32 ", dry %" PRIu32 ", clipped %" PRIu32, s_stats.frames, s_stats.dropped,
+             s_stats.overflows, s_stats.dry, s_decim.stats.clipped);
+    ESP_LOGI(TAG, "ADC clock trimmed %+.1f ppm to the air, fill error %" PRId32 "..%" PRId32 " samples", s_asrc.drift.ppb / 1000.0f, s_asrc.drift.err_min,
+             s_asrc.drift.err_max);
+    audio_ring_init(&s_frames, 0);
+}
+
+const int16_t *hal_adc_audio_peek(uint32_t samples) {
+    if (samples != s_samples || s_frames.frame_size == 0) {
+        return NULL;
+    }
+    if (!s_primed && audio_ring_count(&s_frames) >= HAL_ADC_AUDIO_PRIME) {
+        s_primed = true;
+    }
+    const int16_t *frame = s_primed ? (const int16_t *)audio_ring_read_begin(&s_frames) : NULL;
+    if (frame == NULL) {
+        s_primed = false;
+        s_stats.dry++;
+    }
+    return frame;
+}
+
+void hal_adc_audio_release(void) {
+    audio_ring_read_commit(&s_frames);
+    __atomic_store_n(&s_read_us, (uint32_t)esp_timer_get_time(), __ATOMIC_RELAXED);
+}
+
+void hal_adc_audio_get_stats(hal_adc_audio_stats_t *stats) {
+    *stats = s_stats;
+    stats->decim = s_decim.stats;
+    stats->trim_ppb = s_asrc.drift.ppb;
+}
@@ -0,0 +1,174 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "driver/i2s_std.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "audio_bridge.h"
+#include "hal_i2s.h"
+
+static const char *TAG = "hal_i2s";
+
+#define HAL_I2S_PORTS      (2)
+#define HAL_I2S_TASK_STACK (3072)
+
+typedef struct {
+    hal_i2s_config_t cfg;
+    i2s_chan_handle_t tx;
+    i2s_chan_handle_t rx;
+    audio_bridge_t *bridge;
+    TaskHandle_t task;
+} hal_i2s_t;
+
+static hal_i2s_t s_i2s[HAL_I2S_PORTS];
+
+static bool IRAM_ATTR hal_i2s_on_recv(i2s_chan_handle_t handle, i2s_event_data_t *event, void *user_ctx) {
+    hal_i2s_t *i2s = (hal_i2s_t *)user_ctx;
+    BaseType_t woken = pdFALSE;
+    if (audio_bridge_rx_done(i2s->bridge, (int16_t *)event->dma_buf)) {
+        vTaskNotifyGiveFromISR(i2s->task, &woken);
+    }
+    return woken == pdTRUE;
+}
+
+static bool IRAM_ATTR hal_i2s_on_sent(i2s_chan_handle_t handle, i2s_event_data_t *event, void *user_ctx) {
+    hal_i2s_t *i2s = (hal_i2s_t *)user_ctx;
+    BaseType_t woken = pdFALSE;
+    if (audio_bridge_tx_done(i2s->bridge, (int16_t *)event->dma_buf)) {
+        vTaskNotifyGiveFromISR(i2s->task, &woken);
+    }
+    return woken == pdTRUE;
+}
+
+static void hal_i2s_task(void *arg) {
+    hal_i2s_t *i2s = (hal_i2s_t *)arg;
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, (TickType_t)portMAX_DELAY);
+        audio_bridge_service(i2s->bridge);
+    }
+}
+
+static void hal_i2s_release(hal_i2s_t *i2s) {
+    if (i2s->tx) {
+        i2s_del_channel(i2s->tx);
+        i2s->tx = NULL;
+    }
+    if (i2s->rx) {
+        i2s_del_channel(i2s->rx);
+        i2s->rx = NULL;
+    }
+}
+
+static bool hal_i2s_start(void *drv, audio_bridge_t *bridge) {
+    hal_i2s_t *i2s = (hal_i2s_t *)drv;
+
+    i2s_chan_config_t chan_cfg = I2S_CHANNEL_DEFAULT_CONFIG(i2s->cfg.port, i2s->cfg.slave ? I2S_ROLE_SLAVE : I2S_ROLE_MASTER);
+    // one frame per DMA buffer, two of them: the task writes one while the other plays
+    chan_cfg.dma_desc_num = AUDIO_BRIDGE_SLOTS;
+    chan_cfg.dma_frame_num = bridge->samples;
+    chan_cfg.auto_clear_after_cb = true;
+    if (i2s_new_channel(&chan_cfg, &i2s->tx, &i2s->rx) != ESP_OK) {
+        ESP_LOGE(TAG, "port %d: no channel", i2s->cfg.port);
+        return false;
+    }
+
+    i2s_std_config_t std_cfg = {
+        .clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(bridge->sample_rate),
+        .slot_cfg = I2S_STD_PHILIPS_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_16BIT, I2S_SLOT_MODE_MONO),
+        .gpio_cfg = {
+            .mclk = i2s->cfg.mclk,
+            .bclk = i2s->cfg.bclk,
+            .ws = i2s->cfg.ws,
+            .dout = i2s->cfg.dout,
+            .din = i2s->cfg.din,
+        },
+    };
+    if (i2s->cfg.fmt == HAL_I2S_FMT_PCM_SHORT) {
+        i2s_std_slot_config_t pcm = I2S_STD_PCM_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_16BIT, I2S_SLOT_MODE_MONO);
+        std_cfg.slot_cfg = pcm;
+    }
+    if (i2s_channel_init_std_mode(i2s->tx, &std_cfg) != ESP_OK || i2s_channel_init_std_mode(i2s->rx, &std_cfg) != ESP_OK) {
+        ESP_LOGE(TAG, "port %d: std mode at %" PRIu32 " Hz refused", i2s->cfg.port, bridge->sample_rate);
+        hal_i2s_release(i2s);
+        return false;
+    }
+
+    i2s_event_callbacks_t rx_cbs = { .on_recv = hal_i2s_on_recv };
+    i2s_event_callbacks_t tx_cbs = { .on_sent = hal_i2s_on_sent };
+    i2s_channel_register_event_callback(i2s->rx, &rx_cbs, i2s);
+    i2s_channel_register_event_callback(i2s->tx, &tx_cbs, i2s);
+
+    i2s->bridge = bridge;
+    xTaskCreate(hal_i2s_task, "HalI2sTask", HAL_I2S_TASK_STACK, i2s, i2s->cfg.task_prio, &i2s->task);
+    i2s_channel_enable(i2s->tx);
+    i2s_channel_enable(i2s->rx);
+    ESP_LOGI(TAG, "port %d: %" PRIu32 " Hz, %" PRIu32 " samples per frame, %s", i2s->cfg.port, bridge->sample_rate, bridge->samples,
+             i2s->cfg.slave ? "slave" : "master");
+    return true;
+}
+
+static void hal_i2s_stop(void *drv) {
+    hal_i2s_t *i2s = (hal_i2s_t *)drv;
+    i2s_channel_disable(i2s->rx);
+    i2s_channel_disable(i2s->tx);
+    if (i2s->task) {
+        vTaskDelete(i2s->task);
+        i2s->task = NULL;
+    }
+    hal_i2s_release(i2s);
+    i2s->bridge = NULL;
+}
+
+static int64_t hal_i2s_now_us(void *drv) {
+    return esp_timer_get_time();
+}
+
+const audio_bridge_ops_t hal_i2s_bridge_ops = {
+    .start = hal_i2s_start,
+    .stop = hal_i2s_stop,
+    .now_us = hal_i2s_now_us,
+};
+
+void *hal_i2s_driver(const hal_i2s_config_t *cfg) {
+    if (cfg->port < 0 || cfg->port >= HAL_I2S_PORTS) {
+        return NULL;
+    }
+    hal_i2s_t *i2s = &s_i2s[cfg->port];
+    memset(i2s, 0, sizeof(hal_i2s_t));
+    i2s->cfg = *cfg;
+    return i2s;
+}
@@ -0,0 +1,231 @@
+/*
+ * Copyright 2025 Emiliano Gonzalez (egonzalez . hiperion @ gmail . com))
+ * * Project Site: https://github.com/hiperiondev/esp32-bt-audio-gateway *
+ *
+ * This is based on other projects, please contact their authors for more information.
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "driver/i2s_std.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "audio_asrc.h"
+#include "audio_frame.h"
+#include "audio_pwm.h"
+#include "audio_ring.h"
+#include "hal_pwm_audio.h"
+
+static const char *TAG = "hal_pwm_audio";
+
+#define HAL_PWM_AUDIO_WORDS      (AUDIO_PWM_RATE / 1000 * PCM_BLOCK_DURATION_US / 1000) // serial words per frame, 960
+#define HAL_PWM_AUDIO_BUFS       (2)
+#define HAL_PWM_AUDIO_TASK_STACK (3072)
+
+static i2s_chan_handle_t s_tx = NULL;
+static TaskHandle_t s_task = NULL;
+static audio_pwm_t s_pwm;
+// frames from the audio task to the refill task
+static audio_ring_t s_queue;
+static uint32_t s_write_us; // last frame queued, the fill is interpolated from it
+// the queued frames follow the air clock, the APLL plays them through a 1:1 converter trimmed by the queue fill
+static audio_asrc_t s_asrc;
+static uint32_t s_samples;
+static bool s_primed;
+// played DMA buffers, posted by the interrupt and refilled by the task
+static uint32_t *s_played[HAL_PWM_AUDIO_BUFS];
+static uint32_t s_posted;
+static uint32_t s_refilled;
+static uint32_t s_words[HAL_PWM_AUDIO_WORDS];
+static hal_pwm_audio_stats_t s_stats;
+
+static bool IRAM_ATTR hal_pwm_audio_on_sent(i2s_chan_handle_t handle, i2s_event_data_t *event, void *user_ctx) {
+    BaseType_t woken = pdFALSE;
+    s_played[s_posted % HAL_PWM_AUDIO_BUFS] = (uint32_t *)event->dma_buf;
+    __atomic_store_n(&s_posted, s_posted + 1, __ATOMIC_RELEASE);
+    vTaskNotifyGiveFromISR(s_task, &woken);
+    return woken == pdTRUE;
+}
+
+// the DMA replays a buffer until it is refilled, so a dry queue gives silence (half duty) rather than nothing
+static void hal_pwm_audio_refill(uint32_t *buf) {
+    const int16_t *pcm = NULL;
+    if (!s_primed && audio_ring_count(&s_queue) >= HAL_PWM_AUDIO_PRIME) {
+        s_primed = true;
+    }
+    if (s_primed) {
+        // a trimmed frame may come out a sample short, the next queued one completes it
+        while (audio_asrc_peek(&s_asrc) == NULL) {
+            const uint8_t *frame = audio_ring_read_begin(&s_queue);
+            if (frame == NULL) {
+                break;
+            }
+            audio_asrc_put(&s_asrc, (const int16_t *)frame);
+            audio_ring_read_commit(&s_queue);
+        }
+        pcm = audio_asrc_peek(&s_asrc);
+        s_primed = (pcm != NULL);
+    }
+    audio_pwm_convert(&s_pwm, pcm, s_samples, buf);
+    if (pcm) {
+        audio_asrc_release(&s_asrc);
+        // the audio task queues whole frames, the part of the next one already due counts as queued
+        uint32_t since_us = (uint32_t)esp_timer_get_time() - __atomic_load_n(&s_write_us, __ATOMIC_RELAXED);
+        if (since_us > PCM_BLOCK_DURATION_US) {
+            since_us = PCM_BLOCK_DURATION_US;
+        }
+        audio_asrc_track(&s_asrc, (int32_t)(audio_ring_count(&s_queue) * s_samples + since_us * s_samples / PCM_BLOCK_DURATION_US));
+    } else {
+        s_stats.silent++;
+    }
+    s_stats.refills++;
+}
+
+static void hal_pwm_audio_task(void *arg) {
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, (TickType_t)portMAX_DELAY);
+        uint32_t posted = __atomic_load_n(&s_posted, __ATOMIC_ACQUIRE);
+        // with both buffers posted again the older one is already playing a second time
+        if (posted - s_refilled > HAL_PWM_AUDIO_BUFS - 1) {
+            s_stats.missed += posted - s_refilled - (HAL_PWM_AUDIO_BUFS - 1);
+            s_refilled = posted - (HAL_PWM_AUDIO_BUFS - 1);
+        }
+        while (s_refilled != posted) {
+            int64_t start_us = esp_timer_get_time();
+            hal_pwm_audio_refill(s_played[s_refilled % HAL_PWM_AUDIO_BUFS]);
+            uint32_t spent_us = (uint32_t)(esp_timer_get_time() - start_us);
+            if (spent_us > s_stats.convert_max_us) {
+                s_stats.convert_max_us = spent_us;
+            }
+            s_refilled++;
+        }
+    }
+}
+
+bool hal_pwm_audio_start(const hal_pwm_audio_config_t *cfg, uint32_t sample_rate) {
+    if (s_tx != NULL || !audio_pwm_init(&s_pwm, sample_rate)) {
+        return false;
+    }
+    s_samples = HAL_PWM_AUDIO_WORDS / s_pwm.osr;
+    if (!audio_asrc_init(&s_asrc, sample_rate, s_samples, HAL_PWM_AUDIO_PRIME * s_samples)) {
+        return false;
+    }
+    audio_ring_init(&s_queue, s_samples * BYTES_PER_SAMPLE);
+    s_write_us = (uint32_t)esp_timer_get_time();
+    s_primed = false;
+    s_posted = 0;
+    s_refilled = 0;
+    memset(&s_stats, 0, sizeof(hal_pwm_audio_stats_t));
+
+    // one 32 bit word per PWM period: 16 bit stereo at AUDIO_PWM_RATE, from the audio PLL for a clean carrier
+    i2s_chan_config_t chan_cfg = I2S_CHANNEL_DEFAULT_CONFIG(cfg->port, I2S_ROLE_MASTER);
+    chan_cfg.dma_desc_num = HAL_PWM_AUDIO_BUFS;
+    chan_cfg.dma_frame_num = HAL_PWM_AUDIO_WORDS;
+    if (i2s_new_channel(&chan_cfg, &s_tx, NULL) != ESP_OK) {
+        ESP_LOGE(TAG, "port %d: no channel", cfg->port);
+        s_tx = NULL;
+        return false;
+    }
+    i2s_std_config_t std_cfg = {
+        .clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(AUDIO_PWM_RATE),
+        .slot_cfg = I2S_STD_MSB_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_16BIT, I2S_SLOT_MODE_STEREO),
+        .gpio_cfg = {
+            .mclk = I2S_GPIO_UNUSED,
+            .bclk = I2S_GPIO_UNUSED,
+            .ws = I2S_GPIO_UNUSED,
+            .dout = cfg->pin,
+            .din = I2S_GPIO_UNUSED,
+        },
+    };
+    std_cfg.clk_cfg.clk_src = I2S_CLK_SRC_APLL;
+    if (i2s_channel_init_std_mode(s_tx, &std_cfg) != ESP_OK) {
+        ESP_LOGE(TAG, "port %d: std mode refused", cfg->port);
+        i2s_del_channel(s_tx);
+        s_tx = NULL;
+        return false;
+    }
+
+    // both DMA buffers start at half duty, no click when the pin comes up
+    size_t loaded;
+    audio_pwm_convert(&s_pwm, NULL, s_samples, s_words);
+    for (uint32_t i = 0; i < HAL_PWM_AUDIO_BUFS; i++) {
+        i2s_channel_preload_data(s_tx, s_words, sizeof(s_words), &loaded);
+    }
+
+    i2s_event_callbacks_t cbs = { .on_sent = hal_pwm_audio_on_sent };
+    i2s_channel_register_event_callback(s_tx, &cbs, NULL);
+    xTaskCreate(hal_pwm_audio_task, "HalPwmAudioTask", HAL_PWM_AUDIO_TASK_STACK, NULL, cfg->task_prio, &s_task);
+    i2s_channel_enable(s_tx);
+    ESP_LOGI(TAG, "pin %d: %" PRIu32 " Hz to %d Hz PWM, %" PRIu32 " samples per frame", cfg->pin, sample_rate, AUDIO_PWM_RATE, s_samples);
+    return true;
+}
+
+void hal_pwm_audio_stop(void) {
+    if (s_tx == NULL) {
+        return;
+    }
+    i2s_channel_disable(s_tx);
+    if (s_task) {
+        vTaskDelete(s_task);
+        s_task = NULL;
+    }
+    i2s_del_channel(s_tx);
+    s_tx = NULL;
+    s_stats.pwm = s_pwm.stats;
+    s_stats.trim_ppb = s_asrc.drift.ppb;
+    ESP_LOGI(TAG, "queued %" PRIu32 ", dropped %" PRIu32 ", refills %" PRIu32 ", silent %" PRIu32 ", missed %" PRIu32 ", slowest %" PRIu32 " us",
+             s_stats.queued, s_stats.dropped, s_stats.refills, s_stats.silent, s_stats.missed, s_stats.convert_max_us);
+    ESP_LOGI(TAG, "APLL trimmed %+.1f ppm to the air, fill error %" PRId32 "..%" PRId32 " samples", s_asrc.drift.ppb / 1000.0f, s_asrc.drift.err_min,
+             s_asrc.drift.err_max);
+    audio_ring_init(&s_queue, 0);
+}
+
+bool hal_pwm_audio_write(const int16_t *pcm, uint32_t samples) {
+    if (samples != s_samples) {
+        return false;
+    }
+    uint8_t *frame = audio_ring_write_begin(&s_queue);
+    if (frame == NULL) {
+        s_stats.dropped++;
+        return false;
+    }
+    memcpy(frame, pcm, samples * BYTES_PER_SAMPLE);
+    audio_ring_write_commit(&s_queue);
+    __atomic_store_n(&s_write_us, (uint32_t)esp_timer_get_time(), __ATOMIC_RELAXED);
+    s_stats.queued++;
+    return true;
+}
+
+void hal_pwm_audio_get_stats(hal_pwm_audio_stats_t *stats) {
+    *stats = s_stats;
+    stats->pwm = s_pwm.stats;
+    stats->trim_ppb = s_asrc.drift.ppb;
+}